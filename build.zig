@@ -273,6 +273,7 @@ const common = [_][]const u8{
     "com_game.c",
     "com_infostring.c",
     "com_msg.c",
+    "com_rangecoder.c",
     "common.c",
     "console.c",
     "csprogs.c",
@@ -293,6 +294,9 @@ const common = [_][]const u8{
     "host.c",
     "image.c",
     "image_png.c",
+    "image_resample_sse2.c",
+    "image_resample_avx2.c",
+    "image_dxt.c",
     "jpeg.c",
     "keys.c",
     "lhnet.c",
@@ -302,6 +306,7 @@ const common = [_][]const u8{
     "mdfour.c",
     "meshqueue.c",
     "mod_skeletal_animatevertices_sse.c",
+    "mod_skeletal_animatevertices_avx2.c",
     "mod_skeletal_animatevertices_generic.c",
     "model_alias.c",
     "model_brush.c",
@@ -24,6 +24,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "hmac.h"
 #include "mdfour.h"
 #include "image.h"
+#include "image_dxt.h"
 #include <time.h>
 
 #include "cl_collision.h"
@@ -781,6 +782,9 @@ void CL_InitCommands(void)
 	Cmd_AddCommand(CF_CLIENT, "fullinfo", CL_FullInfo_f, "allows client to modify their userinfo");
 	Cmd_AddCommand(CF_CLIENT, "setinfo", CL_SetInfo_f, "modifies your userinfo");
 	Cmd_AddCommand(CF_CLIENT, "fixtrans", Image_FixTransparentPixels_f, "change alpha-zero pixels in an image file to sensible values, and write out a new TGA (warning: SLOW)");
+	Cmd_AddCommand(CF_CLIENT, "entityframe5_selftest", EntityFrame5_SelfTest_f, "encodes random entity origins and angles with the protocol 8 bit packing, decodes them again and checks the errors stay within bounds (optional: number of updates)");
+	Cmd_AddCommand(CF_CLIENT, "imagebench", Image_Bench_f, "decode the images in textures/, models/, progs/, gfx/ and env/ (or matching the given patterns) serially and on the task queue, and print the throughput per format");
+	Cmd_AddCommand(CF_CLIENT, "r_texture_dds_bake", Image_BakeDDS_f, "compress the images in textures/, models/, progs/, gfx/ and env/ (or matching the given patterns) into the dds/ cache for r_texture_dds_load, skipping ones already cached");
 	host.hook.CL_SendCvar = CL_SendCvar_f;
 
 	// commands that are only sent by server to client for execution
@@ -1,7 +1,75 @@
 #include "quakedef.h"
 #include "protocol.h"
 
-static void EntityState5_ReadUpdate(entity_state_t *s, int number)
+// PROTOCOL_DARKPLACES8 origin and angles, see E5_ANGLES in protocol.h
+static void EntityState5_ReadOriginAnglesBits(sizebuf_t *msg, entity_state_t *s, int bits, int framenum)
+{
+	int i, baseoffset, width, bitcount = 0;
+	int delta[3];
+	unsigned int value;
+	union {float f;unsigned int i;} u;
+	if (bits & E5_ORIGIN)
+	{
+		baseoffset = MSG_ReadBits(msg, 8, &bitcount);
+		if (baseoffset)
+		{
+			width = MSG_ReadBits(msg, 4, &bitcount);
+			for (i = 0;i < 3;i++)
+			{
+				value = width ? MSG_ReadBits(msg, width, &bitcount) : 0;
+				// sign extend
+				delta[i] = (int)value - (width && (value & (1u << (width - 1))) ? (1 << width) : 0);
+			}
+			// if the origin this is relative to was lost, the server will
+			// resend it without a delta, so just skip this one
+			if (s->originframenum && s->originframenum == framenum - baseoffset)
+			{
+				for (i = 0;i < 3;i++)
+					s->origin[i] = ((int)floor(s->origin[i] * (1 << ENTITYFRAME5_ORIGINDELTASHIFT) + 0.5f) + delta[i]) * (1.0f / (1 << ENTITYFRAME5_ORIGINDELTASHIFT));
+				s->originframenum = framenum;
+			}
+		}
+		else
+		{
+			if (MSG_ReadBits(msg, 1, &bitcount))
+			{
+				for (i = 0;i < 3;i++)
+				{
+					u.i = MSG_ReadBits(msg, 32, &bitcount);
+					s->origin[i] = u.f;
+				}
+			}
+			else
+			{
+				for (i = 0;i < 3;i++)
+					s->origin[i] = (short)MSG_ReadBits(msg, 16, &bitcount) * (1.0f / 8.0f);
+			}
+			s->originframenum = framenum;
+		}
+	}
+	if (bits & E5_ANGLES)
+	{
+		switch (MSG_ReadBits(msg, 2, &bitcount))
+		{
+		case 0:
+			for (i = 0;i < 3;i++)
+				s->angles[i] = (signed char)MSG_ReadBits(msg, 8, &bitcount) * (360.0f/256.0f);
+			break;
+		case 1:
+			for (i = 0;i < 3;i++)
+				s->angles[i] = (short)MSG_ReadBits(msg, 16, &bitcount) * (360.0f/65536.0f);
+			break;
+		case 2:
+			EntityState5_UnpackAngles(MSG_ReadBits(msg, 32, &bitcount), s->angles);
+			break;
+		default:
+			Host_Error("EntityState5_ReadUpdate: unknown angle encoding\n");
+			break;
+		}
+	}
+}
+
+static void EntityState5_ReadUpdate(entity_state_t *s, int number, int framenum)
 {
 	int bits;
 	int startoffset = cl_message.readcount;
@@ -24,7 +92,12 @@ static void EntityState5_ReadUpdate(entity_state_t *s, int number)
 	}
 	if (bits & E5_FLAGS)
 		s->flags = MSG_ReadByte(&cl_message);
-	if (bits & E5_ORIGIN)
+	if (cls.protocol == PROTOCOL_DARKPLACES8)
+	{
+		if (bits & (E5_ORIGIN | E5_ANGLES))
+			EntityState5_ReadOriginAnglesBits(&cl_message, s, bits, framenum);
+	}
+	else if (bits & E5_ORIGIN)
 	{
 		if (bits & E5_ORIGIN32)
 		{
@@ -39,7 +112,7 @@ static void EntityState5_ReadUpdate(entity_state_t *s, int number)
 			s->origin[2] = MSG_ReadCoord13i(&cl_message);
 		}
 	}
-	if (bits & E5_ANGLES)
+	if ((bits & E5_ANGLES) && cls.protocol != PROTOCOL_DARKPLACES8)
 	{
 		if (bits & E5_ANGLES16)
 		{
@@ -323,7 +396,7 @@ void EntityFrame5_CL_ReadFrame(void)
 		else
 		{
 			// update entity
-			EntityState5_ReadUpdate(s, enumber);
+			EntityState5_ReadUpdate(s, enumber, framenum);
 		}
 		// set the cl.entities_active flag
 		cl.entities_active[enumber] = (s->active == ACTIVE_NETWORK);
@@ -344,3 +417,124 @@ void EntityFrame5_CL_ReadFrame(void)
 		}
 	}
 }
+
+// difference of two angles in degrees, -180 to 180
+static float EntityFrame5_SelfTest_AngleError(float a, float b)
+{
+	float d = fmod(a - b, 360.0f);
+	if (d > 180.0f)
+		d -= 360.0f;
+	else if (d < -180.0f)
+		d += 360.0f;
+	return fabs(d);
+}
+
+/*
+==================
+EntityFrame5_SelfTest_f
+
+Writes random origins and angles with the PROTOCOL_DARKPLACES8 bit packing
+(absolute and as deltas), reads them back with the client code, and checks
+every error stays within what the encoding promises: exact for float
+origins, 1/16 unit for 1/8 unit origins, exactly the origin the server
+expects the client to rebuild for deltas, and the angle precision of each
+mode
+==================
+*/
+void EntityFrame5_SelfTest_f(cmd_state_t *cmd)
+{
+	int i, j, count, framenum, baseoffset, delta, failures = 0, numdeltas = 0;
+	unsigned char buffer[64];
+	char vabuf[64];
+	sizebuf_t msg;
+	entity_state_t s, r;
+	qbool precise, usedelta;
+	float base[3], sent[3], error, bound;
+	float maxerror[4] = {0, 0, 0, 0}; // absolute origin, delta origin, angles, low precision angles
+
+	count = Cmd_Argc(cmd) > 1 ? atoi(Cmd_Argv(cmd, 1)) : 100000;
+	for (i = 0;i < count;i++)
+	{
+		memset(&s, 0, sizeof(s));
+		precise = (i & 1) != 0;
+		if (i & 2)
+			s.flags |= RENDER_LOWPRECISION;
+		framenum = 1000 + i;
+		// every other update is a delta from an absolute one sent before
+		baseoffset = (i & 4) ? (rand() % 255) + 1 : 0;
+		for (j = 0;j < 3;j++)
+		{
+			base[j] = Q_rint(lhrandom(-4000, 4000) * 8) * (1.0f / 8.0f);
+			// some deltas are too far apart and have to fall back to absolute
+			s.origin[j] = baseoffset ? base[j] + lhrandom(-600, 600) : lhrandom(precise ? -100000 : -4000, precise ? 100000 : 4000);
+			s.angles[j] = lhrandom(-360, 360);
+		}
+		// the same choices EntityState5_WriteUpdate and the writer make
+		usedelta = baseoffset > 0 && baseoffset < 256;
+		for (j = 0;j < 3;j++)
+		{
+			if (fabs(s.origin[j]) >= 4095.9375f)
+				precise = true;
+			delta = (int)floor(s.origin[j] * (1 << ENTITYFRAME5_ORIGINDELTASHIFT) + 0.5f) - (int)floor(base[j] * (1 << ENTITYFRAME5_ORIGINDELTASHIFT) + 0.5f);
+			if (delta < -(1 << (ENTITYFRAME5_ORIGINDELTAMAXBITS - 1)) || delta >= (1 << (ENTITYFRAME5_ORIGINDELTAMAXBITS - 1)))
+				usedelta = false;
+		}
+		if (usedelta)
+			numdeltas++;
+
+		memset(&msg, 0, sizeof(msg));
+		msg.data = buffer;
+		msg.maxsize = sizeof(buffer);
+		EntityState5_WriteOriginAnglesBits(&msg, &s, E5_ORIGIN | E5_ANGLES, precise, baseoffset, base, sent);
+
+		// the client has the base origin from frame framenum - baseoffset
+		memset(&r, 0, sizeof(r));
+		VectorCopy(base, r.origin);
+		r.originframenum = framenum - baseoffset;
+		MSG_BeginReading(&msg);
+		EntityState5_ReadOriginAnglesBits(&msg, &r, E5_ORIGIN | E5_ANGLES, framenum);
+		if (msg.badread || msg.readcount != msg.cursize || r.originframenum != framenum)
+		{
+			Con_Printf("entityframe5_selftest: update %i read back wrong\n", i);
+			failures++;
+			continue;
+		}
+
+		for (j = 0;j < 3;j++)
+		{
+			if (r.origin[j] != sent[j])
+			{
+				Con_Printf("entityframe5_selftest: update %i origin %f read back as %f, server expected %f\n", i, s.origin[j], r.origin[j], sent[j]);
+				failures++;
+			}
+			error = fabs(r.origin[j] - s.origin[j]);
+			if (usedelta)
+			{
+				bound = 0.5f / (1 << ENTITYFRAME5_ORIGINDELTASHIFT);
+				maxerror[1] = max(maxerror[1], error);
+			}
+			else
+			{
+				bound = precise ? 0 : 1.0f / 16.0f;
+				maxerror[0] = max(maxerror[0], error);
+			}
+			// allow for the float precision of the larger origins
+			if (error > bound + fabs(s.origin[j]) * (1.0f / (1 << 22)))
+			{
+				Con_Printf("entityframe5_selftest: update %i origin %f read back as %f, off by %f\n", i, s.origin[j], r.origin[j], error);
+				failures++;
+			}
+
+			error = EntityFrame5_SelfTest_AngleError(r.angles[j], s.angles[j]);
+			bound = (s.flags & RENDER_LOWPRECISION) ? 180.0f / 256.0f : ENTITYFRAME5_PACKEDANGLEERROR;
+			maxerror[(s.flags & RENDER_LOWPRECISION) ? 3 : 2] = max(maxerror[(s.flags & RENDER_LOWPRECISION) ? 3 : 2], error);
+			if (error > bound + 0.01f)
+			{
+				Con_Printf("entityframe5_selftest: update %i angle %f read back as %f, off by %f\n", i, s.angles[j], r.angles[j], error);
+				failures++;
+			}
+		}
+	}
+	Con_Printf("%i updates (%i delta origins), largest errors: origin %f, delta origin %f, angles %f, low precision angles %f\n", count, numdeltas, maxerror[0], maxerror[1], maxerror[2], maxerror[3]);
+	Con_Printf("%s\n", failures ? va(vabuf, sizeof(vabuf), "%i FAILURES", failures) : "all within bounds");
+}
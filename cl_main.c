@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "cl_collision.h"
 #include "cl_video.h"
 #include "image.h"
+#include "image_dxt.h"
 #include "csprogs.h"
 #include "r_shadow.h"
 #include "libcurl.h"
@@ -2966,6 +2967,10 @@ void CL_Init (void)
 	if (cls.state == ca_dedicated)
 	{
 		Cmd_AddCommand(CF_SERVER, "disconnect", CL_Disconnect_f, "disconnect from server (or disconnect all clients if running a server)");
+		Cmd_AddCommand(CF_SERVER, "entityframe5_selftest", EntityFrame5_SelfTest_f, "encodes random entity origins and angles with the protocol 8 bit packing, decodes them again and checks the errors stay within bounds (optional: number of updates)");
+		Cmd_AddCommand(CF_SERVER, "imagebench", Image_Bench_f, "decode the images in textures/, models/, progs/, gfx/ and env/ (or matching the given patterns) serially and on the task queue, and print the throughput per format");
+		// so the dds cache can be baked headless: -dedicated +r_texture_dds_bake +quit
+		Cmd_AddCommand(CF_SERVER, "r_texture_dds_bake", Image_BakeDDS_f, "compress the images in textures/, models/, progs/, gfx/ and env/ (or matching the given patterns) into the dds/ cache for r_texture_dds_load, skipping ones already cached");
 	}
 	else
 	{
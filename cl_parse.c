@@ -103,6 +103,7 @@ const char *svc_strings[128] =
 	"svc_trailparticles", //	60		// [short] entnum [short] effectnum [vector] start [vector] end
 	"svc_pointparticles", //	61		// [short] effectnum [vector] start [vector] velocity [short] count
 	"svc_pointparticles1", //	62		// [short] effectnum [vector] start, same as svc_pointparticles except velocity is zero and count is 1
+	"svc_rangecoded", //	63		// [short] size [variable length] range coded message replacing the rest of the packet (DP8 and later)
 };
 
 const char *qw_svc_strings[128] =
@@ -581,6 +582,38 @@ static qbool QW_CL_CheckOrDownloadFile(const char *filename)
 	return false;
 }
 
+/*
+=====================
+CL_PrefetchPrecaches
+
+Hands the precached files that are not loaded yet to FS_PrefetchAsync, the
+world model first as it takes longest, then the sounds, then the other models
+=====================
+*/
+static void CL_PrefetchPrecaches(void)
+{
+	int i;
+	model_t *mod;
+	sfx_t *sfx;
+	stringlist_t list;
+	char vabuf[1024];
+
+	stringlistinit(&list);
+	if (cl.model_name[1][0] && (mod = Mod_FindName(cl.model_name[1], NULL)) && !mod->loaded)
+		stringlistappend(&list, cl.model_name[1]);
+	for (i = 1;i < MAX_SOUNDS && cl.sound_name[i][0];i++)
+	{
+		// S_LoadSound tries the name with sound/ prepended first
+		if ((sfx = S_FindName(cl.sound_name[i])) && !S_IsSoundPrecached(sfx))
+			stringlistappend(&list, strncasecmp(cl.sound_name[i], "sound/", 6) ? va(vabuf, sizeof(vabuf), "sound/%s", cl.sound_name[i]) : cl.sound_name[i]);
+	}
+	for (i = 2;i < MAX_MODELS && cl.model_name[i][0];i++)
+		if (cl.model_name[i][0] != '*' && (mod = Mod_FindName(cl.model_name[i], NULL)) && !mod->loaded)
+			stringlistappend(&list, cl.model_name[i]);
+	FS_PrefetchAsync(&list);
+	stringlistfreecontents(&list);
+}
+
 static void QW_CL_ProcessUserInfo(int slot);
 static void QW_CL_RequestNextDownload(void)
 {
@@ -660,6 +693,7 @@ static void QW_CL_RequestNextDownload(void)
 			Mod_ClearUsed();
 		for (i = 1;i < MAX_MODELS && cl.model_name[i][0];i++)
 			Mod_FindName(cl.model_name[i], cl.model_name[i][0] == '*' ? cl.model_name[1] : NULL);
+		CL_PrefetchPrecaches();
 		// precache any models used by the client (this also marks them used)
 		cl.model_bolt = Mod_ForName("progs/bolt.mdl", false, false, NULL);
 		cl.model_bolt2 = Mod_ForName("progs/bolt2.mdl", false, false, NULL);
@@ -1085,6 +1119,22 @@ static void CL_UpdateItemsAndWeapon(void)
 #define LOADPROGRESSWEIGHT_WORLDMODEL      30.0
 #define LOADPROGRESSWEIGHT_WORLDMODEL_INIT  2.0
 
+/*
+=====================
+CL_RequestDownload
+
+Asks the server for a file, listing the download extensions it supports
+=====================
+*/
+static void CL_RequestDownload(const char *filename, qbool deflate)
+{
+	char vabuf[1024];
+	if (cl_serverextension_download.integer == 2)
+		CL_ForwardToServer(va(vabuf, sizeof(vabuf), "download %s%s window", filename, (deflate && FS_HasZlib()) ? " deflate" : ""));
+	else
+		CL_ForwardToServer(va(vabuf, sizeof(vabuf), "download %s", filename));
+}
+
 static void CL_BeginDownloads(qbool aborteddownload)
 {
 	char vabuf[1024];
@@ -1123,10 +1173,7 @@ static void CL_BeginDownloads(qbool aborteddownload)
 		 && !FS_FileExists(va(vabuf, sizeof(vabuf), "dlcache/%s.%i.%i", csqc_progname.string, csqc_progsize.integer, csqc_progcrc.integer)))
 		{
 			Con_Printf("Downloading new CSQC code to dlcache/%s.%i.%i\n", csqc_progname.string, csqc_progsize.integer, csqc_progcrc.integer);
-			if(cl_serverextension_download.integer == 2 && FS_HasZlib())
-				CL_ForwardToServer(va(vabuf, sizeof(vabuf), "download %s deflate", csqc_progname.string));
-			else
-				CL_ForwardToServer(va(vabuf, sizeof(vabuf), "download %s", csqc_progname.string));
+			CL_RequestDownload(csqc_progname.string, true);
 			return;
 		}
 	}
@@ -1283,7 +1330,7 @@ static void CL_BeginDownloads(qbool aborteddownload)
 				// regarding the * check: don't try to download submodels
 				if (cl_serverextension_download.integer && cls.netcon && cl.model_name[cl.downloadmodel_current][0] != '*' && !sv.active)
 				{
-					CL_ForwardToServer(va(vabuf, sizeof(vabuf), "download %s", cl.model_name[cl.downloadmodel_current]));
+					CL_RequestDownload(cl.model_name[cl.downloadmodel_current], false);
 					// we'll try loading again when the download finishes
 					return;
 				}
@@ -1335,7 +1382,7 @@ static void CL_BeginDownloads(qbool aborteddownload)
 			{
 				if (cl_serverextension_download.integer && cls.netcon && !sv.active)
 				{
-					CL_ForwardToServer(va(vabuf, sizeof(vabuf), "download %s", soundname));
+					CL_RequestDownload(soundname, false);
 					// we'll try loading again when the download finishes
 					return;
 				}
@@ -1371,13 +1418,18 @@ static void CL_BeginDownloads_f(cmd_state_t *cmd)
 		CL_BeginDownloads(false);
 }
 
+static qbool CL_IsArchiveName(const char *name)
+{
+	const char *extension = FS_FileExtension(name);
+	return !strcasecmp(extension, "pak") || !strcasecmp(extension, "pk3") || !strcasecmp(extension, "dpk");
+}
+
 static void CL_StopDownload(int size, int crc)
 {
 	if (cls.qw_downloadmemory && cls.qw_downloadmemorycursize == size && CRC_Block(cls.qw_downloadmemory, cls.qw_downloadmemorycursize) == crc)
 	{
 		int existingcrc;
 		size_t existingsize;
-		const char *extension;
 
 		if(cls.qw_download_deflate)
 		{
@@ -1423,6 +1475,8 @@ static void CL_StopDownload(int size, int crc)
 					{
 						Con_Printf("Downloaded \"%s\" (%i bytes, %i CRC)\n", name, size, crc);
 						FS_WriteFile(name, cls.qw_downloadmemory, cls.qw_downloadmemorycursize);
+						if (CL_IsArchiveName(cls.qw_downloadname))
+							Curl_HashCache_Add(name, cls.qw_downloadmemory, cls.qw_downloadmemorycursize);
 						if(!strcmp(cls.qw_downloadname, csqc_progname.string))
 						{
 							if(cls.caughtcsprogsdata)
@@ -1444,9 +1498,11 @@ static void CL_StopDownload(int size, int crc)
 				// we do nothing
 				Con_Printf("Downloaded \"%s\" (%i bytes, %i CRC)\n", cls.qw_downloadname, size, crc);
 				FS_WriteFile(cls.qw_downloadname, cls.qw_downloadmemory, cls.qw_downloadmemorycursize);
-				extension = FS_FileExtension(cls.qw_downloadname);
-				if (!strcasecmp(extension, "pak") || !strcasecmp(extension, "pk3") || !strcasecmp(extension, "dpk"))
+				if (CL_IsArchiveName(cls.qw_downloadname))
+				{
+					Curl_HashCache_Add(cls.qw_downloadname, cls.qw_downloadmemory, cls.qw_downloadmemorycursize);
 					FS_Rescan();
+				}
 			}
 		}
 	}
@@ -1472,15 +1528,18 @@ static void CL_ParseDownload(void)
 	start = MSG_ReadLong(&cl_message);
 	size = (unsigned short)MSG_ReadShort(&cl_message);
 
-	// record the start/size information to ack in the next input packet
+	// record the start/size information to ack in the next input packet,
+	// a block that continues the previous one just extends its ack (the
+	// server reads the size as a signed short)
 	for (i = 0;i < CL_MAX_DOWNLOADACKS;i++)
-	{
 		if (!cls.dp_downloadack[i].start && !cls.dp_downloadack[i].size)
-		{
-			cls.dp_downloadack[i].start = start;
-			cls.dp_downloadack[i].size = size;
 			break;
-		}
+	if (i > 0 && size > 0 && cls.dp_downloadack[i-1].start + cls.dp_downloadack[i-1].size == start && cls.dp_downloadack[i-1].size + size <= 32767)
+		cls.dp_downloadack[i-1].size += size;
+	else if (i < CL_MAX_DOWNLOADACKS)
+	{
+		cls.dp_downloadack[i].start = start;
+		cls.dp_downloadack[i].size = size;
 	}
 
 	MSG_ReadBytes(&cl_message, size, data);
@@ -1506,7 +1565,10 @@ static void CL_ParseDownload(void)
 
 static void CL_DownloadBegin_f(cmd_state_t *cmd)
 {
+	int i;
 	int size = atoi(Cmd_Argv(cmd, 1));
+	const char *hash = NULL, *cached;
+	unsigned char *data;
 
 	if (size < 0 || size > 1<<30 || FS_CheckNastyPath(Cmd_Argv(cmd, 2), false))
 	{
@@ -1523,17 +1585,33 @@ static void CL_DownloadBegin_f(cmd_state_t *cmd)
 	// we're really beginning a download now, so initialize stuff
 	dp_strlcpy(cls.qw_downloadname, Cmd_Argv(cmd, 2), sizeof(cls.qw_downloadname));
 	cls.qw_downloadmemorymaxsize = size;
-	cls.qw_downloadmemory = (unsigned char *) Mem_Alloc(cls.permanentmempool, cls.qw_downloadmemorymaxsize);
 	cls.qw_downloadnumber++;
 
 	cls.qw_download_deflate = false;
-	if(Cmd_Argc(cmd) >= 4)
+	for (i = 3;i < Cmd_Argc(cmd);i++)
 	{
-		if(!strcmp(Cmd_Argv(cmd, 3), "deflate"))
+		if(!strcmp(Cmd_Argv(cmd, i), "deflate"))
 			cls.qw_download_deflate = true;
+		else if(!strncmp(Cmd_Argv(cmd, i), "sha256=", 7))
+			hash = Cmd_Argv(cmd, i) + 7;
 		// check further encodings here
 	}
 
+	// a package we already downloaded under another name does not need to
+	// be transferred again
+	if (hash && !cls.qw_download_deflate && (cached = Curl_HashCache_Find(hash, size, &data)))
+	{
+		Con_Printf("Using \"%s\" for \"%s\"\n", cached, cls.qw_downloadname);
+		CL_ForwardToServer("sv_skipdownload");
+		cls.qw_downloadmemory = data;
+		cls.qw_downloadmemorycursize = size;
+		CL_StopDownload(size, CRC_Block(data, size));
+		CL_BeginDownloads(false);
+		return;
+	}
+
+	cls.qw_downloadmemory = (unsigned char *) Mem_Alloc(cls.permanentmempool, cls.qw_downloadmemorymaxsize);
+
 	CL_ForwardToServer("sv_startdownload");
 }
 
@@ -1863,6 +1941,8 @@ static void CL_ParseServerInfo (void)
 			Mod_ClearUsed();
 		for (i = 1;i < nummodels;i++)
 			Mod_FindName(cl.model_name[i], cl.model_name[i][0] == '*' ? cl.model_name[1] : NULL);
+		// start reading the new files while the sounds below load
+		CL_PrefetchPrecaches();
 		// precache any models used by the client (this also marks them used)
 		cl.model_bolt = Mod_ForName("progs/bolt.mdl", false, false, NULL);
 		cl.model_bolt2 = Mod_ForName("progs/bolt2.mdl", false, false, NULL);
@@ -2137,16 +2217,20 @@ static void CL_ParseClientdata (void)
 		cl.stats[STAT_ITEMS] = 0;
 		cl.stats[STAT_VIEWZOOM] = 255;
 	}
-	cl.idealpitch = 0;
-	cl.mpunchangle[0][0] = 0;
-	cl.mpunchangle[0][1] = 0;
-	cl.mpunchangle[0][2] = 0;
-	cl.mpunchvector[0][0] = 0;
-	cl.mpunchvector[0][1] = 0;
-	cl.mpunchvector[0][2] = 0;
-	cl.mvelocity[0][0] = 0;
-	cl.mvelocity[0][1] = 0;
-	cl.mvelocity[0][2] = 0;
+	// PROTOCOL_DARKPLACES8 only sends the SU_DELTAFIELDS that changed
+	if (cls.protocol != PROTOCOL_DARKPLACES8)
+	{
+		cl.idealpitch = 0;
+		cl.mpunchangle[0][0] = 0;
+		cl.mpunchangle[0][1] = 0;
+		cl.mpunchangle[0][2] = 0;
+		cl.mpunchvector[0][0] = 0;
+		cl.mpunchvector[0][1] = 0;
+		cl.mpunchvector[0][2] = 0;
+		cl.mvelocity[0][0] = 0;
+		cl.mvelocity[0][1] = 0;
+		cl.mvelocity[0][2] = 0;
+	}
 	cl.mviewzoom[0] = 1;
 
 	bits = (unsigned short) MSG_ReadShort(&cl_message);
@@ -2956,6 +3040,31 @@ static void CL_ParsePointParticles1(void)
 	CL_ParticleEffect(effectindex, 1, origin, origin, vec3_origin, vec3_origin, NULL, 0);
 }
 
+// replaces the rest of cl_message with the decoded message, so a recorded
+// demo contains the plain message and parsing simply continues
+static void CL_ParseRangeCoded(void)
+{
+	int size, codedsize;
+	static unsigned char decoded[NET_MAXMESSAGE];
+	size = (unsigned short)MSG_ReadShort(&cl_message);
+	codedsize = cl_message.cursize - cl_message.readcount;
+	if (codedsize <= 0 || cl_message.readcount + size > cl_message.maxsize || RangeCoder_Decompress(cl_message.data + cl_message.readcount, codedsize, decoded, size) != size)
+	{
+		Host_Error("CL_ParseRangeCoded: corrupt svc_rangecoded message (%i bytes coded, %i decoded)", codedsize, size);
+		return;
+	}
+	if (cls.netcon)
+	{
+		cls.netcon->rangecodedBytesIn += size;
+		cls.netcon->rangecodedBytesOut += codedsize + 3;
+	}
+	// the message bytes before svc_rangecoded were already parsed, drop the
+	// svc_rangecoded header and the coded data
+	cl_message.readcount -= 3;
+	memcpy(cl_message.data + cl_message.readcount, decoded, size);
+	cl_message.cursize = cl_message.readcount + size;
+}
+
 typedef struct cl_iplog_item_s
 {
 	char *address;
@@ -4229,6 +4338,9 @@ void CL_ParseServerMessage(void)
 			case svc_pointparticles1:
 				CL_ParsePointParticles1();
 				break;
+			case svc_rangecoded:
+				CL_ParseRangeCoded();
+				break;
 			}
 //			R_TimeReport(svc_strings[cmd]);
 		}
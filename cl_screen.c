@@ -2239,6 +2239,7 @@ void CL_UpdateScreen(void)
 
 	R_FrameData_NewFrame();
 	R_BufferData_NewFrame();
+	R_SkinFrame_FinishAsync();
 
 	Matrix4x4_OriginFromMatrix(&r_refdef.view.matrix, vieworigin);
 	R_HDR_UpdateIrisAdaptation(vieworigin);
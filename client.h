@@ -543,7 +543,7 @@ typedef enum qw_downloadtype_e
 }
 qw_downloadtype_t;
 
-#define CL_MAX_DOWNLOADACKS 4
+#define CL_MAX_DOWNLOADACKS 16
 
 typedef struct cl_downloadack_s
 {
@@ -40,6 +40,76 @@ mempool_t *cbuf_mempool;
 // we only run the +whatever commandline arguments once
 qbool host_stuffcmdsrun = false;
 
+// command lines executed during Host_Init, see Cmd_PrintInitStats
+static unsigned int cmd_initlines;
+static double cmd_inittime;
+static int cmd_executedepth;
+
+//=============================================================================
+
+/*
+============
+Cmd_HashName
+
+Case insensitive hash for the command and alias hash tables, so names that
+only differ in case end up in the same bucket for Cmd_ExecuteString
+============
+*/
+static unsigned int Cmd_HashName(const char *name)
+{
+	unsigned int hash = 2166136261u;
+	for (;*name;name++)
+		hash = (hash ^ (unsigned char)tolower((unsigned char)*name)) * 16777619u;
+	return hash % CMD_HASHSIZE;
+}
+
+// buckets are kept in the same order as the alphabetical lists (which put a
+// command before any older one of the same name), so lookups find the same
+// command as walking the list did
+static void Cmd_LinkFunctionHash(cmd_function_t **hashtable, cmd_function_t *func)
+{
+	cmd_function_t **link;
+	for (link = &hashtable[Cmd_HashName(func->name)];*link && strcmp((*link)->name, func->name) < 0;link = &(*link)->hashnext)
+		;
+	func->hashnext = *link;
+	*link = func;
+}
+
+static void Cmd_UnlinkFunctionHash(cmd_function_t **hashtable, cmd_function_t *func)
+{
+	cmd_function_t **link;
+	for (link = &hashtable[Cmd_HashName(func->name)];*link;link = &(*link)->hashnext)
+	{
+		if (*link == func)
+		{
+			*link = func->hashnext;
+			return;
+		}
+	}
+}
+
+static void Cmd_LinkAliasHash(cmd_userdefined_t *userdefined, cmd_alias_t *alias)
+{
+	cmd_alias_t **link;
+	for (link = &userdefined->alias_hash[Cmd_HashName(alias->name)];*link && strcmp((*link)->name, alias->name) < 0;link = &(*link)->hashnext)
+		;
+	alias->hashnext = *link;
+	*link = alias;
+}
+
+static void Cmd_UnlinkAliasHash(cmd_userdefined_t *userdefined, cmd_alias_t *alias)
+{
+	cmd_alias_t **link;
+	for (link = &userdefined->alias_hash[Cmd_HashName(alias->name)];*link;link = &(*link)->hashnext)
+	{
+		if (*link == alias)
+		{
+			*link = alias->hashnext;
+			return;
+		}
+	}
+}
+
 //=============================================================================
 
 void Cbuf_Lock(cmd_buf_t *cbuf)
@@ -765,7 +835,7 @@ static void Cmd_Alias_f (cmd_state_t *cmd)
 	}
 
 	// if the alias already exists, reuse it
-	for (a = cmd->userdefined->alias ; a ; a=a->next)
+	for (a = cmd->userdefined->alias_hash[Cmd_HashName(s)] ; a ; a=a->hashnext)
 	{
 		if (!strcmp(s, a->name))
 		{
@@ -789,6 +859,7 @@ static void Cmd_Alias_f (cmd_state_t *cmd)
 			cmd->userdefined->alias = a;
 		}
 		a->next = current;
+		Cmd_LinkAliasHash(cmd->userdefined, a);
 	}
 
 
@@ -843,6 +914,7 @@ static void Cmd_UnAlias_f (cmd_state_t *cmd)
 					cmd->userdefined->alias = a->next;
 				if(p)
 					p->next = a->next;
+				Cmd_UnlinkAliasHash(cmd->userdefined, a);
 				Z_Free(a->value);
 				Z_Free(a);
 				break;
@@ -1611,7 +1683,7 @@ void Cmd_AddCommand(unsigned flags, const char *cmd_name, xcommand_t function, c
 			if (function)
 			{
 				// fail if the command already exists in this interpreter
-				for (func = cmd->engine_functions; func; func = func->next)
+				for (func = cmd->engine_functions_hash[Cmd_HashName(cmd_name)]; func; func = func->hashnext)
 				{
 					if (!strcmp(cmd_name, func->name))
 					{
@@ -1637,11 +1709,12 @@ void Cmd_AddCommand(unsigned flags, const char *cmd_name, xcommand_t function, c
 					cmd->engine_functions = func;
 				}
 				func->next = current;
+				Cmd_LinkFunctionHash(cmd->engine_functions_hash, func);
 			}
 			else
 			{
 				// mark qcfunc if the function already exists in the qc_functions list
-				for (func = cmd->userdefined->qc_functions; func; func = func->next)
+				for (func = cmd->userdefined->qc_functions_hash[Cmd_HashName(cmd_name)]; func; func = func->hashnext)
 				{
 					if (!strcmp(cmd_name, func->name))
 					{
@@ -1660,7 +1733,7 @@ void Cmd_AddCommand(unsigned flags, const char *cmd_name, xcommand_t function, c
 
 				// bones_was_here: if this QC command overrides an engine command, store its pointer
 				// to avoid doing this search at invocation if QC declines to handle this command.
-				for (cmd_function_t *f = cmd->engine_functions; f; f = f->next)
+				for (cmd_function_t *f = cmd->engine_functions_hash[Cmd_HashName(cmd_name)]; f; f = f->hashnext)
 				{
 					if (!strcmp(cmd_name, f->name))
 					{
@@ -1680,6 +1753,7 @@ void Cmd_AddCommand(unsigned flags, const char *cmd_name, xcommand_t function, c
 					cmd->userdefined->qc_functions = func;
 				}
 				func->next = current;
+				Cmd_LinkFunctionHash(cmd->userdefined->qc_functions_hash, func);
 			}
 		}
 	}
@@ -1693,12 +1767,13 @@ Cmd_Exists
 qbool Cmd_Exists (cmd_state_t *cmd, const char *cmd_name)
 {
 	cmd_function_t	*func;
+	unsigned int hashindex = Cmd_HashName(cmd_name);
 
-	for (func = cmd->userdefined->qc_functions; func; func = func->next)
+	for (func = cmd->userdefined->qc_functions_hash[hashindex]; func; func = func->hashnext)
 		if (!strcmp(cmd_name, func->name))
 			return true;
 
-	for (func=cmd->engine_functions ; func ; func=func->next)
+	for (func = cmd->engine_functions_hash[hashindex]; func; func = func->hashnext)
 		if (!strcmp (cmd_name,func->name))
 			return true;
 
@@ -1920,6 +1995,7 @@ void Cmd_ClearCSQCCommands (cmd_state_t *cmd)
 		*next = func->next;
 		Z_Free(func);
 	}
+	memset(cmd->userdefined->qc_functions_hash, 0, sizeof(cmd->userdefined->qc_functions_hash));
 }
 
 extern cvar_t sv_cheats;
@@ -1993,12 +2069,13 @@ qbool Cmd_SV_Callback(cmd_state_t *cmd, cmd_function_t *func, const char *text,
 Cmd_ExecuteString
 
 A complete command line has been parsed, so try to execute it
-FIXME: lookupnoadd the token to speed search?
 ============
 */
 void Cmd_ExecuteString(cmd_state_t *cmd, const char *text, size_t textlen, cmd_source_t src, qbool lockmutex)
 {
 	int oldpos;
+	unsigned int hashindex;
+	double starttime = 0;
 	cmd_function_t *func;
 	cmd_alias_t *a;
 
@@ -2006,6 +2083,10 @@ void Cmd_ExecuteString(cmd_state_t *cmd, const char *text, size_t textlen, cmd_s
 		Cbuf_Lock(cmd->cbuf);
 	oldpos = cmd->cbuf->tokenizebufferpos;
 	cmd->source = src;
+	// only time the outermost line, commands like exec may nest
+	if (host.state == host_init && !cmd_executedepth)
+		starttime = Sys_DirtyTime();
+	cmd_executedepth++;
 
 	Cmd_TokenizeString (cmd, text);
 
@@ -2014,12 +2095,13 @@ void Cmd_ExecuteString(cmd_state_t *cmd, const char *text, size_t textlen, cmd_s
 		goto done; // no tokens
 
 // check functions
-	for (func = cmd->userdefined->qc_functions; func; func = func->next)
+	hashindex = Cmd_HashName(cmd->argv[0]);
+	for (func = cmd->userdefined->qc_functions_hash[hashindex]; func; func = func->hashnext)
 		if (!strcasecmp(cmd->argv[0], func->name))
 			if(cmd->Handle(cmd, func, text, textlen, src))
 				goto functions_done;
 
-	for (func = cmd->engine_functions; func; func=func->next)
+	for (func = cmd->engine_functions_hash[hashindex]; func; func=func->hashnext)
 		if (!strcasecmp (cmd->argv[0], func->name))
 			if(cmd->Handle(cmd, func, text, textlen, src))
 				goto functions_done;
@@ -2036,7 +2118,7 @@ functions_done:
 
 // check alias
 	// Execute any alias with the same name as a command after the command.
-	for (a=cmd->userdefined->alias ; a ; a=a->next)
+	for (a=cmd->userdefined->alias_hash[hashindex] ; a ; a=a->hashnext)
 	{
 		if (!strcasecmp (cmd->argv[0], a->name))
 		{
@@ -2054,11 +2136,42 @@ functions_done:
 	if (!Cvar_Command(cmd) && (host.framecount > 0))
 		Con_Printf(CON_WARN "Unknown command \"%s\"\n", Cmd_Argv(cmd, 0));
 done:
+	cmd_executedepth--;
+	if (starttime)
+	{
+		cmd_inittime += Sys_DirtyTime() - starttime;
+		cmd_initlines++;
+	}
 	cmd->cbuf->tokenizebufferpos = oldpos;
 	if (lockmutex)
 		Cbuf_Unlock(cmd->cbuf);
 }
 
+/*
+================
+Cmd_PrintInitStats
+
+Startup benchmark for the command interpreter, most of these lines come
+from the configs executed by Host_Init
+================
+*/
+void Cmd_PrintInitStats(void)
+{
+	unsigned int numfunctions = 0, numaliases = 0;
+	cmd_function_t *func;
+	cmd_alias_t *a;
+
+	if (!developer.integer)
+		return;
+	for (func = cmd_local->engine_functions; func; func = func->next)
+		numfunctions++;
+	for (func = cmd_local->userdefined->qc_functions; func; func = func->next)
+		numfunctions++;
+	for (a = cmd_local->userdefined->alias; a; a = a->next)
+		numaliases++;
+	Con_Printf("Cmd: executed %u command lines during startup in %.3fms (%.2fus per line), %u commands and %u aliases in %i hash buckets\n", cmd_initlines, cmd_inittime * 1000.0, cmd_initlines ? cmd_inittime * 1000000.0 / cmd_initlines : 0, numfunctions, numaliases, CMD_HASHSIZE);
+}
+
 /*
 ================
 Cmd_CheckParm
@@ -2125,6 +2238,7 @@ void Cmd_RestoreInitState(void)
 				// destroy this command, it didn't exist at init
 				Con_DPrintf("Cmd_RestoreInitState: Destroying command %s\n", f->name);
 				*fp = f->next;
+				Cmd_UnlinkFunctionHash(cmd->userdefined->qc_functions_hash, f);
 				Z_Free(f);
 			}
 		}
@@ -2137,6 +2251,7 @@ void Cmd_RestoreInitState(void)
 				// destroy this command, it didn't exist at init
 				Con_DPrintf("Cmd_RestoreInitState: Destroying command %s\n", f->name);
 				*fp = f->next;
+				Cmd_UnlinkFunctionHash(cmd->engine_functions_hash, f);
 				Z_Free(f);
 			}
 		}
@@ -2159,6 +2274,7 @@ void Cmd_RestoreInitState(void)
 				// free this alias, it didn't exist at init...
 				Con_DPrintf("Cmd_RestoreInitState: Destroying alias %s\n", a->name);
 				*ap = a->next;
+				Cmd_UnlinkAliasHash(cmd->userdefined, a);
 				if (a->value)
 					Z_Free(a->value);
 				Z_Free(a);
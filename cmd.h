@@ -78,6 +78,7 @@ typedef enum cmd_source_s
 typedef struct cmd_alias_s
 {
 	struct cmd_alias_s *next;
+	struct cmd_alias_s *hashnext;      ///< next alias in the same cmd_userdefined_t alias_hash bucket
 	char name[MAX_ALIAS_NAME];
 	char *value;
 	qbool initstate;           ///< indicates this command existed at init
@@ -88,6 +89,7 @@ typedef struct cmd_function_s
 {
 	unsigned flags;
 	struct cmd_function_s *next;
+	struct cmd_function_s *hashnext;   ///< next command in the same hash bucket
 	const char *name;
 	const char *description;
 	xcommand_t function;
@@ -102,9 +104,11 @@ typedef struct cmd_userdefined_s
 {
 	// csqc functions - this is a mess
 	cmd_function_t *qc_functions;
+	cmd_function_t *qc_functions_hash[CMD_HASHSIZE]; ///< case insensitive, see Cmd_HashName
 
 	// aliases
 	cmd_alias_t *alias;
+	cmd_alias_t *alias_hash[CMD_HASHSIZE]; ///< case insensitive, see Cmd_HashName
 }
 cmd_userdefined_t;
 
@@ -139,6 +143,7 @@ typedef struct cmd_state_s
 	cmd_userdefined_t *userdefined;   ///< possible csqc functions and aliases to execute
 
 	cmd_function_t *engine_functions;
+	cmd_function_t *engine_functions_hash[CMD_HASHSIZE]; ///< case insensitive, see Cmd_HashName
 
 	struct cvar_state_s *cvars;       ///< which cvar system is this cmd state able to access? (&cvars_all or &cvars_null)
 	unsigned cvars_flagsmask;         ///< which CVAR_* flags should be visible to this interpreter? (CF_CLIENT | CF_SERVER, or just CF_SERVER)
@@ -282,6 +287,9 @@ qbool Cmd_QuoteString(char *out, size_t outlen, const char *in, const char *quot
 
 void Cmd_ClearCSQCCommands (cmd_state_t *cmd);
 
+/// prints how many command lines were executed during Host_Init and how long they took (developer only)
+void Cmd_PrintInitStats(void);
+
 void Cmd_NoOperation_f(cmd_state_t *cmd);
 
 #endif
@@ -65,3 +65,56 @@ void EntityFrame_FetchFrame(entityframe_database_t *d, int framenum, entity_fram
 		VectorCopy(d->eye, f->eye);
 	}
 }
+
+// (client and server) packs entity angles as the three smallest components
+// of the rotation quaternion (10 bits each) plus the index of the largest
+// one (2 bits), used by PROTOCOL_DARKPLACES8
+unsigned int EntityState5_PackAngles(const float *angles)
+{
+	int i, largest, shift, q;
+	float quat[4], origin[3], sign;
+	unsigned int packed;
+	matrix4x4_t matrix;
+	Matrix4x4_CreateFromQuakeEntity(&matrix, 0, 0, 0, angles[0], angles[1], angles[2], 1);
+	Matrix4x4_ToOrigin3Quat4Float(&matrix, origin, quat);
+	largest = 0;
+	for (i = 1;i < 4;i++)
+		if (fabs(quat[i]) > fabs(quat[largest]))
+			largest = i;
+	// q and -q are the same rotation, so make the dropped one positive
+	sign = quat[largest] < 0 ? -1.0f : 1.0f;
+	packed = largest;
+	for (i = 0, shift = 2;i < 4;i++)
+	{
+		if (i == largest)
+			continue;
+		// the smaller components are within +-sqrt(0.5)
+		q = (int)floor((quat[i] * sign * 0.70710678f + 0.5f) * 1023.0f + 0.5f);
+		packed |= (unsigned int)bound(0, q, 1023) << shift;
+		shift += 10;
+	}
+	return packed;
+}
+
+// (client and server) reverses EntityState5_PackAngles, angles come out in
+// the 0-360 range
+void EntityState5_UnpackAngles(unsigned int packed, float *angles)
+{
+	int i, largest, shift;
+	float quat[4], sum = 0;
+	vec3_t forward, left, up, origin;
+	matrix4x4_t matrix;
+	largest = packed & 3;
+	for (i = 0, shift = 2;i < 4;i++)
+	{
+		if (i == largest)
+			continue;
+		quat[i] = (((packed >> shift) & 1023) * (2.0f / 1023.0f) - 1.0f) * 0.70710678f;
+		sum += quat[i] * quat[i];
+		shift += 10;
+	}
+	quat[largest] = sqrt(max(0.0f, 1.0f - sum));
+	Matrix4x4_FromOriginQuat(&matrix, 0, 0, 0, quat[0], quat[1], quat[2], quat[3]);
+	Matrix4x4_ToVectors(&matrix, forward, left, up, origin);
+	AnglesFromVectors(angles, forward, up, false);
+}
@@ -242,6 +242,24 @@ void MSG_WriteAngle (sizebuf_t *sb, float f, protocolversion_t protocol)
 		MSG_WriteAngle16i (sb, f);
 }
 
+// appends numbits (up to 32) bits of value, least significant bit first,
+// bitcount tracks the bit position within the last byte and must start at 0
+// for each run of bits, the run is padded to a whole byte when it ends
+void MSG_WriteBits (sizebuf_t *sb, unsigned int value, int numbits, int *bitcount)
+{
+	int n;
+	while (numbits > 0)
+	{
+		if (!(*bitcount & 7))
+			*SZ_GetSpace(sb, 1) = 0;
+		n = min(numbits, 8 - (*bitcount & 7));
+		sb->data[sb->cursize - 1] |= (value & ((1u << n) - 1)) << (*bitcount & 7);
+		value >>= n;
+		numbits -= n;
+		*bitcount += n;
+	}
+}
+
 //
 // reading functions
 //
@@ -361,6 +379,31 @@ size_t MSG_ReadString_len (sizebuf_t *sb, char *string, size_t maxstring)
 	return l;
 }
 
+// reverses MSG_WriteBits, returns 0 and sets badread if the message ends
+unsigned int MSG_ReadBits (sizebuf_t *sb, int numbits, int *bitcount)
+{
+	int n, shift = 0;
+	unsigned int value = 0;
+	while (numbits > 0)
+	{
+		if (!(*bitcount & 7))
+		{
+			if (sb->readcount >= sb->cursize)
+			{
+				sb->badread = true;
+				return 0;
+			}
+			sb->readcount++;
+		}
+		n = min(numbits, 8 - (*bitcount & 7));
+		value |= ((sb->data[sb->readcount - 1] >> (*bitcount & 7)) & ((1u << n) - 1)) << shift;
+		shift += n;
+		numbits -= n;
+		*bitcount += n;
+	}
+	return value;
+}
+
 size_t MSG_ReadBytes (sizebuf_t *sb, size_t numbytes, unsigned char *out)
 {
 	size_t l = 0;
@@ -0,0 +1,248 @@
+/*
+Copyright (C) 2000-2020 DarkPlaces contributors
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// com_rangecoder.c -- adaptive order-0 range coder for network messages
+
+#include "darkplaces.h"
+
+/*
+============================================================================
+
+					RANGE CODER
+
+carryless range coder (Subbotin) with an adaptive byte model, used by
+PROTOCOL_DARKPLACES8 to compress unreliable messages (svc_rangecoded).
+
+every message starts from the same prior which favors the byte values that
+dominate entity and stat updates (zero, small positive and negative deltas),
+so no model state has to survive packet loss.
+
+============================================================================
+*/
+
+#define RC_TOP (1u<<24)
+#define RC_BOT (1u<<16)
+// total frequency must stay <= RC_BOT so range / total never reaches zero
+#define RC_MAXTOTAL RC_BOT
+#define RC_INCREMENT 24
+
+typedef struct rangemodel_s
+{
+	unsigned int freq[256];
+	// fenwick tree of freq[], 1 based
+	unsigned int tree[257];
+	unsigned int total;
+}
+rangemodel_t;
+
+typedef struct rangecoder_s
+{
+	unsigned int low;
+	unsigned int range;
+	unsigned int code;
+	unsigned char *data;
+	int pos;
+	int size;
+	qbool overflow;
+}
+rangecoder_t;
+
+static unsigned int rangemodel_prior[256];
+
+static void RangeModel_Build(rangemodel_t *m)
+{
+	int i, j;
+	memset(m->tree, 0, sizeof(m->tree));
+	m->total = 0;
+	for (i = 0;i < 256;i++)
+	{
+		m->total += m->freq[i];
+		for (j = i + 1;j <= 256;j += j & -j)
+			m->tree[j] += m->freq[i];
+	}
+}
+
+static void RangeModel_Init(rangemodel_t *m)
+{
+	int i, d;
+	if (!rangemodel_prior[0])
+	{
+		for (i = 0;i < 256;i++)
+		{
+			// distance from zero if the byte is read as signed
+			d = min(i, 256 - i);
+			rangemodel_prior[i] = d ? 1 + 32 / d : 64;
+		}
+		// high bit flags (E5_EXTEND1 and friends)
+		rangemodel_prior[0x80] += 8;
+	}
+	memcpy(m->freq, rangemodel_prior, sizeof(m->freq));
+	RangeModel_Build(m);
+}
+
+static unsigned int RangeModel_CumFreq(const rangemodel_t *m, int symbol)
+{
+	unsigned int sum = 0;
+	for (;symbol > 0;symbol -= symbol & -symbol)
+		sum += m->tree[symbol];
+	return sum;
+}
+
+// returns the symbol whose cumulative range contains target, and changes
+// target to the cumulative frequency below that symbol
+static int RangeModel_Find(const rangemodel_t *m, unsigned int *target)
+{
+	int pos = 0, step;
+	unsigned int remaining = *target;
+	for (step = 256;step;step >>= 1)
+	{
+		if (pos + step <= 256 && m->tree[pos + step] <= remaining)
+		{
+			pos += step;
+			remaining -= m->tree[pos];
+		}
+	}
+	*target -= remaining;
+	return pos;
+}
+
+static void RangeModel_Update(rangemodel_t *m, int symbol)
+{
+	int j;
+	m->freq[symbol] += RC_INCREMENT;
+	m->total += RC_INCREMENT;
+	for (j = symbol + 1;j <= 256;j += j & -j)
+		m->tree[j] += RC_INCREMENT;
+	if (m->total > RC_MAXTOTAL)
+	{
+		for (j = 0;j < 256;j++)
+			m->freq[j] = (m->freq[j] + 1) >> 1;
+		RangeModel_Build(m);
+	}
+}
+
+static void RangeCoder_PutByte(rangecoder_t *rc, unsigned char c)
+{
+	if (rc->pos < rc->size)
+		rc->data[rc->pos++] = c;
+	else
+		rc->overflow = true;
+}
+
+static unsigned char RangeCoder_GetByte(rangecoder_t *rc)
+{
+	if (rc->pos < rc->size)
+		return rc->data[rc->pos++];
+	rc->overflow = true;
+	return 0;
+}
+
+static void RangeCoder_Encode(rangecoder_t *rc, unsigned int cumfreq, unsigned int freq, unsigned int total)
+{
+	rc->range /= total;
+	rc->low += cumfreq * rc->range;
+	rc->range *= freq;
+	while ((rc->low ^ (rc->low + rc->range)) < RC_TOP || (rc->range < RC_BOT && ((rc->range = (0u - rc->low) & (RC_BOT - 1)), 1)))
+	{
+		RangeCoder_PutByte(rc, rc->low >> 24);
+		rc->low <<= 8;
+		rc->range <<= 8;
+	}
+}
+
+static void RangeCoder_Decode(rangecoder_t *rc, unsigned int cumfreq, unsigned int freq)
+{
+	rc->low += cumfreq * rc->range;
+	rc->range *= freq;
+	while ((rc->low ^ (rc->low + rc->range)) < RC_TOP || (rc->range < RC_BOT && ((rc->range = (0u - rc->low) & (RC_BOT - 1)), 1)))
+	{
+		rc->code = (rc->code << 8) | RangeCoder_GetByte(rc);
+		rc->low <<= 8;
+		rc->range <<= 8;
+	}
+}
+
+/*
+============
+RangeCoder_Compress
+
+Returns the number of bytes written to out, or -1 if the output would not fit
+in outsize (so passing insize - 1 only succeeds if the data got smaller)
+============
+*/
+int RangeCoder_Compress(const unsigned char *in, int insize, unsigned char *out, int outsize)
+{
+	int i;
+	rangemodel_t model;
+	rangecoder_t rc;
+
+	RangeModel_Init(&model);
+	memset(&rc, 0, sizeof(rc));
+	rc.range = 0xFFFFFFFFu;
+	rc.data = out;
+	rc.size = outsize;
+	for (i = 0;i < insize && !rc.overflow;i++)
+	{
+		RangeCoder_Encode(&rc, RangeModel_CumFreq(&model, in[i]), model.freq[in[i]], model.total);
+		RangeModel_Update(&model, in[i]);
+	}
+	// flush
+	for (i = 0;i < 4;i++)
+	{
+		RangeCoder_PutByte(&rc, rc.low >> 24);
+		rc.low <<= 8;
+	}
+	return rc.overflow ? -1 : rc.pos;
+}
+
+/*
+============
+RangeCoder_Decompress
+
+Decodes exactly outsize bytes, returns outsize or -1 if the input was too
+short (corrupt message)
+============
+*/
+int RangeCoder_Decompress(const unsigned char *in, int insize, unsigned char *out, int outsize)
+{
+	int i, symbol;
+	unsigned int target;
+	rangemodel_t model;
+	rangecoder_t rc;
+
+	RangeModel_Init(&model);
+	memset(&rc, 0, sizeof(rc));
+	rc.range = 0xFFFFFFFFu;
+	rc.data = (unsigned char *)in;
+	rc.size = insize;
+	for (i = 0;i < 4;i++)
+		rc.code = (rc.code << 8) | RangeCoder_GetByte(&rc);
+	for (i = 0;i < outsize && !rc.overflow;i++)
+	{
+		rc.range /= model.total;
+		target = (rc.code - rc.low) / rc.range;
+		if (target >= model.total)
+			return -1;
+		symbol = RangeModel_Find(&model, &target);
+		RangeCoder_Decode(&rc, target, model.freq[symbol]);
+		out[i] = symbol;
+		RangeModel_Update(&model, symbol);
+	}
+	return rc.overflow ? -1 : outsize;
+}
@@ -68,6 +68,10 @@ unsigned short CRC_Block_CaseInsensitive(const unsigned char *data, size_t size)
 
 unsigned char COM_BlockSequenceCRCByteQW(unsigned char *base, int length, int sequence);
 
+// adaptive range coder used by svc_rangecoded (com_rangecoder.c)
+int RangeCoder_Compress(const unsigned char *in, int insize, unsigned char *out, int outsize);
+int RangeCoder_Decompress(const unsigned char *in, int insize, unsigned char *out, int outsize);
+
 // these are actually md4sum (mdfour.c)
 unsigned Com_BlockChecksum (void *buffer, int length);
 void Com_BlockFullChecksum (void *buffer, int len, unsigned char *outbuf);
@@ -167,6 +171,7 @@ void MSG_WriteCoord32f (sizebuf_t *sb, vec_t f);
 void MSG_WriteCoord (sizebuf_t *sb, vec_t f, protocolversion_t protocol);
 void MSG_WriteVector (sizebuf_t *sb, const vec3_t v, protocolversion_t protocol);
 void MSG_WriteAngle (sizebuf_t *sb, vec_t f, protocolversion_t protocol);
+void MSG_WriteBits (sizebuf_t *sb, unsigned int value, int numbits, int *bitcount);
 
 void MSG_BeginReading (sizebuf_t *sb);
 int MSG_ReadLittleShort (sizebuf_t *sb);
@@ -179,6 +184,7 @@ char *MSG_ReadString (sizebuf_t *sb, char *string, size_t maxstring);
 /// Same as MSG_ReadString except it returns the number of bytes written to *string excluding the \0 terminator.
 size_t MSG_ReadString_len (sizebuf_t *sb, char *string, size_t maxstring);
 size_t MSG_ReadBytes (sizebuf_t *sb, size_t numbytes, unsigned char *out);
+unsigned int MSG_ReadBits (sizebuf_t *sb, int numbits, int *bitcount);
 
 #define MSG_ReadChar(sb) ((sb)->readcount >= (sb)->cursize ? ((sb)->badread = true, -1) : (signed char)(sb)->data[(sb)->readcount++])
 #define MSG_ReadByte(sb) ((sb)->readcount >= (sb)->cursize ? ((sb)->badread = true, -1) : (unsigned char)(sb)->data[(sb)->readcount++])
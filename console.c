@@ -404,6 +404,8 @@ LOGGING
 //@{
 cvar_t log_file = {CF_CLIENT | CF_SERVER, "log_file", "", "filename to log messages to"};
 cvar_t log_file_stripcolors = {CF_CLIENT | CF_SERVER, "log_file_stripcolors", "0", "strip color codes from log messages"};
+cvar_t log_file_maxsize = {CF_CLIENT | CF_SERVER, "log_file_maxsize", "0", "once log_file grows past this many KiB it is renamed to <log_file>.1 (older ones move on to .2 and so on) and a new one is started, 0 = no limit"};
+cvar_t log_file_rotate = {CF_CLIENT | CF_SERVER, "log_file_rotate", "3", "how many old log files to keep when log_file_maxsize is reached"};
 cvar_t log_dest_udp = {CF_CLIENT | CF_SERVER, "log_dest_udp", "", "UDP address to log messages to (in QW rcon compatible format); multiple destinations can be separated by spaces; DO NOT SPECIFY DNS NAMES HERE"};
 char log_dest_buffer[1400]; // UDP packet
 size_t log_dest_buffer_pos;
@@ -415,6 +417,20 @@ unsigned char* logqueue = NULL;
 size_t logq_ind = 0;
 size_t logq_size = 0;
 
+// while log_file is open, lines are queued in a ring buffer and written out
+// in batches by a writer thread (see Log_Thread)
+#define LOG_RING_SIZE (256 << 10)
+static char log_ring[LOG_RING_SIZE];
+static size_t log_ring_head = 0; ///< total bytes queued
+static size_t log_ring_tail = 0; ///< total bytes taken by the writer
+static void *log_mutex = NULL;
+static void *log_cond = NULL;
+static void *log_thread = NULL;
+static qbool log_thread_quit = false;
+static fs_offset_t log_file_size = 0;
+static qbool log_rotate_failed = false; ///< don't retry until the log is reopened
+static char log_sanitizebuf[MAX_INPUTLINE];
+
 void Log_ConPrint (const char *msg);
 //@}
 static void Log_DestBuffer_Init(void)
@@ -500,16 +516,203 @@ static const char* Log_Timestamp (const char *desc)
 	return timestamp;
 }
 
+/*
+====================
+Log_Rotate
+
+Moves the full log to <log_file>.1 (and the older ones one number up) and
+starts a new one.  Holds log_mutex so logfile is never seen closed by anyone
+else, and if the new file can't be created the old one is reopened so no
+lines are lost.
+====================
+*/
+static void Log_Rotate (void)
+{
+	char path[MAX_OSPATH], from[MAX_OSPATH], to[MAX_OSPATH];
+	int i, count = bound(0, log_file_rotate.integer, 99);
+	qfile_t *newfile;
+
+	if (log_rotate_failed)
+		return;
+
+	if (log_mutex)
+		Thread_LockMutex(log_mutex);
+	FS_Close (logfile);
+
+	dpsnprintf (path, sizeof (path), "%s/%s", fs_gamedir, crt_log_file);
+	if (count > 0)
+	{
+		dpsnprintf (to, sizeof (to), "%s.%i", path, count);
+		remove (to);
+		for (i = count - 1;i >= 1;i--)
+		{
+			dpsnprintf (from, sizeof (from), "%s.%i", path, i);
+			dpsnprintf (to, sizeof (to), "%s.%i", path, i + 1);
+			rename (from, to);
+		}
+		dpsnprintf (to, sizeof (to), "%s.1", path);
+		rename (path, to);
+	}
+	else
+		remove (path);
+
+	newfile = FS_OpenRealFile(crt_log_file, "a", true);
+	if (newfile)
+		log_file_size = 0;
+	else
+	{
+		// keep appending to the old one (which is gone if log_file_rotate is 0)
+		log_rotate_failed = true;
+		dpsnprintf (to, sizeof (to), "%s.1", crt_log_file);
+		newfile = FS_OpenRealFile(count > 0 ? to : crt_log_file, "a", true);
+	}
+	logfile = newfile;
+	if (log_mutex)
+		Thread_UnlockMutex(log_mutex);
+
+	// straight to the terminal, Con_Printf would queue to this thread
+	if (log_rotate_failed)
+		Sys_Printf ("WARNING: could not start a new %s, %s\n", crt_log_file, logfile ? "appending to the old one" : "logging stopped");
+}
+
+/*
+====================
+Log_WriteToFile
+
+Only called by the writer thread, or with no writer thread running
+====================
+*/
+static void Log_WriteToFile (const char *data, size_t len)
+{
+	if (logfile == NULL || !len)
+		return;
+	FS_Write (logfile, data, len);
+	log_file_size += len;
+	if (log_file_maxsize.integer > 0 && log_file_size >= (fs_offset_t)log_file_maxsize.integer << 10)
+		Log_Rotate ();
+}
+
+/*
+====================
+Log_Thread
+
+Writes out everything that was queued since the last batch with at most two
+writes (the ring buffer may wrap around), and only quits once the queue is
+empty
+====================
+*/
+static int Log_Thread (void *unused)
+{
+	size_t start, end, pos;
+
+	Thread_LockMutex(log_mutex);
+	for (;;)
+	{
+		if (log_ring_head == log_ring_tail)
+		{
+			if (log_thread_quit)
+				break;
+			Thread_CondWait(log_cond, log_mutex);
+			continue;
+		}
+		start = log_ring_tail;
+		end = log_ring_head;
+		Thread_UnlockMutex(log_mutex);
+
+		pos = start % LOG_RING_SIZE;
+		if (pos + (end - start) > LOG_RING_SIZE)
+		{
+			Log_WriteToFile (log_ring + pos, LOG_RING_SIZE - pos);
+			Log_WriteToFile (log_ring, end - start - (LOG_RING_SIZE - pos));
+		}
+		else
+			Log_WriteToFile (log_ring + pos, end - start);
+
+		Thread_LockMutex(log_mutex);
+		log_ring_tail = end;
+		// wake up anyone waiting for room
+		Thread_CondBroadcast(log_cond);
+	}
+	Thread_UnlockMutex(log_mutex);
+	return 0;
+}
+
+/*
+====================
+Log_Write
+
+Queues data for the writer thread, only blocks if the ring buffer is full
+====================
+*/
+static void Log_Write (const char *data, size_t len)
+{
+	size_t pos, n;
+
+	if (!log_thread)
+	{
+		Log_WriteToFile (data, len);
+		return;
+	}
+
+	Thread_LockMutex(log_mutex);
+	while (len)
+	{
+		if (log_ring_head - log_ring_tail == LOG_RING_SIZE)
+		{
+			Thread_CondWait(log_cond, log_mutex);
+			continue;
+		}
+		pos = log_ring_head % LOG_RING_SIZE;
+		n = min(len, LOG_RING_SIZE - (log_ring_head - log_ring_tail));
+		n = min(n, LOG_RING_SIZE - pos);
+		memcpy (log_ring + pos, data, n);
+		log_ring_head += n;
+		data += n;
+		len -= n;
+	}
+	Thread_CondBroadcast(log_cond);
+	Thread_UnlockMutex(log_mutex);
+}
+
+static void Log_StartThread (void)
+{
+	if (log_thread || !Thread_HasThreads())
+		return;
+	if (!log_mutex)
+	{
+		log_mutex = Thread_CreateMutex();
+		log_cond = Thread_CreateCond();
+	}
+	log_thread_quit = false;
+	log_thread = Thread_CreateThread(Log_Thread, NULL);
+}
+
+// waits until everything queued so far is written
+static void Log_StopThread (void)
+{
+	if (!log_thread)
+		return;
+	Thread_LockMutex(log_mutex);
+	log_thread_quit = true;
+	Thread_CondBroadcast(log_cond);
+	Thread_UnlockMutex(log_mutex);
+	Thread_WaitThread(log_thread, 0);
+	log_thread = NULL;
+}
+
 static void Log_Open (void)
 {
-	if (logfile != NULL || log_file.string[0] == '\0')
+	if (crt_log_file[0] || log_file.string[0] == '\0')
 		return;
 
 	logfile = FS_OpenRealFile(log_file.string, "a", false);
 	if (logfile != NULL)
 	{
 		dp_strlcpy (crt_log_file, log_file.string, sizeof (crt_log_file));
+		log_file_size = FS_FileSize (logfile);
+		log_rotate_failed = false;
 		FS_Print (logfile, Log_Timestamp ("Log started"));
+		Log_StartThread ();
 	}
 }
 
@@ -520,8 +723,13 @@ Log_Close
 */
 void Log_Close (void)
 {
-	qfile_t* l = logfile;
+	qfile_t* l;
 
+	Log_StopThread ();
+	// a failed rotation leaves no file open, but the name must still be
+	// cleared or Log_ConPrint keeps trying to reopen it
+	crt_log_file[0] = '\0';
+	l = logfile;
 	if (l == NULL)
 		return;
 
@@ -529,8 +737,6 @@ void Log_Close (void)
 	FS_Print (l, "\n");
 	logfile = NULL;
 	FS_Close (l);
-
-	crt_log_file[0] = '\0';
 }
 
 
@@ -552,8 +758,8 @@ void Log_Start (void)
 		logqueue = NULL;
 		if(logq_ind != 0)
 		{
-			if (logfile != NULL)
-				FS_Write (logfile, temp, logq_ind);
+			if (crt_log_file[0])
+				Log_Write ((const char *)temp, logq_ind);
 			if(*log_dest_udp.string)
 			{
 				for(pos = 0; pos < logq_ind; )
@@ -624,23 +830,19 @@ void Log_ConPrint (const char *msg)
 		Log_Open ();
 	}
 
-	// If a log file is available
-	if (logfile != NULL)
+	// If a log file is available (crt_log_file only changes while the writer
+	// thread is stopped, unlike logfile which it swaps when rotating)
+	if (crt_log_file[0])
 	{
 		if (log_file_stripcolors.integer)
 		{
-			// sanitize msg
-			size_t len = strlen(msg);
-			char* sanitizedmsg = (char*)Mem_Alloc(tempmempool, len + 1);
-			memcpy (sanitizedmsg, msg, len);
-			SanitizeString(sanitizedmsg, sanitizedmsg); // SanitizeString's in pointer is always ahead of the out pointer, so this should work.
-			FS_Print (logfile, sanitizedmsg);
-			Mem_Free(sanitizedmsg);
-		}
-		else 
-		{
-			FS_Print (logfile, msg);
+			// sanitize msg (Con_MaskPrint lines always fit, and it holds
+			// con_mutex so the buffer can be shared)
+			dp_strlcpy (log_sanitizebuf, msg, sizeof (log_sanitizebuf));
+			SanitizeString(log_sanitizebuf, log_sanitizebuf); // SanitizeString's in pointer is always ahead of the out pointer, so this should work.
+			msg = log_sanitizebuf;
 		}
+		Log_Write (msg, strlen (msg));
 	}
 
 	inprogress = false;
@@ -884,6 +1086,8 @@ void Con_Init (void)
 
 	Cvar_RegisterVariable (&log_file);
 	Cvar_RegisterVariable (&log_file_stripcolors);
+	Cvar_RegisterVariable (&log_file_maxsize);
+	Cvar_RegisterVariable (&log_file_rotate);
 	Cvar_RegisterVariable (&log_dest_udp);
 
 	// support for the classic Quake option
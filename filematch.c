@@ -78,6 +78,119 @@ int matchpattern_with_separator(const char *in, const char *pattern, int caseins
 	return 1; // success
 }
 
+qbool matchpattern_compile(matchpattern_compiled_t *compiled, const char *pattern, int caseinsensitive, const char *separators, qbool wildcard_least_one)
+{
+	int i, length = (int)strlen(pattern);
+	if (length >= (int)sizeof(compiled->pattern))
+		return false;
+	memset(compiled, 0, sizeof(*compiled));
+	compiled->caseinsensitive = caseinsensitive;
+	compiled->wildcard_least_one = wildcard_least_one;
+	for (i = 0;i <= length;i++)
+	{
+		int c = pattern[i];
+		if (caseinsensitive && c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		compiled->pattern[i] = c;
+	}
+	for (;*separators;separators++)
+		compiled->separator[(unsigned char)*separators] = true;
+	for (i = 0;i < length && pattern[i] != '*' && pattern[i] != '?';i++)
+		;
+	compiled->prefixlength = i;
+	compiled->haswildcard = i < length;
+	if (compiled->haswildcard)
+		for (i = length;i > 0 && pattern[i - 1] != '*' && pattern[i - 1] != '?';i--)
+			compiled->suffixlength++;
+	return true;
+}
+
+static int matchpattern_compiled_r(const unsigned char *in, const char *pattern, const matchpattern_compiled_t *compiled)
+{
+	int c;
+	while (*pattern)
+	{
+		switch (*pattern)
+		{
+		case '?': // match any single character
+			if (*in == 0 || compiled->separator[*in])
+				return 0; // no match
+			in++;
+			pattern++;
+			break;
+		case '*': // match anything until following string
+			if (compiled->wildcard_least_one)
+			{
+				if (*in == 0 || compiled->separator[*in])
+					return 0; // no match
+				in++;
+			}
+			pattern++;
+			// a trailing * matches the rest of this path element
+			if (!*pattern)
+			{
+				for (;*in;in++)
+					if (compiled->separator[*in])
+						return 0;
+				return 1;
+			}
+			while (*in)
+			{
+				if (compiled->separator[*in])
+					break;
+				// see if pattern matches at this offset
+				if (matchpattern_compiled_r(in, pattern, compiled))
+					return 1;
+				// nope, advance to next offset
+				in++;
+			}
+			break;
+		default:
+			c = *in;
+			if (compiled->caseinsensitive && c >= 'A' && c <= 'Z')
+				c += 'a' - 'A';
+			if (c != *pattern)
+				return 0; // no match
+			in++;
+			pattern++;
+			break;
+		}
+	}
+	if (*in)
+		return 0; // reached end of pattern but not end of input
+	return 1; // success
+}
+
+int matchpattern_compiled(const char *in, const matchpattern_compiled_t *compiled)
+{
+	int i, c, length;
+	const char *tail;
+	if (!compiled->haswildcard)
+		return compiled->caseinsensitive ? !strcasecmp(in, compiled->pattern) : !strcmp(in, compiled->pattern);
+	// reject on the literal prefix and suffix before trying the wildcards
+	for (i = 0;i < compiled->prefixlength;i++)
+	{
+		c = in[i];
+		if (compiled->caseinsensitive && c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		if (c != compiled->pattern[i])
+			return 0;
+	}
+	length = (int)strlen(in);
+	if (length < compiled->prefixlength + compiled->suffixlength)
+		return 0;
+	tail = compiled->pattern + strlen(compiled->pattern) - compiled->suffixlength;
+	for (i = 0;i < compiled->suffixlength;i++)
+	{
+		c = in[length - compiled->suffixlength + i];
+		if (compiled->caseinsensitive && c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		if (c != tail[i])
+			return 0;
+	}
+	return matchpattern_compiled_r((const unsigned char *)in + compiled->prefixlength, compiled->pattern + compiled->prefixlength, compiled);
+}
+
 // a little strings system
 void stringlistinit(stringlist_t *list)
 {
@@ -33,6 +33,27 @@ typedef struct stringlist_s
 
 int matchpattern(const char *in, const char *pattern, int caseinsensitive);
 int matchpattern_with_separator(const char *in, const char *pattern, int caseinsensitive, const char *separators, qbool wildcard_least_one);
+
+#define MATCHPATTERN_MAXLENGTH 1024
+
+/// a pattern prepared for matching against many names, see matchpattern_compile
+typedef struct matchpattern_compiled_s
+{
+	char pattern[MATCHPATTERN_MAXLENGTH]; ///< lowercase if caseinsensitive
+	int caseinsensitive;
+	qbool wildcard_least_one;
+	qbool separator[256];
+	/// literal characters before the first wildcard, every match starts with them
+	int prefixlength;
+	/// literal characters after the last wildcard, every match ends with them
+	int suffixlength;
+	qbool haswildcard;
+} matchpattern_compiled_t;
+
+/// returns false if the pattern is too long, use matchpattern_with_separator then
+qbool matchpattern_compile(matchpattern_compiled_t *compiled, const char *pattern, int caseinsensitive, const char *separators, qbool wildcard_least_one);
+/// same result as matchpattern_with_separator with the arguments given to matchpattern_compile
+int matchpattern_compiled(const char *in, const matchpattern_compiled_t *compiled);
 void stringlistinit(stringlist_t *list);
 void stringlistfreecontents(stringlist_t *list);
 void stringlistappend(stringlist_t *list, const char *text);
@@ -35,6 +35,7 @@
 # include <pwd.h>
 # include <sys/stat.h>
 # include <unistd.h>
+# include <sys/mman.h>
 #endif
 
 #include "quakedef.h"
@@ -113,6 +114,10 @@ typedef int filedesc_t;
 static filedesc_t FILEDESC_DUP(const char *filename, filedesc_t fd) {
 	return dup(fd);
 }
+# ifndef WIN32
+/// packs are memory mapped so stored files can be read without syscalls
+#  define FS_PACKMMAP 1
+# endif
 #endif
 
 
@@ -300,13 +305,17 @@ typedef struct
 #define QFILE_FLAG_REMOVE (1 << 3)
 
 #define FILE_BUFF_SIZE 2048
+/// the compressed input buffer doubles up to this size while a file is read sequentially
+#define ZBUFF_MAXSIZE (256 << 10)
 typedef struct
 {
 	z_stream	zstream;
 	size_t		comp_length;			///< length of the compressed file
 	size_t		in_ind, in_len;			///< input buffer current index and length
 	size_t		in_position;			///< position in the compressed file
-	unsigned char		input [FILE_BUFF_SIZE];
+	const unsigned char	*input;			///< into inputbuffer, or the pack mapping
+	unsigned char		*inputbuffer;
+	size_t		inputsize;				///< allocated size of inputbuffer
 } ztoolkit_t;
 
 struct qfile_s
@@ -325,6 +334,7 @@ struct qfile_s
 	ztoolkit_t*		ztk;	///< For zipped files.
 
 	const unsigned char *data;	///< For data files.
+	struct fs_packmap_s *map;	///< data (or compressed input) is read from this memory mapped pack
 
 	const char *filename; ///< Kept around for QFILE_FLAG_REMOVE, unused otherwise
 };
@@ -382,11 +392,21 @@ typedef struct packfile_s
 	fs_offset_t realsize;	///< real file size (uncompressed)
 } packfile_t;
 
+/// a whole pack file mapped into memory, shared by the pack and every file
+/// opened from it so it stays valid after the pack is unloaded
+typedef struct fs_packmap_s
+{
+	const unsigned char *data;
+	size_t size;
+	Thread_Atomic refcount;
+} fs_packmap_t;
+
 typedef struct pack_s
 {
 	char filename [MAX_OSPATH];
 	char shortname [MAX_QPATH];
 	filedesc_t handle;
+	fs_packmap_t *map; ///< NULL if the pack is read with FILEDESC_READ
 	qbool ignorecase;  ///< PK3 ignores case
 	int numfiles;
 	qbool vpack;
@@ -418,9 +438,14 @@ void FS_Ls_f(cmd_state_t *cmd);
 void FS_Which_f(cmd_state_t *cmd);
 
 static searchpath_t *FS_FindFile (const char *name, int *index, const char **canonicalname, qbool quiet);
+static void FS_InvalidateIndex (void);
+static void FS_ClearNegativeCache (void);
+static void FS_ClearPrefetch (const char *ospath);
+static void FS_Prefetch_Stop (void);
 static packfile_t* FS_AddFileToPack (const char* name, pack_t* pack,
 									fs_offset_t offset, fs_offset_t packsize,
 									fs_offset_t realsize, int flags);
+static void FS_SortPackFiles (pack_t *pack);
 
 
 /*
@@ -437,6 +462,86 @@ void *fs_mutex = NULL;
 searchpath_t *fs_searchpaths = NULL;
 const char *const fs_checkgamedir_missing = "missing";
 
+/// merged index of all files in the packs of fs_searchpaths, see FS_BuildIndex
+typedef struct fs_indexentry_s
+{
+	struct fs_indexentry_s *next;
+	searchpath_t *search;
+	int index; ///< into search->pack->files
+} fs_indexentry_t;
+
+/// name that was not found anywhere, see FS_ClearNegativeCache
+typedef struct fs_negativeentry_s
+{
+	struct fs_negativeentry_s *next;
+	char name[1]; ///< allocated to fit
+} fs_negativeentry_t;
+
+#define FS_NEGATIVECACHE_HASHSIZE 1024
+#define FS_NEGATIVECACHE_MAX 8192
+
+static void *fs_index_mutex = NULL;
+static qbool fs_index_valid = false;
+static fs_indexentry_t *fs_index_entries = NULL;
+static fs_indexentry_t **fs_index_hash = NULL;
+static unsigned int fs_index_hashsize = 0;
+static fs_negativeentry_t *fs_negativecache_hash[FS_NEGATIVECACHE_HASHSIZE];
+static int fs_negativecache_count = 0;
+
+/// file being read ahead by the prefetch threads, see FS_PrefetchAsync
+typedef enum fs_prefetchstate_e
+{
+	FS_PREFETCH_QUEUED,
+	FS_PREFETCH_LOADING,
+	FS_PREFETCH_DONE,
+	FS_PREFETCH_CANCELLED ///< unlinked while loading, the thread frees it
+} fs_prefetchstate_t;
+
+typedef struct fs_prefetch_s
+{
+	struct fs_prefetch_s *next;
+	fs_prefetchstate_t state;
+	char name[MAX_QPATH]; ///< as passed to FS_LoadFile
+	char sourcepath[MAX_OSPATH]; ///< loose file, or the pack it is stored in
+	struct fs_packmap_s *map; ///< reference on the pack mapping if there is one
+	fs_offset_t offset; ///< -1 for loose files
+	fs_offset_t packsize;
+	fs_offset_t realsize;
+	qbool deflated;
+	unsigned char *data; ///< fs_mempool, NULL if loading failed
+	fs_offset_t filesize;
+} fs_prefetch_t;
+
+#define FS_PREFETCH_MAXTHREADS 8
+
+static void *fs_prefetch_mutex = NULL;
+static void *fs_prefetch_cond = NULL;
+static void *fs_prefetch_threads[FS_PREFETCH_MAXTHREADS];
+static int fs_prefetch_numthreads = 0;
+static qbool fs_prefetch_quit = false;
+static fs_prefetch_t *fs_prefetch_list = NULL;
+static fs_offset_t fs_prefetch_bytes = 0;
+
+/// parsed PK3 directory remembered across runs, see FS_PackCache_Load
+typedef struct fs_packcache_s
+{
+	struct fs_packcache_s *next;
+	char filename[MAX_OSPATH];
+	long long filesize;
+	long long filetime;
+	qbool used; ///< written back by FS_PackCache_Save
+	int numfiles;
+	packfile_t *files;
+} fs_packcache_t;
+
+#define FS_PACKCACHE_MAGIC "DPPACKCACHE1"
+
+static fs_packcache_t *fs_packcache = NULL;
+static qbool fs_packcache_loaded = false;
+static qbool fs_packcache_dirty = false;
+static int fs_packcache_hits = 0;
+static int fs_packcache_misses = 0;
+
 #define MAX_FILES_IN_PACK	65536
 
 char fs_userdir[MAX_OSPATH];
@@ -456,6 +561,9 @@ cvar_t scr_screenshot_name = {CF_CLIENT | CF_PERSISTENT, "scr_screenshot_name","
 cvar_t fs_empty_files_in_pack_mark_deletions = {CF_CLIENT | CF_SERVER, "fs_empty_files_in_pack_mark_deletions", "0", "if enabled, empty files in a pak/pk3 count as not existing but cancel the search in further packs, effectively allowing patch pak/pk3 files to 'delete' files"};
 cvar_t fs_unload_dlcache = {CF_CLIENT, "fs_unload_dlcache", "1", "if enabled, unload dlcache's loaded pak/pk3 files when changing server and/or map WARNING: disabling unloading can cause servers to override assets of other servers, \"memory leaking\" by dlcache assets never unloading and many more issues"};
 cvar_t cvar_fs_gamedir = {CF_CLIENT | CF_SERVER | CF_READONLY | CF_PERSISTENT, "fs_gamedir", "", "the list of currently selected gamedirs (use the 'gamedir' command to change this)"};
+cvar_t fs_negativecache = {CF_CLIENT | CF_SERVER, "fs_negativecache", "1", "remember names of files that do not exist (cleared by fs_rescan, map changes and files written by the engine), disable if you add files to the game directories while the game is running"};
+cvar_t fs_prefetch = {CF_CLIENT | CF_SERVER | CF_ARCHIVE, "fs_prefetch", "2", "number of threads reading and decompressing precached files ahead of time while a map loads, 0 disables"};
+cvar_t fs_prefetch_maxmb = {CF_CLIENT | CF_SERVER | CF_ARCHIVE, "fs_prefetch_maxmb", "256", "stop reading ahead once this many megabytes of prefetched files are waiting to be used"};
 
 
 /*
@@ -822,6 +930,7 @@ static int PK3_BuildFileList (pack_t *pack, const pk3_endOfCentralDir_t *eocd)
 	// If the package is empty, central_dir is NULL here
 	if (central_dir != NULL)
 		Mem_Free (central_dir);
+	FS_SortPackFiles (pack);
 	return pack->numfiles;
 }
 
@@ -887,14 +996,287 @@ static pack_t *FS_LoadPackPK3FromFD (const char *packfile, filedesc_t packhandle
 	return pack;
 }
 
+
+/*
+====================
+FS_SysFileStat
+
+Size and modification time of an OS file, false if it can't be found
+====================
+*/
+qbool FS_SysFileStat (const char *path, long long *filesize, long long *filetime)
+{
+#ifdef WIN32
+	struct _stat64 st;
+	WPATHDEF(pathw);
+
+	WIDE(path, pathw);
+	if (_wstat64(pathw, &st) == -1)
+		return false;
+#else
+	struct stat st;
+
+	if (stat(path, &st) == -1)
+		return false;
+#endif
+	*filesize = st.st_size;
+	*filetime = st.st_mtime;
+	return true;
+}
+
+static void FS_PackCache_Path (char *path, size_t pathsize)
+{
+	dpsnprintf(path, pathsize, "%spackcache.dat", *fs_userdir ? fs_userdir : fs_basedir);
+}
+
+/*
+====================
+FS_PackCache_Load
+
+Reads the directories of the PK3 files parsed by an earlier run, keyed on their
+path, size and modification time. Only used with -packcache.
+====================
+*/
+static void FS_PackCache_Load (void)
+{
+	char path[MAX_OSPATH];
+	unsigned char *buf, *p, *end;
+	fs_offset_t bufsize;
+	fs_packcache_t *entry, *list = NULL;
+	int i, len, numentries = 0;
+	qbool ok = true;
+
+	fs_packcache_loaded = true;
+	FS_PackCache_Path(path, sizeof(path));
+	if (!(buf = FS_SysLoadFile(path, tempmempool, true, &bufsize)))
+		return;
+	end = buf + bufsize;
+	p = buf + strlen(FS_PACKCACHE_MAGIC);
+	if (bufsize < (fs_offset_t)strlen(FS_PACKCACHE_MAGIC) || memcmp(buf, FS_PACKCACHE_MAGIC, strlen(FS_PACKCACHE_MAGIC)))
+		ok = false;
+	while (ok && p < end)
+	{
+		if (end - p < 2 || (len = (unsigned short)BuffLittleShort(p)) >= MAX_OSPATH || end - p < 2 + len + 20)
+		{
+			ok = false;
+			break;
+		}
+		entry = (fs_packcache_t *)Mem_Alloc(fs_mempool, sizeof(*entry));
+		entry->next = list;
+		list = entry;
+		memcpy(entry->filename, p + 2, len);
+		p += 2 + len;
+		entry->filesize = (long long)(unsigned int)BuffLittleLong(p) | ((long long)BuffLittleLong(p + 4) << 32);
+		entry->filetime = (long long)(unsigned int)BuffLittleLong(p + 8) | ((long long)BuffLittleLong(p + 12) << 32);
+		entry->numfiles = BuffLittleLong(p + 16);
+		p += 20;
+		if (entry->numfiles < 0 || entry->numfiles > MAX_FILES_IN_PACK)
+		{
+			ok = false;
+			break;
+		}
+		entry->files = (packfile_t *)Mem_Alloc(fs_mempool, max(entry->numfiles, 1) * sizeof(*entry->files));
+		for (i = 0;i < entry->numfiles;i++)
+		{
+			if (end - p < 1 || (len = p[0]) >= MAX_QPATH || end - p < 1 + len + 16)
+			{
+				ok = false;
+				break;
+			}
+			memcpy(entry->files[i].name, p + 1, len);
+			p += 1 + len;
+			entry->files[i].flags = BuffLittleLong(p);
+			entry->files[i].offset = (unsigned int)BuffLittleLong(p + 4);
+			entry->files[i].packsize = (unsigned int)BuffLittleLong(p + 8);
+			entry->files[i].realsize = (unsigned int)BuffLittleLong(p + 12);
+			p += 16;
+		}
+		numentries++;
+	}
+	Mem_Free(buf);
+
+	if (!ok)
+	{
+		Con_Printf(CON_WARN "%s is corrupt, ignoring it\n", path);
+		while ((entry = list))
+		{
+			list = entry->next;
+			if (entry->files)
+				Mem_Free(entry->files);
+			Mem_Free(entry);
+		}
+		fs_packcache_dirty = true;
+		return;
+	}
+	fs_packcache = list;
+	Con_DPrintf("FS_PackCache_Load: %i packs in %s\n", numentries, path);
+}
+
+/*
+====================
+FS_PackCache_Save
+
+Writes the directories of all packs opened since startup back to disk, stale
+entries are dropped
+====================
+*/
+static void FS_PackCache_Save (void)
+{
+	char path[MAX_OSPATH];
+	unsigned char *buf, *p;
+	size_t bufsize = strlen(FS_PACKCACHE_MAGIC);
+	fs_packcache_t *entry;
+	qfile_t *file;
+	int i, len;
+
+	if (!fs_packcache_dirty)
+		return;
+	fs_packcache_dirty = false;
+
+	for (entry = fs_packcache;entry;entry = entry->next)
+		if (entry->used)
+			bufsize += 2 + strlen(entry->filename) + 20 + entry->numfiles * (1 + MAX_QPATH + 16);
+	buf = p = (unsigned char *)Mem_Alloc(tempmempool, bufsize);
+	memcpy(p, FS_PACKCACHE_MAGIC, strlen(FS_PACKCACHE_MAGIC));
+	p += strlen(FS_PACKCACHE_MAGIC);
+	for (entry = fs_packcache;entry;entry = entry->next)
+	{
+		if (!entry->used)
+			continue;
+		len = (int)strlen(entry->filename);
+		StoreLittleShort(p, len);
+		memcpy(p + 2, entry->filename, len);
+		p += 2 + len;
+		StoreLittleLong(p, (unsigned int)entry->filesize);
+		StoreLittleLong(p + 4, (unsigned int)(entry->filesize >> 32));
+		StoreLittleLong(p + 8, (unsigned int)entry->filetime);
+		StoreLittleLong(p + 12, (unsigned int)(entry->filetime >> 32));
+		StoreLittleLong(p + 16, entry->numfiles);
+		p += 20;
+		for (i = 0;i < entry->numfiles;i++)
+		{
+			len = (int)strlen(entry->files[i].name);
+			p[0] = len;
+			memcpy(p + 1, entry->files[i].name, len);
+			p += 1 + len;
+			StoreLittleLong(p, entry->files[i].flags);
+			StoreLittleLong(p + 4, (unsigned int)entry->files[i].offset);
+			StoreLittleLong(p + 8, (unsigned int)entry->files[i].packsize);
+			StoreLittleLong(p + 12, (unsigned int)entry->files[i].realsize);
+			p += 16;
+		}
+	}
+
+	FS_PackCache_Path(path, sizeof(path));
+	if ((file = FS_SysOpen(path, "wb", false)))
+	{
+		FS_Write(file, buf, p - buf);
+		FS_Close(file);
+	}
+	else
+		Con_DPrintf("FS_PackCache_Save: can't write %s\n", path);
+	Mem_Free(buf);
+}
+
+static void FS_PackCache_Free (void)
+{
+	fs_packcache_t *entry;
+
+	while ((entry = fs_packcache))
+	{
+		fs_packcache = entry->next;
+		Mem_Free(entry->files);
+		Mem_Free(entry);
+	}
+	fs_packcache_loaded = false;
+}
+
+/*
+====================
+FS_PackCache_Find
+
+Returns the cache entry for a pack file, NULL if it is missing or out of date
+====================
+*/
+static fs_packcache_t *FS_PackCache_Find (const char *packfile, long long filesize, long long filetime)
+{
+	fs_packcache_t *entry;
+
+	if (!fs_packcache_loaded)
+		FS_PackCache_Load();
+	for (entry = fs_packcache;entry;entry = entry->next)
+	{
+		if (strcmp(entry->filename, packfile))
+			continue;
+		if (entry->filesize == filesize && entry->filetime == filetime)
+		{
+			if (!entry->used)
+				fs_packcache_dirty = true;
+			entry->used = true;
+			return entry;
+		}
+		// the pack changed, the new directory replaces this entry
+		entry->filename[0] = 0;
+		entry->used = false;
+		fs_packcache_dirty = true;
+		return NULL;
+	}
+	return NULL;
+}
+
+static void FS_PackCache_Add (const pack_t *pack, long long filesize, long long filetime)
+{
+	fs_packcache_t *entry;
+
+	entry = (fs_packcache_t *)Mem_Alloc(fs_mempool, sizeof(*entry));
+	dp_strlcpy(entry->filename, pack->filename, sizeof(entry->filename));
+	entry->filesize = filesize;
+	entry->filetime = filetime;
+	entry->used = true;
+	entry->numfiles = pack->numfiles;
+	entry->files = (packfile_t *)Mem_Alloc(fs_mempool, max(pack->numfiles, 1) * sizeof(*entry->files));
+	memcpy(entry->files, pack->files, pack->numfiles * sizeof(*entry->files));
+	entry->next = fs_packcache;
+	fs_packcache = entry;
+	fs_packcache_dirty = true;
+}
+
 static filedesc_t FS_SysOpenFiledesc(const char *filepath, const char *mode, qbool nonblocking);
 static pack_t *FS_LoadPackPK3 (const char *packfile)
 {
 	filedesc_t packhandle;
+	fs_packcache_t *entry = NULL;
+	long long filesize, filetime;
+	qbool usecache;
+	pack_t *pack;
+
 	packhandle = FS_SysOpenFiledesc (packfile, "rb", false);
 	if (!FILEDESC_ISVALID(packhandle))
 		return NULL;
-	return FS_LoadPackPK3FromFD(packfile, packhandle, false);
+
+	// COMMANDLINEOPTION: Filesystem: -packcache remembers the file lists of pk3 archives in packcache.dat so unchanged ones are not parsed again
+	usecache = Sys_CheckParm("-packcache") && FS_SysFileStat(packfile, &filesize, &filetime);
+	if (usecache && (entry = FS_PackCache_Find(packfile, filesize, filetime)))
+	{
+		fs_packcache_hits++;
+		pack = (pack_t *)Mem_Alloc(fs_mempool, sizeof (pack_t));
+		pack->ignorecase = true; // PK3 ignores case
+		dp_strlcpy (pack->filename, packfile, sizeof (pack->filename));
+		pack->handle = packhandle;
+		pack->numfiles = entry->numfiles;
+		pack->files = (packfile_t *)Mem_Alloc(fs_mempool, max(entry->numfiles, 1) * sizeof(packfile_t));
+		memcpy(pack->files, entry->files, entry->numfiles * sizeof(packfile_t));
+		Con_DPrintf("Added packfile %s (%i files, cached)\n", packfile, pack->numfiles);
+		return pack;
+	}
+
+	pack = FS_LoadPackPK3FromFD(packfile, packhandle, false);
+	if (pack && usecache)
+	{
+		fs_packcache_misses++;
+		FS_PackCache_Add(pack, filesize, filetime);
+	}
+	return pack;
 }
 
 
@@ -935,6 +1317,34 @@ static qbool PK3_GetTrueFileOffset (packfile_t *pfile, pack_t *pack)
 }
 
 
+/*
+====================
+PK3_InflateBuffer
+
+Decompresses a whole raw deflate stream in one call, used when the compressed
+data is already in memory
+====================
+*/
+static qbool PK3_InflateBuffer (const unsigned char *in, fs_offset_t insize, unsigned char *out, fs_offset_t outsize)
+{
+	z_stream zstream;
+	int error;
+
+	memset(&zstream, 0, sizeof(zstream));
+	zstream.next_in = (unsigned char *)in;
+	zstream.avail_in = (unsigned int)insize;
+	zstream.next_out = out;
+	zstream.avail_out = (unsigned int)outsize;
+	if (qz_inflateInit2 (&zstream, -MAX_WBITS) != Z_OK)
+		return false;
+	error = qz_inflate (&zstream, Z_FINISH);
+	qz_inflateEnd (&zstream);
+	// without the dummy byte after the stream (see FS_OpenPackedFile) older
+	// zlib versions stop with a full output buffer instead of Z_STREAM_END
+	return (error == Z_STREAM_END || error == Z_OK || error == Z_BUF_ERROR) && (fs_offset_t)zstream.total_out == outsize;
+}
+
+
 /*
 =============================================================================
 
@@ -948,44 +1358,17 @@ OTHER PRIVATE FUNCTIONS
 ====================
 FS_AddFileToPack
 
-Add a file to the list of files contained into a package
+Add a file to the list of files contained into a package, the list must be
+sorted with FS_SortPackFiles once all files are added
 ====================
 */
 static packfile_t* FS_AddFileToPack (const char* name, pack_t* pack,
 									 fs_offset_t offset, fs_offset_t packsize,
 									 fs_offset_t realsize, int flags)
 {
-	int (*strcmp_funct) (const char* str1, const char* str2);
-	int left, right, middle;
 	packfile_t *pfile;
 
-	strcmp_funct = pack->ignorecase ? strcasecmp : strcmp;
-
-	// Look for the slot we should put that file into (binary search)
-	left = 0;
-	right = pack->numfiles - 1;
-	while (left <= right)
-	{
-		int diff;
-
-		middle = (left + right) / 2;
-		diff = strcmp_funct (pack->files[middle].name, name);
-
-		// If we found the file, there's a problem
-		if (!diff)
-			Con_Printf ("Package %s contains the file %s several times\n", pack->filename, name);
-
-		// If we're too far in the list
-		if (diff > 0)
-			right = middle - 1;
-		else
-			left = middle + 1;
-	}
-
-	// We have to move the right of the list by one slot to free the one we need
-	pfile = &pack->files[left];
-	memmove (pfile + 1, pfile, (pack->numfiles - left) * sizeof (*pfile));
-	pack->numfiles++;
+	pfile = &pack->files[pack->numfiles++];
 
 	dp_strlcpy (pfile->name, name, sizeof (pfile->name));
 	pfile->offset = offset;
@@ -996,6 +1379,45 @@ static packfile_t* FS_AddFileToPack (const char* name, pack_t* pack,
 	return pfile;
 }
 
+// files with the same name keep their order in the package, which is also
+// the order of their data
+static int FS_PackFileCompare (const void *a, const void *b)
+{
+	const packfile_t *fa = (const packfile_t *)a, *fb = (const packfile_t *)b;
+	int diff = strcmp (fa->name, fb->name);
+	if (diff)
+		return diff;
+	return fa->offset < fb->offset ? -1 : fa->offset > fb->offset;
+}
+
+static int FS_PackFileCompareNoCase (const void *a, const void *b)
+{
+	const packfile_t *fa = (const packfile_t *)a, *fb = (const packfile_t *)b;
+	int diff = strcasecmp (fa->name, fb->name);
+	if (diff)
+		return diff;
+	return fa->offset < fb->offset ? -1 : fa->offset > fb->offset;
+}
+
+/*
+====================
+FS_SortPackFiles
+
+Sorts the file list of a package for binary searching
+====================
+*/
+static void FS_SortPackFiles (pack_t *pack)
+{
+	int i;
+	int (*strcmp_funct) (const char* str1, const char* str2);
+
+	strcmp_funct = pack->ignorecase ? strcasecmp : strcmp;
+	qsort (pack->files, pack->numfiles, sizeof (*pack->files), pack->ignorecase ? FS_PackFileCompareNoCase : FS_PackFileCompare);
+	for (i = 1;i < pack->numfiles;i++)
+		if (!strcmp_funct (pack->files[i - 1].name, pack->files[i].name))
+			Con_Printf ("Package %s contains the file %s several times\n", pack->filename, pack->files[i].name);
+}
+
 static void FS_mkdir (const char *path)
 {
 	WPATHDEF(pathw);
@@ -1148,6 +1570,7 @@ static pack_t *FS_LoadPackPAK (const char *packfile)
 
 		FS_AddFileToPack (info[i].name, pack, offset, size, size, PACKFILE_FLAG_TRUEOFFS);
 	}
+	FS_SortPackFiles (pack);
 
 	Mem_Free(info);
 
@@ -1155,6 +1578,70 @@ static pack_t *FS_LoadPackPAK (const char *packfile)
 	return pack;
 }
 
+#ifdef FS_PACKMMAP
+// true if path is in fs_basedir or fs_userdir
+static qbool FS_PathInGameDirs (const char *path)
+{
+	if (*fs_basedir ? !strncmp(path, fs_basedir, strlen(fs_basedir)) : path[0] != '/')
+		return true;
+	return *fs_userdir && !strncmp(path, fs_userdir, strlen(fs_userdir));
+}
+#endif
+
+/*
+====================
+FS_MapPack
+
+Maps a whole pak/pk3 file into memory, returns NULL if that is not supported
+or fails (the pack is then read through its handle)
+
+Reading a mapping raises SIGBUS if the file has been truncated on disk since,
+where read() would just fail. So only the packs installed in the game
+directories are mapped; downloaded packs in dlcache and packs added from
+anywhere else might be rewritten while loaded, and are read instead.
+====================
+*/
+static fs_packmap_t *FS_MapPack (pack_t *pack)
+{
+#ifdef FS_PACKMMAP
+	struct stat st;
+	void *data;
+	fs_packmap_t *map;
+
+	// mapping many big packs would eat up a 32bit address space
+	// COMMANDLINEOPTION: Filesystem: -nopackmmap reads pak/pk3 files with read() instead of mapping them into memory
+	if (sizeof(void *) < 8 || Sys_CheckParm("-nopackmmap"))
+		return NULL;
+	if (pack->dlcache || !FS_PathInGameDirs(pack->filename))
+		return NULL;
+	if (fstat(pack->handle, &st) || st.st_size <= 0)
+		return NULL;
+	data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, pack->handle, 0);
+	if (data == MAP_FAILED)
+	{
+		Con_DPrintf("FS_MapPack: can't map %s, reading it instead\n", pack->filename);
+		return NULL;
+	}
+	map = (fs_packmap_t *)Mem_Alloc(fs_mempool, sizeof(*map));
+	map->data = (const unsigned char *)data;
+	map->size = (size_t)st.st_size;
+	Thread_AtomicSet(&map->refcount, 1);
+	return map;
+#else
+	return NULL;
+#endif
+}
+
+static void FS_ReleasePackMap (fs_packmap_t *map)
+{
+	if (!Thread_AtomicDecRef(&map->refcount))
+		return;
+#ifdef FS_PACKMMAP
+	munmap((void *)map->data, map->size);
+#endif
+	Mem_Free(map);
+}
+
 /*
 ====================
 FS_LoadPackVirtual
@@ -1268,6 +1755,9 @@ static qbool FS_AddPack_Fullpath(const char *pakfile, const char *shortname, qbo
 		}
 		search->pack = pak;
 		search->pack->dlcache = dlcache;
+		if (!pak->vpack)
+			pak->map = FS_MapPack(pak);
+		FS_InvalidateIndex();
 		if(pak->vpack)
 		{
 			dpsnprintf(search->filename, sizeof(search->filename), "%s/", pakfile);
@@ -1376,6 +1866,7 @@ static void FS_AddGameDirectory (const char *dir)
 	dp_strlcpy (search->filename, dir, sizeof (search->filename));
 	search->next = fs_searchpaths;
 	fs_searchpaths = search;
+	FS_InvalidateIndex();
 }
 
 
@@ -1453,6 +1944,7 @@ static void FS_ClearSearchPath (void)
 	// unload all packs and directory information, close all pack files
 	// (if a qfile is still reading a pack it won't be harmed because it used
 	//  dup() to get its own handle already)
+	FS_InvalidateIndex();
 	while (fs_searchpaths)
 	{
 		searchpath_t *search = fs_searchpaths;
@@ -1463,6 +1955,8 @@ static void FS_ClearSearchPath (void)
 			{
 				// close the file
 				FILEDESC_CLOSE(search->pack->handle);
+				if (search->pack->map)
+					FS_ReleasePackMap(search->pack->map);
 				// free any memory associated with it
 				if (search->pack->files)
 					Mem_Free(search->pack->files);
@@ -1486,9 +1980,13 @@ void FS_UnloadPacks_dlcache(void)
 {
 	searchpath_t *search = fs_searchpaths, *searchprev = fs_searchpaths, *searchnext;
 
+	// a new map may come with new files
+	FS_ClearNegativeCache();
+
 	if (!fs_unload_dlcache.integer)
 		return;
 
+	FS_InvalidateIndex();
 	while (search)
 	{
 		searchnext = search->next;
@@ -1504,6 +2002,8 @@ void FS_UnloadPacks_dlcache(void)
 
 			// close the file
 			FILEDESC_CLOSE(search->pack->handle);
+			if (search->pack->map)
+				FS_ReleasePackMap(search->pack->map);
 			// free any memory associated with it
 			if (search->pack->files)
 				Mem_Free(search->pack->files);
@@ -1525,6 +2025,7 @@ static void FS_AddSelfPack(void)
 		search->next = fs_searchpaths;
 		search->pack = fs_selfpack;
 		fs_searchpaths = search;
+		FS_InvalidateIndex();
 	}
 }
 
@@ -1537,9 +2038,13 @@ FS_Rescan
 static void FS_ListGameDirs(void);
 void FS_Rescan (void)
 {
-	int i;
+	int i, numpacks, numfiles;
 	char gamedirbuf[MAX_INPUTLINE];
 	char vabuf[1024];
+	double starttime = Sys_DirtyTime();
+	searchpath_t *search;
+
+	fs_packcache_hits = fs_packcache_misses = 0;
 
 	FS_ListGameDirs();
 
@@ -1571,6 +2076,24 @@ void FS_Rescan (void)
 	// add back the selfpack as new first item
 	FS_AddSelfPack();
 
+	FS_PackCache_Save();
+	if (developer.integer > 0)
+	{
+		numpacks = numfiles = 0;
+		for (search = fs_searchpaths;search;search = search->next)
+		{
+			if (search->pack && !search->pack->vpack)
+			{
+				numpacks++;
+				numfiles += search->pack->numfiles;
+			}
+		}
+		Con_DPrintf("FS_Rescan: %i packs (%i files) mounted in %.3fms", numpacks, numfiles, (Sys_DirtyTime() - starttime) * 1000.0);
+		if (fs_packcache_hits || fs_packcache_misses)
+			Con_DPrintf(", %i of %i directories from packcache.dat", fs_packcache_hits, fs_packcache_hits + fs_packcache_misses);
+		Con_DPrint("\n");
+	}
+
 	if (cls.state != ca_dedicated)
 	{
 		// set the default screenshot name to either the mod name or the
@@ -2114,6 +2637,9 @@ void FS_Init_Commands(void)
 	Cvar_RegisterVariable (&fs_empty_files_in_pack_mark_deletions);
 	Cvar_RegisterVariable (&fs_unload_dlcache);
 	Cvar_RegisterVariable (&cvar_fs_gamedir);
+	Cvar_RegisterVariable (&fs_negativecache);
+	Cvar_RegisterVariable (&fs_prefetch);
+	Cvar_RegisterVariable (&fs_prefetch_maxmb);
 
 	Cmd_AddCommand(CF_SHARED, "gamedir", FS_GameDir_f, "changes active gamedir list, can take multiple arguments which shouldn't include the base directory, the last gamedir is the \"primary\" and files will be saved there (example usage: gamedir ctf id1)");
 	Cmd_AddCommand(CF_SHARED, "fs_rescan", FS_Rescan_f, "rescans filesystem for new pack archives and any other changes");
@@ -2282,7 +2808,10 @@ static void FS_Init_Dir (void)
 	FS_Rescan();
 
 	if (Thread_HasThreads())
+	{
 		fs_mutex = Thread_CreateMutex();
+		fs_index_mutex = Thread_CreateMutex();
+	}
 }
 
 /*
@@ -2357,10 +2886,13 @@ FS_Shutdown
 */
 void FS_Shutdown (void)
 {
+	FS_Prefetch_Stop();
+
 	// close all pack files and such
 	// (hopefully there aren't any other open files, but they'll be cleaned up
 	//  by the OS anyway)
 	FS_ClearSearchPath();
+	FS_PackCache_Free();
 	Mem_FreePool (&fs_mempool);
 	PK3_CloseLibrary ();
 
@@ -2372,6 +2904,8 @@ void FS_Shutdown (void)
 
 	if (fs_mutex)
 		Thread_DestroyMutex(fs_mutex);
+	if (fs_index_mutex)
+		Thread_DestroyMutex(fs_index_mutex);
 }
 
 static filedesc_t FS_SysOpenFiledesc(const char *filepath, const char *mode, qbool nonblocking)
@@ -2426,6 +2960,14 @@ static filedesc_t FS_SysOpenFiledesc(const char *filepath, const char *mode, qbo
 	if(Sys_CheckParm("-readonly") && mod != O_RDONLY)
 		return FILEDESC_INVALID;
 
+	// the file may have been looked up (and not found) before, or shadow
+	// one that was read ahead from a pack
+	if (opt & O_CREAT)
+	{
+		FS_ClearNegativeCache();
+		FS_ClearPrefetch(filepath);
+	}
+
 #if USE_RWOPS
 	if (dolock)
 		return FILEDESC_INVALID;
@@ -2533,6 +3075,19 @@ static qfile_t *FS_OpenPackedFile (pack_t* pack, int pack_ind)
 	}
 #endif
 
+	// stored files in a mapped pack are read straight from the mapping
+	if (pack->map && !(pfile->flags & PACKFILE_FLAG_DEFLATED) && pfile->offset >= 0 && pfile->offset + pfile->realsize <= (fs_offset_t)pack->map->size)
+	{
+		file = (qfile_t *)Mem_Alloc (fs_mempool, sizeof (*file));
+		file->flags = QFILE_FLAG_DATA;
+		file->ungetc = EOF;
+		file->real_length = pfile->realsize;
+		file->data = pack->map->data + pfile->offset;
+		file->map = pack->map;
+		Thread_AtomicIncRef(&file->map->refcount);
+		return file;
+	}
+
 	// LadyHavoc: FILEDESC_SEEK affects all duplicates of a handle so we do it before
 	// the dup() call to avoid having to close the dup_handle on error here
 	if (FILEDESC_SEEK (pack->handle, pfile->offset, SEEK_SET) == -1)
@@ -2570,7 +3125,7 @@ static qfile_t *FS_OpenPackedFile (pack_t* pack, int pack_ind)
 		ztk->comp_length = pfile->packsize;
 
 		// Initialize zlib stream
-		ztk->zstream.next_in = ztk->input;
+		ztk->zstream.next_in = NULL;
 		ztk->zstream.avail_in = 0;
 
 		/* From Zlib's "unzip.c":
@@ -2594,6 +3149,13 @@ static qfile_t *FS_OpenPackedFile (pack_t* pack, int pack_ind)
 		ztk->zstream.avail_out = sizeof (file->buff);
 
 		file->ztk = ztk;
+
+		// compressed data in a mapped pack is inflated straight from the mapping
+		if (pack->map && pfile->offset + pfile->packsize <= (fs_offset_t)pack->map->size)
+		{
+			file->map = pack->map;
+			Thread_AtomicIncRef(&file->map->refcount);
+		}
 	}
 
 	return file;
@@ -2671,75 +3233,227 @@ void FS_SanitizePath(char *path)
 			*path = '/';
 }
 
+/*
+=============================================================================
+
+MERGED FILE INDEX
+
+All files in the packs of fs_searchpaths are hashed into one table, so
+FS_FindFile does not have to search every pack. Plain directories are still
+checked with a stat, but names that could not be found anywhere are
+remembered in the negative cache.
+
+=============================================================================
+*/
+
+// case insensitive, as pk3 files ignore case
+static unsigned int FS_HashName (const char *name)
+{
+	unsigned int hash = 2166136261u;
+	for (;*name;name++)
+		hash = (hash ^ (unsigned char)tolower((unsigned char)*name)) * 16777619u;
+	return hash;
+}
+
+static void FS_ClearNegativeCache (void)
+{
+	int i;
+	fs_negativeentry_t *entry;
+	if (!fs_negativecache_count)
+		return;
+	if (fs_index_mutex) Thread_LockMutex(fs_index_mutex);
+	for (i = 0;i < FS_NEGATIVECACHE_HASHSIZE;i++)
+	{
+		while ((entry = fs_negativecache_hash[i]))
+		{
+			fs_negativecache_hash[i] = entry->next;
+			Mem_Free(entry);
+		}
+	}
+	fs_negativecache_count = 0;
+	if (fs_index_mutex) Thread_UnlockMutex(fs_index_mutex);
+}
+
 /*
 ====================
+FS_InvalidateIndex
+
+Called whenever fs_searchpaths changes, the index is rebuilt on the next
 FS_FindFile
+====================
+*/
+static void FS_InvalidateIndex (void)
+{
+	if (fs_index_mutex) Thread_LockMutex(fs_index_mutex);
+	fs_index_valid = false;
+	if (fs_index_entries)
+		Mem_Free(fs_index_entries);
+	if (fs_index_hash)
+		Mem_Free(fs_index_hash);
+	fs_index_entries = NULL;
+	fs_index_hash = NULL;
+	fs_index_hashsize = 0;
+	if (fs_index_mutex) Thread_UnlockMutex(fs_index_mutex);
+	FS_ClearNegativeCache();
+	FS_ClearPrefetch(NULL);
+}
 
-Look for a file in the packages and in the filesystem
+/*
+====================
+FS_BuildIndex
 
-Return the searchpath where the file was found (or NULL)
-and the file index in the package if relevant
+Each bucket lists the files in search path order. A file is left out if an
+earlier pack has the same name and any lookup that finds the later one would
+find the earlier one first anyway. Called with fs_index_mutex locked.
 ====================
 */
-static searchpath_t *FS_FindFile (const char *name, int *index, const char **canonicalname, qbool quiet)
+static void FS_BuildIndex (void)
 {
 	searchpath_t *search;
 	pack_t *pak;
+	fs_indexentry_t *entry, **link;
+	int i, numfiles = 0, numentries = 0, numpacks = 0;
+	unsigned int hashsize;
+	double starttime = Sys_DirtyTime();
 
-	// search through the path, one element at a time
 	for (search = fs_searchpaths;search;search = search->next)
-	{
-		// is the element a pak file?
 		if (search->pack && !search->pack->vpack)
-		{
-			int (*strcmp_funct) (const char* str1, const char* str2);
-			int left, right, middle;
+			numfiles += search->pack->numfiles;
+	for (hashsize = 256;hashsize < (unsigned int)numfiles;hashsize <<= 1)
+		;
 
-			pak = search->pack;
-			strcmp_funct = pak->ignorecase ? strcasecmp : strcmp;
+	fs_index_hashsize = hashsize;
+	fs_index_hash = (fs_indexentry_t **)Mem_Alloc(fs_mempool, hashsize * sizeof(*fs_index_hash));
+	fs_index_entries = (fs_indexentry_t *)Mem_Alloc(fs_mempool, max(numfiles, 1) * sizeof(*fs_index_entries));
+	for (search = fs_searchpaths;search;search = search->next)
+	{
+		if (!search->pack || search->pack->vpack)
+			continue;
+		pak = search->pack;
+		numpacks++;
+		for (i = 0;i < pak->numfiles;i++)
+		{
+			for (link = &fs_index_hash[FS_HashName(pak->files[i].name) & (hashsize - 1)];(entry = *link);link = &entry->next)
+				if ((entry->search->pack->ignorecase || !pak->ignorecase) && !strcmp(entry->search->pack->files[entry->index].name, pak->files[i].name))
+					break;
+			if (entry)
+				continue; // shadowed by an earlier pack
+			entry = fs_index_entries + numentries++;
+			entry->next = NULL;
+			entry->search = search;
+			entry->index = i;
+			*link = entry;
+		}
+	}
+	fs_index_valid = true;
+	if (developer_extra.integer)
+		Con_DPrintf("FS_BuildIndex: %i files (%i unique) from %i packs in %.3fms\n", numfiles, numentries, numpacks, (Sys_DirtyTime() - starttime) * 1000.0);
+}
 
-			// Look for the file (binary search)
-			left = 0;
-			right = pak->numfiles - 1;
-			while (left <= right)
-			{
-				int diff;
+// returns the first pack file in search path order matching name, or NULL
+static fs_indexentry_t *FS_FindIndexEntry (const char *name)
+{
+	fs_indexentry_t *entry;
+	pack_t *pak;
+	for (entry = fs_index_hash[FS_HashName(name) & (fs_index_hashsize - 1)];entry;entry = entry->next)
+	{
+		pak = entry->search->pack;
+		if (!(pak->ignorecase ? strcasecmp : strcmp)(pak->files[entry->index].name, name))
+			break;
+	}
+	return entry;
+}
 
-				middle = (left + right) / 2;
-				diff = strcmp_funct (pak->files[middle].name, name);
+static qbool FS_FindNegativeCache (const char *name)
+{
+	fs_negativeentry_t *entry;
+	for (entry = fs_negativecache_hash[FS_HashName(name) % FS_NEGATIVECACHE_HASHSIZE];entry;entry = entry->next)
+		if (!strcmp(entry->name, name))
+			return true;
+	return false;
+}
 
-				// Found it
-				if (!diff)
-				{
-					if (fs_empty_files_in_pack_mark_deletions.integer && pak->files[middle].realsize == 0)
-					{
-						// yes, but the first one is empty so we treat it as not being there
-						if (!quiet && developer_extra.integer)
-							Con_DPrintf("FS_FindFile: %s is marked as deleted\n", name);
-
-						if (index != NULL)
-							*index = -1;
-						if (canonicalname)
-							*canonicalname = NULL;
-						return NULL;
-					}
+static void FS_AddNegativeCache (const char *name)
+{
+	unsigned int hashindex;
+	size_t namelen = strlen(name);
+	fs_negativeentry_t *entry;
+	if (fs_negativecache_count >= FS_NEGATIVECACHE_MAX)
+		FS_ClearNegativeCache();
+	if (fs_index_mutex) Thread_LockMutex(fs_index_mutex);
+	hashindex = FS_HashName(name) % FS_NEGATIVECACHE_HASHSIZE;
+	entry = (fs_negativeentry_t *)Mem_Alloc(fs_mempool, sizeof(*entry) + namelen);
+	memcpy(entry->name, name, namelen + 1);
+	entry->next = fs_negativecache_hash[hashindex];
+	fs_negativecache_hash[hashindex] = entry;
+	fs_negativecache_count++;
+	if (fs_index_mutex) Thread_UnlockMutex(fs_index_mutex);
+}
 
-					if (!quiet && developer_extra.integer)
-						Con_DPrintf("FS_FindFile: %s in %s\n", pak->files[middle].name, pak->filename);
+/*
+====================
+FS_FindFile
 
-					if (index != NULL)
-						*index = middle;
-					if (canonicalname)
-						*canonicalname = pak->files[middle].name;
-					return search;
-				}
+Look for a file in the packages and in the filesystem
 
-				// If we're too far in the list
-				if (diff > 0)
-					right = middle - 1;
-				else
-					left = middle + 1;
+Return the searchpath where the file was found (or NULL)
+and the file index in the package if relevant
+====================
+*/
+static searchpath_t *FS_FindFile (const char *name, int *index, const char **canonicalname, qbool quiet)
+{
+	searchpath_t *search, *foundsearch = NULL;
+	fs_indexentry_t *found;
+	int foundindex = -1;
+	pack_t *pak;
+	qbool negative;
+
+	if (fs_index_mutex) Thread_LockMutex(fs_index_mutex);
+	if (!fs_index_valid)
+		FS_BuildIndex();
+	found = FS_FindIndexEntry(name);
+	// the entry is freed if another thread invalidates the index, so copy
+	// it before unlocking
+	if (found)
+	{
+		foundsearch = found->search;
+		foundindex = found->index;
+	}
+	negative = !found && fs_negativecache.integer && FS_FindNegativeCache(name);
+	if (fs_index_mutex) Thread_UnlockMutex(fs_index_mutex);
+
+	// search through the path, one element at a time, the index already
+	// knows which pack (if any) has it so only directories need checking
+	for (search = fs_searchpaths;search && !negative;search = search->next)
+	{
+		// is the element a pak file?
+		if (search->pack && !search->pack->vpack)
+		{
+			if (foundsearch != search)
+				continue;
+
+			pak = search->pack;
+			if (fs_empty_files_in_pack_mark_deletions.integer && pak->files[foundindex].realsize == 0)
+			{
+				// yes, but the first one is empty so we treat it as not being there
+				if (!quiet && developer_extra.integer)
+					Con_DPrintf("FS_FindFile: %s is marked as deleted\n", name);
+
+				if (index != NULL)
+					*index = -1;
+				if (canonicalname)
+					*canonicalname = NULL;
+				return NULL;
 			}
+
+			if (!quiet && developer_extra.integer)
+				Con_DPrintf("FS_FindFile: %s in %s\n", pak->files[foundindex].name, pak->filename);
+
+			if (index != NULL)
+				*index = foundindex;
+			if (canonicalname)
+				*canonicalname = pak->files[foundindex].name;
+			return search;
 		}
 		else
 		{
@@ -2759,6 +3473,9 @@ static searchpath_t *FS_FindFile (const char *name, int *index, const char **can
 		}
 	}
 
+	if (!negative && fs_negativecache.integer)
+		FS_AddNegativeCache(name);
+
 	if (!quiet && developer_extra.integer)
 		Con_DPrintf("FS_FindFile: can't find %s\n", name);
 
@@ -2965,6 +3682,8 @@ int FS_Close (qfile_t* file)
 {
 	if(file->flags & QFILE_FLAG_DATA)
 	{
+		if (file->map)
+			FS_ReleasePackMap(file->map);
 		Mem_Free(file);
 		return 0;
 	}
@@ -2991,8 +3710,12 @@ int FS_Close (qfile_t* file)
 	if (file->ztk)
 	{
 		qz_inflateEnd (&file->ztk->zstream);
+		if (file->ztk->inputbuffer)
+			Mem_Free (file->ztk->inputbuffer);
 		Mem_Free (file->ztk);
 	}
+	if (file->map)
+		FS_ReleasePackMap(file->map);
 
 	Mem_Free (file);
 	return 0;
@@ -3080,9 +3803,9 @@ fs_offset_t FS_Read (qfile_t* file, void* buffer, size_t buffersize)
 		size_t left = file->real_length - file->position;
 		if(buffersize > left)
 			buffersize = left;
-		memcpy(buffer, file->data + file->position, buffersize);
+		memcpy((unsigned char *)buffer + done, file->data + file->position, buffersize);
 		file->position += buffersize;
-		return buffersize;
+		return done + buffersize;
 	}
 
 	// First, we copy as many bytes as we can from "buff"
@@ -3090,8 +3813,8 @@ fs_offset_t FS_Read (qfile_t* file, void* buffer, size_t buffersize)
 	{
 		count = file->buff_len - file->buff_ind;
 		count = ((fs_offset_t)buffersize > count) ? count : (fs_offset_t)buffersize;
+		memcpy ((unsigned char *)buffer + done, &file->buff[file->buff_ind], count);
 		done += count;
-		memcpy (buffer, &file->buff[file->buff_ind], count);
 		file->buff_ind += count;
 
 		buffersize -= count;
@@ -3174,13 +3897,31 @@ fs_offset_t FS_Read (qfile_t* file, void* buffer, size_t buffersize)
 				return done;
 
 			count = (fs_offset_t)(ztk->comp_length - ztk->in_position);
-			if (count > (fs_offset_t)sizeof (ztk->input))
-				count = (fs_offset_t)sizeof (ztk->input);
-			FILEDESC_SEEK (file->handle, file->offset + (fs_offset_t)ztk->in_position, SEEK_SET);
-			if (FILEDESC_READ (file->handle, ztk->input, count) != count)
+			if (file->map)
 			{
-				Con_Printf ("FS_Read: unexpected end of file\n");
-				break;
+				// the rest of the compressed data is already in memory
+				ztk->input = file->map->data + file->offset + ztk->in_position;
+			}
+			else
+			{
+				// read further ahead each time the file keeps being read
+				// sequentially, FS_Seek starts over with a small buffer
+				if (!ztk->inputsize || (ztk->in_position && ztk->inputsize < ZBUFF_MAXSIZE && count > (fs_offset_t)ztk->inputsize))
+				{
+					ztk->inputsize = ztk->inputsize ? ztk->inputsize * 2 : FILE_BUFF_SIZE;
+					if (ztk->inputbuffer)
+						Mem_Free (ztk->inputbuffer);
+					ztk->inputbuffer = (unsigned char *)Mem_Alloc (fs_mempool, ztk->inputsize);
+				}
+				if (count > (fs_offset_t)ztk->inputsize)
+					count = (fs_offset_t)ztk->inputsize;
+				FILEDESC_SEEK (file->handle, file->offset + (fs_offset_t)ztk->in_position, SEEK_SET);
+				if (FILEDESC_READ (file->handle, ztk->inputbuffer, count) != count)
+				{
+					Con_Printf ("FS_Read: unexpected end of file\n");
+					break;
+				}
+				ztk->input = ztk->inputbuffer;
 			}
 
 			ztk->in_ind = 0;
@@ -3188,7 +3929,7 @@ fs_offset_t FS_Read (qfile_t* file, void* buffer, size_t buffersize)
 			ztk->in_position += count;
 		}
 
-		ztk->zstream.next_in = &ztk->input[ztk->in_ind];
+		ztk->zstream.next_in = (unsigned char *)&ztk->input[ztk->in_ind];
 		ztk->zstream.avail_in = (unsigned int)(ztk->in_len - ztk->in_ind);
 
 		// Now that we are sure we have compressed data available, we need to determine
@@ -3416,9 +4157,15 @@ int FS_Seek (qfile_t* file, fs_offset_t offset, int whence)
 			Con_Printf("IMPOSSIBLE: couldn't seek in already opened pk3 file.\n");
 
 		// Reset the Zlib stream
-		ztk->zstream.next_in = ztk->input;
+		ztk->zstream.next_in = NULL;
 		ztk->zstream.avail_in = 0;
 		qz_inflateReset (&ztk->zstream);
+		if (ztk->inputbuffer)
+		{
+			Mem_Free (ztk->inputbuffer);
+			ztk->inputbuffer = NULL;
+		}
+		ztk->inputsize = 0;
 	}
 
 	// We need a big buffer to force inflating into it directly
@@ -3486,6 +4233,410 @@ void FS_Purge (qfile_t* file)
 }
 
 
+/*
+=============================================================================
+
+PREFETCHING
+
+=============================================================================
+*/
+
+static void FS_Prefetch_Free (fs_prefetch_t *p)
+{
+	if (p->data)
+		Mem_Free(p->data);
+	if (p->map)
+		FS_ReleasePackMap(p->map);
+	Mem_Free(p);
+}
+
+/*
+====================
+FS_Prefetch_Read
+
+Reads and decompresses one file, only touches the entry and its own file
+handles so it is safe to run without fs_mutex
+====================
+*/
+static unsigned char *FS_Prefetch_Read (fs_prefetch_t *p, fs_offset_t *filesize)
+{
+	qfile_t *file;
+	unsigned char *data, *packed = NULL;
+	const unsigned char *in;
+
+	if (p->offset < 0)
+	{
+		if (!(file = FS_SysOpen(p->sourcepath, "rb", false)))
+			return NULL;
+		*filesize = file->real_length;
+		if (*filesize < 0)
+		{
+			FS_Close(file);
+			return NULL;
+		}
+		data = (unsigned char *)Mem_Alloc(fs_mempool, *filesize + 1);
+		if (FS_Read(file, data, *filesize) != *filesize)
+		{
+			Mem_Free(data);
+			data = NULL;
+		}
+		FS_Close(file);
+		return data;
+	}
+
+	// the pack's own handle can't be used here, its seek position is
+	// shared with the main thread
+	if (p->map)
+		in = p->map->data + p->offset;
+	else
+	{
+		if (!(file = FS_SysOpen(p->sourcepath, "rb", false)))
+			return NULL;
+		packed = (unsigned char *)Mem_Alloc(fs_mempool, p->packsize);
+		if (FS_Seek(file, p->offset, SEEK_SET) || FS_Read(file, packed, p->packsize) != p->packsize)
+		{
+			FS_Close(file);
+			Mem_Free(packed);
+			return NULL;
+		}
+		FS_Close(file);
+		in = packed;
+	}
+
+	*filesize = p->realsize;
+	data = (unsigned char *)Mem_Alloc(fs_mempool, p->realsize + 1);
+	if (!p->deflated)
+		memcpy(data, in, p->realsize);
+	else if (!PK3_InflateBuffer(in, p->packsize, data, p->realsize))
+	{
+		Mem_Free(data);
+		data = NULL;
+	}
+	if (packed)
+		Mem_Free(packed);
+	return data;
+}
+
+static int FS_Prefetch_Thread (void *unused)
+{
+	fs_prefetch_t *p;
+	unsigned char *data;
+	fs_offset_t filesize = 0;
+
+	Thread_LockMutex(fs_prefetch_mutex);
+	while (!fs_prefetch_quit)
+	{
+		for (p = fs_prefetch_list;p && p->state != FS_PREFETCH_QUEUED;p = p->next)
+			;
+		if (!p)
+		{
+			Thread_CondWait(fs_prefetch_cond, fs_prefetch_mutex);
+			continue;
+		}
+		// leave the rest for FS_LoadFile if nobody picked up the earlier ones
+		if (fs_prefetch_bytes >= (fs_offset_t)fs_prefetch_maxmb.integer << 20)
+		{
+			p->state = FS_PREFETCH_DONE;
+			continue;
+		}
+		p->state = FS_PREFETCH_LOADING;
+		Thread_UnlockMutex(fs_prefetch_mutex);
+		data = FS_Prefetch_Read(p, &filesize);
+		Thread_LockMutex(fs_prefetch_mutex);
+		if (p->state == FS_PREFETCH_CANCELLED)
+		{
+			if (data)
+				Mem_Free(data);
+			FS_Prefetch_Free(p);
+		}
+		else
+		{
+			p->data = data;
+			p->filesize = filesize;
+			p->state = FS_PREFETCH_DONE;
+			if (data)
+				fs_prefetch_bytes += filesize;
+		}
+		Thread_CondBroadcast(fs_prefetch_cond);
+	}
+	Thread_UnlockMutex(fs_prefetch_mutex);
+	return 0;
+}
+
+/*
+====================
+FS_Prefetch_Start
+
+Returns false if no prefetch thread is running, FS_LoadFile then reads
+everything itself
+====================
+*/
+static qbool FS_Prefetch_Start (void)
+{
+	int numthreads = bound(0, fs_prefetch.integer, FS_PREFETCH_MAXTHREADS);
+	void *thread;
+
+	if (!fs_prefetch_mutex)
+	{
+		fs_prefetch_mutex = Thread_CreateMutex();
+		fs_prefetch_cond = Thread_CreateCond();
+		if (!fs_prefetch_mutex || !fs_prefetch_cond)
+		{
+			if (fs_prefetch_cond)
+				Thread_DestroyCond(fs_prefetch_cond);
+			if (fs_prefetch_mutex)
+				Thread_DestroyMutex(fs_prefetch_mutex);
+			fs_prefetch_cond = NULL;
+			fs_prefetch_mutex = NULL;
+			return false;
+		}
+	}
+	fs_prefetch_quit = false;
+	for (;fs_prefetch_numthreads < numthreads;fs_prefetch_numthreads++)
+	{
+		if (!(thread = Thread_CreateThread(FS_Prefetch_Thread, NULL)))
+		{
+			Con_DPrintf("FS_Prefetch_Start: could not create a prefetch thread\n");
+			break;
+		}
+		fs_prefetch_threads[fs_prefetch_numthreads] = thread;
+	}
+	return fs_prefetch_numthreads > 0;
+}
+
+static void FS_Prefetch_Stop (void)
+{
+	int i;
+
+	if (!fs_prefetch_mutex)
+		return;
+	Thread_LockMutex(fs_prefetch_mutex);
+	fs_prefetch_quit = true;
+	Thread_CondBroadcast(fs_prefetch_cond);
+	Thread_UnlockMutex(fs_prefetch_mutex);
+	for (i = 0;i < fs_prefetch_numthreads;i++)
+		Thread_WaitThread(fs_prefetch_threads[i], 0);
+	fs_prefetch_numthreads = 0;
+	FS_ClearPrefetch(NULL);
+	Thread_DestroyCond(fs_prefetch_cond);
+	Thread_DestroyMutex(fs_prefetch_mutex);
+	fs_prefetch_cond = NULL;
+	fs_prefetch_mutex = NULL;
+}
+
+/*
+====================
+FS_ClearPrefetch
+
+Forgets prefetched files, either all of them or the ones that a newly created
+OS file could shadow
+====================
+*/
+static void FS_ClearPrefetch (const char *ospath)
+{
+	fs_prefetch_t *p, **link;
+	size_t ospathlen = ospath ? strlen(ospath) : 0, namelen;
+
+	if (!fs_prefetch_mutex)
+		return;
+	Thread_LockMutex(fs_prefetch_mutex);
+	for (link = &fs_prefetch_list;(p = *link);)
+	{
+		if (ospath)
+		{
+			namelen = strlen(p->name);
+			if (namelen > ospathlen || strcasecmp(ospath + ospathlen - namelen, p->name))
+			{
+				link = &p->next;
+				continue;
+			}
+		}
+		*link = p->next;
+		if (p->state == FS_PREFETCH_LOADING)
+			p->state = FS_PREFETCH_CANCELLED;
+		else
+		{
+			if (p->data)
+				fs_prefetch_bytes -= p->filesize;
+			FS_Prefetch_Free(p);
+		}
+	}
+	Thread_UnlockMutex(fs_prefetch_mutex);
+}
+
+/*
+====================
+FS_Prefetch_Take
+
+Returns the contents of a prefetched file (in fs_mempool, with the usual 0
+byte appended) and forgets about it, waits if it is still being read.
+Returns NULL if the file was not prefetched.
+====================
+*/
+static unsigned char *FS_Prefetch_Take (const char *path, fs_offset_t *filesize)
+{
+	fs_prefetch_t *p, **link;
+	unsigned char *data = NULL;
+
+	if (!fs_prefetch_mutex)
+		return NULL;
+	Thread_LockMutex(fs_prefetch_mutex);
+	for (link = &fs_prefetch_list;(p = *link);)
+	{
+		if (strcmp(p->name, path))
+		{
+			link = &p->next;
+			continue;
+		}
+		if (p->state == FS_PREFETCH_LOADING)
+		{
+			// the list may change while we wait, so search again afterwards
+			Thread_CondWait(fs_prefetch_cond, fs_prefetch_mutex);
+			link = &fs_prefetch_list;
+			continue;
+		}
+		*link = p->next;
+		if (p->data)
+		{
+			data = p->data;
+			*filesize = p->filesize;
+			fs_prefetch_bytes -= p->filesize;
+			p->data = NULL;
+		}
+		FS_Prefetch_Free(p);
+		break;
+	}
+	Thread_UnlockMutex(fs_prefetch_mutex);
+	return data;
+}
+
+/*
+====================
+FS_PrefetchAsync
+
+Starts reading (and decompressing) the listed files on the prefetch threads,
+so that FS_LoadFile finds them in memory when they are loaded later on.
+Replaces the files of an earlier list that were not loaded yet.
+====================
+*/
+void FS_PrefetchAsync (const stringlist_t *list)
+{
+	int i, pack_ind, numqueued = 0;
+	searchpath_t *search;
+	packfile_t *pfile;
+	fs_prefetch_t *p, *queue = NULL, **tail = &queue;
+
+	if (fs_prefetch.integer <= 0 || !Thread_HasThreads())
+		return;
+
+	FS_ClearPrefetch(NULL);
+	if (!FS_Prefetch_Start())
+		return;
+
+	// the lookups happen here, the threads never walk fs_searchpaths
+	for (i = 0;i < list->numstrings;i++)
+	{
+		const char *name = list->strings[i];
+		if (strlen(name) >= MAX_QPATH || FS_CheckNastyPath(name, false))
+			continue;
+		for (p = queue;p && strcmp(p->name, name);p = p->next)
+			;
+		if (p)
+			continue;
+		if (fs_mutex) Thread_LockMutex(fs_mutex);
+		search = FS_FindFile(name, &pack_ind, NULL, true);
+		if (!search)
+		{
+			if (fs_mutex) Thread_UnlockMutex(fs_mutex);
+			continue;
+		}
+		p = (fs_prefetch_t *)Mem_Alloc(fs_mempool, sizeof(*p));
+		dp_strlcpy(p->name, name, sizeof(p->name));
+		p->state = FS_PREFETCH_QUEUED;
+		if (pack_ind < 0)
+		{
+			dpsnprintf(p->sourcepath, sizeof(p->sourcepath), "%s%s", search->filename, name);
+			p->offset = -1;
+		}
+		else
+		{
+			pfile = &search->pack->files[pack_ind];
+			if ((pfile->flags & PACKFILE_FLAG_SYMLINK)
+			 || ((pfile->flags & PACKFILE_FLAG_DEFLATED) && !FS_HasZlib())
+			 || !PK3_GetTrueFileOffset(pfile, search->pack))
+			{
+				if (fs_mutex) Thread_UnlockMutex(fs_mutex);
+				Mem_Free(p);
+				continue;
+			}
+			dp_strlcpy(p->sourcepath, search->pack->filename, sizeof(p->sourcepath));
+			p->offset = pfile->offset;
+			p->packsize = pfile->packsize;
+			p->realsize = pfile->realsize;
+			p->deflated = (pfile->flags & PACKFILE_FLAG_DEFLATED) != 0;
+			if (search->pack->map && p->offset + p->packsize <= (fs_offset_t)search->pack->map->size)
+			{
+				p->map = search->pack->map;
+				Thread_AtomicIncRef(&p->map->refcount);
+			}
+		}
+		if (fs_mutex) Thread_UnlockMutex(fs_mutex);
+		*tail = p;
+		tail = &p->next;
+		numqueued++;
+	}
+
+	if (!queue)
+		return;
+	Thread_LockMutex(fs_prefetch_mutex);
+	*tail = fs_prefetch_list;
+	fs_prefetch_list = queue;
+	Thread_CondBroadcast(fs_prefetch_cond);
+	Thread_UnlockMutex(fs_prefetch_mutex);
+
+	if (developer_loadfile.integer)
+		Con_Printf("prefetching %i of %i files\n", numqueued, list->numstrings);
+}
+
+
+/*
+============
+FS_InflateWholeFile
+
+Inflates a compressed file that was just opened in a single call, instead of
+streaming it through FS_Read. Returns false without touching the stream if
+that is not possible.
+============
+*/
+static qbool FS_InflateWholeFile (qfile_t *file, unsigned char *out)
+{
+	ztoolkit_t *ztk = file->ztk;
+	unsigned char *packed = NULL;
+	const unsigned char *in;
+	qbool ok;
+
+	if (!ztk || file->position || file->buff_len || file->ungetc != EOF || ztk->in_position)
+		return false;
+
+	if (file->map)
+		in = file->map->data + file->offset;
+	else
+	{
+		packed = (unsigned char *)Mem_Alloc (tempmempool, ztk->comp_length);
+		if (FILEDESC_SEEK (file->handle, file->offset, SEEK_SET) == -1 || FILEDESC_READ (file->handle, packed, ztk->comp_length) != (fs_offset_t)ztk->comp_length)
+		{
+			Mem_Free (packed);
+			return false;
+		}
+		in = packed;
+	}
+	ok = PK3_InflateBuffer (in, ztk->comp_length, out, file->real_length);
+	if (packed)
+		Mem_Free (packed);
+	return ok;
+}
+
+
 /*
 ============
 FS_LoadAndCloseQFile
@@ -3511,7 +4662,8 @@ static unsigned char *FS_LoadAndCloseQFile (qfile_t *file, const char *path, mem
 
 		buf = (unsigned char *)Mem_Alloc (pool, filesize + 1);
 		buf[filesize] = '\0';
-		FS_Read (file, buf, filesize);
+		if (!(file->flags & QFILE_FLAG_DEFLATED) || !FS_InflateWholeFile (file, buf))
+			FS_Read (file, buf, filesize);
 		FS_Close (file);
 		if (developer_loadfile.integer)
 			Con_Printf("loaded file \"%s\" (%u bytes)\n", path, (unsigned int)filesize);
@@ -3533,11 +4685,90 @@ Always appends a 0 byte.
 */
 unsigned char *FS_LoadFile (const char *path, mempool_t *pool, qbool quiet, fs_offset_t *filesizepointer)
 {
-	qfile_t *file = FS_OpenVirtualFile(path, quiet);
+	qfile_t *file;
+	unsigned char *prefetched, *buf;
+	fs_offset_t filesize;
+
+	if ((prefetched = FS_Prefetch_Take(path, &filesize)))
+	{
+		// hand the buffer over, a copy would double the peak memory use
+		Mem_ChangePool(pool, prefetched);
+		buf = prefetched;
+		if (developer_loadfile.integer)
+			Con_Printf("loaded prefetched file \"%s\" (%u bytes)\n", path, (unsigned int)filesize);
+		if (filesizepointer)
+			*filesizepointer = filesize;
+		return buf;
+	}
+
+	file = FS_OpenVirtualFile(path, quiet);
 	return FS_LoadAndCloseQFile(file, path, pool, quiet, filesizepointer);
 }
 
 
+/*
+============
+FS_LoadRealFile
+
+Like FS_LoadFile, but only reads the real file in the gamedir of the user
+directory (where FS_WriteFile puts it), never one from a package.
+Always appends a 0 byte.
+============
+*/
+unsigned char *FS_LoadRealFile (const char *path, mempool_t *pool, qbool quiet, fs_offset_t *filesizepointer)
+{
+	return FS_LoadAndCloseQFile(FS_OpenRealFile(path, "rb", quiet), path, pool, quiet, filesizepointer);
+}
+
+
+/*
+============
+FS_LoadFileView
+
+Loads a file for reading only, without a copy if it is stored in a mapped pack
+============
+*/
+qbool FS_LoadFileView (const char *path, qbool quiet, fs_fileview_t *view)
+{
+	qfile_t *file;
+
+	memset(view, 0, sizeof(*view));
+	if ((view->buffer = FS_Prefetch_Take(path, &view->size)))
+	{
+		Mem_ChangePool(tempmempool, view->buffer);
+		view->data = view->buffer;
+		return true;
+	}
+	file = FS_OpenVirtualFile(path, quiet);
+	if (!file)
+		return false;
+	if (file->map)
+	{
+		view->data = file->data;
+		view->size = file->real_length;
+		view->map = file->map;
+		// the view keeps the mapping alive after the file is closed
+		Thread_AtomicIncRef(&view->map->refcount);
+		FS_Close(file);
+		if (developer_loadfile.integer)
+			Con_Printf("mapped file \"%s\" (%u bytes)\n", path, (unsigned int)view->size);
+		return true;
+	}
+	view->buffer = FS_LoadAndCloseQFile(file, path, tempmempool, quiet, &view->size);
+	view->data = view->buffer;
+	return view->buffer != NULL;
+}
+
+void FS_FreeFileView (fs_fileview_t *view)
+{
+	if (view->map)
+		FS_ReleasePackMap(view->map);
+	if (view->buffer)
+		Mem_Free(view->buffer);
+	memset(view, 0, sizeof(*view));
+}
+
+
 /*
 ============
 FS_SysLoadFile
@@ -3740,6 +4971,67 @@ qbool FS_SysFileExists (const char *path)
 	return FS_SysFileType (path) != FS_FILETYPE_NONE;
 }
 
+/*
+===========
+FS_SearchAddResult
+
+Appends name to the results unless it is already there
+===========
+*/
+static qbool FS_SearchAddResult (stringlist_t *results, int **hash, int *hashsize, const char *name)
+{
+	int i, newsize, *newhash;
+	unsigned int h;
+
+	// keep the open addressing table at most half full
+	if (results->numstrings * 2 >= *hashsize)
+	{
+		newsize = *hashsize ? *hashsize * 2 : 256;
+		newhash = (int *)Mem_Alloc(tempmempool, newsize * sizeof(*newhash));
+		for (i = 0;i < results->numstrings;i++)
+		{
+			for (h = FS_HashName(results->strings[i]) & (newsize - 1);newhash[h];h = (h + 1) & (newsize - 1))
+				;
+			newhash[h] = i + 1;
+		}
+		if (*hash)
+			Mem_Free(*hash);
+		*hash = newhash;
+		*hashsize = newsize;
+	}
+	for (h = FS_HashName(name) & (*hashsize - 1);(*hash)[h];h = (h + 1) & (*hashsize - 1))
+		if (!strcmp(results->strings[(*hash)[h] - 1], name))
+			return false;
+	(*hash)[h] = results->numstrings + 1;
+	stringlistappend(results, name);
+	return true;
+}
+
+/*
+===========
+FS_SearchPackStart
+
+Index of the first file in a sorted pack whose name starts with (or sorts
+after) the given prefix
+===========
+*/
+static int FS_SearchPackStart (const pack_t *pak, const char *prefix, int prefixlength)
+{
+	int left = 0, right = pak->numfiles, middle;
+
+	if (!prefixlength || !pak->ignorecase)
+		return 0;
+	while (left < right)
+	{
+		middle = (left + right) / 2;
+		if (strncasecmp(pak->files[middle].name, prefix, prefixlength) < 0)
+			left = middle + 1;
+		else
+			right = middle;
+	}
+	return left;
+}
+
 /*
 ===========
 FS_Search
@@ -3753,9 +5045,11 @@ fssearch_t *FS_Search(const char *pattern, int caseinsensitive, int quiet, const
 	searchpath_t *searchpath;
 	pack_t *pak;
 	int i, basepathlength, numfiles, numchars, resultlistindex, dirlistindex;
+	int *resulthash = NULL, resulthashsize = 0;
 	stringlist_t resultlist;
 	stringlist_t dirlist;
 	stringlist_t matchedSet, foundSet;
+	matchpattern_compiled_t compiled;
 	const char *start, *slash, *backslash, *colon, *separator;
 	char *basepath;
 
@@ -3768,6 +5062,12 @@ fssearch_t *FS_Search(const char *pattern, int caseinsensitive, int quiet, const
 		return NULL;
 	}
 
+	if (!matchpattern_compile(&compiled, pattern, true, "/\\:", false))
+	{
+		Con_Printf("Search pattern is too long!\n");
+		return NULL;
+	}
+
 	stringlistinit(&resultlist);
 	stringlistinit(&dirlist);
 	search = NULL;
@@ -3795,23 +5095,21 @@ fssearch_t *FS_Search(const char *pattern, int caseinsensitive, int quiet, const
 				if(strcmp(packfile, pak->shortname))
 					continue;
 			}
-			for (i = 0;i < pak->numfiles;i++)
+			// the files are sorted, and every match (or directory of a
+			// match) starts with the part of the pattern before the first
+			// wildcard, so only that range of the list needs to be checked
+			for (i = FS_SearchPackStart(pak, pattern, compiled.prefixlength);i < pak->numfiles;i++)
 			{
 				char temp[MAX_OSPATH];
+				if (pak->ignorecase && strncasecmp(pak->files[i].name, pattern, compiled.prefixlength))
+					break;
 				dp_strlcpy(temp, pak->files[i].name, sizeof(temp));
 				while (temp[0])
 				{
-					if (matchpattern(temp, (char *)pattern, true))
+					if (matchpattern_compiled(temp, &compiled))
 					{
-						for (resultlistindex = 0;resultlistindex < resultlist.numstrings;resultlistindex++)
-							if (!strcmp(resultlist.strings[resultlistindex], temp))
-								break;
-						if (resultlistindex == resultlist.numstrings)
-						{
-							stringlistappend(&resultlist, temp);
-							if (!quiet && developer_loading.integer)
-								Con_Printf("SearchPackFile: %s : %s\n", pak->filename, temp);
-						}
+						if (FS_SearchAddResult(&resultlist, &resulthash, &resulthashsize, temp) && !quiet && developer_loading.integer)
+							Con_Printf("SearchPackFile: %s : %s\n", pak->filename, temp);
 					}
 					// strip off one path element at a time until empty
 					// this way directories are added to the listing if they match the pattern
@@ -3908,17 +5206,10 @@ fssearch_t *FS_Search(const char *pattern, int caseinsensitive, int quiet, const
 			for (dirlistindex = 0;dirlistindex < matchedSet.numstrings;dirlistindex++)
 			{
 				const char *matchtemp = matchedSet.strings[dirlistindex];
-				if (matchpattern(matchtemp, (char *)pattern, true))
+				if (matchpattern_compiled(matchtemp, &compiled))
 				{
-					for (resultlistindex = 0;resultlistindex < resultlist.numstrings;resultlistindex++)
-						if (!strcmp(resultlist.strings[resultlistindex], matchtemp))
-							break;
-					if (resultlistindex == resultlist.numstrings)
-					{
-						stringlistappend(&resultlist, matchtemp);
-						if (!quiet && developer_loading.integer)
-							Con_Printf("SearchDirFile: %s\n", matchtemp);
-					}
+					if (FS_SearchAddResult(&resultlist, &resulthash, &resulthashsize, matchtemp) && !quiet && developer_loading.integer)
+						Con_Printf("SearchDirFile: %s\n", matchtemp);
 				}
 			}
 			stringlistfreecontents( &matchedSet );
@@ -3949,6 +5240,8 @@ fssearch_t *FS_Search(const char *pattern, int caseinsensitive, int quiet, const
 		}
 	}
 	stringlistfreecontents(&resultlist);
+	if (resulthash)
+		Mem_Free(resulthash);
 
 	Mem_Free(basepath);
 	return search;
@@ -4094,6 +5387,41 @@ const char *FS_WhichPack(const char *filename)
 		return 0;
 }
 
+// full path of the package file that provides filename, or NULL
+const char *FS_WhichPackFile(const char *filename)
+{
+	int index;
+	searchpath_t *sp = FS_FindFile(filename, &index, NULL, true);
+	if(sp && sp->pack && !sp->pack->vpack)
+		return sp->pack->filename;
+	return NULL;
+}
+
+// full OS path of filename if it is a loose file, false if it is in a package
+qbool FS_RealFilePath(const char *filename, char *path, size_t pathsize)
+{
+	int index;
+	searchpath_t *sp = FS_FindFile(filename, &index, NULL, true);
+	if(!sp || index >= 0)
+		return false;
+	dpsnprintf(path, pathsize, "%s%s", sp->filename, filename);
+	return true;
+}
+
+// true if the package file pakfile (a game path, like FS_AddPack takes) is mounted
+qbool FS_PackLoaded(const char *pakfile)
+{
+	char fullpath[MAX_OSPATH];
+	searchpath_t *search;
+
+	if(!FS_RealFilePath(pakfile, fullpath, sizeof(fullpath)))
+		return false;
+	for(search = fs_searchpaths; search; search = search->next)
+		if(search->pack && !strcasecmp(search->pack->filename, fullpath))
+			return true;
+	return false;
+}
+
 /*
 ====================
 FS_IsRegisteredQuakePack
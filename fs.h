@@ -63,6 +63,10 @@ typedef struct vfs_s
 
 qbool FS_AddPack(const char *pakfile, qbool *already_loaded, qbool keep_plain_dirs, qbool dlcache); // already_loaded may be NULL if caller does not care
 const char *FS_WhichPack(const char *filename);
+const char *FS_WhichPackFile(const char *filename);
+qbool FS_RealFilePath(const char *filename, char *path, size_t pathsize);
+qbool FS_PackLoaded(const char *pakfile);
+qbool FS_SysFileStat (const char *path, long long *filesize, long long *filetime); // uses absolute path
 void FS_CreatePath (char *path);
 int FS_SysOpenFD(const char *filepath, const char *mode, qbool nonblocking); // uses absolute path
 qfile_t* FS_SysOpen (const char* filepath, const char* mode, qbool nonblocking); // uses absolute path
@@ -124,6 +128,25 @@ fssearch_t *FS_Search(const char *pattern, int caseinsensitive, int quiet, const
 void FS_FreeSearch(fssearch_t *search);
 
 unsigned char *FS_LoadFile (const char *path, mempool_t *pool, qbool quiet, fs_offset_t *filesizepointer);
+unsigned char *FS_LoadRealFile (const char *path, mempool_t *pool, qbool quiet, fs_offset_t *filesizepointer); // only the file in the user gamedir
+
+/// read-only contents of a file, see FS_LoadFileView
+typedef struct fs_fileview_s
+{
+	const unsigned char *data; ///< not 0 terminated
+	fs_offset_t size;
+	unsigned char *buffer;     ///< private, set if the file had to be loaded
+	struct fs_packmap_s *map;  ///< private, set if data points into a memory mapped pack
+}
+fs_fileview_t;
+/// Like FS_LoadFile, but files stored uncompressed in a memory mapped pack are
+/// not copied. Returns false if the file can't be opened, otherwise the view
+/// must be released with FS_FreeFileView.
+qbool FS_LoadFileView (const char *path, qbool quiet, fs_fileview_t *view);
+void FS_FreeFileView (fs_fileview_t *view);
+/// Reads the listed files ahead on worker threads (if fs_prefetch is set) so
+/// the FS_LoadFile/FS_LoadFileView calls for them don't wait for the disk.
+void FS_PrefetchAsync (const struct stringlist_s *list);
 unsigned char *FS_SysLoadFile (const char *path, mempool_t *pool, qbool quiet, fs_offset_t *filesizepointer);
 qbool FS_WriteFileInBlocks (const char *filename, const void *const *data, const fs_offset_t *len, size_t count);
 qbool FS_WriteFile (const char *filename, const void *data, fs_offset_t len);
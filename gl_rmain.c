@@ -153,8 +153,10 @@ cvar_t gl_fogstart = {CF_CLIENT, "gl_fogstart", "0", "nehahra fog start distance
 cvar_t gl_fogend = {CF_CLIENT, "gl_fogend","0", "nehahra fog end distance (for Nehahra compatibility only)"};
 cvar_t gl_skyclip = {CF_CLIENT, "gl_skyclip", "4608", "nehahra farclip distance - the real fog end (for Nehahra compatibility only)"};
 
-cvar_t r_texture_dds_load = {CF_CLIENT | CF_ARCHIVE, "r_texture_dds_load", "0", "load compressed dds/filename.dds texture instead of filename.tga, if the file exists (requires driver support)"};
+cvar_t r_texture_dds_load = {CF_CLIENT | CF_ARCHIVE, "r_texture_dds_load", "0", "load compressed dds/filename.dds texture instead of filename.tga, if the file exists (requires driver support), see r_texture_dds_bake to fill the cache ahead of time"};
 cvar_t r_texture_dds_save = {CF_CLIENT | CF_ARCHIVE, "r_texture_dds_save", "0", "save compressed dds/filename.dds texture when filename.tga is loaded, so that it can be loaded instead next time"};
+cvar_t r_texture_async = {CF_CLIENT | CF_ARCHIVE, "r_texture_async", "1", "decode model skins that appear during the game on the task queue and draw them grey until they are uploaded, instead of stalling the frame (not used while loading a level, or with r_texture_dds_load/r_texture_dds_save/r_fixtrans_auto)"};
+cvar_t r_texture_async_uploadtime = {CF_CLIENT | CF_ARCHIVE, "r_texture_async_uploadtime", "2", "milliseconds per frame to spend uploading skins decoded by r_texture_async (at least one skin is uploaded each frame)"};
 
 cvar_t r_usedepthtextures = {CF_CLIENT | CF_ARCHIVE, "r_usedepthtextures", "1", "use depth texture instead of depth renderbuffer where possible, uses less video memory but may render slower (or faster) depending on hardware"};
 cvar_t r_viewfbo = {CF_CLIENT | CF_ARCHIVE, "r_viewfbo", "0", "enables use of an 8bit (1) or 16bit (2) or 32bit (3) per component float framebuffer render, which may be at a different resolution than the video mode; the default setting of 0 uses a framebuffer render when required, and renders directly to the screen otherwise"};
@@ -244,6 +246,9 @@ cvar_t r_glsl_saturation_redcompensate = {CF_CLIENT | CF_ARCHIVE, "r_glsl_satura
 
 cvar_t r_glsl_vertextextureblend_usebothalphas = {CF_CLIENT | CF_ARCHIVE, "r_glsl_vertextextureblend_usebothalphas", "0", "use both alpha layers on vertex blended surfaces, each alpha layer sets amount of 'blend leak' on another layer, requires mod_q3shader_force_terrain_alphaflag on."};
 
+cvar_t r_animcache_sharedposes = {CF_CLIENT | CF_ARCHIVE, "r_animcache_sharedposes", "1", "entities with the same model, frame blend and skeleton share their animated vertices or bone matrices within a view"};
+cvar_t r_animcache_threaded = {CF_CLIENT | CF_ARCHIVE, "r_animcache_threaded", "1", "skin visible animated entities on the CPU in parallel, keeps one task queue thread per CPU running (limited by taskqueue_maxthreads); has no effect on entities skinned by r_glsl_skeletal"};
+
 // FIXME: This cvar would grow to a ridiculous size after several launches and clean exits when used during surface sorting.
 cvar_t r_framedatasize = {CF_CLIENT | CF_ARCHIVE, "r_framedatasize", "0.5", "size of renderer data cache used during one frame (for skeletal animation caching, light processing, etc)"};
 cvar_t r_buffermegs[R_BUFFERDATA_COUNT] =
@@ -2157,6 +2162,75 @@ typedef struct
 r_skinframe_t;
 r_skinframe_t r_skinframe;
 
+// images of a skinframe loaded with TEXF_ASYNC, in the order the synchronous loader tries them
+typedef enum r_skinframe_asyncimage_e
+{
+	R_SKINFRAME_ASYNC_BASE,
+	R_SKINFRAME_ASYNC_NORM,
+	R_SKINFRAME_ASYNC_BUMP,
+	R_SKINFRAME_ASYNC_GLOW,
+	R_SKINFRAME_ASYNC_GLOSS,
+	R_SKINFRAME_ASYNC_PANTS,
+	R_SKINFRAME_ASYNC_SHIRT,
+	R_SKINFRAME_ASYNC_REFLECT,
+	R_SKINFRAME_ASYNC_COUNT
+}
+r_skinframe_asyncimage_t;
+
+typedef struct r_skinframe_asyncfile_s
+{
+	imagefile_t file;
+	// filled in by the task
+	unsigned char *pixels;
+	int width;
+	int height;
+	int miplevel;
+	qbool hasalpha; // image_hasalpha of the decode
+}
+r_skinframe_asyncfile_t;
+
+// a skinframe being decoded on the task queue, everything the task reads is
+// copied in here when it is queued so it never touches the skinframe or cvars
+typedef struct r_skinframe_async_s
+{
+	taskqueue_task_t task;
+	struct r_skinframe_async_s *next;
+	// NULL if the skinframe was purged or reloaded before the upload
+	skinframe_t *skinframe;
+	char name[MAX_QPATH];
+	int textureflags;
+	int miplevel;
+	qbool complain;
+	qbool fallbacknotexture;
+	qbool loadnormalmap;
+	qbool loadfog;
+	float bumpscale_bumpmap;
+	float bumpscale_basetexture;
+	r_skinframe_asyncfile_t images[R_SKINFRAME_ASYNC_COUNT];
+	// filled in by the task, only hasalpha and avgcolor are used
+	skinframe_t decoded;
+	unsigned char *fogpixels;
+	unsigned char *nmappixels;
+	int nmapwidth;
+	int nmapheight;
+	int nmapmiplevel;
+}
+r_skinframe_async_t;
+
+// queued jobs, oldest first
+static r_skinframe_async_t *r_skinframe_asyncjobs;
+// whether the queued jobs hold worker threads, TaskQueue_Frame alone would
+// start none for a handful of decodes and run them on the main thread
+static qbool r_skinframe_asyncthreads;
+
+static void R_SkinFrame_CancelAsync(skinframe_t *s)
+{
+	// the job is freed when its task finishes, it just won't upload anything
+	if (s->async)
+		s->async->skinframe = NULL;
+	s->async = NULL;
+}
+
 void R_SkinFrame_PrepareForPurge(void)
 {
 	r_skinframe.loadsequence++;
@@ -2189,6 +2263,7 @@ void R_SkinFrame_PurgeSkinFrame(skinframe_t *s)
 	R_PurgeTexture(s->glow); s->glow = NULL;
 	R_PurgeTexture(s->fog); s->fog = NULL;
 	R_PurgeTexture(s->reflect); s->reflect = NULL;
+	R_SkinFrame_CancelAsync(s);
 	s->loadsequence = 0;
 }
 
@@ -2303,6 +2378,270 @@ skinframe_t *R_SkinFrame_Find(const char *name, int textureflags, int comparewid
 		skinframe->avgcolor[3] = avgcolor[4] / (255.0 * cnt); \
 	}
 
+// t->p[0] = r_skinframe_async_t to decode
+static void R_SkinFrame_Async_Task(taskqueue_task_t *t)
+{
+	r_skinframe_async_t *job = (r_skinframe_async_t *)t->p[0];
+	skinframe_t *skinframe = &job->decoded; // for R_SKINFRAME_LOAD_AVERAGE_COLORS
+	r_skinframe_asyncfile_t *image;
+	r_skinframe_asyncfile_t *base = job->images + R_SKINFRAME_ASYNC_BASE;
+	r_skinframe_asyncfile_t *bump = job->images + R_SKINFRAME_ASYNC_BUMP;
+	int i, j;
+
+	for (i = 0, image = job->images;i < R_SKINFRAME_ASYNC_COUNT;i++, image++)
+	{
+		if (image->file.loadfunc)
+		{
+			image->pixels = Image_DecodeFileBGRA(&image->file, false, &image->miplevel, &image->width, &image->height);
+			image->hasalpha = image_hasalpha;
+		}
+	}
+
+	if (base->pixels)
+	{
+		if (job->textureflags & TEXF_ALPHA)
+		{
+			skinframe->hasalpha = base->hasalpha;
+			if (job->loadfog && skinframe->hasalpha)
+			{
+				job->fogpixels = (unsigned char *)Mem_Alloc(tempmempool, base->width * base->height * 4);
+				for (j = 0;j < base->width * base->height * 4;j += 4)
+				{
+					job->fogpixels[j+0] = 255;
+					job->fogpixels[j+1] = 255;
+					job->fogpixels[j+2] = 255;
+					job->fogpixels[j+3] = base->pixels[j+3];
+				}
+			}
+		}
+		R_SKINFRAME_LOAD_AVERAGE_COLORS(base->width * base->height, base->pixels[4 * pix + comp]);
+
+		if (job->loadnormalmap && !job->images[R_SKINFRAME_ASYNC_NORM].pixels)
+		{
+			if (bump->pixels)
+			{
+				job->nmappixels = (unsigned char *)Mem_Alloc(tempmempool, bump->width * bump->height * 4);
+				Image_HeightmapToNormalmap_BGRA(bump->pixels, job->nmappixels, bump->width, bump->height, false, job->bumpscale_bumpmap);
+				job->nmapwidth = bump->width;
+				job->nmapheight = bump->height;
+				job->nmapmiplevel = bump->miplevel;
+			}
+			else if (job->bumpscale_basetexture > 0)
+			{
+				job->nmappixels = (unsigned char *)Mem_Alloc(tempmempool, base->width * base->height * 4);
+				Image_HeightmapToNormalmap_BGRA(base->pixels, job->nmappixels, base->width, base->height, false, job->bumpscale_basetexture);
+				job->nmapwidth = base->width;
+				job->nmapheight = base->height;
+				job->nmapmiplevel = job->miplevel;
+			}
+		}
+	}
+	t->done = 1;
+}
+
+static void R_SkinFrame_Async_Free(r_skinframe_async_t *job)
+{
+	int i;
+	for (i = 0;i < R_SKINFRAME_ASYNC_COUNT;i++)
+	{
+		if (job->images[i].pixels)
+			Mem_Free(job->images[i].pixels);
+		Image_CloseFile(&job->images[i].file);
+	}
+	if (job->fogpixels)
+		Mem_Free(job->fogpixels);
+	if (job->nmappixels)
+		Mem_Free(job->nmappixels);
+	Mem_Free(job);
+}
+
+static rtexture_t *R_SkinFrame_Async_LoadTexture(r_skinframe_async_t *job, r_skinframe_asyncimage_t index, const char *suffix, textype_t textype, int flags)
+{
+	r_skinframe_asyncfile_t *image = job->images + index;
+	char vabuf[1024];
+	if (!image->pixels)
+		return NULL;
+	return R_LoadTexture2D(r_main_texturepool, va(vabuf, sizeof(vabuf), "%s%s", job->skinframe->basename, suffix), image->width, image->height, image->pixels, textype, flags, image->miplevel, NULL);
+}
+
+// uploads what the task decoded, this is the same as the end of
+// R_SkinFrame_LoadExternal_SkinFrame
+static void R_SkinFrame_Async_Upload(r_skinframe_async_t *job)
+{
+	skinframe_t *skinframe = job->skinframe;
+	int textureflags = job->textureflags;
+	int nmapflags = (TEXF_ALPHA | textureflags) & (r_mipnormalmaps.integer ? ~0 : ~TEXF_MIPMAP) & (gl_texturecompression_normal.integer && gl_texturecompression.integer ? ~0 : ~TEXF_COMPRESS);
+	textype_t textype = vid.sRGB3D ? TEXTYPE_SRGB_BGRA : TEXTYPE_BGRA;
+	char vabuf[1024];
+
+	skinframe->async = NULL;
+	if (!job->images[R_SKINFRAME_ASYNC_BASE].pixels)
+	{
+		// the file didn't decode, the synchronous loader tries the other formats and the fallbacks
+		R_SkinFrame_LoadExternal_SkinFrame(skinframe, job->name, textureflags, job->complain, job->fallbacknotexture);
+		return;
+	}
+
+	skinframe->base = R_SkinFrame_Async_LoadTexture(job, R_SKINFRAME_ASYNC_BASE, "", textype, textureflags & (gl_texturecompression_color.integer && gl_texturecompression.integer ? ~0 : ~TEXF_COMPRESS));
+	skinframe->hasalpha = job->decoded.hasalpha;
+	Vector4Copy(job->decoded.avgcolor, skinframe->avgcolor);
+	if (job->fogpixels)
+		skinframe->fog = R_LoadTexture2D (r_main_texturepool, va(vabuf, sizeof(vabuf), "%s_mask", skinframe->basename), job->images[R_SKINFRAME_ASYNC_BASE].width, job->images[R_SKINFRAME_ASYNC_BASE].height, job->fogpixels, TEXTYPE_BGRA, textureflags & (gl_texturecompression_color.integer && gl_texturecompression.integer ? ~0 : ~TEXF_COMPRESS), job->images[R_SKINFRAME_ASYNC_BASE].miplevel, NULL);
+	skinframe->nmap = R_SkinFrame_Async_LoadTexture(job, R_SKINFRAME_ASYNC_NORM, "_nmap", TEXTYPE_BGRA, nmapflags);
+	if (!skinframe->nmap && job->nmappixels)
+		skinframe->nmap = R_LoadTexture2D (r_main_texturepool, va(vabuf, sizeof(vabuf), "%s_nmap", skinframe->basename), job->nmapwidth, job->nmapheight, job->nmappixels, TEXTYPE_BGRA, nmapflags, job->nmapmiplevel, NULL);
+	skinframe->glow = R_SkinFrame_Async_LoadTexture(job, R_SKINFRAME_ASYNC_GLOW, "_glow", textype, textureflags & (gl_texturecompression_glow.integer && gl_texturecompression.integer ? ~0 : ~TEXF_COMPRESS));
+	skinframe->gloss = R_SkinFrame_Async_LoadTexture(job, R_SKINFRAME_ASYNC_GLOSS, "_gloss", textype, (TEXF_ALPHA | textureflags) & (gl_texturecompression_gloss.integer && gl_texturecompression.integer ? ~0 : ~TEXF_COMPRESS));
+	skinframe->pants = R_SkinFrame_Async_LoadTexture(job, R_SKINFRAME_ASYNC_PANTS, "_pants", textype, textureflags & (gl_texturecompression_color.integer && gl_texturecompression.integer ? ~0 : ~TEXF_COMPRESS));
+	skinframe->shirt = R_SkinFrame_Async_LoadTexture(job, R_SKINFRAME_ASYNC_SHIRT, "_shirt", textype, textureflags & (gl_texturecompression_color.integer && gl_texturecompression.integer ? ~0 : ~TEXF_COMPRESS));
+	skinframe->reflect = R_SkinFrame_Async_LoadTexture(job, R_SKINFRAME_ASYNC_REFLECT, "_reflect", textype, textureflags & (gl_texturecompression_reflectmask.integer && gl_texturecompression.integer ? ~0 : ~TEXF_COMPRESS));
+}
+
+/*
+===============
+R_SkinFrame_FinishAsync
+
+Uploads the skinframes whose decode has finished, as many as fit in
+r_texture_async_uploadtime (called once per frame)
+===============
+*/
+void R_SkinFrame_FinishAsync(void)
+{
+	r_skinframe_async_t *job, **link;
+	double starttime = Sys_DirtyTime();
+	int numuploaded = 0;
+
+	for (link = &r_skinframe_asyncjobs;(job = *link);)
+	{
+		if (!TaskQueue_IsDone(&job->task))
+		{
+			link = &job->next;
+			continue;
+		}
+		if (job->skinframe)
+		{
+			if (numuploaded > 0 && (Sys_DirtyTime() - starttime) * 1000.0 >= r_texture_async_uploadtime.value)
+				break;
+			R_SkinFrame_Async_Upload(job);
+			numuploaded++;
+		}
+		*link = job->next;
+		R_SkinFrame_Async_Free(job);
+	}
+	if (!r_skinframe_asyncjobs && r_skinframe_asyncthreads)
+	{
+		TaskQueue_ReleaseThreads();
+		r_skinframe_asyncthreads = false;
+	}
+}
+
+static void R_SkinFrame_Async_Shutdown(void)
+{
+	r_skinframe_async_t *job;
+	while ((job = r_skinframe_asyncjobs))
+	{
+		r_skinframe_asyncjobs = job->next;
+		TaskQueue_WaitForTaskDone(&job->task);
+		R_SkinFrame_Async_Free(job);
+	}
+	if (r_skinframe_asyncthreads)
+		TaskQueue_ReleaseThreads();
+	r_skinframe_asyncthreads = false;
+}
+
+/*
+===============
+R_SkinFrame_LoadExternal_Async
+
+Finds the images of a skin and queues their decode, returning a skinframe with
+no textures that R_SkinFrame_FinishAsync fills in later.  Returns NULL if the
+skin has to be loaded synchronously.
+===============
+*/
+static skinframe_t *R_SkinFrame_LoadExternal_Async(skinframe_t *skinframe, const char *name, int textureflags, int miplevel, qbool complain, qbool fallbacknotexture)
+{
+	r_skinframe_async_t *job, **link;
+	char basename[MAX_QPATH];
+	char vabuf[1024];
+	int i;
+
+	// dds files and r_fixtrans_auto are only handled by the synchronous path,
+	// and a level load is going to wait for everything anyway
+	if (!r_texture_async.integer || cls.signon != SIGNONS || r_loaddds || r_savedds || r_fixtrans_auto.integer)
+		return NULL;
+	// without a worker thread the decode would still run on this thread,
+	// just a frame later
+	if (!r_skinframe_asyncthreads)
+	{
+		if (!TaskQueue_RequireThreads(0))
+		{
+			TaskQueue_ReleaseThreads();
+			return NULL;
+		}
+		r_skinframe_asyncthreads = true;
+	}
+
+	job = (r_skinframe_async_t *)Mem_Alloc(r_main_mempool, sizeof(*job));
+	if (!Image_OpenFile(name, &job->images[R_SKINFRAME_ASYNC_BASE].file))
+	{
+		// missing, or a wad lump or embedded pic
+		Mem_Free(job);
+		return NULL;
+	}
+
+	// the files are looked up here as the filesystem isn't thread safe, only the decode is queued
+	Image_StripImageExtension(name, basename, sizeof(basename));
+	if (r_loadnormalmap && !Image_OpenFile(va(vabuf, sizeof(vabuf), "%s_norm", basename), &job->images[R_SKINFRAME_ASYNC_NORM].file) && r_shadow_bumpscale_bumpmap.value > 0)
+		Image_OpenFile(va(vabuf, sizeof(vabuf), "%s_bump", basename), &job->images[R_SKINFRAME_ASYNC_BUMP].file);
+	if (!Image_OpenFile(va(vabuf, sizeof(vabuf), "%s_glow", basename), &job->images[R_SKINFRAME_ASYNC_GLOW].file)
+	 && !Image_OpenFile(va(vabuf, sizeof(vabuf), "%s.blend", basename), &job->images[R_SKINFRAME_ASYNC_GLOW].file)
+	 && !Image_OpenFile(va(vabuf, sizeof(vabuf), "%s_blend", basename), &job->images[R_SKINFRAME_ASYNC_GLOW].file))
+		Image_OpenFile(va(vabuf, sizeof(vabuf), "%s_luma", basename), &job->images[R_SKINFRAME_ASYNC_GLOW].file);
+	if (r_loadgloss)
+		Image_OpenFile(va(vabuf, sizeof(vabuf), "%s_gloss", basename), &job->images[R_SKINFRAME_ASYNC_GLOSS].file);
+	Image_OpenFile(va(vabuf, sizeof(vabuf), "%s_pants", basename), &job->images[R_SKINFRAME_ASYNC_PANTS].file);
+	Image_OpenFile(va(vabuf, sizeof(vabuf), "%s_shirt", basename), &job->images[R_SKINFRAME_ASYNC_SHIRT].file);
+	Image_OpenFile(va(vabuf, sizeof(vabuf), "%s_reflect", basename), &job->images[R_SKINFRAME_ASYNC_REFLECT].file);
+
+	if (developer_loading.integer)
+		Con_Printf("loading skin \"%s\" in the background\n", name);
+
+	if (!skinframe)
+		skinframe = R_SkinFrame_Find(name, textureflags, 0, 0, 0, true);
+	R_SkinFrame_CancelAsync(skinframe);
+	skinframe->stain = NULL;
+	skinframe->merged = NULL;
+	skinframe->base = NULL;
+	skinframe->pants = NULL;
+	skinframe->shirt = NULL;
+	skinframe->nmap = NULL;
+	skinframe->gloss = NULL;
+	skinframe->glow = NULL;
+	skinframe->fog = NULL;
+	skinframe->reflect = NULL;
+	skinframe->hasalpha = false;
+
+	job->skinframe = skinframe;
+	dp_strlcpy(job->name, name, sizeof(job->name));
+	job->textureflags = textureflags & ~(TEXF_FORCE_RELOAD | TEXF_ASYNC);
+	job->miplevel = miplevel;
+	job->complain = complain;
+	job->fallbacknotexture = fallbacknotexture;
+	job->loadnormalmap = r_loadnormalmap;
+	job->loadfog = r_loadfog;
+	job->bumpscale_bumpmap = r_shadow_bumpscale_bumpmap.value;
+	job->bumpscale_basetexture = r_shadow_bumpscale_basetexture.value;
+	for (i = 0;i < R_SKINFRAME_ASYNC_COUNT;i++)
+		job->images[i].miplevel = miplevel;
+	TaskQueue_Setup(&job->task, NULL, R_SkinFrame_Async_Task, 0, 0, job, NULL);
+	TaskQueue_Enqueue(1, &job->task);
+	for (link = &r_skinframe_asyncjobs;*link;link = &(*link)->next)
+		;
+	*link = job;
+	skinframe->async = job;
+	return skinframe;
+}
+
 skinframe_t *R_SkinFrame_LoadExternal(const char *name, int textureflags, qbool complain, qbool fallbacknotexture)
 {
 	skinframe_t *skinframe;
@@ -2310,9 +2649,9 @@ skinframe_t *R_SkinFrame_LoadExternal(const char *name, int textureflags, qbool
 	if (cls.state == ca_dedicated)
 		return NULL;
 
-	// return an existing skinframe if already loaded
+	// return an existing skinframe if already loaded (or still decoding)
 	skinframe = R_SkinFrame_Find(name, textureflags, 0, 0, 0, false);
-	if (skinframe && skinframe->base)
+	if (skinframe && (skinframe->base || skinframe->async))
 		return skinframe;
 
 	// if the skinframe doesn't exist this will create it
@@ -2328,6 +2667,7 @@ skinframe_t *R_SkinFrame_LoadExternal_SkinFrame(skinframe_t *skinframe, const ch
 	unsigned char *basepixels = NULL;
 	int basepixels_width = 0;
 	int basepixels_height = 0;
+	qbool basepixels_hasalpha = false;
 	rtexture_t *ddsbase = NULL;
 	qbool ddshasalpha = false;
 	float ddsavgcolor[4];
@@ -2340,6 +2680,9 @@ skinframe_t *R_SkinFrame_LoadExternal_SkinFrame(skinframe_t *skinframe, const ch
 	if (cls.state == ca_dedicated)
 		return NULL;
 
+	if ((textureflags & TEXF_ASYNC) && (skinframe = R_SkinFrame_LoadExternal_Async(skinframe, name, textureflags, miplevel, complain, fallbacknotexture)))
+		return skinframe;
+
 	Image_StripImageExtension(name, basename, sizeof(basename));
 
 	// check for DDS texture file first
@@ -2350,6 +2693,10 @@ skinframe_t *R_SkinFrame_LoadExternal_SkinFrame(skinframe_t *skinframe, const ch
 			basepixels = Image_GenerateNoTexture();
 		if (basepixels == NULL)
 			return NULL;
+		// read these before anything else decodes on this thread
+		basepixels_width = image_width;
+		basepixels_height = image_height;
+		basepixels_hasalpha = image_hasalpha;
 	}
 
 	// FIXME handle miplevel
@@ -2360,7 +2707,8 @@ skinframe_t *R_SkinFrame_LoadExternal_SkinFrame(skinframe_t *skinframe, const ch
 	// we've got some pixels to store, so really allocate this new texture now
 	if (!skinframe)
 		skinframe = R_SkinFrame_Find(name, textureflags, 0, 0, 0, true);
-	textureflags &= ~TEXF_FORCE_RELOAD;
+	textureflags &= ~(TEXF_FORCE_RELOAD | TEXF_ASYNC);
+	R_SkinFrame_CancelAsync(skinframe);
 	skinframe->stain = NULL;
 	skinframe->merged = NULL;
 	skinframe->base = NULL;
@@ -2385,31 +2733,22 @@ skinframe_t *R_SkinFrame_LoadExternal_SkinFrame(skinframe_t *skinframe, const ch
 	}
 	else
 	{
-		basepixels_width = image_width;
-		basepixels_height = image_height;
 		skinframe->base = R_LoadTexture2D (r_main_texturepool, skinframe->basename, basepixels_width, basepixels_height, basepixels, vid.sRGB3D ? TEXTYPE_SRGB_BGRA : TEXTYPE_BGRA, textureflags & (gl_texturecompression_color.integer && gl_texturecompression.integer ? ~0 : ~TEXF_COMPRESS), miplevel, NULL);
 		if (textureflags & TEXF_ALPHA)
 		{
-			for (j = 3;j < basepixels_width * basepixels_height * 4;j += 4)
-			{
-				if (basepixels[j] < 255)
-				{
-					skinframe->hasalpha = true;
-					break;
-				}
-			}
+			skinframe->hasalpha = basepixels_hasalpha;
 			if (r_loadfog && skinframe->hasalpha)
 			{
 				// has transparent pixels
-				pixels = (unsigned char *)Mem_Alloc(tempmempool, image_width * image_height * 4);
-				for (j = 0;j < image_width * image_height * 4;j += 4)
+				pixels = (unsigned char *)Mem_Alloc(tempmempool, basepixels_width * basepixels_height * 4);
+				for (j = 0;j < basepixels_width * basepixels_height * 4;j += 4)
 				{
 					pixels[j+0] = 255;
 					pixels[j+1] = 255;
 					pixels[j+2] = 255;
 					pixels[j+3] = basepixels[j+3];
 				}
-				skinframe->fog = R_LoadTexture2D (r_main_texturepool, va(vabuf, sizeof(vabuf), "%s_mask", skinframe->basename), image_width, image_height, pixels, TEXTYPE_BGRA, textureflags & (gl_texturecompression_color.integer && gl_texturecompression.integer ? ~0 : ~TEXF_COMPRESS), miplevel, NULL);
+				skinframe->fog = R_LoadTexture2D (r_main_texturepool, va(vabuf, sizeof(vabuf), "%s_mask", skinframe->basename), basepixels_width, basepixels_height, pixels, TEXTYPE_BGRA, textureflags & (gl_texturecompression_color.integer && gl_texturecompression.integer ? ~0 : ~TEXF_COMPRESS), miplevel, NULL);
 				Mem_Free(pixels);
 			}
 		}
@@ -3156,6 +3495,7 @@ static void gl_main_shutdown(void)
 	r_qwskincache_size = 0;
 
 	// clear out the r_skinframe state
+	R_SkinFrame_Async_Shutdown();
 	Mem_ExpandableArray_FreeArray(&r_skinframe.array);
 	memset(&r_skinframe, 0, sizeof(r_skinframe));
 
@@ -3301,6 +3641,8 @@ void GL_Main_Init(void)
 	Cvar_RegisterVariable(&r_transparent_sortarraysize);
 	Cvar_RegisterVariable(&r_texture_dds_load);
 	Cvar_RegisterVariable(&r_texture_dds_save);
+	Cvar_RegisterVariable(&r_texture_async);
+	Cvar_RegisterVariable(&r_texture_async_uploadtime);
 	Cvar_RegisterVariable(&r_usedepthtextures);
 	Cvar_RegisterVariable(&r_viewfbo);
 	Cvar_RegisterVariable(&r_rendertarget_debug);
@@ -3378,6 +3720,8 @@ void GL_Main_Init(void)
 	Cvar_RegisterVariable(&r_glsl_saturation);
 	Cvar_RegisterVariable(&r_glsl_saturation_redcompensate);
 	Cvar_RegisterVariable(&r_glsl_vertextextureblend_usebothalphas);
+	Cvar_RegisterVariable(&r_animcache_sharedposes);
+	Cvar_RegisterVariable(&r_animcache_threaded);
 	Cvar_RegisterVariable(&r_framedatasize);
 	for (i = 0;i < R_BUFFERDATA_COUNT;i++)
 		Cvar_RegisterVariable(&r_buffermegs[i]);
@@ -3733,15 +4077,36 @@ r_meshbuffer_t *R_BufferData_Store(size_t datasize, const void *data, r_bufferda
  * multiple times in one frame for lighting, shadowing, reflections, etc.
  */
 
+// whether r_animcache_threaded holds worker threads, see TaskQueue_RequireThreads
+static qbool r_animcache_threadsrequired = false;
+
 void R_AnimCache_Free(void)
 {
+	if (r_animcache_threadsrequired)
+		TaskQueue_ReleaseThreads();
+	r_animcache_threadsrequired = false;
 }
 
+// entities of this view by (model, frameblend, skeleton), so entities in the
+// same animation state can share one set of bone matrices or vertex arrays
+static entity_render_t **r_animcache_posehash;
+static int r_animcache_posehashmask;
+
 void R_AnimCache_ClearCache(void)
 {
 	int i;
 	entity_render_t *ent;
 
+	r_animcache_posehash = NULL;
+	if (r_animcache_sharedposes.integer && r_refdef.scene.numentities)
+	{
+		for (i = 16;i < r_refdef.scene.numentities * 2;i <<= 1)
+			;
+		r_animcache_posehashmask = i - 1;
+		r_animcache_posehash = (entity_render_t **)R_FrameData_Alloc(sizeof(*r_animcache_posehash) * i);
+		memset(r_animcache_posehash, 0, sizeof(*r_animcache_posehash) * i);
+	}
+
 	for (i = 0;i < r_refdef.scene.numentities;i++)
 	{
 		ent = r_refdef.scene.entities[i];
@@ -3764,10 +4129,59 @@ void R_AnimCache_ClearCache(void)
 	}
 }
 
-qbool R_AnimCache_GetEntity(entity_render_t *ent, qbool wantnormals, qbool wanttangents)
+static qbool R_AnimCache_SamePose(const entity_render_t *a, const entity_render_t *b)
+{
+	return a->model == b->model && a->skeleton == b->skeleton && !memcmp(a->frameblend, b->frameblend, sizeof(a->frameblend));
+}
+
+// returns the first entity seen in this view with the same animation state
+// as ent, or NULL (and remembers ent) if there is none
+static entity_render_t *R_AnimCache_FindPose(entity_render_t *ent)
+{
+	int i, index;
+	unsigned int hashindex;
+	entity_render_t *other;
+
+	hashindex = (unsigned int)((size_t)ent->model >> 4) * 0x9E3779B1u ^ (unsigned int)((size_t)ent->skeleton >> 4);
+	for (i = 0;i < MAX_FRAMEBLENDS && ent->frameblend[i].lerp > 0;i++)
+		hashindex = (hashindex * 31 + ent->frameblend[i].subframe) * 31 + (unsigned int)(ent->frameblend[i].lerp * 65536.0f);
+	hashindex ^= hashindex >> 15;
+	r_refdef.stats[r_stat_animcache_pose_lookups]++;
+	for (i = 0;i <= r_animcache_posehashmask;i++)
+	{
+		index = (hashindex + i) & r_animcache_posehashmask;
+		other = r_animcache_posehash[index];
+		if (!other)
+		{
+			r_animcache_posehash[index] = ent;
+			return NULL;
+		}
+		if (other != ent && R_AnimCache_SamePose(ent, other))
+			return other;
+	}
+	return NULL;
+}
+
+typedef struct r_animcache_job_s
+{
+	entity_render_t *ent;
+	float *vertex3f;
+	float *normal3f;
+	float *svector3f;
+	float *tvector3f;
+}
+r_animcache_job_t;
+
+// allocates the cache arrays of ent and describes the AnimateVertices call
+// that fills them in job (job->ent stays NULL if no call is needed), this
+// part uses R_FrameData so it must run on the main thread
+static qbool R_AnimCache_PrepareEntity(entity_render_t *ent, qbool wantnormals, qbool wanttangents, r_animcache_job_t *job)
 {
 	model_t *model = ent->model;
 	int numvertices;
+	entity_render_t *owner;
+
+	job->ent = NULL;
 
 	// see if this ent is worth caching
 	if (!model || !model->Draw || !model->AnimateVertices)
@@ -3789,6 +4203,28 @@ qbool R_AnimCache_GetEntity(entity_render_t *ent, qbool wantnormals, qbool wantt
 		if (!wantnormals && !wanttangents)
 			return false;
 	}
+	else if (r_animcache_posehash && (owner = R_AnimCache_FindPose(ent)))
+	{
+		// another entity in the same animation state was cached already
+		if (owner->animcache_skeletaltransform3x4)
+		{
+			ent->animcache_skeletaltransform3x4 = owner->animcache_skeletaltransform3x4;
+			ent->animcache_skeletaltransform3x4buffer = owner->animcache_skeletaltransform3x4buffer;
+			ent->animcache_skeletaltransform3x4offset = owner->animcache_skeletaltransform3x4offset;
+			ent->animcache_skeletaltransform3x4size = owner->animcache_skeletaltransform3x4size;
+			r_refdef.stats[r_stat_animcache_pose_hits]++;
+			return true;
+		}
+		if (owner->animcache_vertex3f && (!wantnormals || owner->animcache_normal3f) && (!wanttangents || owner->animcache_svector3f))
+		{
+			ent->animcache_vertex3f = owner->animcache_vertex3f;
+			ent->animcache_normal3f = owner->animcache_normal3f;
+			ent->animcache_svector3f = owner->animcache_svector3f;
+			ent->animcache_tvector3f = owner->animcache_tvector3f;
+			r_refdef.stats[r_stat_animcache_pose_hits]++;
+			return true;
+		}
+	}
 
 	// check which kind of cache we need to generate
 	if (r_gpuskeletal && model->num_bones > 0 && model->surfmesh.data_skeletalindex4ub)
@@ -3817,7 +4253,11 @@ qbool R_AnimCache_GetEntity(entity_render_t *ent, qbool wantnormals, qbool wantt
 				ent->animcache_svector3f = (float *)R_FrameData_Alloc(sizeof(float[3])*numvertices);
 				ent->animcache_tvector3f = (float *)R_FrameData_Alloc(sizeof(float[3])*numvertices);
 			}
-			model->AnimateVertices(model, ent->frameblend, ent->skeleton, NULL, wantnormals ? ent->animcache_normal3f : NULL, wanttangents ? ent->animcache_svector3f : NULL, wanttangents ? ent->animcache_tvector3f : NULL);
+			job->ent = ent;
+			job->vertex3f = NULL;
+			job->normal3f = wantnormals ? ent->animcache_normal3f : NULL;
+			job->svector3f = wanttangents ? ent->animcache_svector3f : NULL;
+			job->tvector3f = wanttangents ? ent->animcache_tvector3f : NULL;
 			r_refdef.stats[r_stat_animcache_shade_count] += 1;
 			r_refdef.stats[r_stat_animcache_shade_vertices] += numvertices;
 			r_refdef.stats[r_stat_animcache_shade_maxvertices] = max(r_refdef.stats[r_stat_animcache_shade_maxvertices], numvertices);
@@ -3835,7 +4275,11 @@ qbool R_AnimCache_GetEntity(entity_render_t *ent, qbool wantnormals, qbool wantt
 			ent->animcache_svector3f = (float *)R_FrameData_Alloc(sizeof(float[3])*numvertices);
 			ent->animcache_tvector3f = (float *)R_FrameData_Alloc(sizeof(float[3])*numvertices);
 		}
-		model->AnimateVertices(model, ent->frameblend, ent->skeleton, ent->animcache_vertex3f, ent->animcache_normal3f, ent->animcache_svector3f, ent->animcache_tvector3f);
+		job->ent = ent;
+		job->vertex3f = ent->animcache_vertex3f;
+		job->normal3f = ent->animcache_normal3f;
+		job->svector3f = ent->animcache_svector3f;
+		job->tvector3f = ent->animcache_tvector3f;
 		if (wantnormals || wanttangents)
 		{
 			r_refdef.stats[r_stat_animcache_shade_count] += 1;
@@ -3849,16 +4293,78 @@ qbool R_AnimCache_GetEntity(entity_render_t *ent, qbool wantnormals, qbool wantt
 	return true;
 }
 
+static void R_AnimCache_RunJob(const r_animcache_job_t *job)
+{
+	entity_render_t *ent = job->ent;
+	ent->model->AnimateVertices(ent->model, ent->frameblend, ent->skeleton, job->vertex3f, job->normal3f, job->svector3f, job->tvector3f);
+}
+
+qbool R_AnimCache_GetEntity(entity_render_t *ent, qbool wantnormals, qbool wanttangents)
+{
+	r_animcache_job_t job;
+	if (!R_AnimCache_PrepareEntity(ent, wantnormals, wanttangents, &job))
+		return false;
+	if (job.ent)
+		R_AnimCache_RunJob(&job);
+	return true;
+}
+
+// t->p[0] = r_animcache_job_t to run
+static void R_AnimCache_Task(taskqueue_task_t *t)
+{
+	R_AnimCache_RunJob((const r_animcache_job_t *)t->p[0]);
+	t->done = 1;
+}
+
 void R_AnimCache_CacheVisibleEntities(void)
 {
-	int i;
+	int i, numjobs;
+	r_animcache_job_t *jobs;
+	taskqueue_task_t *tasks;
+	taskqueue_task_t done_task;
 
-	// TODO: thread this
 	// NOTE: R_PrepareRTLights() also caches entities
 
+	// a few dozen skinning tasks per frame are far below what makes
+	// TaskQueue_Frame start any threads by itself
+	if (!r_animcache_threaded.integer != !r_animcache_threadsrequired)
+	{
+		if (r_animcache_threadsrequired)
+			TaskQueue_ReleaseThreads();
+		else
+			TaskQueue_RequireThreads(0);
+		r_animcache_threadsrequired = !r_animcache_threadsrequired;
+	}
+
+	if (!r_animcache_threaded.integer)
+	{
+		for (i = 0;i < r_refdef.scene.numentities;i++)
+			if (r_refdef.viewcache.entityvisible[i])
+				R_AnimCache_GetEntity(r_refdef.scene.entities[i], true, true);
+		return;
+	}
+
+	// allocate all the output arrays up front, then skin the entities on the
+	// task queue (the gpuskeletal path finishes during the prepare)
+	jobs = (r_animcache_job_t *)R_FrameData_Alloc(sizeof(*jobs) * r_refdef.scene.numentities);
+	numjobs = 0;
 	for (i = 0;i < r_refdef.scene.numentities;i++)
 		if (r_refdef.viewcache.entityvisible[i])
-			R_AnimCache_GetEntity(r_refdef.scene.entities[i], true, true);
+			if (R_AnimCache_PrepareEntity(r_refdef.scene.entities[i], true, true, jobs + numjobs) && jobs[numjobs].ent)
+				numjobs++;
+	if (numjobs < 2)
+	{
+		for (i = 0;i < numjobs;i++)
+			R_AnimCache_RunJob(jobs + i);
+		return;
+	}
+	tasks = (taskqueue_task_t *)R_FrameData_Alloc(sizeof(*tasks) * numjobs);
+	for (i = 0;i < numjobs;i++)
+		TaskQueue_Setup(tasks + i, NULL, R_AnimCache_Task, 0, 0, jobs + i, NULL);
+	TaskQueue_Setup(&done_task, NULL, TaskQueue_Task_CheckTasksDone, numjobs, 0, tasks, NULL);
+	TaskQueue_Enqueue(numjobs, tasks);
+	TaskQueue_Enqueue(1, &done_task);
+	TaskQueue_WaitForTaskDone(&done_task);
 }
 
 //==================================================================================
@@ -6562,6 +7068,13 @@ texture_t *R_GetCurrentTexture(texture_t *t)
 	if (t->backgroundshaderpass && t->backgroundshaderpass->numframes >= 2)
 		t->backgroundcurrentskinframe = t->backgroundshaderpass->skinframes[LoopingFrameNumberFromDouble(rsurface.shadertime * t->backgroundshaderpass->framerate, t->backgroundshaderpass->numframes)];
 
+	// a skin that was still decoding when the model loaded only now knows if it has alpha
+	if (t->skinframealphapending && t->materialshaderpass && !t->materialshaderpass->skinframes[0]->async)
+	{
+		if (t->materialshaderpass->skinframes[0]->hasalpha)
+			t->basematerialflags |= MATERIALFLAG_ALPHA | MATERIALFLAG_BLENDED | MATERIALFLAG_NOSHADOW;
+		t->skinframealphapending = false;
+	}
 	t->currentmaterialflags = t->basematerialflags;
 	t->currentalpha = rsurface.entity->alpha * t->basealpha;
 	if (t->basematerialflags & MATERIALFLAG_WATERALPHA && (model->brush.supportwateralpha || r_water.integer || r_novis.integer || r_trippy.integer))
@@ -6752,7 +7265,7 @@ texture_t *R_GetCurrentTexture(texture_t *t)
 		R_SkinFrame_GenerateTexturesFromQPixels(t->currentskinframe, t->colormapping);
 	t->basetexture = (!t->colormapping && t->currentskinframe->merged) ? t->currentskinframe->merged : t->currentskinframe->base;
 	if (!t->basetexture)
-		t->basetexture = r_texture_notexture;
+		t->basetexture = t->currentskinframe->async ? r_texture_grey128 : r_texture_notexture;
 	t->pantstexture = t->colormapping ? t->currentskinframe->pants : NULL;
 	t->shirttexture = t->colormapping ? t->currentskinframe->shirt : NULL;
 	t->nmaptexture = t->currentskinframe->nmap;
@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "image.h"
 #include "jpeg.h"
 #include "image_png.h"
+#include "image_dxt.h"
 
 cvar_t gl_max_size = {CF_CLIENT | CF_ARCHIVE, "gl_max_size", "2048", "maximum allowed texture size, can be used to reduce video memory usage, limited by hardware capabilities (typically 2048, 4096, or 8192)"};
 cvar_t gl_max_lightmapsize = {CF_CLIENT | CF_ARCHIVE, "gl_max_lightmapsize", "512", "maximum allowed texture size for lightmap textures, use larger values to improve rendering speed, as long as there is enough video memory available (setting it too high for the hardware will cause very bad performance)"};
@@ -33,6 +34,7 @@ cvar_t gl_picmip_sprites = {CF_CLIENT | CF_ARCHIVE, "gl_picmip_sprites", "0", "e
 cvar_t r_picmipsprites = {CF_CLIENT | CF_ARCHIVE, "r_picmipsprites", "1", "make gl_picmip affect sprites too (saves some graphics memory in sprite heavy games) (setting this to 0 is a shorthand for gl_picmip_sprites -9999999)"};
 cvar_t gl_picmip_other = {CF_CLIENT | CF_ARCHIVE, "gl_picmip_other", "0", "extra picmip level for other textures (may be negative, which will then reduce gl_picmip for these)"};
 cvar_t r_lerpimages = {CF_CLIENT | CF_ARCHIVE, "r_lerpimages", "1", "bilinear filters images when scaling them up to power of 2 size (mode 1), looks better than glquake (mode 0)"};
+cvar_t r_srgbmipmaps = {CF_CLIENT | CF_ARCHIVE, "r_srgbmipmaps", "1", "average the colors of sRGB textures in linear space when making their mipmaps, so they don't get darker in the distance"};
 cvar_t gl_texture_anisotropy = {CF_CLIENT | CF_ARCHIVE, "gl_texture_anisotropy", "1", "anisotropic filtering quality (if supported by hardware), 1 sample (no anisotropy) and 8 sample (8 tap anisotropy) are recommended values"};
 cvar_t gl_texturecompression = {CF_CLIENT | CF_ARCHIVE, "gl_texturecompression", "0", "whether to compress textures, a value of 0 disables compression (even if the individual cvars are 1), 1 enables fast (low quality) compression at startup, 2 enables slow (high quality) compression at startup"};
 cvar_t gl_texturecompression_color = {CF_CLIENT | CF_ARCHIVE, "gl_texturecompression_color", "1", "whether to compress colormap (diffuse) textures"};
@@ -721,6 +723,7 @@ void R_Textures_Init (void)
 {
 	Cmd_AddCommand(CF_CLIENT, "gl_texturemode", &GL_TextureMode_f, "set texture filtering mode (GL_NEAREST, GL_LINEAR, GL_LINEAR_MIPMAP_LINEAR, etc); an additional argument 'force' forces the texture mode even in cases where it may not be appropriate");
 	Cmd_AddCommand(CF_CLIENT, "r_texturestats", R_TextureStats_f, "print information about all loaded textures and some statistics");
+	Cmd_AddCommand(CF_CLIENT, "r_texture_resamplebench", Image_ResampleBench_f, "times the image resample and mipmap code on the given images (or generated ones) and checks the SIMD versions against the generic one");
 	Cvar_RegisterVariable (&gl_max_size);
 	Cvar_RegisterVariable (&gl_picmip);
 	Cvar_RegisterVariable (&gl_picmip_world);
@@ -730,6 +733,7 @@ void R_Textures_Init (void)
 	Cvar_RegisterVariable (&gl_picmip_other);
 	Cvar_RegisterVariable (&gl_max_lightmapsize);
 	Cvar_RegisterVariable (&r_lerpimages);
+	Cvar_RegisterVariable (&r_srgbmipmaps);
 	Cvar_RegisterVariable (&gl_texture_anisotropy);
 	Cvar_RegisterVariable (&gl_texturecompression);
 	Cvar_RegisterVariable (&gl_texturecompression_color);
@@ -962,12 +966,30 @@ static void R_UploadPartialTexture(gltexture_t *glt, const unsigned char *data,
 	}
 }
 
+static qbool R_TextureIssRGB(gltexture_t *glt)
+{
+	switch (glt->textype->glinternalformat)
+	{
+	case GL_SRGB:
+	case GL_SRGB_ALPHA:
+	case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+	case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+		return true;
+	default:
+		return false;
+	}
+}
+
 static void R_UploadFullTexture(gltexture_t *glt, const unsigned char *data)
 {
 	int i, mip = 0, width, height, depth;
 	GLint oldbindtexnum = 0;
 	const unsigned char *prevbuffer;
+	void (*mipreduce)(const unsigned char *in, unsigned char *out, int *width, int *height, int *depth, int destwidth, int destheight, int destdepth);
 	prevbuffer = data;
+	mipreduce = r_srgbmipmaps.integer && R_TextureIssRGB(glt) ? Image_MipReduce32_sRGB : Image_MipReduce32;
 
 	// error out if a stretch is needed on special texture types
 	if (glt->texturetype != GLTEXTURETYPE_2D && (glt->tilewidth != glt->inputwidth || glt->tileheight != glt->inputheight || glt->tiledepth != glt->inputdepth))
@@ -1024,7 +1046,7 @@ static void R_UploadFullTexture(gltexture_t *glt, const unsigned char *data)
 		while (width > glt->tilewidth || height > glt->tileheight || depth > glt->tiledepth)
 		{
 			R_MakeResizeBufferBigger(width * height * depth * glt->sides * glt->bytesperpixel);
-			Image_MipReduce32(prevbuffer, resizebuffer, &width, &height, &depth, glt->tilewidth, glt->tileheight, glt->tiledepth);
+			mipreduce(prevbuffer, resizebuffer, &width, &height, &depth, glt->tilewidth, glt->tileheight, glt->tiledepth);
 			prevbuffer = resizebuffer;
 		}
 	}
@@ -1059,7 +1081,7 @@ static void R_UploadFullTexture(gltexture_t *glt, const unsigned char *data)
 					while (width > 1 || height > 1 || depth > 1)
 					{
 						R_MakeResizeBufferBigger(width * height * depth * glt->sides * glt->bytesperpixel);
-						Image_MipReduce32(prevbuffer, resizebuffer, &width, &height, &depth, 1, 1, 1);
+						mipreduce(prevbuffer, resizebuffer, &width, &height, &depth, 1, 1, 1);
 						prevbuffer = resizebuffer;
 						qglTexImage2D(GL_TEXTURE_2D, mip++, glt->glinternalformat, width, height, 0, glt->glformat, glt->gltype, prevbuffer);CHECKGLERROR
 					}
@@ -1073,7 +1095,7 @@ static void R_UploadFullTexture(gltexture_t *glt, const unsigned char *data)
 					while (width > 1 || height > 1 || depth > 1)
 					{
 						R_MakeResizeBufferBigger(width * height * depth * glt->sides * glt->bytesperpixel);
-						Image_MipReduce32(prevbuffer, resizebuffer, &width, &height, &depth, 1, 1, 1);
+						mipreduce(prevbuffer, resizebuffer, &width, &height, &depth, 1, 1, 1);
 						prevbuffer = resizebuffer;
 						qglTexImage3D(GL_TEXTURE_3D, mip++, glt->glinternalformat, width, height, depth, 0, glt->glformat, glt->gltype, prevbuffer);CHECKGLERROR
 					}
@@ -1098,7 +1120,7 @@ static void R_UploadFullTexture(gltexture_t *glt, const unsigned char *data)
 					while (width > glt->tilewidth || height > glt->tileheight || depth > glt->tiledepth)
 					{
 						R_MakeResizeBufferBigger(width * height * depth * glt->sides * glt->bytesperpixel);
-						Image_MipReduce32(prevbuffer, resizebuffer, &width, &height, &depth, glt->tilewidth, glt->tileheight, glt->tiledepth);
+						mipreduce(prevbuffer, resizebuffer, &width, &height, &depth, glt->tilewidth, glt->tileheight, glt->tiledepth);
 						prevbuffer = resizebuffer;
 					}
 					mip = 0;
@@ -1108,7 +1130,7 @@ static void R_UploadFullTexture(gltexture_t *glt, const unsigned char *data)
 						while (width > 1 || height > 1 || depth > 1)
 						{
 							R_MakeResizeBufferBigger(width * height * depth * glt->sides * glt->bytesperpixel);
-							Image_MipReduce32(prevbuffer, resizebuffer, &width, &height, &depth, 1, 1, 1);
+							mipreduce(prevbuffer, resizebuffer, &width, &height, &depth, 1, 1, 1);
 							prevbuffer = resizebuffer;
 							qglTexImage2D(cubemapside[i], mip++, glt->glinternalformat, width, height, 0, glt->glformat, glt->gltype, prevbuffer);CHECKGLERROR
 						}
@@ -1438,10 +1460,6 @@ int R_SaveTextureDDSFile(rtexture_t *rt, const char *filename, qbool skipuncompr
 	int oldbindtexnum;
 	int bytesperpixel = 0;
 	int bytesperblock = 0;
-	int dds_flags;
-	int dds_format_flags;
-	int dds_caps1;
-	int dds_caps2;
 	int ret;
 	int mip;
 	int mipmaps;
@@ -1505,40 +1523,9 @@ int R_SaveTextureDDSFile(rtexture_t *rt, const char *filename, qbool skipuncompr
 	dds = (unsigned char *)Mem_Alloc(tempmempool, ddssize);
 	if (!dds)
 		return -4;
-	dds_caps1 = 0x1000; // DDSCAPS_TEXTURE
-	dds_caps2 = 0;
-	if (bytesperblock)
-	{
-		dds_flags = 0x81007; // DDSD_CAPS | DDSD_PIXELFORMAT | DDSD_WIDTH | DDSD_HEIGHT | DDSD_LINEARSIZE
-		dds_format_flags = 0x4; // DDPF_FOURCC
-	}
-	else
-	{
-		dds_flags = 0x100F; // DDSD_CAPS | DDSD_PIXELFORMAT | DDSD_WIDTH | DDSD_HEIGHT | DDSD_PITCH
-		dds_format_flags = 0x40; // DDPF_RGB
-	}
-	if (mipmaps)
-	{
-		dds_flags |= 0x20000; // DDSD_MIPMAPCOUNT
-		dds_caps1 |= 0x400008; // DDSCAPS_MIPMAP | DDSCAPS_COMPLEX
-	}
-	if(hasalpha)
-		dds_format_flags |= 0x1; // DDPF_ALPHAPIXELS
-	memcpy(dds, "DDS ", 4);
-	StoreLittleLong(dds+4, 124); // http://msdn.microsoft.com/en-us/library/bb943982%28v=vs.85%29.aspx says so
-	StoreLittleLong(dds+8, dds_flags);
-	StoreLittleLong(dds+12, mipinfo[0][1]); // height
-	StoreLittleLong(dds+16, mipinfo[0][0]); // width
-	StoreLittleLong(dds+24, 0); // depth
-	StoreLittleLong(dds+28, mipmaps); // mipmaps
-	StoreLittleLong(dds+76, 32); // format size
-	StoreLittleLong(dds+80, dds_format_flags);
-	StoreLittleLong(dds+108, dds_caps1);
-	StoreLittleLong(dds+112, dds_caps2);
+	Image_StoreDDSHeader(dds, mipinfo[0][0], mipinfo[0][1], mipmaps, bytesperblock ? ddsfourcc : NULL, mipinfo[0][2], hasalpha);
 	if (bytesperblock)
 	{
-		StoreLittleLong(dds+20, mipinfo[0][2]); // linear size
-		memcpy(dds+84, ddsfourcc, 4);
 		for (mip = 0;mip < mipmaps;mip++)
 		{
 			qglGetCompressedTexImage(gltexturetypeenums[glt->texturetype], mip, dds + mipinfo[mip][3]);CHECKGLERROR
@@ -1546,9 +1533,6 @@ int R_SaveTextureDDSFile(rtexture_t *rt, const char *filename, qbool skipuncompr
 	}
 	else
 	{
-		StoreLittleLong(dds+20, mipinfo[0][0]*bytesperpixel); // pitch
-		StoreLittleLong(dds+88, bytesperpixel*8); // bits per pixel
-		dds[94] = dds[97] = dds[100] = dds[107] = 255; // bgra byte order masks
 		for (mip = 0;mip < mipmaps;mip++)
 		{
 			qglGetTexImage(gltexturetypeenums[glt->texturetype], mip, GL_BGRA, GL_UNSIGNED_BYTE, dds + mipinfo[mip][3]);CHECKGLERROR
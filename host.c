@@ -551,6 +551,7 @@ void Host_Init (void)
 		Cbuf_Execute(cmd_local->cbuf);
 	}
 
+	Cmd_PrintInitStats();
 	Con_DPrint("========Initialized=========\n");
 	host.state = host_active;
 
@@ -618,6 +619,9 @@ double Host_Frame(double time)
 
 	++host.framecount;
 
+	// everything in the frame arena belongs to the previous frame
+	Mem_FrameArena_NewFrame();
+
 	TaskQueue_Frame(false);
 
 	// keep the random time dependent, but not when playing demos/benchmarking
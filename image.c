@@ -3,11 +3,19 @@
 #include "image.h"
 #include "jpeg.h"
 #include "image_png.h"
+#include "image_resample_sse2.h"
+#include "image_resample_avx2.h"
+#ifdef SSE2_PRESENT
+#include <emmintrin.h>
+#endif
 #include "r_shadow.h"
 #include "wad.h"
+#include "taskqueue.h"
 
-int		image_width;
-int		image_height;
+THREADLOCAL int		image_width;
+THREADLOCAL int		image_height;
+THREADLOCAL qbool	image_hasalpha;
+THREADLOCAL qbool	image_alphachecked;
 
 static unsigned char *Image_GetEmbeddedPicBGRA(const char *name);
 
@@ -19,6 +27,38 @@ static void Image_CopyAlphaFromBlueBGRA(unsigned char *outpixels, const unsigned
 		outpixels[4*i+3] = inpixels[4*i]; // blue channel
 }
 
+qbool Image_HasAlphaBGRA(const unsigned char *pixels, int numpixels)
+{
+	int i = 0;
+#ifdef SSE2_PRESENT
+	const __m128i alphamask = _mm_set1_epi32((int)0xFF000000);
+	__m128i opaque = alphamask;
+	// and the alpha bytes together 16 pixels at a time, stopping early now and then
+	for (;i + 16 <= numpixels;i += 16)
+	{
+		opaque = _mm_and_si128(opaque, _mm_and_si128(
+			_mm_and_si128(_mm_loadu_si128((const __m128i *)(pixels + i * 4)), _mm_loadu_si128((const __m128i *)(pixels + i * 4 + 16))),
+			_mm_and_si128(_mm_loadu_si128((const __m128i *)(pixels + i * 4 + 32)), _mm_loadu_si128((const __m128i *)(pixels + i * 4 + 48)))));
+		if ((i & 1023) == 0 && _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(opaque, alphamask), alphamask)) != 0xFFFF)
+			return true;
+	}
+	if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(opaque, alphamask), alphamask)) != 0xFFFF)
+		return true;
+#endif
+	for (;i < numpixels;i++)
+		if (pixels[i*4+3] < 255)
+			return true;
+	return false;
+}
+
+// makes image_hasalpha right for data, unless the loader already did
+static void Image_CheckAlpha(const unsigned char *data)
+{
+	if (!image_alphachecked)
+		image_hasalpha = Image_HasAlphaBGRA(data, image_width * image_height);
+	image_alphachecked = true;
+}
+
 #if 1
 // written by LadyHavoc in a readable way, optimized by Vic, further optimized by LadyHavoc (the non-special index case), readable version preserved below this
 void Image_CopyMux(unsigned char *outpixels, const unsigned char *inpixels, int inputwidth, int inputheight, qbool inputflipx, qbool inputflipy, qbool inputflipdiagonal, int numoutputcomponents, int numinputcomponents, int *outputinputcomponentindices)
@@ -1025,43 +1065,74 @@ imageformat_t imageformats_other[] =
 	{NULL, NULL}
 };
 
-int fixtransparentpixels(unsigned char *data, int w, int h);
-unsigned char *loadimagepixelsbgra (const char *filename, qbool complain, qbool allowFixtrans, qbool convertsRGB, int *miplevel)
+// strips the extension and picks the list of formats to search for filename,
+// basename, path and afterpath must be MAX_QPATH in size
+static imageformat_t *Image_FormatsForName(const char *filename, char *basename, char *path, char *afterpath)
 {
-	fs_offset_t filesize;
-	imageformat_t *firstformat, *format;
-	int mymiplevel;
-	unsigned char *f, *data = NULL, *data2 = NULL;
-	char basename[MAX_QPATH], name[MAX_QPATH], name2[MAX_QPATH], path[MAX_QPATH], afterpath[MAX_QPATH], *c;
-	char vabuf[1024];
+	char *c;
 	//if (developer_memorydebug.integer)
 	//	Mem_CheckSentinelsGlobal();
 	if (developer_texturelogging.integer)
 		Log_Printf("textures.log", "%s\n", filename);
-	Image_StripImageExtension(filename, basename, sizeof(basename)); // strip filename extensions to allow replacement by other types
+	Image_StripImageExtension(filename, basename, MAX_QPATH); // strip filename extensions to allow replacement by other types
 	// replace *'s with #, so commandline utils don't get confused when dealing with the external files
 	for (c = basename;*c;c++)
 		if (*c == '*')
 			*c = '#';
 	path[0] = 0;
-	name[0] = 0;
-	dp_strlcpy(afterpath, basename, sizeof(afterpath));
+	dp_strlcpy(afterpath, basename, MAX_QPATH);
 	if (strchr(basename, '/'))
 	{
 		int i;
-		for (i = 0;i < (int)sizeof(path)-1 && basename[i] != '/' && basename[i];i++)
+		for (i = 0;i < MAX_QPATH-1 && basename[i] != '/' && basename[i];i++)
 			path[i] = basename[i];
 		path[i] = 0;
-		dp_strlcpy(afterpath, basename + i + 1, sizeof(afterpath));
+		dp_strlcpy(afterpath, basename + i + 1, MAX_QPATH);
 	}
 	if (!strcasecmp(path, "textures"))
-		firstformat = imageformats_textures;
+		return imageformats_textures;
 	else if (!strcasecmp(path, "gfx") || !strcasecmp(path, "locale")) // locale/ is used in GAME_BLOODOMNICIDE
-		firstformat = imageformats_gfx;
+		return imageformats_gfx;
 	else if (!path[0])
-		firstformat = imageformats_nopath;
+		return imageformats_nopath;
+	else
+		return imageformats_other;
+}
+
+// jpeg can't do alpha, so it is simulated by loading another jpeg and using
+// its blue channel, data must be image_width by image_height
+static void Image_MergeJPEGAlpha(unsigned char *data, const fs_fileview_t *view, int miplevel, int mymiplevel, const char *basename)
+{
+	unsigned char *data2;
+	int mymiplevel2 = miplevel;
+	int image_width_save = image_width;
+	int image_height_save = image_height;
+	data2 = JPEG_LoadImage_BGRA(view->data, (int)view->size, &mymiplevel2);
+	if(data2 && mymiplevel == mymiplevel2 && image_width == image_width_save && image_height == image_height_save)
+		Image_CopyAlphaFromBlueBGRA(data, data2, image_width, image_height);
 	else
-		firstformat = imageformats_other;
+		Con_Printf("loadimagepixelsrgba: corrupt or invalid alpha image %s_alpha\n", basename);
+	image_width = image_width_save;
+	image_height = image_height_save;
+	// the jpeg loader said opaque, now the alpha has to be scanned
+	image_alphachecked = false;
+	if(data2)
+		Mem_Free(data2);
+}
+
+int fixtransparentpixels(unsigned char *data, int w, int h);
+unsigned char *loadimagepixelsbgra (const char *filename, qbool complain, qbool allowFixtrans, qbool convertsRGB, int *miplevel)
+{
+	fs_offset_t filesize;
+	imageformat_t *firstformat, *format;
+	int mymiplevel;
+	unsigned char *data = NULL;
+	fs_fileview_t view;
+	char basename[MAX_QPATH], name[MAX_QPATH], name2[MAX_QPATH], path[MAX_QPATH], afterpath[MAX_QPATH];
+	char vabuf[1024];
+	firstformat = Image_FormatsForName(filename, basename, path, afterpath);
+	name[0] = 0;
+	image_alphachecked = false;
 	// now try all the formats in the selected list
 	for (format = firstformat;format->formatstring;format++)
 	{
@@ -1069,34 +1140,23 @@ unsigned char *loadimagepixelsbgra (const char *filename, qbool complain, qbool
 
 		FS_SanitizePath(name);
 
-		if(FS_FileExists(name) && (f = FS_LoadFile(name, tempmempool, true, &filesize)) != NULL)
+		if(FS_FileExists(name) && FS_LoadFileView(name, true, &view))
 		{
 			mymiplevel = miplevel ? *miplevel : 0;
 			image_width = 0;
 			image_height = 0;
-			data = format->loadfunc(f, (int)filesize, &mymiplevel);
-			Mem_Free(f);
+			image_alphachecked = false;
+			data = format->loadfunc(view.data, (int)view.size, &mymiplevel);
+			FS_FreeFileView(&view);
 			if (data)
 			{
 				if(format->loadfunc == JPEG_LoadImage_BGRA) // jpeg can't do alpha, so let's simulate it by loading another jpeg
 				{
 					dpsnprintf (name2, sizeof(name2), format->formatstring, va(vabuf, sizeof(vabuf), "%s_alpha", basename));
-					f = FS_LoadFile(name2, tempmempool, true, &filesize);
-					if(f)
+					if(FS_LoadFileView(name2, true, &view))
 					{
-						int mymiplevel2 = miplevel ? *miplevel : 0;
-						int image_width_save = image_width;
-						int image_height_save = image_height;
-						data2 = format->loadfunc(f, (int)filesize, &mymiplevel2);
-						if(data2 && mymiplevel == mymiplevel2 && image_width == image_width_save && image_height == image_height_save)
-							Image_CopyAlphaFromBlueBGRA(data, data2, image_width, image_height);
-						else
-							Con_Printf("loadimagepixelsrgba: corrupt or invalid alpha image %s_alpha\n", basename);
-						image_width = image_width_save;
-						image_height = image_height_save;
-						if(data2)
-							Mem_Free(data2);
-						Mem_Free(f);
+						Image_MergeJPEGAlpha(data, &view, miplevel ? *miplevel : 0, mymiplevel, basename);
+						FS_FreeFileView(&view);
 					}
 				}
 				if (developer_loading.integer)
@@ -1123,6 +1183,7 @@ unsigned char *loadimagepixelsbgra (const char *filename, qbool complain, qbool
 				}
 				if (convertsRGB)
 					Image_MakeLinearColorsFromsRGB(data, data, image_width * image_height);
+				Image_CheckAlpha(data);
 				return data;
 			}
 			else
@@ -1147,14 +1208,20 @@ unsigned char *loadimagepixelsbgra (const char *filename, qbool complain, qbool
 				data = LoadLMP_BGRA(lmpdata, filesize, &mymiplevel);
 			// no cleanup after looking up a wad lump - the whole gfx.wad is loaded at once
 			if (data)
+			{
+				Image_CheckAlpha(data);
 				return data;
+			}
 			Con_DPrintf("Error loading image %s (file loaded but decode failed)\n", name);
 		}
 	}
 
 	// check if the image name exists as an embedded pic
 	if ((data = Image_GetEmbeddedPicBGRA(basename)))
+	{
+		Image_CheckAlpha(data);
 		return data;
+	}
 
 	if (complain)
 	{
@@ -1175,6 +1242,290 @@ unsigned char *loadimagepixelsbgra (const char *filename, qbool complain, qbool
 	return NULL;
 }
 
+/*
+============
+Image_OpenFile
+
+Finds the file loadimagepixelsbgra would decode for filename and maps it (and
+the _alpha companion of a jpeg) without decoding anything, so the decode can
+be done on another thread with Image_DecodeFileBGRA.  Only real files are
+found, wad lumps and embedded pics have to go through loadimagepixelsbgra.
+============
+*/
+qbool Image_OpenFile(const char *filename, imagefile_t *file)
+{
+	imageformat_t *format;
+	char basename[MAX_QPATH], path[MAX_QPATH], afterpath[MAX_QPATH], name2[MAX_QPATH];
+	char vabuf[1024];
+	memset(file, 0, sizeof(*file));
+	for (format = Image_FormatsForName(filename, basename, path, afterpath);format->formatstring;format++)
+	{
+		dpsnprintf (file->name, sizeof(file->name), format->formatstring, basename);
+		FS_SanitizePath(file->name);
+		if (FS_FileExists(file->name) && FS_LoadFileView(file->name, true, &file->view))
+		{
+			dp_strlcpy(file->basename, basename, sizeof(file->basename));
+			file->loadfunc = format->loadfunc;
+			if (format->loadfunc == JPEG_LoadImage_BGRA)
+			{
+				dpsnprintf (name2, sizeof(name2), format->formatstring, va(vabuf, sizeof(vabuf), "%s_alpha", basename));
+				FS_LoadFileView(name2, true, &file->alphaview);
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+============
+Image_DecodeFileBGRA
+
+Decodes a file found by Image_OpenFile, this touches nothing but the file and
+the thread's own image_width/image_height so it can run on any thread
+============
+*/
+unsigned char *Image_DecodeFileBGRA(imagefile_t *file, qbool convertsRGB, int *miplevel, int *width, int *height)
+{
+	unsigned char *data;
+	int mymiplevel = miplevel ? *miplevel : 0;
+	image_width = 0;
+	image_height = 0;
+	image_alphachecked = false;
+	data = file->loadfunc(file->view.data, (int)file->view.size, &mymiplevel);
+	if (!data)
+	{
+		Con_DPrintf("Error loading image %s (file loaded but decode failed)\n", file->name);
+		return NULL;
+	}
+	if (file->alphaview.data)
+		Image_MergeJPEGAlpha(data, &file->alphaview, miplevel ? *miplevel : 0, mymiplevel, file->basename);
+	if (developer_loading.integer)
+		Con_DPrintf("loaded image %s (%dx%d)\n", file->name, image_width, image_height);
+	if (miplevel)
+		*miplevel = mymiplevel;
+	if (convertsRGB)
+		Image_MakeLinearColorsFromsRGB(data, data, image_width * image_height);
+	Image_CheckAlpha(data);
+	*width = image_width;
+	*height = image_height;
+	return data;
+}
+
+void Image_CloseFile(imagefile_t *file)
+{
+	if (file->view.data)
+		FS_FreeFileView(&file->view);
+	if (file->alphaview.data)
+		FS_FreeFileView(&file->alphaview);
+	file->loadfunc = NULL;
+}
+
+/*
+============
+Image_ListImages
+
+Collects the images matching the command's arguments (by default the usual
+texture directories) by name without extension, each loads the way
+loadimagepixelsbgra would, so the format it prefers wins
+============
+*/
+void Image_ListImages(cmd_state_t *cmd, stringlist_t *list)
+{
+	static const char *defaultpatterns[] = {"textures/*", "textures/*/*", "textures/*/*/*", "models/*", "models/*/*", "models/*/*/*", "progs/*", "gfx/*", "gfx/*/*", "env/*", NULL};
+	const char **patterns = defaultpatterns;
+	const char *argpatterns[64];
+	const char *ext;
+	fssearch_t *search;
+	char basename[MAX_QPATH];
+	int i, j;
+
+	if (Cmd_Argc(cmd) > 1)
+	{
+		for (i = 1;i < Cmd_Argc(cmd) && i < (int)(sizeof(argpatterns) / sizeof(argpatterns[0])) - 1;i++)
+			argpatterns[i - 1] = Cmd_Argv(cmd, i);
+		argpatterns[i - 1] = NULL;
+		patterns = argpatterns;
+	}
+
+	stringlistinit(list);
+	for (i = 0;patterns[i];i++)
+	{
+		if (!(search = FS_Search(patterns[i], true, true, NULL)))
+			continue;
+		for (j = 0;j < search->numfilenames;j++)
+		{
+			ext = FS_FileExtension(search->filenames[j]);
+			if (strcasecmp(ext, "tga") && strcasecmp(ext, "png") && strcasecmp(ext, "jpg") && strcasecmp(ext, "pcx"))
+				continue;
+			FS_StripExtension(search->filenames[j], basename, sizeof(basename));
+			// alpha channels for jpg files, merged when the jpg loads
+			if (strlen(basename) > 6 && !strcasecmp(basename + strlen(basename) - 6, "_alpha"))
+				continue;
+			stringlistappend(list, basename);
+		}
+		FS_FreeSearch(search);
+	}
+	stringlistsort(list, true);
+}
+
+#define IMAGE_BENCH_BATCH 64
+
+typedef struct imagebenchformat_s
+{
+	const char *extension;
+	int count;
+	int opaque;
+	size_t filebytes;
+	size_t pixels;
+	double time;
+}
+imagebenchformat_t;
+
+// set on the thread running Image_Bench_f, to count the decodes done elsewhere
+static THREADLOCAL qbool image_bench_mainthread;
+static Thread_Atomic image_bench_workerdecodes;
+
+// t->p[0] = imagefile_t to decode, the decoded pixel count is returned in
+// t->i[0] and whether it has any alpha in t->i[1]
+static void Image_Bench_Task(taskqueue_task_t *t)
+{
+	int width, height, miplevel = 0;
+	unsigned char *pixels = Image_DecodeFileBGRA((imagefile_t *)t->p[0], false, &miplevel, &width, &height);
+	if (!image_bench_mainthread)
+		Thread_AtomicAdd(&image_bench_workerdecodes, 1);
+	t->i[0] = 0;
+	t->i[1] = 0;
+	if (pixels)
+	{
+		t->i[0] = (size_t)width * height;
+		t->i[1] = image_hasalpha;
+		Mem_Free(pixels);
+	}
+	t->done = 1;
+}
+
+static void Image_Bench_PrintLine(const char *name, int count, size_t filebytes, size_t pixels, double time)
+{
+	time = max(time, 0.000001);
+	Con_Printf("  %-8s %5i %9.2f MB %9.2f Mpix %10.3f ms %8.1f MB/s %8.1f Mpix/s\n", name, count, filebytes / 1048576.0, pixels / 1000000.0, time * 1000.0, filebytes / (1048576.0 * time), pixels / (1000000.0 * time));
+}
+
+/*
+============
+Image_Bench_f
+
+Decodes the images matching the patterns (by default the usual texture
+directories) one at a time, timing each format, then again all at once on the
+task queue.  MB/s is of the compressed file data.  Needs no renderer, so it
+works on a dedicated server as well.
+============
+*/
+void Image_Bench_f(cmd_state_t *cmd)
+{
+	imagebenchformat_t formats[] = {{"tga"}, {"png"}, {"jpg"}, {"pcx"}, {"other"}};
+	int numformats = (int)(sizeof(formats) / sizeof(formats[0]));
+	stringlist_t list;
+	imagefile_t *files;
+	taskqueue_task_t *tasks;
+	taskqueue_task_t done_task;
+	imagebenchformat_t *format;
+	imagebenchformat_t total;
+	const char *ext;
+	int i, j, numfiles, numthreads, numopened = 0;
+	size_t threadedbytes = 0, threadedpixels = 0;
+	double starttime, threadedtime = 0;
+
+	// a dedicated server never starts the renderer, which opens these
+	JPEG_OpenLibrary ();
+	PNG_OpenLibrary ();
+	Image_ListImages(cmd, &list);
+	if (!list.numstrings)
+	{
+		Con_Printf("%s: no images found\nusage: %s [pattern...]\n", Cmd_Argv(cmd, 0), Cmd_Argv(cmd, 0));
+		stringlistfreecontents(&list);
+		return;
+	}
+	Con_Printf("jpeg: %s, png: libpng writing BGRA\n", JPEG_DecodesToBGRA() ? "libjpeg-turbo writing BGRA" : "libjpeg, converted to BGRA per scanline");
+	// a console command usually runs before TaskQueue_Frame has started any
+	// threads, and would decode the threaded pass on this thread too
+	numthreads = TaskQueue_RequireThreads(0);
+	image_bench_mainthread = true;
+	Thread_AtomicSet(&image_bench_workerdecodes, 0);
+
+	files = (imagefile_t *)Mem_Alloc(tempmempool, IMAGE_BENCH_BATCH * sizeof(*files));
+	tasks = (taskqueue_task_t *)Mem_Alloc(tempmempool, IMAGE_BENCH_BATCH * sizeof(*tasks));
+	for (i = 0;i < list.numstrings;i += IMAGE_BENCH_BATCH)
+	{
+		numfiles = 0;
+		for (j = i;j < list.numstrings && j < i + IMAGE_BENCH_BATCH;j++)
+			if (Image_OpenFile(list.strings[j], files + numfiles))
+				numfiles++;
+		numopened += numfiles;
+
+		// serial, one format at a time
+		for (j = 0;j < numfiles;j++)
+		{
+			ext = FS_FileExtension(files[j].name);
+			for (format = formats;format < formats + numformats - 1 && strcasecmp(ext, format->extension);format++)
+				;
+			TaskQueue_Setup(tasks + j, NULL, Image_Bench_Task, 0, 0, files + j, NULL);
+			starttime = Sys_DirtyTime();
+			Image_Bench_Task(tasks + j);
+			format->time += Sys_DirtyTime() - starttime;
+			if (!tasks[j].i[0])
+				continue;
+			format->count++;
+			format->opaque += !tasks[j].i[1];
+			format->filebytes += (size_t)(files[j].view.size + files[j].alphaview.size);
+			format->pixels += tasks[j].i[0];
+		}
+
+		// the whole batch at once
+		starttime = Sys_DirtyTime();
+		for (j = 0;j < numfiles;j++)
+			TaskQueue_Setup(tasks + j, NULL, Image_Bench_Task, 0, 0, files + j, NULL);
+		TaskQueue_Setup(&done_task, NULL, TaskQueue_Task_CheckTasksDone, numfiles, 0, tasks, NULL);
+		TaskQueue_Enqueue(numfiles, tasks);
+		TaskQueue_Enqueue(1, &done_task);
+		TaskQueue_WaitForTaskDone(&done_task);
+		threadedtime += Sys_DirtyTime() - starttime;
+		for (j = 0;j < numfiles;j++)
+		{
+			if (tasks[j].i[0])
+			{
+				threadedbytes += (size_t)(files[j].view.size + files[j].alphaview.size);
+				threadedpixels += tasks[j].i[0];
+			}
+			Image_CloseFile(files + j);
+		}
+		// keep the console and any connection alive
+		CL_KeepaliveMessage(false);
+	}
+	Mem_Free(tasks);
+	Mem_Free(files);
+	stringlistfreecontents(&list);
+	image_bench_mainthread = false;
+	TaskQueue_ReleaseThreads();
+
+	memset(&total, 0, sizeof(total));
+	Con_Printf("  format   count      file         pixels           time\n");
+	for (format = formats;format < formats + numformats;format++)
+	{
+		if (!format->count)
+			continue;
+		Image_Bench_PrintLine(format->extension, format->count, format->filebytes, format->pixels, format->time);
+		total.count += format->count;
+		total.opaque += format->opaque;
+		total.filebytes += format->filebytes;
+		total.pixels += format->pixels;
+		total.time += format->time;
+	}
+	Image_Bench_PrintLine("serial", total.count, total.filebytes, total.pixels, total.time);
+	Image_Bench_PrintLine("threaded", total.count, threadedbytes, threadedpixels, threadedtime);
+	Con_Printf("%i of %i images opaque, %.2fx speedup on %i task queue threads (%i of %i decoded off the main thread)\n", total.opaque, total.count, total.time / max(threadedtime, 0.000001), numthreads, Thread_AtomicGet(&image_bench_workerdecodes), numopened);
+}
+
 qbool Image_GetStockPicSize(const char *filename, int *returnwidth, int *returnheight)
 {
 	unsigned char *data;
@@ -1508,9 +1859,210 @@ static void Image_Resample32LerpLine (const unsigned char *in, unsigned char *ou
 }
 
 #define LERPBYTE(i) r = resamplerow1[i];out[i] = (unsigned char) ((((resamplerow2[i] - r) * lerp) >> 16) + r)
-static void Image_Resample32Lerp(const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
+static void Image_Resample32LerpRows(const unsigned char *resamplerow1, const unsigned char *resamplerow2, unsigned char *out, int outwidth, int lerp)
 {
-	int i, j, r, yi, oldy, f, fstep, lerp, endy = (inheight-1), inwidth4 = inwidth*4, outwidth4 = outwidth*4;
+	int j, r;
+	j = outwidth - 4;
+	while(j >= 0)
+	{
+		LERPBYTE( 0);
+		LERPBYTE( 1);
+		LERPBYTE( 2);
+		LERPBYTE( 3);
+		LERPBYTE( 4);
+		LERPBYTE( 5);
+		LERPBYTE( 6);
+		LERPBYTE( 7);
+		LERPBYTE( 8);
+		LERPBYTE( 9);
+		LERPBYTE(10);
+		LERPBYTE(11);
+		LERPBYTE(12);
+		LERPBYTE(13);
+		LERPBYTE(14);
+		LERPBYTE(15);
+		out += 16;
+		resamplerow1 += 16;
+		resamplerow2 += 16;
+		j -= 4;
+	}
+	if (j & 2)
+	{
+		LERPBYTE( 0);
+		LERPBYTE( 1);
+		LERPBYTE( 2);
+		LERPBYTE( 3);
+		LERPBYTE( 4);
+		LERPBYTE( 5);
+		LERPBYTE( 6);
+		LERPBYTE( 7);
+		out += 8;
+		resamplerow1 += 8;
+		resamplerow2 += 8;
+	}
+	if (j & 1)
+	{
+		LERPBYTE( 0);
+		LERPBYTE( 1);
+		LERPBYTE( 2);
+		LERPBYTE( 3);
+	}
+}
+
+// note: if given odd width/height the reductions discard the last row/column
+// of pixels, rather than doing a proper box-filter scale down
+static void Image_MipReduce32Both(const unsigned char *in, int nextrow, unsigned char *out, int outwidth)
+{
+	int x;
+	for (x = 0;x < outwidth;x++)
+	{
+		out[0] = (unsigned char) ((in[0] + in[4] + in[nextrow  ] + in[nextrow+4]) >> 2);
+		out[1] = (unsigned char) ((in[1] + in[5] + in[nextrow+1] + in[nextrow+5]) >> 2);
+		out[2] = (unsigned char) ((in[2] + in[6] + in[nextrow+2] + in[nextrow+6]) >> 2);
+		out[3] = (unsigned char) ((in[3] + in[7] + in[nextrow+3] + in[nextrow+7]) >> 2);
+		out += 4;
+		in += 8;
+	}
+}
+
+static void Image_MipReduce32Width(const unsigned char *in, unsigned char *out, int outwidth)
+{
+	int x;
+	for (x = 0;x < outwidth;x++)
+	{
+		out[0] = (unsigned char) ((in[0] + in[4]) >> 1);
+		out[1] = (unsigned char) ((in[1] + in[5]) >> 1);
+		out[2] = (unsigned char) ((in[2] + in[6]) >> 1);
+		out[3] = (unsigned char) ((in[3] + in[7]) >> 1);
+		out += 4;
+		in += 8;
+	}
+}
+
+static void Image_MipReduce32Height(const unsigned char *in, int nextrow, unsigned char *out, int outwidth)
+{
+	int x;
+	for (x = 0;x < outwidth;x++)
+	{
+		out[0] = (unsigned char) ((in[0] + in[nextrow  ]) >> 1);
+		out[1] = (unsigned char) ((in[1] + in[nextrow+1]) >> 1);
+		out[2] = (unsigned char) ((in[2] + in[nextrow+2]) >> 1);
+		out[3] = (unsigned char) ((in[3] + in[nextrow+3]) >> 1);
+		out += 4;
+		in += 4;
+	}
+}
+
+// the sRGB reductions average the colors in linear space, so mipmaps of sRGB
+// textures don't get darker than the texture looks from up close
+static unsigned short image_mip_linearfromsrgb[256];
+static unsigned char image_mip_srgbfromlinear[8192]; // indexed by linear >> 3
+
+static void Image_MipReduce32_sRGBTables(void)
+{
+	int i;
+	if (image_mip_srgbfromlinear[8191])
+		return;
+	// this math from http://www.opengl.org/registry/specs/EXT/texture_sRGB.txt
+	// like Image_MakeLinearColorsFromsRGB, but with 16 bits of precision so the dark colors survive the round trip
+	for (i = 0;i < 256;i++)
+		image_mip_linearfromsrgb[i] = (unsigned short)floor(Image_LinearFloatFromsRGB(i) * 65535.0f + 0.5f);
+	for (i = 0;i < 8192;i++)
+		image_mip_srgbfromlinear[i] = (unsigned char)floor(bound(0.0f, Image_sRGBFloatFromLinearFloat((i * 8 + 4) * (1.0f / 65535.0f)), 1.0f) * 255.0f + 0.5f);
+}
+
+#define SRGBAVERAGE4(a, b, c, d) image_mip_srgbfromlinear[(image_mip_linearfromsrgb[a] + image_mip_linearfromsrgb[b] + image_mip_linearfromsrgb[c] + image_mip_linearfromsrgb[d]) >> 5]
+#define SRGBAVERAGE2(a, b) image_mip_srgbfromlinear[(image_mip_linearfromsrgb[a] + image_mip_linearfromsrgb[b]) >> 4]
+static void Image_MipReduce32Both_sRGB(const unsigned char *in, int nextrow, unsigned char *out, int outwidth)
+{
+	int x;
+	for (x = 0;x < outwidth;x++)
+	{
+		out[0] = SRGBAVERAGE4(in[0], in[4], in[nextrow  ], in[nextrow+4]);
+		out[1] = SRGBAVERAGE4(in[1], in[5], in[nextrow+1], in[nextrow+5]);
+		out[2] = SRGBAVERAGE4(in[2], in[6], in[nextrow+2], in[nextrow+6]);
+		out[3] = (unsigned char) ((in[3] + in[7] + in[nextrow+3] + in[nextrow+7]) >> 2);
+		out += 4;
+		in += 8;
+	}
+}
+
+static void Image_MipReduce32Width_sRGB(const unsigned char *in, unsigned char *out, int outwidth)
+{
+	int x;
+	for (x = 0;x < outwidth;x++)
+	{
+		out[0] = SRGBAVERAGE2(in[0], in[4]);
+		out[1] = SRGBAVERAGE2(in[1], in[5]);
+		out[2] = SRGBAVERAGE2(in[2], in[6]);
+		out[3] = (unsigned char) ((in[3] + in[7]) >> 1);
+		out += 4;
+		in += 8;
+	}
+}
+
+static void Image_MipReduce32Height_sRGB(const unsigned char *in, int nextrow, unsigned char *out, int outwidth)
+{
+	int x;
+	for (x = 0;x < outwidth;x++)
+	{
+		out[0] = SRGBAVERAGE2(in[0], in[nextrow  ]);
+		out[1] = SRGBAVERAGE2(in[1], in[nextrow+1]);
+		out[2] = SRGBAVERAGE2(in[2], in[nextrow+2]);
+		out[3] = (unsigned char) ((in[3] + in[nextrow+3]) >> 1);
+		out += 4;
+		in += 4;
+	}
+}
+
+typedef struct imageresamplefuncs_s
+{
+	const char *name;
+	void (*lerpline)(const unsigned char *in, unsigned char *out, int inwidth, int outwidth);
+	void (*lerprows)(const unsigned char *row1, const unsigned char *row2, unsigned char *out, int outwidth, int lerp);
+	void (*reduceboth)(const unsigned char *in, int nextrow, unsigned char *out, int outwidth);
+	void (*reducewidth)(const unsigned char *in, unsigned char *out, int outwidth);
+	void (*reduceheight)(const unsigned char *in, int nextrow, unsigned char *out, int outwidth);
+}
+imageresamplefuncs_t;
+
+static const imageresamplefuncs_t image_resample_generic = {"generic", Image_Resample32LerpLine, Image_Resample32LerpRows, Image_MipReduce32Both, Image_MipReduce32Width, Image_MipReduce32Height};
+static const imageresamplefuncs_t image_resample_srgb = {"sRGB", NULL, NULL, Image_MipReduce32Both_sRGB, Image_MipReduce32Width_sRGB, Image_MipReduce32Height_sRGB};
+#ifdef SSE2_PRESENT
+static const imageresamplefuncs_t image_resample_sse2 = {"SSE2", Image_Resample32LerpLine_SSE2, Image_Resample32LerpRows_SSE2, Image_MipReduce32Both_SSE2, Image_MipReduce32Width_SSE2, Image_MipReduce32Height_SSE2};
+#endif
+#ifdef AVX2_POSSIBLE
+// the horizontal lerp is bound by its unaligned loads, AVX2 doesn't help it
+#ifdef SSE2_PRESENT
+static const imageresamplefuncs_t image_resample_avx2 = {"AVX2", Image_Resample32LerpLine_SSE2, Image_Resample32LerpRows_AVX2, Image_MipReduce32Both_AVX2, Image_MipReduce32Width_AVX2, Image_MipReduce32Height_AVX2};
+#else
+static const imageresamplefuncs_t image_resample_avx2 = {"AVX2", Image_Resample32LerpLine, Image_Resample32LerpRows_AVX2, Image_MipReduce32Both_AVX2, Image_MipReduce32Width_AVX2, Image_MipReduce32Height_AVX2};
+#endif
+#endif
+
+// the fastest kernels this cpu can run, picked on first use
+static const imageresamplefuncs_t *image_resamplefuncs;
+
+static const imageresamplefuncs_t *Image_ResampleFuncs(void)
+{
+	if (!image_resamplefuncs)
+	{
+		image_resamplefuncs = &image_resample_generic;
+#ifdef SSE2_PRESENT
+		if (!Sys_CheckParm("-nosse"))
+			image_resamplefuncs = &image_resample_sse2;
+#endif
+#ifdef AVX2_POSSIBLE
+		if (Sys_HaveAVX2())
+			image_resamplefuncs = &image_resample_avx2;
+#endif
+	}
+	return image_resamplefuncs;
+}
+
+static void Image_Resample32Lerp(const imageresamplefuncs_t *funcs, const void *indata, int inwidth, int inheight, void *outdata, int outwidth, int outheight)
+{
+	int i, yi, oldy, f, fstep, endy = (inheight-1), inwidth4 = inwidth*4, outwidth4 = outwidth*4;
 	unsigned char *out;
 	const unsigned char *inrow;
 	unsigned char *resamplerow1;
@@ -1523,74 +2075,24 @@ static void Image_Resample32Lerp(const void *indata, int inwidth, int inheight,
 
 	inrow = (const unsigned char *)indata;
 	oldy = 0;
-	Image_Resample32LerpLine (inrow, resamplerow1, inwidth, outwidth);
-	Image_Resample32LerpLine (inrow + inwidth4, resamplerow2, inwidth, outwidth);
-	for (i = 0, f = 0;i < outheight;i++,f += fstep)
+	funcs->lerpline (inrow, resamplerow1, inwidth, outwidth);
+	funcs->lerpline (inrow + inwidth4, resamplerow2, inwidth, outwidth);
+	for (i = 0, f = 0;i < outheight;i++,f += fstep, out += outwidth4)
 	{
 		yi = f >> 16;
 		if (yi < endy)
 		{
-			lerp = f & 0xFFFF;
 			if (yi != oldy)
 			{
 				inrow = (unsigned char *)indata + inwidth4*yi;
 				if (yi == oldy+1)
 					memcpy(resamplerow1, resamplerow2, outwidth4);
 				else
-					Image_Resample32LerpLine (inrow, resamplerow1, inwidth, outwidth);
-				Image_Resample32LerpLine (inrow + inwidth4, resamplerow2, inwidth, outwidth);
+					funcs->lerpline (inrow, resamplerow1, inwidth, outwidth);
+				funcs->lerpline (inrow + inwidth4, resamplerow2, inwidth, outwidth);
 				oldy = yi;
 			}
-			j = outwidth - 4;
-			while(j >= 0)
-			{
-				LERPBYTE( 0);
-				LERPBYTE( 1);
-				LERPBYTE( 2);
-				LERPBYTE( 3);
-				LERPBYTE( 4);
-				LERPBYTE( 5);
-				LERPBYTE( 6);
-				LERPBYTE( 7);
-				LERPBYTE( 8);
-				LERPBYTE( 9);
-				LERPBYTE(10);
-				LERPBYTE(11);
-				LERPBYTE(12);
-				LERPBYTE(13);
-				LERPBYTE(14);
-				LERPBYTE(15);
-				out += 16;
-				resamplerow1 += 16;
-				resamplerow2 += 16;
-				j -= 4;
-			}
-			if (j & 2)
-			{
-				LERPBYTE( 0);
-				LERPBYTE( 1);
-				LERPBYTE( 2);
-				LERPBYTE( 3);
-				LERPBYTE( 4);
-				LERPBYTE( 5);
-				LERPBYTE( 6);
-				LERPBYTE( 7);
-				out += 8;
-				resamplerow1 += 8;
-				resamplerow2 += 8;
-			}
-			if (j & 1)
-			{
-				LERPBYTE( 0);
-				LERPBYTE( 1);
-				LERPBYTE( 2);
-				LERPBYTE( 3);
-				out += 4;
-				resamplerow1 += 4;
-				resamplerow2 += 4;
-			}
-			resamplerow1 -= outwidth4;
-			resamplerow2 -= outwidth4;
+			funcs->lerprows(resamplerow1, resamplerow2, out, outwidth, f & 0xFFFF);
 		}
 		else
 		{
@@ -1600,7 +2102,7 @@ static void Image_Resample32Lerp(const void *indata, int inwidth, int inheight,
 				if (yi == oldy+1)
 					memcpy(resamplerow1, resamplerow2, outwidth4);
 				else
-					Image_Resample32LerpLine (inrow, resamplerow1, inwidth, outwidth);
+					funcs->lerpline (inrow, resamplerow1, inwidth, outwidth);
 				oldy = yi;
 			}
 			memcpy(out, resamplerow1, outwidth4);
@@ -1662,16 +2164,16 @@ void Image_Resample32(const void *indata, int inwidth, int inheight, int indepth
 		return;
 	}
 	if (quality)
-		Image_Resample32Lerp(indata, inwidth, inheight, outdata, outwidth, outheight);
+		Image_Resample32Lerp(Image_ResampleFuncs(), indata, inwidth, inheight, outdata, outwidth, outheight);
 	else
 		Image_Resample32Nolerp(indata, inwidth, inheight, outdata, outwidth, outheight);
 }
 
 // in can be the same as out
-void Image_MipReduce32(const unsigned char *in, unsigned char *out, int *width, int *height, int *depth, int destwidth, int destheight, int destdepth)
+static void Image_MipReduce32_Funcs(const imageresamplefuncs_t *funcs, const unsigned char *in, unsigned char *out, int *width, int *height, int *depth, int destwidth, int destheight, int destdepth)
 {
 	const unsigned char *inrow;
-	int x, y, nextrow;
+	int y, nextrow;
 	if (*depth != 1 || destdepth != 1)
 	{
 		Con_Printf ("Image_Resample: 3D resampling not supported\n");
@@ -1683,8 +2185,6 @@ void Image_MipReduce32(const unsigned char *in, unsigned char *out, int *width,
 			*depth >>= 1;
 		return;
 	}
-	// note: if given odd width/height this discards the last row/column of
-	// pixels, rather than doing a proper box-filter scale down
 	inrow = in;
 	nextrow = *width * 4;
 	if (*width > destwidth)
@@ -1694,34 +2194,14 @@ void Image_MipReduce32(const unsigned char *in, unsigned char *out, int *width,
 		{
 			// reduce both
 			*height >>= 1;
-			for (y = 0;y < *height;y++, inrow += nextrow * 2)
-			{
-				for (in = inrow, x = 0;x < *width;x++)
-				{
-					out[0] = (unsigned char) ((in[0] + in[4] + in[nextrow  ] + in[nextrow+4]) >> 2);
-					out[1] = (unsigned char) ((in[1] + in[5] + in[nextrow+1] + in[nextrow+5]) >> 2);
-					out[2] = (unsigned char) ((in[2] + in[6] + in[nextrow+2] + in[nextrow+6]) >> 2);
-					out[3] = (unsigned char) ((in[3] + in[7] + in[nextrow+3] + in[nextrow+7]) >> 2);
-					out += 4;
-					in += 8;
-				}
-			}
+			for (y = 0;y < *height;y++, inrow += nextrow * 2, out += *width * 4)
+				funcs->reduceboth(inrow, nextrow, out, *width);
 		}
 		else
 		{
 			// reduce width
-			for (y = 0;y < *height;y++, inrow += nextrow)
-			{
-				for (in = inrow, x = 0;x < *width;x++)
-				{
-					out[0] = (unsigned char) ((in[0] + in[4]) >> 1);
-					out[1] = (unsigned char) ((in[1] + in[5]) >> 1);
-					out[2] = (unsigned char) ((in[2] + in[6]) >> 1);
-					out[3] = (unsigned char) ((in[3] + in[7]) >> 1);
-					out += 4;
-					in += 8;
-				}
-			}
+			for (y = 0;y < *height;y++, inrow += nextrow, out += *width * 4)
+				funcs->reducewidth(inrow, out, *width);
 		}
 	}
 	else
@@ -1730,24 +2210,140 @@ void Image_MipReduce32(const unsigned char *in, unsigned char *out, int *width,
 		{
 			// reduce height
 			*height >>= 1;
-			for (y = 0;y < *height;y++, inrow += nextrow * 2)
-			{
-				for (in = inrow, x = 0;x < *width;x++)
-				{
-					out[0] = (unsigned char) ((in[0] + in[nextrow  ]) >> 1);
-					out[1] = (unsigned char) ((in[1] + in[nextrow+1]) >> 1);
-					out[2] = (unsigned char) ((in[2] + in[nextrow+2]) >> 1);
-					out[3] = (unsigned char) ((in[3] + in[nextrow+3]) >> 1);
-					out += 4;
-					in += 4;
-				}
-			}
+			for (y = 0;y < *height;y++, inrow += nextrow * 2, out += *width * 4)
+				funcs->reduceheight(inrow, nextrow, out, *width);
 		}
 		else
 			Con_Printf ("Image_MipReduce: desired size already achieved\n");
 	}
 }
 
+void Image_MipReduce32(const unsigned char *in, unsigned char *out, int *width, int *height, int *depth, int destwidth, int destheight, int destdepth)
+{
+	Image_MipReduce32_Funcs(Image_ResampleFuncs(), in, out, width, height, depth, destwidth, destheight, destdepth);
+}
+
+void Image_MipReduce32_sRGB(const unsigned char *in, unsigned char *out, int *width, int *height, int *depth, int destwidth, int destheight, int destdepth)
+{
+	Image_MipReduce32_sRGBTables();
+	Image_MipReduce32_Funcs(&image_resample_srgb, in, out, width, height, depth, destwidth, destheight, destdepth);
+}
+
+// fills an image with gradients and noise, so every lerp weight and carry gets hit
+static void Image_ResampleBench_MakeImage(unsigned char *pixels, int width, int height, unsigned int seed)
+{
+	int x, y;
+	for (y = 0;y < height;y++)
+	{
+		for (x = 0;x < width;x++, pixels += 4)
+		{
+			seed = seed * 1103515245u + 12345u;
+			pixels[0] = (unsigned char)(x * 255 / max(width - 1, 1));
+			pixels[1] = (unsigned char)(y * 255 / max(height - 1, 1));
+			pixels[2] = (unsigned char)(seed >> 16);
+			pixels[3] = (unsigned char)((seed >> 24) & 1 ? 255 : seed >> 8);
+		}
+	}
+}
+
+// resamples to the next power of two (and to 3/4 size), then mipmaps the
+// result down to 1x1 the way R_UploadFullTexture does, returns the seconds
+// taken and leaves the concatenated output in out
+static double Image_ResampleBench_Run(const imageresamplefuncs_t *funcs, const unsigned char *pixels, int width, int height, unsigned char *out, int repeats)
+{
+	int r, w, h, d, w2, h2;
+	unsigned char *mip, *nextmip;
+	double starttime = Sys_DirtyTime();
+	for (w2 = 1;w2 < width;w2 <<= 1);
+	for (h2 = 1;h2 < height;h2 <<= 1);
+	for (r = 0;r < repeats;r++)
+	{
+		Image_Resample32Lerp(funcs, pixels, width, height, out, max(width * 3 / 4, 1), max(height * 3 / 4, 1));
+		mip = out + max(width * 3 / 4, 1) * max(height * 3 / 4, 1) * 4;
+		Image_Resample32Lerp(funcs, pixels, width, height, mip, w2, h2);
+		w = w2;
+		h = h2;
+		d = 1;
+		while (w > 1 || h > 1)
+		{
+			nextmip = mip + w * h * 4;
+			Image_MipReduce32_Funcs(funcs, mip, nextmip, &w, &h, &d, 1, 1, 1);
+			mip = nextmip;
+		}
+	}
+	return Sys_DirtyTime() - starttime;
+}
+
+/*
+================
+Image_ResampleBench_f
+
+Times the resample and mipmap kernels this cpu can run against the generic
+ones, on the given images or on generated ones, and checks they all give the
+same output
+================
+*/
+void Image_ResampleBench_f(cmd_state_t *cmd)
+{
+	static const int sizes[][2] = {{256, 256}, {640, 480}, {1023, 511}, {37, 13}, {1, 300}};
+	const imageresamplefuncs_t *funcs[3];
+	int numfuncs, numimages, i, j, k, width, height, w2, h2, differ;
+	unsigned char *pixels, *reference, *out;
+	size_t outsize;
+	double times[3];
+	char vabuf[64];
+
+	numfuncs = 0;
+	funcs[numfuncs++] = &image_resample_generic;
+#ifdef SSE2_PRESENT
+	funcs[numfuncs++] = &image_resample_sse2;
+#endif
+#ifdef AVX2_POSSIBLE
+	if (Sys_HaveAVX2())
+		funcs[numfuncs++] = &image_resample_avx2;
+#endif
+	Con_Printf("resample kernels in use: %s\n", Image_ResampleFuncs()->name);
+
+	numimages = Cmd_Argc(cmd) > 1 ? Cmd_Argc(cmd) - 1 : (int)(sizeof(sizes) / sizeof(sizes[0]));
+	for (i = 0;i < numimages;i++)
+	{
+		if (Cmd_Argc(cmd) > 1)
+		{
+			if (!(pixels = loadimagepixelsbgra(Cmd_Argv(cmd, i + 1), true, false, false, NULL)))
+				continue;
+			width = image_width;
+			height = image_height;
+		}
+		else
+		{
+			width = sizes[i][0];
+			height = sizes[i][1];
+			pixels = (unsigned char *)Mem_Alloc(tempmempool, width * height * 4);
+			Image_ResampleBench_MakeImage(pixels, width, height, i + 1);
+		}
+		for (w2 = 1;w2 < width;w2 <<= 1);
+		for (h2 = 1;h2 < height;h2 <<= 1);
+		// the 3/4 size image plus a whole mip chain is less than 3/4 + 2 times the power of two size
+		outsize = ((size_t)width * height + (size_t)w2 * h2 * 2) * 4;
+		reference = (unsigned char *)Mem_Alloc(tempmempool, outsize);
+		out = (unsigned char *)Mem_Alloc(tempmempool, outsize);
+		Con_Printf("%s (%ix%i):\n", Cmd_Argc(cmd) > 1 ? Cmd_Argv(cmd, i + 1) : "generated", width, height);
+		for (j = 0;j < numfuncs;j++)
+		{
+			times[j] = Image_ResampleBench_Run(funcs[j], pixels, width, height, j ? out : reference, 10);
+			differ = 0;
+			if (j)
+				for (k = 0;k < (int)outsize;k++)
+					if (out[k] != reference[k])
+						differ++;
+			Con_Printf("  %-8s %9.3f ms %6.2fx %s\n", funcs[j]->name, times[j] * 100.0, times[0] / max(times[j], 0.000001), differ ? va(vabuf, sizeof(vabuf), "%i bytes differ", differ) : "matches");
+		}
+		Mem_Free(out);
+		Mem_Free(reference);
+		Mem_Free(pixels);
+	}
+}
+
 void Image_HeightmapToNormalmap_BGRA(const unsigned char *inpixels, unsigned char *outpixels, int width, int height, int clamp, float bumpscale)
 {
 	int x, y, x1, x2, y1, y2;
@@ -1872,6 +2468,7 @@ unsigned char *Image_GenerateNoTexture(void)
 	unsigned char *data = (unsigned char *)Mem_Alloc(tempmempool, 16 * 16 * 4);
 	image_width = 16;
 	image_height = 16;
+	image_hasalpha = false;
 	// this makes a light grey/dark grey checkerboard texture
 	for (y = 0; y < 16; y++)
 	{
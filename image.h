@@ -5,12 +5,24 @@
 #include <stddef.h>
 #include "qtypes.h"
 #include "cvar.h"
+#include "fs.h"
+#include "thread.h"
 #include "r_textures.h"
 
-extern int image_width, image_height;
+// dimensions of the last image decoded on this thread
+extern THREADLOCAL int image_width, image_height;
+// whether the last image loadimagepixelsbgra or Image_DecodeFileBGRA returned
+// on this thread has any alpha below 255, so callers need not scan for it
+extern THREADLOCAL qbool image_hasalpha;
+// set by the loaders that work out image_hasalpha while decoding, for the
+// others the pixels are scanned afterwards
+extern THREADLOCAL qbool image_alphachecked;
 
 unsigned char *Image_GenerateNoTexture(void);
 
+// returns true if any pixel has alpha below 255
+qbool Image_HasAlphaBGRA(const unsigned char *pixels, int numpixels);
+
 // swizzle components (even converting number of components) and flip images
 // (warning: input must be different than output due to non-linear read/write)
 // (tip: component indices can contain values | 0x80000000 to tell it to
@@ -31,6 +43,35 @@ unsigned char *LoadTGA_BGRA (const unsigned char *f, int filesize, int *miplevel
 // loads a texture, as pixel data
 unsigned char *loadimagepixelsbgra (const char *filename, qbool complain, qbool allowFixtrans, qbool convertsRGB, int *miplevel);
 
+// an image file found by Image_OpenFile, waiting to be decoded
+typedef struct imagefile_s
+{
+	char name[MAX_QPATH];
+	char basename[MAX_QPATH];
+	fs_fileview_t view;
+	// the _alpha companion of a jpeg, if any
+	fs_fileview_t alphaview;
+	unsigned char *(*loadfunc)(const unsigned char *f, int filesize, int *miplevel);
+}
+imagefile_t;
+
+// finds and maps the file loadimagepixelsbgra would load, without decoding it
+// (returns false for wad lumps and embedded pics)
+qbool Image_OpenFile(const char *filename, imagefile_t *file);
+
+// decodes a file found by Image_OpenFile, safe to call from any thread
+unsigned char *Image_DecodeFileBGRA(imagefile_t *file, qbool convertsRGB, int *miplevel, int *width, int *height);
+
+// releases the file mappings of Image_OpenFile (main thread only)
+void Image_CloseFile(imagefile_t *file);
+
+// collects the names (without extension, sorted) of the tga/png/jpg/pcx
+// images matching the command's arguments, or the usual texture directories
+void Image_ListImages(cmd_state_t *cmd, struct stringlist_s *list);
+
+// console command to time image decoding per format, serially and on the task queue
+void Image_Bench_f(cmd_state_t *cmd);
+
 // searches for lmp and wad pics of the provided name and returns true and their dimensions if found
 qbool Image_GetStockPicSize(const char *filename, int *returnwidth, int *returnheight);
 
@@ -57,6 +98,10 @@ void Image_Resample32(const void *indata, int inwidth, int inheight, int indepth
 
 // scales the image down by a power of 2 (in can be the same as out)
 void Image_MipReduce32(const unsigned char *in, unsigned char *out, int *width, int *height, int *depth, int destwidth, int destheight, int destdepth);
+// same but averages the colors in linear space, for sRGB textures
+void Image_MipReduce32_sRGB(const unsigned char *in, unsigned char *out, int *width, int *height, int *depth, int destwidth, int destheight, int destdepth);
+// console command to time the SIMD resample kernels against the generic ones
+void Image_ResampleBench_f(cmd_state_t *cmd);
 
 void Image_HeightmapToNormalmap_BGRA(const unsigned char *inpixels, unsigned char *outpixels, int width, int height, int clamp, float bumpscale);
 
@@ -0,0 +1,567 @@
+/*
+DXT1/DXT5 block compression, used to bake the dds/ texture cache without a
+GL context, so later loads with r_texture_dds_load skip decoding the source
+images.
+
+The color endpoints are the corners of the block's color bounding box, pulled
+in by 1/16 of its size, and every pixel takes the nearest of the four palette
+colors.  This is not as good as the encoders that search for the best axis,
+but it is fast and it is what the driver compressors do too.
+*/
+
+#include "quakedef.h"
+#include "image.h"
+#include "image_dxt.h"
+#include "jpeg.h"
+#include "image_png.h"
+#include "taskqueue.h"
+
+#ifdef SSE2_PRESENT
+#include <emmintrin.h>
+#endif
+
+// pull the endpoints in by this fraction of the bounding box (as a shift)
+#define DXT_INSET_SHIFT 4
+// block rows each task compresses
+#define DXT_TASK_BLOCKROWS 16
+// images the bake command decodes and compresses at once
+#define DXT_BAKE_BATCH 32
+
+size_t Image_DXTSize(int width, int height, qbool dxt5)
+{
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * (dxt5 ? 16 : 8);
+}
+
+// gathers a 4x4 block, repeating the last row and column of images that are
+// not a multiple of 4 in size
+static void Image_DXT_GetBlock(const unsigned char *bgra, int width, int height, int bx, int by, unsigned char *block)
+{
+	int x, y, sx, sy;
+	if (bx * 4 + 4 <= width && by * 4 + 4 <= height)
+	{
+		for (y = 0;y < 4;y++)
+			memcpy(block + y * 16, bgra + ((by * 4 + y) * width + bx * 4) * 4, 16);
+		return;
+	}
+	for (y = 0;y < 4;y++)
+	{
+		sy = min(by * 4 + y, height - 1);
+		for (x = 0;x < 4;x++)
+		{
+			sx = min(bx * 4 + x, width - 1);
+			memcpy(block + (y * 4 + x) * 4, bgra + (sy * width + sx) * 4, 4);
+		}
+	}
+}
+
+static void Image_DXT_GetMinMax(const unsigned char *block, unsigned char *mincolor, unsigned char *maxcolor)
+{
+#ifdef SSE2_PRESENT
+	__m128i r0, r1, r2, r3, mn, mx;
+	int i;
+	r0 = _mm_loadu_si128((const __m128i *)block);
+	r1 = _mm_loadu_si128((const __m128i *)(block + 16));
+	r2 = _mm_loadu_si128((const __m128i *)(block + 32));
+	r3 = _mm_loadu_si128((const __m128i *)(block + 48));
+	mn = _mm_min_epu8(_mm_min_epu8(r0, r1), _mm_min_epu8(r2, r3));
+	mx = _mm_max_epu8(_mm_max_epu8(r0, r1), _mm_max_epu8(r2, r3));
+	mn = _mm_min_epu8(mn, _mm_srli_si128(mn, 8));
+	mx = _mm_max_epu8(mx, _mm_srli_si128(mx, 8));
+	mn = _mm_min_epu8(mn, _mm_srli_si128(mn, 4));
+	mx = _mm_max_epu8(mx, _mm_srli_si128(mx, 4));
+	i = _mm_cvtsi128_si32(mn);
+	memcpy(mincolor, &i, 4);
+	i = _mm_cvtsi128_si32(mx);
+	memcpy(maxcolor, &i, 4);
+#else
+	int i, j;
+	memcpy(mincolor, block, 4);
+	memcpy(maxcolor, block, 4);
+	for (i = 4;i < 64;i += 4)
+	{
+		for (j = 0;j < 4;j++)
+		{
+			mincolor[j] = min(mincolor[j], block[i+j]);
+			maxcolor[j] = max(maxcolor[j], block[i+j]);
+		}
+	}
+#endif
+}
+
+static unsigned short Image_DXT_To565(const unsigned char *c)
+{
+	return (unsigned short)((((c[2] * 31 + 127) / 255) << 11) | (((c[1] * 63 + 127) / 255) << 5) | ((c[0] * 31 + 127) / 255));
+}
+
+static void Image_DXT_From565(unsigned short v, unsigned char *c)
+{
+	c[0] = (unsigned char)(((v & 0x1F) << 3) | ((v & 0x1F) >> 2));
+	c[1] = (unsigned char)((((v >> 5) & 0x3F) << 2) | (((v >> 5) & 0x3F) >> 4));
+	c[2] = (unsigned char)(((v >> 11) << 3) | ((v >> 11) >> 2));
+	c[3] = 0;
+}
+
+#ifdef SSE2_PRESENT
+// squared color distance of 4 pixels (unpacked to 16bit, lo has pixels 0 and
+// 1, hi has 2 and 3) to a palette color
+static inline __m128i Image_DXT_Distance4(__m128i lo, __m128i hi, __m128i color)
+{
+	__m128 a, b;
+	lo = _mm_sub_epi16(lo, color);
+	hi = _mm_sub_epi16(hi, color);
+	a = _mm_castsi128_ps(_mm_madd_epi16(lo, lo));
+	b = _mm_castsi128_ps(_mm_madd_epi16(hi, hi));
+	return _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))), _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))));
+}
+#endif
+
+// picks the nearest palette color for each pixel, ties go to the lower index
+static unsigned int Image_DXT_ColorIndices(const unsigned char *block, const unsigned char *palette)
+{
+	unsigned int indices = 0;
+#ifdef SSE2_PRESENT
+	int i, k;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rgbmask = _mm_set1_epi32(0x00FFFFFF);
+	__m128i color[4], px, lo, hi, dist, best, bestindex, less;
+	for (k = 0;k < 4;k++)
+		color[k] = _mm_set_epi16(0, palette[k*4+2], palette[k*4+1], palette[k*4+0], 0, palette[k*4+2], palette[k*4+1], palette[k*4+0]);
+	for (i = 0;i < 16;i += 4)
+	{
+		px = _mm_and_si128(_mm_loadu_si128((const __m128i *)(block + i * 4)), rgbmask);
+		lo = _mm_unpacklo_epi8(px, zero);
+		hi = _mm_unpackhi_epi8(px, zero);
+		best = Image_DXT_Distance4(lo, hi, color[0]);
+		bestindex = zero;
+		for (k = 1;k < 4;k++)
+		{
+			dist = Image_DXT_Distance4(lo, hi, color[k]);
+			less = _mm_cmplt_epi32(dist, best);
+			best = _mm_or_si128(_mm_andnot_si128(less, best), _mm_and_si128(less, dist));
+			bestindex = _mm_or_si128(_mm_andnot_si128(less, bestindex), _mm_and_si128(less, _mm_set1_epi32(k)));
+		}
+		// gather the 4 lane indices into 8 bits
+		bestindex = _mm_or_si128(bestindex, _mm_srli_si128(_mm_slli_epi32(bestindex, 2), 4));
+		bestindex = _mm_or_si128(bestindex, _mm_srli_si128(_mm_slli_epi32(bestindex, 4), 8));
+		indices |= (unsigned int)(_mm_cvtsi128_si32(bestindex) & 0xFF) << (i * 2);
+	}
+#else
+	int i, k, d, bestd, bestk, db, dg, dr;
+	for (i = 0;i < 16;i++)
+	{
+		bestd = 0x7FFFFFFF;
+		bestk = 0;
+		for (k = 0;k < 4;k++)
+		{
+			db = block[i*4+0] - palette[k*4+0];
+			dg = block[i*4+1] - palette[k*4+1];
+			dr = block[i*4+2] - palette[k*4+2];
+			d = db * db + dg * dg + dr * dr;
+			if (bestd > d)
+			{
+				bestd = d;
+				bestk = k;
+			}
+		}
+		indices |= (unsigned int)bestk << (i * 2);
+	}
+#endif
+	return indices;
+}
+
+static void Image_DXT_EncodeColor(const unsigned char *block, const unsigned char *mincolor, const unsigned char *maxcolor, unsigned char *out)
+{
+	int i, inset;
+	unsigned short c0, c1, c;
+	unsigned char lo[4], hi[4], palette[16];
+	unsigned int indices;
+	for (i = 0;i < 3;i++)
+	{
+		inset = (maxcolor[i] - mincolor[i]) >> DXT_INSET_SHIFT;
+		lo[i] = (unsigned char)(mincolor[i] + inset);
+		hi[i] = (unsigned char)(maxcolor[i] - inset);
+	}
+	c0 = Image_DXT_To565(hi);
+	c1 = Image_DXT_To565(lo);
+	// c0 > c1 selects the 4 color mode (in DXT1 the other mode has a transparent color)
+	if (c0 < c1)
+	{
+		c = c0;
+		c0 = c1;
+		c1 = c;
+	}
+	if (c0 == c1)
+		indices = 0;
+	else
+	{
+		Image_DXT_From565(c0, palette);
+		Image_DXT_From565(c1, palette + 4);
+		for (i = 0;i < 3;i++)
+		{
+			palette[ 8+i] = (unsigned char)((palette[i] * 2 + palette[4+i]) / 3);
+			palette[12+i] = (unsigned char)((palette[i] + palette[4+i] * 2) / 3);
+		}
+		palette[11] = palette[15] = 0;
+		indices = Image_DXT_ColorIndices(block, palette);
+	}
+	StoreLittleShort(out, c0);
+	StoreLittleShort(out + 2, c1);
+	StoreLittleLong(out + 4, indices);
+}
+
+// the alpha endpoints are not inset, so fully opaque and fully transparent
+// pixels stay exact (which alpha tested textures depend on)
+static void Image_DXT_EncodeAlpha(const unsigned char *block, unsigned char a0, unsigned char a1, unsigned char *out)
+{
+	int i, k, d, bestd, bestk;
+	int palette[8];
+	unsigned int indices[2] = {0, 0};
+	out[0] = a0;
+	out[1] = a1;
+	if (a0 > a1)
+	{
+		palette[0] = a0;
+		palette[1] = a1;
+		for (k = 2;k < 8;k++)
+			palette[k] = ((8 - k) * a0 + (k - 1) * a1) / 7;
+		for (i = 0;i < 16;i++)
+		{
+			bestd = 256;
+			bestk = 0;
+			for (k = 0;k < 8;k++)
+			{
+				d = abs(block[i*4+3] - palette[k]);
+				if (bestd > d)
+				{
+					bestd = d;
+					bestk = k;
+				}
+			}
+			indices[i >> 3] |= (unsigned int)bestk << ((i & 7) * 3);
+		}
+	}
+	// 3 bytes of 3 bit indices per 8 pixels
+	out[2] = (unsigned char)(indices[0]);
+	out[3] = (unsigned char)(indices[0] >> 8);
+	out[4] = (unsigned char)(indices[0] >> 16);
+	out[5] = (unsigned char)(indices[1]);
+	out[6] = (unsigned char)(indices[1] >> 8);
+	out[7] = (unsigned char)(indices[1] >> 16);
+}
+
+void Image_CompressDXTRows(const unsigned char *bgra, int width, int height, unsigned char *out, qbool dxt5, int firstrow, int numrows)
+{
+	int bx, by, blockswide = (width + 3) / 4, blockstall = (height + 3) / 4;
+	unsigned char block[64], mincolor[4], maxcolor[4];
+	out += (size_t)firstrow * blockswide * (dxt5 ? 16 : 8);
+	for (by = firstrow;by < firstrow + numrows && by < blockstall;by++)
+	{
+		for (bx = 0;bx < blockswide;bx++)
+		{
+			Image_DXT_GetBlock(bgra, width, height, bx, by, block);
+			Image_DXT_GetMinMax(block, mincolor, maxcolor);
+			if (dxt5)
+			{
+				Image_DXT_EncodeAlpha(block, maxcolor[3], mincolor[3], out);
+				out += 8;
+			}
+			Image_DXT_EncodeColor(block, mincolor, maxcolor, out);
+			out += 8;
+		}
+	}
+}
+
+void Image_CompressDXT(const unsigned char *bgra, int width, int height, unsigned char *out, qbool dxt5)
+{
+	Image_CompressDXTRows(bgra, width, height, out, dxt5, 0, (height + 3) / 4);
+}
+
+void Image_StoreDDSHeader(unsigned char *dds, int width, int height, int mipmaps, const char *fourcc, int linearsize, qbool hasalpha)
+{
+	int dds_flags;
+	int dds_format_flags;
+	int dds_caps1;
+	int dds_caps2;
+	dds_caps1 = 0x1000; // DDSCAPS_TEXTURE
+	dds_caps2 = 0;
+	if (fourcc)
+	{
+		dds_flags = 0x81007; // DDSD_CAPS | DDSD_PIXELFORMAT | DDSD_WIDTH | DDSD_HEIGHT | DDSD_LINEARSIZE
+		dds_format_flags = 0x4; // DDPF_FOURCC
+	}
+	else
+	{
+		dds_flags = 0x100F; // DDSD_CAPS | DDSD_PIXELFORMAT | DDSD_WIDTH | DDSD_HEIGHT | DDSD_PITCH
+		dds_format_flags = 0x40; // DDPF_RGB
+	}
+	if (mipmaps)
+	{
+		dds_flags |= 0x20000; // DDSD_MIPMAPCOUNT
+		dds_caps1 |= 0x400008; // DDSCAPS_MIPMAP | DDSCAPS_COMPLEX
+	}
+	if(hasalpha)
+		dds_format_flags |= 0x1; // DDPF_ALPHAPIXELS
+	memset(dds, 0, 128);
+	memcpy(dds, "DDS ", 4);
+	StoreLittleLong(dds+4, 124); // http://msdn.microsoft.com/en-us/library/bb943982%28v=vs.85%29.aspx says so
+	StoreLittleLong(dds+8, dds_flags);
+	StoreLittleLong(dds+12, height); // height
+	StoreLittleLong(dds+16, width); // width
+	StoreLittleLong(dds+24, 0); // depth
+	StoreLittleLong(dds+28, mipmaps); // mipmaps
+	StoreLittleLong(dds+76, 32); // format size
+	StoreLittleLong(dds+80, dds_format_flags);
+	StoreLittleLong(dds+108, dds_caps1);
+	StoreLittleLong(dds+112, dds_caps2);
+	if (fourcc)
+	{
+		StoreLittleLong(dds+20, linearsize); // linear size
+		memcpy(dds+84, fourcc, 4);
+	}
+	else
+	{
+		StoreLittleLong(dds+20, width*4); // pitch
+		StoreLittleLong(dds+88, 32); // bits per pixel
+		dds[94] = dds[97] = dds[100] = dds[107] = 255; // bgra byte order masks
+	}
+}
+
+typedef struct imagebakedds_s
+{
+	char basename[MAX_QPATH];
+	imagefile_t file;
+	// the whole mip chain, and the same with the colors made white for the
+	// fog mask if the image has alpha
+	unsigned char *pixels;
+	unsigned char *maskpixels;
+	int mipmaps;
+	int mipwidth[16];
+	int mipheight[16];
+	size_t mipoffset[16];
+	qbool hasalpha;
+	// finished files
+	unsigned char *dds;
+	unsigned char *maskdds;
+	size_t ddssize;
+}
+imagebakedds_t;
+
+typedef struct imagebakeddstile_s
+{
+	const unsigned char *pixels;
+	int width, height;
+	unsigned char *out;
+	qbool dxt5;
+}
+imagebakeddstile_t;
+
+// decodes an image and makes its mipmaps
+static void Image_BakeDDS_DecodeTask(taskqueue_task_t *t)
+{
+	imagebakedds_t *bake = (imagebakedds_t *)t->p[0];
+	unsigned char *data;
+	int width, height, depth, mip;
+	size_t size, i;
+	const char *suffix;
+	void (*mipreduce)(const unsigned char *in, unsigned char *out, int *width, int *height, int *depth, int destwidth, int destheight, int destdepth);
+	// color maps are sRGB and are averaged in linear space as the renderer
+	// does with r_srgbmipmaps, normal and bump maps hold vectors, not colors
+	suffix = bake->basename + max(strlen(bake->basename), 5) - 5;
+	mipreduce = (!strcasecmp(suffix, "_norm") || !strcasecmp(suffix, "_bump")) ? Image_MipReduce32 : Image_MipReduce32_sRGB;
+	data = Image_DecodeFileBGRA(&bake->file, false, NULL, &width, &height);
+	if (data && width > 0 && height > 0)
+	{
+		// same mip count as R_SaveTextureDDSFile
+		bake->mipwidth[0] = width;
+		bake->mipheight[0] = height;
+		bake->mipoffset[0] = 0;
+		size = (size_t)width * height * 4;
+		for (mip = 1;mip < 16 && (bake->mipwidth[mip-1] > 1 || bake->mipheight[mip-1] > 1);mip++)
+		{
+			bake->mipwidth[mip] = max(bake->mipwidth[mip-1] >> 1, 1);
+			bake->mipheight[mip] = max(bake->mipheight[mip-1] >> 1, 1);
+			bake->mipoffset[mip] = size;
+			size += (size_t)bake->mipwidth[mip] * bake->mipheight[mip] * 4;
+		}
+		bake->mipmaps = mip;
+		bake->pixels = (unsigned char *)Mem_Alloc(tempmempool, size);
+		memcpy(bake->pixels, data, (size_t)width * height * 4);
+		Mem_Free(data);
+		for (mip = 1;mip < bake->mipmaps;mip++)
+		{
+			width = bake->mipwidth[mip-1];
+			height = bake->mipheight[mip-1];
+			depth = 1;
+			mipreduce(bake->pixels + bake->mipoffset[mip-1], bake->pixels + bake->mipoffset[mip], &width, &height, &depth, 1, 1, 1);
+		}
+		bake->hasalpha = image_hasalpha;
+		if (bake->hasalpha)
+		{
+			bake->maskpixels = (unsigned char *)Mem_Alloc(tempmempool, size);
+			for (i = 0;i < size;i += 4)
+			{
+				bake->maskpixels[i+0] = 255;
+				bake->maskpixels[i+1] = 255;
+				bake->maskpixels[i+2] = 255;
+				bake->maskpixels[i+3] = bake->pixels[i+3];
+			}
+		}
+	}
+	t->done = 1;
+}
+
+static void Image_BakeDDS_CompressTask(taskqueue_task_t *t)
+{
+	imagebakeddstile_t *tile = (imagebakeddstile_t *)t->p[0];
+	Image_CompressDXTRows(tile->pixels, tile->width, tile->height, tile->out, tile->dxt5, (int)t->i[0], (int)t->i[1]);
+	t->done = 1;
+}
+
+// sets up the dds file and a tile per mip level, returns the number of tiles
+static int Image_BakeDDS_SetupTiles(imagebakedds_t *bake, const unsigned char *pixels, unsigned char **dds, imagebakeddstile_t *tiles)
+{
+	int mip;
+	size_t size = 128;
+	for (mip = 0;mip < bake->mipmaps;mip++)
+		size += Image_DXTSize(bake->mipwidth[mip], bake->mipheight[mip], bake->hasalpha);
+	bake->ddssize = size;
+	*dds = (unsigned char *)Mem_Alloc(tempmempool, size);
+	Image_StoreDDSHeader(*dds, bake->mipwidth[0], bake->mipheight[0], bake->mipmaps, bake->hasalpha ? "DXT5" : "DXT1", (int)Image_DXTSize(bake->mipwidth[0], bake->mipheight[0], bake->hasalpha), bake->hasalpha);
+	size = 128;
+	for (mip = 0;mip < bake->mipmaps;mip++)
+	{
+		tiles[mip].pixels = pixels + bake->mipoffset[mip];
+		tiles[mip].width = bake->mipwidth[mip];
+		tiles[mip].height = bake->mipheight[mip];
+		tiles[mip].out = *dds + size;
+		tiles[mip].dxt5 = bake->hasalpha;
+		size += Image_DXTSize(bake->mipwidth[mip], bake->mipheight[mip], bake->hasalpha);
+	}
+	return bake->mipmaps;
+}
+
+static void Image_BakeDDS_Batch(imagebakedds_t *bakes, int numbakes, int *numwritten)
+{
+	int i, j, numtiles, numtasks;
+	taskqueue_task_t *tasks, done_task;
+	imagebakeddstile_t *tiles;
+	char vabuf[1024];
+
+	// decode
+	tasks = (taskqueue_task_t *)Mem_Alloc(tempmempool, numbakes * sizeof(*tasks));
+	for (i = 0;i < numbakes;i++)
+		TaskQueue_Setup(tasks + i, NULL, Image_BakeDDS_DecodeTask, 0, 0, bakes + i, NULL);
+	TaskQueue_Setup(&done_task, NULL, TaskQueue_Task_CheckTasksDone, numbakes, 0, tasks, NULL);
+	TaskQueue_Enqueue(numbakes, tasks);
+	TaskQueue_Enqueue(1, &done_task);
+	TaskQueue_WaitForTaskDone(&done_task);
+	Mem_Free(tasks);
+
+	// compress, split into strips of block rows
+	tiles = (imagebakeddstile_t *)Mem_Alloc(tempmempool, numbakes * 2 * 16 * sizeof(*tiles));
+	numtiles = 0;
+	for (i = 0;i < numbakes;i++)
+	{
+		if (!bakes[i].pixels)
+			continue;
+		numtiles += Image_BakeDDS_SetupTiles(bakes + i, bakes[i].pixels, &bakes[i].dds, tiles + numtiles);
+		if (bakes[i].maskpixels)
+			numtiles += Image_BakeDDS_SetupTiles(bakes + i, bakes[i].maskpixels, &bakes[i].maskdds, tiles + numtiles);
+	}
+	numtasks = 0;
+	for (i = 0;i < numtiles;i++)
+		numtasks += (tiles[i].height + DXT_TASK_BLOCKROWS * 4 - 1) / (DXT_TASK_BLOCKROWS * 4);
+	if (numtasks)
+	{
+		tasks = (taskqueue_task_t *)Mem_Alloc(tempmempool, numtasks * sizeof(*tasks));
+		numtasks = 0;
+		for (i = 0;i < numtiles;i++)
+			for (j = 0;j * 4 < tiles[i].height;j += DXT_TASK_BLOCKROWS)
+				TaskQueue_Setup(tasks + numtasks++, NULL, Image_BakeDDS_CompressTask, j, DXT_TASK_BLOCKROWS, tiles + i, NULL);
+		TaskQueue_Setup(&done_task, NULL, TaskQueue_Task_CheckTasksDone, numtasks, 0, tasks, NULL);
+		TaskQueue_Enqueue(numtasks, tasks);
+		TaskQueue_Enqueue(1, &done_task);
+		TaskQueue_WaitForTaskDone(&done_task);
+		Mem_Free(tasks);
+	}
+	Mem_Free(tiles);
+
+	// write
+	for (i = 0;i < numbakes;i++)
+	{
+		if (bakes[i].dds)
+		{
+			if (FS_WriteFile(va(vabuf, sizeof(vabuf), "dds/%s.dds", bakes[i].basename), bakes[i].dds, bakes[i].ddssize))
+				(*numwritten)++;
+			if (bakes[i].maskdds)
+				FS_WriteFile(va(vabuf, sizeof(vabuf), "dds/%s_mask.dds", bakes[i].basename), bakes[i].maskdds, bakes[i].ddssize);
+		}
+		else
+			Con_Printf("^1%s: could not decode\n", bakes[i].file.name);
+		Image_CloseFile(&bakes[i].file);
+		if (bakes[i].pixels)
+			Mem_Free(bakes[i].pixels);
+		if (bakes[i].maskpixels)
+			Mem_Free(bakes[i].maskpixels);
+		if (bakes[i].dds)
+			Mem_Free(bakes[i].dds);
+		if (bakes[i].maskdds)
+			Mem_Free(bakes[i].maskdds);
+	}
+}
+
+/*
+================
+Image_BakeDDS_f
+
+Compresses every tga/png/jpg/pcx image matching the patterns (by default the
+usual texture directories) into the dds/ cache that r_texture_dds_load reads,
+opaque images as DXT1 and the rest as DXT5 plus a _mask for fog.  Images that
+already have a cache file are skipped, delete dds/ to rebuild it.  Needs no GL
+context, so it works before a map is loaded.
+================
+*/
+void Image_BakeDDS_f(cmd_state_t *cmd)
+{
+	stringlist_t list;
+	imagebakedds_t *bakes;
+	char vabuf[1024];
+	int i, numbakes, numthreads, numwritten = 0, numskipped = 0;
+	double starttime = Sys_DirtyTime();
+
+	// a dedicated server never starts the renderer, which opens these
+	JPEG_OpenLibrary ();
+	PNG_OpenLibrary ();
+	Image_ListImages(cmd, &list);
+	// this usually runs before the first TaskQueue_Frame, which is what
+	// starts threads otherwise, so the batches would run on this thread
+	numthreads = TaskQueue_RequireThreads(0);
+
+	bakes = (imagebakedds_t *)Mem_Alloc(tempmempool, DXT_BAKE_BATCH * sizeof(*bakes));
+	numbakes = 0;
+	for (i = 0;i < list.numstrings;i++)
+	{
+		if (FS_FileExists(va(vabuf, sizeof(vabuf), "dds/%s.dds", list.strings[i])))
+		{
+			numskipped++;
+			continue;
+		}
+		memset(bakes + numbakes, 0, sizeof(*bakes));
+		dp_strlcpy(bakes[numbakes].basename, list.strings[i], sizeof(bakes[numbakes].basename));
+		if (!Image_OpenFile(list.strings[i], &bakes[numbakes].file))
+			continue;
+		if (++numbakes == DXT_BAKE_BATCH)
+		{
+			Image_BakeDDS_Batch(bakes, numbakes, &numwritten);
+			numbakes = 0;
+			// keep the console and any connection alive
+			CL_KeepaliveMessage(false);
+		}
+	}
+	if (numbakes)
+		Image_BakeDDS_Batch(bakes, numbakes, &numwritten);
+	Mem_Free(bakes);
+	stringlistfreecontents(&list);
+	TaskQueue_ReleaseThreads();
+	Con_Printf("wrote %i dds files (%i already cached) in %.3f seconds on %i task queue threads\n", numwritten, numskipped, Sys_DirtyTime() - starttime, numthreads);
+}
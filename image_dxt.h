@@ -0,0 +1,28 @@
+#ifndef IMAGE_DXT_H
+#define IMAGE_DXT_H
+
+#include <stddef.h>
+#include "qtypes.h"
+
+struct cmd_state_s;
+
+// bytes one mip level takes as DXT1 (8 bytes per 4x4 block) or DXT5 (16 bytes per block)
+size_t Image_DXTSize(int width, int height, qbool dxt5);
+
+// compresses the 4x4 block rows firstrow to firstrow+numrows-1 of a BGRA
+// image, width and height need not be multiples of 4 (the edge pixels are
+// repeated), out points at the start of the whole compressed image, safe to
+// call from any thread
+void Image_CompressDXTRows(const unsigned char *bgra, int width, int height, unsigned char *out, qbool dxt5, int firstrow, int numrows);
+
+// compresses a whole BGRA image
+void Image_CompressDXT(const unsigned char *bgra, int width, int height, unsigned char *out, qbool dxt5);
+
+// fills in the 128 byte DDS header, fourcc NULL means uncompressed 32bit BGRA
+void Image_StoreDDSHeader(unsigned char *dds, int width, int height, int mipmaps, const char *fourcc, int linearsize, qbool hasalpha);
+
+// console command to compress every image in the game directories into the dds/ cache
+void Image_BakeDDS_f(struct cmd_state_s *cmd);
+
+#endif
+
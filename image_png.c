@@ -50,6 +50,7 @@ static void				(*qpng_set_bgr)				(void*);
 static int				(*qpng_set_interlace_handling)	(void*);
 static void				(*qpng_read_update_info)	(void*, void*);
 static void				(*qpng_read_image)			(void*, unsigned char**);
+static void				(*qpng_read_row)			(void*, unsigned char*, unsigned char*);
 static void				(*qpng_read_end)			(void*, void*);
 static void				(*qpng_destroy_read_struct)	(void**, void**, void**);
 static void				(*qpng_destroy_write_struct)	(void**, void**);
@@ -98,6 +99,7 @@ static dllfunction_t pngfuncs[] =
 	{"png_set_interlace_handling",	(void **) &qpng_set_interlace_handling},
 	{"png_read_update_info",	(void **) &qpng_read_update_info},
 	{"png_read_image",			(void **) &qpng_read_image},
+	{"png_read_row",			(void **) &qpng_read_row},
 	{"png_read_end",			(void **) &qpng_read_end},
 	{"png_destroy_read_struct",	(void **) &qpng_destroy_read_struct},
 	{"png_destroy_write_struct",	(void **) &qpng_destroy_write_struct},
@@ -226,7 +228,8 @@ void PNG_CloseLibrary (void)
 #define PNG_INFO_tRNS 0x0010
 
 // this struct is only used for status information during loading
-static struct
+// (one per thread, skins are decoded on the task queue)
+static THREADLOCAL struct
 {
 	const unsigned char	*tmpBuf;
 	int		tmpBuflength;
@@ -293,11 +296,12 @@ static void PNG_warning_fn(void *png, const char *message)
 
 unsigned char *PNG_LoadImage_BGRA (const unsigned char *raw, int filesize, int *miplevel)
 {
-	unsigned int c;
 	unsigned int	y;
 	void *png, *pnginfo;
 	unsigned char *imagedata = NULL;
 	unsigned char ioBuffer[8192];
+	qbool alphachannel;
+	volatile qbool hasalpha = false; // set after the setjmp
 
 	// FIXME: register an error handler so that abort() won't be called on error
 
@@ -384,6 +388,9 @@ unsigned char *PNG_LoadImage_BGRA (const unsigned char *raw, int filesize, int *
 		qpng_set_gray_to_rgb(png);
 	if (my_png.BitDepth < 8)
 		qpng_set_expand(png);
+	// have libpng write BGRA while it has the row in cache anyway
+	qpng_set_bgr(png);
+	alphachannel = (my_png.ColorType & PNG_COLOR_MASK_ALPHA) || qpng_get_valid(png, pnginfo, PNG_INFO_tRNS);
 
 	qpng_read_update_info(png, pnginfo);
 
@@ -399,7 +406,21 @@ unsigned char *PNG_LoadImage_BGRA (const unsigned char *raw, int filesize, int *
 			my_png.Data = imagedata;
 			for(y = 0;y < my_png.Height;y++)
 				my_png.FRowPtrs[y] = my_png.Data + y * my_png.FRowBytes;
-			qpng_read_image(png, my_png.FRowPtrs);
+			if (my_png.Interlace)
+			{
+				qpng_read_image(png, my_png.FRowPtrs);
+				hasalpha = alphachannel && Image_HasAlphaBGRA(imagedata, (int)(my_png.Width * my_png.Height));
+			}
+			else
+			{
+				// a row at a time, so the alpha check reads each row while it is still in cache
+				for(y = 0;y < my_png.Height;y++)
+				{
+					qpng_read_row(png, my_png.FRowPtrs[y], NULL);
+					if (alphachannel && !hasalpha)
+						hasalpha = Image_HasAlphaBGRA(my_png.FRowPtrs[y], (int)my_png.Width);
+				}
+			}
 		}
 		else
 		{
@@ -431,14 +452,8 @@ unsigned char *PNG_LoadImage_BGRA (const unsigned char *raw, int filesize, int *
 		return NULL;
 	}
 
-	// swizzle RGBA to BGRA
-	for (y = 0;y < (unsigned int)(image_width*image_height*4);y += 4)
-	{
-		c = imagedata[y+0];
-		imagedata[y+0] = imagedata[y+2];
-		imagedata[y+2] = c;
-	}
-
+	image_hasalpha = hasalpha;
+	image_alphachecked = true;
 	return imagedata;
 }
 
@@ -0,0 +1,115 @@
+#include "image_resample_avx2.h"
+
+#ifdef AVX2_POSSIBLE
+
+#include <immintrin.h>
+
+// only this file is built for AVX2, image.c checks Sys_HaveAVX2 first
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+// see Lerp16 in image_resample_sse2.c
+static AVX2_TARGET inline __m256i Lerp16x16(__m256i a, __m256i b, __m256i lerp, __m256i lerpfix)
+{
+	__m256i diff = _mm256_sub_epi16(b, a);
+	return _mm256_add_epi16(_mm256_add_epi16(_mm256_mulhi_epi16(diff, lerp), _mm256_and_si256(diff, lerpfix)), a);
+}
+
+// the unpacks and packs all work within 128bit lanes, so the byte order
+// comes out right without any permutes except where the output is narrower
+
+AVX2_TARGET void Image_Resample32LerpRows_AVX2(const unsigned char *row1, const unsigned char *row2, unsigned char *out, int outwidth, int lerp)
+{
+	int i, n = outwidth * 4;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i l = _mm256_set1_epi16((short)lerp);
+	const __m256i lfix = _mm256_cmpgt_epi16(zero, l);
+	__m256i a, b;
+	for (i = 0;i + 32 <= n;i += 32)
+	{
+		a = _mm256_loadu_si256((const __m256i *)(row1 + i));
+		b = _mm256_loadu_si256((const __m256i *)(row2 + i));
+		_mm256_storeu_si256((__m256i *)(out + i), _mm256_packus_epi16(
+			Lerp16x16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero), l, lfix),
+			Lerp16x16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero), l, lfix)));
+	}
+	for (;i < n;i++)
+		out[i] = (unsigned char) ((((row2[i] - row1[i]) * lerp) >> 16) + row1[i]);
+}
+
+// the reductions read ahead of what they write so they work in place
+
+AVX2_TARGET void Image_MipReduce32Both_AVX2(const unsigned char *in, int nextrow, unsigned char *out, int outwidth)
+{
+	int x;
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i a, b, lo, hi;
+	for (x = 0;x + 4 <= outwidth;x += 4, in += 32, out += 16)
+	{
+		a = _mm256_loadu_si256((const __m256i *)in);
+		b = _mm256_loadu_si256((const __m256i *)(in + nextrow));
+		lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+		hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+		a = _mm256_srli_epi16(_mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi)), 2);
+		// each lane holds two output pixels in its low 8 bytes
+		a = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, a), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm_storeu_si128((__m128i *)out, _mm256_castsi256_si128(a));
+	}
+	for (;x < outwidth;x++, in += 8, out += 4)
+	{
+		out[0] = (unsigned char) ((in[0] + in[4] + in[nextrow  ] + in[nextrow+4]) >> 2);
+		out[1] = (unsigned char) ((in[1] + in[5] + in[nextrow+1] + in[nextrow+5]) >> 2);
+		out[2] = (unsigned char) ((in[2] + in[6] + in[nextrow+2] + in[nextrow+6]) >> 2);
+		out[3] = (unsigned char) ((in[3] + in[7] + in[nextrow+3] + in[nextrow+7]) >> 2);
+	}
+}
+
+AVX2_TARGET void Image_MipReduce32Width_AVX2(const unsigned char *in, unsigned char *out, int outwidth)
+{
+	int x;
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i a, lo, hi;
+	for (x = 0;x + 4 <= outwidth;x += 4, in += 32, out += 16)
+	{
+		a = _mm256_loadu_si256((const __m256i *)in);
+		lo = _mm256_unpacklo_epi8(a, zero);
+		hi = _mm256_unpackhi_epi8(a, zero);
+		a = _mm256_srli_epi16(_mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), _mm256_unpackhi_epi64(lo, hi)), 1);
+		a = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, a), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm_storeu_si128((__m128i *)out, _mm256_castsi256_si128(a));
+	}
+	for (;x < outwidth;x++, in += 8, out += 4)
+	{
+		out[0] = (unsigned char) ((in[0] + in[4]) >> 1);
+		out[1] = (unsigned char) ((in[1] + in[5]) >> 1);
+		out[2] = (unsigned char) ((in[2] + in[6]) >> 1);
+		out[3] = (unsigned char) ((in[3] + in[7]) >> 1);
+	}
+}
+
+AVX2_TARGET void Image_MipReduce32Height_AVX2(const unsigned char *in, int nextrow, unsigned char *out, int outwidth)
+{
+	int x;
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i a, b;
+	for (x = 0;x + 8 <= outwidth;x += 8, in += 32, out += 32)
+	{
+		a = _mm256_loadu_si256((const __m256i *)in);
+		b = _mm256_loadu_si256((const __m256i *)(in + nextrow));
+		_mm256_storeu_si256((__m256i *)out, _mm256_packus_epi16(
+			_mm256_srli_epi16(_mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero)), 1),
+			_mm256_srli_epi16(_mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero)), 1)));
+	}
+	for (;x < outwidth;x++, in += 4, out += 4)
+	{
+		out[0] = (unsigned char) ((in[0] + in[nextrow  ]) >> 1);
+		out[1] = (unsigned char) ((in[1] + in[nextrow+1]) >> 1);
+		out[2] = (unsigned char) ((in[2] + in[nextrow+2]) >> 1);
+		out[3] = (unsigned char) ((in[3] + in[nextrow+3]) >> 1);
+	}
+}
+
+#endif
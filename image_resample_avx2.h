@@ -0,0 +1,14 @@
+#ifndef IMAGE_RESAMPLE_AVX2_H
+#define IMAGE_RESAMPLE_AVX2_H
+
+#include "quakedef.h"
+
+#ifdef AVX2_POSSIBLE
+// same results as the generic kernels in image.c, bit for bit
+void Image_Resample32LerpRows_AVX2(const unsigned char *row1, const unsigned char *row2, unsigned char *out, int outwidth, int lerp);
+void Image_MipReduce32Both_AVX2(const unsigned char *in, int nextrow, unsigned char *out, int outwidth);
+void Image_MipReduce32Width_AVX2(const unsigned char *in, unsigned char *out, int outwidth);
+void Image_MipReduce32Height_AVX2(const unsigned char *in, int nextrow, unsigned char *out, int outwidth);
+#endif
+
+#endif
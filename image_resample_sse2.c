@@ -0,0 +1,142 @@
+#include "image_resample_sse2.h"
+
+#ifdef SSE2_PRESENT
+
+#include <emmintrin.h>
+
+// the lerps are ((b - a) * lerp >> 16) + a with lerp in 0-65535, mulhi only
+// takes a signed lerp so where it went negative (lerp >= 32768) the product
+// is 65536 * (b - a) short, which is (b - a) after the shift
+static inline __m128i Lerp16(__m128i a, __m128i b, __m128i lerp, __m128i lerpfix)
+{
+	__m128i diff = _mm_sub_epi16(b, a);
+	return _mm_add_epi16(_mm_add_epi16(_mm_mulhi_epi16(diff, lerp), _mm_and_si128(diff, lerpfix)), a);
+}
+
+void Image_Resample32LerpLine_SSE2(const unsigned char *in, unsigned char *out, int inwidth, int outwidth)
+{
+	int j, xi, f, fstep, endx, lerp;
+	const __m128i zero = _mm_setzero_si128();
+	__m128i a, b, l;
+	fstep = (int) (inwidth*65536.0f/outwidth);
+	endx = (inwidth-1);
+	// two pixels at a time while both have a pixel to the right to lerp to
+	for (j = 0, f = 0;j + 1 < outwidth && ((f + fstep) >> 16) < endx;j += 2, f += fstep * 2)
+	{
+		a = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(in + (f >> 16) * 4)), zero);
+		b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(in + ((f + fstep) >> 16) * 4)), zero);
+		l = _mm_unpacklo_epi64(_mm_set1_epi16((short)(f & 0xFFFF)), _mm_set1_epi16((short)((f + fstep) & 0xFFFF)));
+		a = Lerp16(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b), l, _mm_cmplt_epi16(l, zero));
+		_mm_storel_epi64((__m128i *)out, _mm_packus_epi16(a, a));
+		out += 8;
+	}
+	for (;j < outwidth;j++, f += fstep)
+	{
+		xi = f >> 16;
+		if (xi < endx)
+		{
+			lerp = f & 0xFFFF;
+			*out++ = (unsigned char) ((((in[xi*4+4] - in[xi*4+0]) * lerp) >> 16) + in[xi*4+0]);
+			*out++ = (unsigned char) ((((in[xi*4+5] - in[xi*4+1]) * lerp) >> 16) + in[xi*4+1]);
+			*out++ = (unsigned char) ((((in[xi*4+6] - in[xi*4+2]) * lerp) >> 16) + in[xi*4+2]);
+			*out++ = (unsigned char) ((((in[xi*4+7] - in[xi*4+3]) * lerp) >> 16) + in[xi*4+3]);
+		}
+		else // last pixel of the line has no pixel to lerp to
+		{
+			*out++ = in[xi*4+0];
+			*out++ = in[xi*4+1];
+			*out++ = in[xi*4+2];
+			*out++ = in[xi*4+3];
+		}
+	}
+}
+
+void Image_Resample32LerpRows_SSE2(const unsigned char *row1, const unsigned char *row2, unsigned char *out, int outwidth, int lerp)
+{
+	int i, n = outwidth * 4;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i l = _mm_set1_epi16((short)lerp);
+	const __m128i lfix = _mm_cmplt_epi16(l, zero);
+	__m128i a, b;
+	for (i = 0;i + 16 <= n;i += 16)
+	{
+		a = _mm_loadu_si128((const __m128i *)(row1 + i));
+		b = _mm_loadu_si128((const __m128i *)(row2 + i));
+		_mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(
+			Lerp16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), l, lfix),
+			Lerp16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), l, lfix)));
+	}
+	for (;i < n;i++)
+		out[i] = (unsigned char) ((((row2[i] - row1[i]) * lerp) >> 16) + row1[i]);
+}
+
+// the reductions read ahead of what they write so they work in place
+
+void Image_MipReduce32Both_SSE2(const unsigned char *in, int nextrow, unsigned char *out, int outwidth)
+{
+	int x;
+	const __m128i zero = _mm_setzero_si128();
+	__m128i a, b, lo, hi;
+	for (x = 0;x + 2 <= outwidth;x += 2, in += 16, out += 8)
+	{
+		a = _mm_loadu_si128((const __m128i *)in);
+		b = _mm_loadu_si128((const __m128i *)(in + nextrow));
+		lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+		hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+		a = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi)), 2);
+		_mm_storel_epi64((__m128i *)out, _mm_packus_epi16(a, a));
+	}
+	for (;x < outwidth;x++, in += 8, out += 4)
+	{
+		out[0] = (unsigned char) ((in[0] + in[4] + in[nextrow  ] + in[nextrow+4]) >> 2);
+		out[1] = (unsigned char) ((in[1] + in[5] + in[nextrow+1] + in[nextrow+5]) >> 2);
+		out[2] = (unsigned char) ((in[2] + in[6] + in[nextrow+2] + in[nextrow+6]) >> 2);
+		out[3] = (unsigned char) ((in[3] + in[7] + in[nextrow+3] + in[nextrow+7]) >> 2);
+	}
+}
+
+void Image_MipReduce32Width_SSE2(const unsigned char *in, unsigned char *out, int outwidth)
+{
+	int x;
+	const __m128i zero = _mm_setzero_si128();
+	__m128i a, lo, hi;
+	for (x = 0;x + 2 <= outwidth;x += 2, in += 16, out += 8)
+	{
+		a = _mm_loadu_si128((const __m128i *)in);
+		lo = _mm_unpacklo_epi8(a, zero);
+		hi = _mm_unpackhi_epi8(a, zero);
+		a = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi)), 1);
+		_mm_storel_epi64((__m128i *)out, _mm_packus_epi16(a, a));
+	}
+	for (;x < outwidth;x++, in += 8, out += 4)
+	{
+		out[0] = (unsigned char) ((in[0] + in[4]) >> 1);
+		out[1] = (unsigned char) ((in[1] + in[5]) >> 1);
+		out[2] = (unsigned char) ((in[2] + in[6]) >> 1);
+		out[3] = (unsigned char) ((in[3] + in[7]) >> 1);
+	}
+}
+
+void Image_MipReduce32Height_SSE2(const unsigned char *in, int nextrow, unsigned char *out, int outwidth)
+{
+	int x;
+	const __m128i zero = _mm_setzero_si128();
+	__m128i a, b;
+	for (x = 0;x + 4 <= outwidth;x += 4, in += 16, out += 16)
+	{
+		a = _mm_loadu_si128((const __m128i *)in);
+		b = _mm_loadu_si128((const __m128i *)(in + nextrow));
+		_mm_storeu_si128((__m128i *)out, _mm_packus_epi16(
+			_mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)), 1),
+			_mm_srli_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)), 1)));
+	}
+	for (;x < outwidth;x++, in += 4, out += 4)
+	{
+		out[0] = (unsigned char) ((in[0] + in[nextrow  ]) >> 1);
+		out[1] = (unsigned char) ((in[1] + in[nextrow+1]) >> 1);
+		out[2] = (unsigned char) ((in[2] + in[nextrow+2]) >> 1);
+		out[3] = (unsigned char) ((in[3] + in[nextrow+3]) >> 1);
+	}
+}
+
+#endif
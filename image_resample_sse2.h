@@ -0,0 +1,15 @@
+#ifndef IMAGE_RESAMPLE_SSE2_H
+#define IMAGE_RESAMPLE_SSE2_H
+
+#include "quakedef.h"
+
+#ifdef SSE2_PRESENT
+// same results as the generic kernels in image.c, bit for bit
+void Image_Resample32LerpLine_SSE2(const unsigned char *in, unsigned char *out, int inwidth, int outwidth);
+void Image_Resample32LerpRows_SSE2(const unsigned char *row1, const unsigned char *row2, unsigned char *out, int outwidth, int lerp);
+void Image_MipReduce32Both_SSE2(const unsigned char *in, int nextrow, unsigned char *out, int outwidth);
+void Image_MipReduce32Width_SSE2(const unsigned char *in, unsigned char *out, int outwidth);
+void Image_MipReduce32Height_SSE2(const unsigned char *in, int nextrow, unsigned char *out, int outwidth);
+#endif
+
+#endif
@@ -57,6 +57,13 @@ typedef int jboolean;
 #define qjpeg_write_scanlines jpeg_write_scanlines
 #define qjpeg_simple_progression jpeg_simple_progression
 #define jpeg_dll true
+// libjpeg-turbo can write BGRA itself (with its SIMD color conversion)
+#ifdef JCS_EXTENSIONS
+#define jpeg_extbgra true
+#else
+#define jpeg_extbgra false
+#define JCS_EXT_BGRA JCS_RGB
+#endif
 #else
 /*
 =================================================================
@@ -84,6 +91,8 @@ typedef enum
 	JCS_CMYK,
 	JCS_YCCK
 } J_COLOR_SPACE;
+// libjpeg-turbo adds color spaces for the output byte order, this one fills in alpha 255 too
+#define JCS_EXT_BGRA ((J_COLOR_SPACE)13)
 typedef enum {JPEG_DUMMY1} J_DCT_METHOD;
 typedef enum {JPEG_DUMMY2} J_DITHER_MODE;
 typedef unsigned int JDIMENSION;
@@ -456,11 +465,13 @@ static dllfunction_t jpegfuncs[] =
 // Handle for JPEG DLL
 dllhandle_t jpeg_dll = NULL;
 qbool jpeg_tried_loading = 0;
+// whether the DLL is libjpeg-turbo, which can decode straight to BGRA
+static qbool jpeg_extbgra = false;
 #endif
 
 static unsigned char jpeg_eoi_marker [2] = {0xFF, JPEG_EOI};
-static jmp_buf error_in_jpeg;
-static qbool jpeg_toolarge;
+static THREADLOCAL jmp_buf error_in_jpeg;
+static THREADLOCAL qbool jpeg_toolarge;
 
 // Our own output manager for JPEG compression
 typedef struct
@@ -523,7 +534,13 @@ qbool JPEG_OpenLibrary (void)
 #endif
 
 	// Load the DLL
-	return Sys_LoadDependency (dllnames, &jpeg_dll, jpegfuncs);
+	if (!Sys_LoadDependency (dllnames, &jpeg_dll, jpegfuncs))
+		return false;
+	// only libjpeg-turbo has this (since 1.5, and the BGRA output since 1.1)
+	jpeg_extbgra = Sys_GetProcAddress(jpeg_dll, "jpeg_skip_scanlines") != NULL;
+	if (jpeg_extbgra)
+		Con_DPrintf("JPEG: libjpeg-turbo found, decoding straight to BGRA\n");
+	return true;
 #endif
 }
 
@@ -540,9 +557,22 @@ void JPEG_CloseLibrary (void)
 #ifndef LINK_TO_LIBJPEG
 	Sys_FreeLibrary (&jpeg_dll);
 	jpeg_tried_loading = false; // allow retry
+	jpeg_extbgra = false;
 #endif
 }
 
+/*
+====================
+JPEG_DecodesToBGRA
+
+True if the loaded library does the color conversion straight to BGRA
+====================
+*/
+qbool JPEG_DecodesToBGRA (void)
+{
+	return jpeg_dll && jpeg_extbgra;
+}
+
 
 /*
 =================================================================
@@ -596,6 +626,40 @@ static void JPEG_ErrorExit (j_common_ptr cinfo)
 }
 
 
+// converts scanlines libjpeg decoded as RGB or greyscale to BGRA
+static void JPEG_ScanlineToBGRA(const unsigned char *scanline, unsigned char *buffer_ptr, int width, int components)
+{
+	int ind;
+	switch (components)
+	{
+		// RGB images
+		case 3:
+			for (ind = 0; ind < width * 3; ind += 3, buffer_ptr += 4)
+			{
+				buffer_ptr[2] = scanline[ind];
+				buffer_ptr[1] = scanline[ind + 1];
+				buffer_ptr[0] = scanline[ind + 2];
+				buffer_ptr[3] = 255;
+			}
+			break;
+
+		// Greyscale images (default to it, just in case)
+		case 1:
+		default:
+			for (ind = 0; ind < width; ind++, buffer_ptr += 4)
+			{
+				buffer_ptr[0] = scanline[ind];
+				buffer_ptr[1] = scanline[ind];
+				buffer_ptr[2] = scanline[ind];
+				buffer_ptr[3] = 255;
+			}
+	}
+}
+
+// scanlines asked for per jpeg_read_scanlines call, it decodes as many as
+// one row of blocks has (up to 4 with the usual subsampling)
+#define JPEG_MAXSCANLINES 16
+
 /*
 ====================
 JPEG_LoadImage
@@ -607,9 +671,14 @@ unsigned char* JPEG_LoadImage_BGRA (const unsigned char *f, int filesize, int *m
 {
 	struct jpeg_decompress_struct cinfo;
 	struct jpeg_error_mgr jerr;
-	unsigned char *image_buffer = NULL, *scanline = NULL;
+	// volatile as they are set after the setjmp and freed after a longjmp
+	unsigned char * volatile image_buffer = NULL;
+	unsigned char * volatile scanline = NULL;
+	unsigned char *rows[JPEG_MAXSCANLINES];
 	unsigned int line;
 	int submip = 0;
+	int i, numrows;
+	qbool bgra;
 
 	// No DLL = no JPEGs
 	if (!jpeg_dll)
@@ -628,6 +697,10 @@ unsigned char* JPEG_LoadImage_BGRA (const unsigned char *f, int filesize, int *m
 	qjpeg_read_header (&cinfo, true);
 	cinfo.scale_num = 1;
 	cinfo.scale_denom = (1 << submip);
+	// libjpeg-turbo can't convert CMYK or YCCK to BGRA
+	bgra = jpeg_extbgra && (cinfo.jpeg_color_space == JCS_GRAYSCALE || cinfo.jpeg_color_space == JCS_RGB || cinfo.jpeg_color_space == JCS_YCbCr);
+	if (bgra)
+		cinfo.out_color_space = JCS_EXT_BGRA;
 	qjpeg_start_decompress (&cinfo);
 
 	image_width = cinfo.output_width;
@@ -640,8 +713,9 @@ unsigned char* JPEG_LoadImage_BGRA (const unsigned char *f, int filesize, int *m
 	}
 
 	image_buffer = (unsigned char *)Mem_Alloc(tempmempool, image_width * image_height * 4);
-	scanline = (unsigned char *)Mem_Alloc(tempmempool, image_width * cinfo.output_components);
-	if (!image_buffer || !scanline)
+	if (!bgra)
+		scanline = (unsigned char *)Mem_Alloc(tempmempool, image_width * cinfo.output_components * JPEG_MAXSCANLINES);
+	if (!image_buffer || (!bgra && !scanline))
 	{
 		if (image_buffer)
 			Mem_Free (image_buffer);
@@ -654,46 +728,26 @@ unsigned char* JPEG_LoadImage_BGRA (const unsigned char *f, int filesize, int *m
 		return NULL;
 	}
 
-	// Decompress the image, line by line
+	// Decompress the image, straight into the BGRA buffer if the library can
+	// do the conversion, otherwise a few lines at a time into the scanline
+	// buffer and convert those to BGRA
 	line = 0;
 	while (cinfo.output_scanline < cinfo.output_height)
 	{
-		unsigned char *buffer_ptr;
-		int ind;
-
-		qjpeg_read_scanlines (&cinfo, &scanline, 1);
-
-		// Convert the image to BGRA
-		switch (cinfo.output_components)
-		{
-			// RGB images
-			case 3:
-				buffer_ptr = &image_buffer[image_width * line * 4];
-				for (ind = 0; ind < image_width * 3; ind += 3, buffer_ptr += 4)
-				{
-					buffer_ptr[2] = scanline[ind];
-					buffer_ptr[1] = scanline[ind + 1];
-					buffer_ptr[0] = scanline[ind + 2];
-					buffer_ptr[3] = 255;
-				}
-				break;
-
-			// Greyscale images (default to it, just in case)
-			case 1:
-			default:
-				buffer_ptr = &image_buffer[image_width * line * 4];
-				for (ind = 0; ind < image_width; ind++, buffer_ptr += 4)
-				{
-					buffer_ptr[0] = scanline[ind];
-					buffer_ptr[1] = scanline[ind];
-					buffer_ptr[2] = scanline[ind];
-					buffer_ptr[3] = 255;
-				}
-		}
-
-		line++;
+		numrows = min(JPEG_MAXSCANLINES, (int)(cinfo.output_height - cinfo.output_scanline));
+		for (i = 0;i < numrows;i++)
+			rows[i] = bgra ? &image_buffer[image_width * (line + i) * 4] : &scanline[image_width * cinfo.output_components * i];
+		numrows = qjpeg_read_scanlines (&cinfo, rows, numrows);
+		if (!bgra)
+			for (i = 0;i < numrows;i++)
+				JPEG_ScanlineToBGRA(rows[i], &image_buffer[image_width * (line + i) * 4], image_width, cinfo.output_components);
+		line += numrows;
+	}
+	if (scanline)
+	{
+		Mem_Free (scanline);
+		scanline = NULL;
 	}
-	Mem_Free (scanline); scanline = NULL;
 
 	qjpeg_finish_decompress (&cinfo);
 	qjpeg_destroy_decompress (&cinfo);
@@ -701,6 +755,8 @@ unsigned char* JPEG_LoadImage_BGRA (const unsigned char *f, int filesize, int *m
 	if(miplevel)
 		*miplevel -= submip;
 
+	image_hasalpha = false;
+	image_alphachecked = true;
 	return image_buffer;
 
 error_caught:
@@ -29,6 +29,7 @@
 
 qbool JPEG_OpenLibrary (void);
 void JPEG_CloseLibrary (void);
+qbool JPEG_DecodesToBGRA (void);
 unsigned char* JPEG_LoadImage_BGRA (const unsigned char *f, int filesize, int *miplevel);
 qbool JPEG_SaveImage_preflipped (const char *filename, int width, int height, unsigned char *data);
 
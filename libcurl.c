@@ -16,6 +16,8 @@ static cvar_t curl_useragent_append = {CF_SHARED, "curl_useragent_append","", "a
 static cvar_t sv_curl_defaulturl = {CF_SERVER, "sv_curl_defaulturl","", "default autodownload source URL"};
 static cvar_t sv_curl_serverpackages = {CF_SERVER, "sv_curl_serverpackages","", "list of required files for the clients, separated by spaces"};
 static cvar_t sv_curl_maxspeed = {CF_SERVER, "sv_curl_maxspeed","0", "maximum download speed for clients downloading from sv_curl_defaulturl (KiB/s)"};
+static cvar_t sv_curl_sha256 = {CF_SERVER, "sv_curl_sha256","1", "send the SHA-256 of each package along with autodownload requests, so clients can reuse a copy they already have under another name and notice changed packages (older clients print a harmless warning)"};
+static cvar_t sv_curl_sha256_framebytes = {CF_SERVER, "sv_curl_sha256_framebytes","1048576", "how many bytes of the offered packages the server hashes per frame for sv_curl_sha256 (at least 64 KiB); packages are announced without a hash until they are done"};
 
 static cvar_t developer_curl = {CF_SHARED, "developer_curl","0", "whether verbose libcurl output should be printed to stderr"};
 
@@ -217,6 +219,7 @@ typedef struct downloadinfo_s
 	double bytes_sent_curl; // for throttling
 	llist_t list;
 	qbool forthismap;
+	char sha256[CURL_SHA256_HEXSIZE]; // expected content hash, or empty
 	double maxspeed;
 	curl_slist *slist; // http headers
 
@@ -517,7 +520,8 @@ CURL_DOWNLOAD_FAILED or CURL_DOWNLOAD_ABORTED) and in the second case the error
 code from libcurl, or 0, if another error has occurred.
 ====================
 */
-static qbool Curl_Begin(const char *URL, const char *extraheaders, double maxspeed, const char *name, int loadtype, qbool forthismap, const char *post_content_type, const unsigned char *postbuf, size_t postbufsize, unsigned char *buf, size_t bufsize, curl_callback_t callback, void *cbdata);
+static qbool Curl_Begin(const char *URL, const char *extraheaders, double maxspeed, const char *name, int loadtype, qbool forthismap, const char *sha256, const char *post_content_type, const unsigned char *postbuf, size_t postbufsize, unsigned char *buf, size_t bufsize, curl_callback_t callback, void *cbdata);
+static void Curl_HashCache_AddFile(const char *path, const char *expected);
 static void Curl_EndDownload(downloadinfo *di, CurlStatus status, CURLcode error, const char *content_type_)
 {
 	char content_type[64];
@@ -581,7 +585,7 @@ static void Curl_EndDownload(downloadinfo *di, CurlStatus status, CURLcode error
 		FS_Close(di->stream); \
 		if(di->startpos && !di->callback) \
 		{ \
-			Curl_Begin(di->url, di->extraheaders, di->maxspeed, di->filename, di->loadtype, di->forthismap, di->post_content_type, di->postbuf, di->postbufsize, NULL, 0, NULL, NULL); \
+			Curl_Begin(di->url, di->extraheaders, di->maxspeed, di->filename, di->loadtype, di->forthismap, di->sha256[0] ? di->sha256 : NULL, di->post_content_type, di->postbuf, di->postbufsize, NULL, 0, NULL, NULL); \
 			di->forthismap = false; \
 		} \
 	} \
@@ -592,6 +596,8 @@ static void Curl_EndDownload(downloadinfo *di, CurlStatus status, CURLcode error
 		ok = FS_AddPack(di->filename, NULL, true, true);
 		if(!ok)
 			CLEAR_AND_RETRY();
+		else
+			Curl_HashCache_AddFile(di->filename, di->sha256);
 	}
 	else if(ok && di->loadtype == LOADTYPE_CACHEPIC)
 	{
@@ -817,6 +823,459 @@ void Curl_Init(void)
 	curlm = qcurl_multi_init();
 }
 
+/*
+====================
+Content hash cache
+
+dlcache/sha256.txt maps the SHA-256 of every completely downloaded package to
+the file it was saved as, one "<hash> <size> <path>" line per download. This
+lets a package that shows up again under another name be taken from disk, and
+notices a package that kept its name but changed its content.
+
+The client hashes with the crypto library, without it nothing is cached.  The
+server hashes the packages it offers itself, a few bytes each frame.
+====================
+*/
+#define CURL_HASHCACHE_FILE "dlcache/sha256.txt"
+
+typedef struct curl_hashentry_s
+{
+	struct curl_hashentry_s *next;
+	char hash[CURL_SHA256_HEXSIZE];
+	fs_offset_t size;
+	char path[MAX_OSPATH];
+}
+curl_hashentry_t;
+
+// client: downloaded files, newest first
+static curl_hashentry_t *curl_hashcache = NULL;
+static char curl_hashcache_gamedir[MAX_OSPATH];
+// incremental SHA-256 (FIPS 180-4), the crypto library only hashes whole buffers
+typedef struct curl_sha256_s
+{
+	uint32_t state[8];
+	uint64_t length; // bytes hashed so far
+	unsigned char block[64];
+	size_t blocksize; // bytes waiting in block
+}
+curl_sha256_t;
+// server: hashes of files offered for download, made by Curl_ServerSHA256_Frame
+typedef struct curl_serverhash_s
+{
+	struct curl_serverhash_s *next;
+	char path[MAX_OSPATH];
+	// of the file when the hash was started, a changed file is hashed again
+	long long size;
+	long long mtime;
+	qfile_t *file; // open while the hash is being made
+	curl_sha256_t sha256;
+	char hash[CURL_SHA256_HEXSIZE]; // empty if the file couldn't be read
+}
+curl_serverhash_t;
+static curl_serverhash_t *curl_serverhashes = NULL;
+
+static void Curl_HashCache_FreeList(curl_hashentry_t **list)
+{
+	while(*list)
+	{
+		curl_hashentry_t *e = *list;
+		*list = e->next;
+		Z_Free(e);
+	}
+}
+
+static curl_hashentry_t *Curl_HashCache_Insert(curl_hashentry_t **list, const char *hash, fs_offset_t size, const char *path)
+{
+	curl_hashentry_t *e = (curl_hashentry_t *) Z_Malloc(sizeof(*e));
+	dp_strlcpy(e->hash, hash, sizeof(e->hash));
+	e->size = size;
+	dp_strlcpy(e->path, path, sizeof(e->path));
+	e->next = *list;
+	*list = e;
+	return e;
+}
+
+/*
+====================
+Curl_SHA256
+
+Writes the lowercase hex SHA-256 of data to hash (CURL_SHA256_HEXSIZE bytes),
+returns false if the crypto library is not available
+====================
+*/
+qbool Curl_SHA256(const unsigned char *data, size_t size, char *hash)
+{
+	unsigned char digest[32];
+	int i;
+	if(!Crypto_Available() || size > INT_MAX)
+		return false;
+	sha256(digest, data, (int) size);
+	for(i = 0; i < 32; ++i)
+		dpsnprintf(hash + i * 2, 3, "%02x", digest[i]);
+	return true;
+}
+
+static qbool Curl_ValidSHA256(const char *hash)
+{
+	int i;
+	for(i = 0; i < CURL_SHA256_HEXSIZE - 1; ++i)
+		if(!isxdigit((unsigned char) hash[i]))
+			return false;
+	return !hash[i];
+}
+
+static unsigned char *Curl_ReadAndClose(qfile_t *f, fs_offset_t *size)
+{
+	unsigned char *data;
+	*size = FS_FileSize(f);
+	if(*size < 0 || *size > INT_MAX)
+	{
+		FS_Close(f);
+		return NULL;
+	}
+	data = (unsigned char *) Mem_Alloc(tempmempool, *size + 1);
+	if(FS_Read(f, data, *size) != *size)
+	{
+		Mem_Free(data);
+		data = NULL;
+	}
+	FS_Close(f);
+	return data;
+}
+
+static void Curl_HashCache_Load(void)
+{
+	qfile_t *f;
+	fs_offset_t size;
+	char *text;
+	const char *p;
+	char hash[CURL_SHA256_HEXSIZE];
+	fs_offset_t filesize;
+
+	if(!strcmp(curl_hashcache_gamedir, fs_gamedir))
+		return;
+	Curl_HashCache_FreeList(&curl_hashcache);
+	dp_strlcpy(curl_hashcache_gamedir, fs_gamedir, sizeof(curl_hashcache_gamedir));
+
+	f = FS_OpenRealFile(CURL_HASHCACHE_FILE, "rb", true);
+	if(!f)
+		return;
+	text = (char *) Curl_ReadAndClose(f, &size);
+	if(!text)
+		return;
+	text[size] = 0;
+
+	// the file is appended to, so later lines are newer and get inserted
+	// in front of the older ones
+	p = text;
+	for(;;)
+	{
+		if(!COM_ParseToken_Console(&p))
+			break;
+		dp_strlcpy(hash, com_token, sizeof(hash));
+		if(!COM_ParseToken_Console(&p))
+			break;
+		filesize = (fs_offset_t) strtod(com_token, NULL);
+		if(!COM_ParseToken_Console(&p))
+			break;
+		if(Curl_ValidSHA256(hash) && filesize > 0 && !FS_CheckNastyPath(com_token, false))
+			Curl_HashCache_Insert(&curl_hashcache, hash, filesize, com_token);
+	}
+	Mem_Free(text);
+}
+
+static curl_hashentry_t *Curl_HashCache_FindPath(const char *path)
+{
+	curl_hashentry_t *e;
+	Curl_HashCache_Load();
+	for(e = curl_hashcache; e; e = e->next)
+		if(!strcmp(e->path, path))
+			return e;
+	return NULL;
+}
+
+/*
+====================
+Curl_HashCache_Add
+
+Remembers the content hash of a file that was just downloaded to path
+====================
+*/
+void Curl_HashCache_Add(const char *path, const unsigned char *data, size_t size)
+{
+	char hash[CURL_SHA256_HEXSIZE];
+	curl_hashentry_t *e;
+	qfile_t *f;
+
+	if(!Curl_SHA256(data, size, hash))
+		return;
+	e = Curl_HashCache_FindPath(path);
+	if(e && e->size == (fs_offset_t) size && !strcmp(e->hash, hash))
+		return;
+	Curl_HashCache_Insert(&curl_hashcache, hash, (fs_offset_t) size, path);
+
+	f = FS_OpenRealFile(CURL_HASHCACHE_FILE, "ab", false);
+	if(f)
+	{
+		FS_Printf(f, "%s %.0f \"%s\"\n", hash, (double) size, path);
+		FS_Close(f);
+	}
+}
+
+static void Curl_HashCache_AddFile(const char *path, const char *expected)
+{
+	qfile_t *f;
+	fs_offset_t size;
+	unsigned char *data;
+	curl_hashentry_t *e;
+
+	if(!Crypto_Available())
+		return;
+	f = FS_OpenRealFile(path, "rb", true);
+	if(!f)
+		return;
+	data = Curl_ReadAndClose(f, &size);
+	if(!data)
+		return;
+	Curl_HashCache_Add(path, data, size);
+	Mem_Free(data);
+	e = Curl_HashCache_FindPath(path);
+	if(expected && *expected && e && strcmp(e->hash, expected))
+		Con_Printf("^3WARNING:^7 %s does not have the content the server announced\n", path);
+}
+
+/*
+====================
+Curl_HashCache_Find
+
+Returns the name of a previously downloaded file that still has the given
+hash and size, or NULL. If data is not NULL, the file is also loaded and its
+content verified, and *data must be Mem_Free()d by the caller.
+====================
+*/
+const char *Curl_HashCache_Find(const char *hash, fs_offset_t size, unsigned char **data)
+{
+	curl_hashentry_t *e;
+	qfile_t *f;
+	fs_offset_t filesize;
+	unsigned char *buf;
+	char filehash[CURL_SHA256_HEXSIZE];
+
+	if(data)
+		*data = NULL;
+	if(!Crypto_Available() || !Curl_ValidSHA256(hash))
+		return NULL;
+	Curl_HashCache_Load();
+	for(e = curl_hashcache; e; e = e->next)
+	{
+		if(strcmp(e->hash, hash) || (size >= 0 && e->size != size))
+			continue;
+		// the newest entry for a path is the one that counts
+		if(Curl_HashCache_FindPath(e->path) != e)
+			continue;
+		f = FS_OpenRealFile(e->path, "rb", true);
+		if(!f)
+			continue;
+		if(!data)
+		{
+			filesize = FS_FileSize(f);
+			FS_Close(f);
+			if(filesize == e->size)
+				return e->path;
+			continue;
+		}
+		buf = Curl_ReadAndClose(f, &filesize);
+		if(!buf)
+			continue;
+		if(filesize == e->size && Curl_SHA256(buf, filesize, filehash) && !strcmp(filehash, hash))
+		{
+			*data = buf;
+			return e->path;
+		}
+		Mem_Free(buf);
+	}
+	return NULL;
+}
+
+static const uint32_t curl_sha256_k[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define CURL_SHA256_ROR(x,n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void Curl_SHA256_Block(curl_sha256_t *s, const unsigned char *block)
+{
+	uint32_t w[64], v[8], t1, t2;
+	int i;
+
+	for(i = 0; i < 16; ++i)
+		w[i] = ((uint32_t) block[i * 4] << 24) | ((uint32_t) block[i * 4 + 1] << 16) | ((uint32_t) block[i * 4 + 2] << 8) | block[i * 4 + 3];
+	for(; i < 64; ++i)
+		w[i] = w[i - 16] + w[i - 7]
+			+ (CURL_SHA256_ROR(w[i - 15], 7) ^ CURL_SHA256_ROR(w[i - 15], 18) ^ (w[i - 15] >> 3))
+			+ (CURL_SHA256_ROR(w[i - 2], 17) ^ CURL_SHA256_ROR(w[i - 2], 19) ^ (w[i - 2] >> 10));
+	memcpy(v, s->state, sizeof(v));
+	for(i = 0; i < 64; ++i)
+	{
+		t1 = v[7] + (CURL_SHA256_ROR(v[4], 6) ^ CURL_SHA256_ROR(v[4], 11) ^ CURL_SHA256_ROR(v[4], 25)) + ((v[4] & v[5]) ^ (~v[4] & v[6])) + curl_sha256_k[i] + w[i];
+		t2 = (CURL_SHA256_ROR(v[0], 2) ^ CURL_SHA256_ROR(v[0], 13) ^ CURL_SHA256_ROR(v[0], 22)) + ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+		memmove(v + 1, v, sizeof(v[0]) * 7);
+		v[4] += t1;
+		v[0] = t1 + t2;
+	}
+	for(i = 0; i < 8; ++i)
+		s->state[i] += v[i];
+}
+
+static void Curl_SHA256_Begin(curl_sha256_t *s)
+{
+	static const uint32_t init[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+	memcpy(s->state, init, sizeof(s->state));
+	s->length = 0;
+	s->blocksize = 0;
+}
+
+static void Curl_SHA256_Update(curl_sha256_t *s, const unsigned char *data, size_t size)
+{
+	size_t n;
+	s->length += size;
+	while(size)
+	{
+		n = min(size, sizeof(s->block) - s->blocksize);
+		memcpy(s->block + s->blocksize, data, n);
+		s->blocksize += n;
+		data += n;
+		size -= n;
+		if(s->blocksize == sizeof(s->block))
+		{
+			Curl_SHA256_Block(s, s->block);
+			s->blocksize = 0;
+		}
+	}
+}
+
+// writes the lowercase hex digest to hash (CURL_SHA256_HEXSIZE bytes)
+static void Curl_SHA256_Final(curl_sha256_t *s, char *hash)
+{
+	uint64_t bits = s->length * 8;
+	int i;
+
+	s->block[s->blocksize++] = 0x80;
+	if(s->blocksize > 56)
+	{
+		memset(s->block + s->blocksize, 0, sizeof(s->block) - s->blocksize);
+		Curl_SHA256_Block(s, s->block);
+		s->blocksize = 0;
+	}
+	memset(s->block + s->blocksize, 0, 56 - s->blocksize);
+	for(i = 0; i < 8; ++i)
+		s->block[56 + i] = (unsigned char) (bits >> (56 - i * 8));
+	Curl_SHA256_Block(s, s->block);
+	for(i = 0; i < 32; ++i)
+		dpsnprintf(hash + i * 2, 3, "%02x", (unsigned int) ((s->state[i / 4] >> (24 - (i % 4) * 8)) & 0xFF));
+}
+
+/*
+====================
+Curl_ServerSHA256
+
+Returns the hash of a file the server offers for download (by absolute path),
+or NULL while it is still being made.  The first call for a file, and any
+call after the file's size or modification time changed, starts hashing it;
+Curl_ServerSHA256_Frame then reads sv_curl_sha256_framebytes of it per frame,
+so a big package costs the server a bounded amount of time each frame instead
+of one long stall.  Until it is done the file is announced without a hash.
+====================
+*/
+const char *Curl_ServerSHA256(const char *path)
+{
+	curl_serverhash_t *e;
+	long long size, mtime;
+
+	if(!FS_SysFileStat(path, &size, &mtime))
+		return NULL;
+	for(e = curl_serverhashes; e; e = e->next)
+		if(!strcmp(e->path, path))
+			break;
+	if(e)
+	{
+		if(e->size == size && e->mtime == mtime)
+			return e->file || !e->hash[0] ? NULL : e->hash;
+		if(e->file)
+			FS_Close(e->file);
+	}
+	else
+	{
+		e = (curl_serverhash_t *) Z_Malloc(sizeof(*e));
+		dp_strlcpy(e->path, path, sizeof(e->path));
+		e->next = curl_serverhashes;
+		curl_serverhashes = e;
+	}
+	e->size = size;
+	e->mtime = mtime;
+	e->hash[0] = 0;
+	e->file = FS_SysOpen(path, "rb", false);
+	if(e->file)
+		Curl_SHA256_Begin(&e->sha256);
+	return NULL;
+}
+
+/*
+====================
+Curl_ServerSHA256_Frame
+
+Continues the hashes started by Curl_ServerSHA256, reading at most
+sv_curl_sha256_framebytes in total.
+====================
+*/
+static void Curl_ServerSHA256_Frame(void)
+{
+	static unsigned char buf[65536];
+	curl_serverhash_t *e;
+	fs_offset_t budget = max(sv_curl_sha256_framebytes.integer, (int) sizeof(buf));
+	fs_offset_t n;
+
+	for(e = curl_serverhashes; e && budget > 0; e = e->next)
+	{
+		while(e->file && budget > 0)
+		{
+			n = FS_Read(e->file, buf, min(budget, (fs_offset_t) sizeof(buf)));
+			if(n > 0)
+			{
+				Curl_SHA256_Update(&e->sha256, buf, n);
+				budget -= n;
+				continue;
+			}
+			// a short file means it changed while it was read, the next
+			// Curl_ServerSHA256 call sees the new size and starts over
+			if(n == 0 && (long long) e->sha256.length == e->size)
+				Curl_SHA256_Final(&e->sha256, e->hash);
+			FS_Close(e->file);
+			e->file = NULL;
+		}
+	}
+}
+
+static void Curl_ServerSHA256_Shutdown(void)
+{
+	curl_serverhash_t *e;
+	while((e = curl_serverhashes))
+	{
+		curl_serverhashes = e->next;
+		if(e->file)
+			FS_Close(e->file);
+		Z_Free(e);
+	}
+}
+
 /*
 ====================
 Curl_Shutdown
@@ -827,6 +1286,9 @@ Surprise... closes all the stuff. Please do this BEFORE shutting down LHNET.
 void Curl_ClearRequirements(void);
 void Curl_Shutdown(void)
 {
+	Curl_HashCache_FreeList(&curl_hashcache);
+	curl_hashcache_gamedir[0] = 0;
+	Curl_ServerSHA256_Shutdown();
 	if(!curl_dll)
 		return;
 	Curl_ClearRequirements();
@@ -883,7 +1345,7 @@ Starts a download of a given URL to the file name portion of this URL (or name
 if given) in the "dlcache/" folder.
 ====================
 */
-static qbool Curl_Begin(const char *URL, const char *extraheaders, double maxspeed, const char *name, int loadtype, qbool forthismap, const char *post_content_type, const unsigned char *postbuf, size_t postbufsize, unsigned char *buf, size_t bufsize, curl_callback_t callback, void *cbdata)
+static qbool Curl_Begin(const char *URL, const char *extraheaders, double maxspeed, const char *name, int loadtype, qbool forthismap, const char *sha256, const char *post_content_type, const unsigned char *postbuf, size_t postbufsize, unsigned char *buf, size_t bufsize, curl_callback_t callback, void *cbdata)
 {
 	if(buf)
 		if(loadtype != LOADTYPE_NONE)
@@ -993,6 +1455,45 @@ static qbool Curl_Begin(const char *URL, const char *extraheaders, double maxspe
 				}
 			}
 
+			if(sha256 && loadtype == LOADTYPE_PAK)
+			{
+				curl_hashentry_t *e = Curl_HashCache_FindPath(fn);
+				const char *cached;
+
+				// we downloaded this name before, but the server has another
+				// version of it now; a mounted pack can't be replaced under
+				// the file system, so that one is kept until it is unloaded
+				if(e && strcmp(e->hash, sha256) && FS_FileExists(fn))
+				{
+					if(FS_PackLoaded(fn))
+						Con_Printf("%s has changed on the server but is in use, reconnect with fs_unload_dlcache 1 to update it\n", fn);
+					else
+					{
+						qfile_t *f = FS_OpenRealFile(fn, "rb", true);
+						Con_Printf("%s has changed on the server, downloading it again\n", fn);
+						if(f)
+						{
+							FS_RemoveOnClose(f);
+							FS_Close(f);
+						}
+					}
+				}
+
+				// we may have the same content under another name
+				if(!FS_FileExists(fn) && (cached = Curl_HashCache_Find(sha256, -1, NULL)) && FS_AddPack(cached, NULL, true, true))
+				{
+					Con_DPrintf("%s is already in %s, not downloading!\n", fn, cached);
+					if(forthismap)
+					{
+						++numdownloads_added;
+						++numdownloads_success;
+					}
+
+					if (curl_mutex) Thread_UnlockMutex(curl_mutex);
+					return false;
+				}
+			}
+
 			if(FS_FileExists(fn))
 			{
 				if(loadtype == LOADTYPE_PAK)
@@ -1065,6 +1566,8 @@ static qbool Curl_Begin(const char *URL, const char *extraheaders, double maxspe
 		dp_strlcpy(di->url, URL, sizeof(di->url));
 		dpsnprintf(di->referer, sizeof(di->referer), "dp://%s/", cls.netcon ? cls.netcon->address : "notconnected.invalid");
 		di->forthismap = forthismap;
+		if(sha256)
+			dp_strlcpy(di->sha256, sha256, sizeof(di->sha256));
 		di->stream = NULL;
 		di->startpos = 0;
 		di->curle = NULL;
@@ -1112,15 +1615,15 @@ static qbool Curl_Begin(const char *URL, const char *extraheaders, double maxspe
 
 qbool Curl_Begin_ToFile(const char *URL, double maxspeed, const char *name, int loadtype, qbool forthismap)
 {
-	return Curl_Begin(URL, NULL, maxspeed, name, loadtype, forthismap, NULL, NULL, 0, NULL, 0, NULL, NULL);
+	return Curl_Begin(URL, NULL, maxspeed, name, loadtype, forthismap, NULL, NULL, NULL, 0, NULL, 0, NULL, NULL);
 }
 qbool Curl_Begin_ToMemory(const char *URL, double maxspeed, unsigned char *buf, size_t bufsize, curl_callback_t callback, void *cbdata)
 {
-	return Curl_Begin(URL, NULL, maxspeed, NULL, false, false, NULL, NULL, 0, buf, bufsize, callback, cbdata);
+	return Curl_Begin(URL, NULL, maxspeed, NULL, false, false, NULL, NULL, NULL, 0, buf, bufsize, callback, cbdata);
 }
 qbool Curl_Begin_ToMemory_POST(const char *URL, const char *extraheaders, double maxspeed, const char *post_content_type, const unsigned char *postbuf, size_t postbufsize, unsigned char *buf, size_t bufsize, curl_callback_t callback, void *cbdata)
 {
-	return Curl_Begin(URL, extraheaders, maxspeed, NULL, false, false, post_content_type, postbuf, postbufsize, buf, bufsize, callback, cbdata);
+	return Curl_Begin(URL, extraheaders, maxspeed, NULL, false, false, NULL, post_content_type, postbuf, postbufsize, buf, bufsize, callback, cbdata);
 }
 
 /*
@@ -1138,6 +1641,10 @@ void Curl_Frame(void)
 
 	noclear = false;
 
+	// the server hashes its packages even without libcurl, clients may
+	// download them over the game connection
+	Curl_ServerSHA256_Frame();
+
 	if(!curl_enabled.integer && cls.state != ca_dedicated)
 		return;
 
@@ -1408,10 +1915,11 @@ curl url
 
 For internal use:
 
-curl [--pak] [--forthismap] [--for filename filename...] url
+curl [--pak] [--forthismap] [--sha256=hash] [--for filename filename...] url
 	--pak: after downloading, load the package into the virtual file system
 	--for filename...: only download of at least one of the named files is missing
 	--forthismap: don't reconnect on failure
+	--sha256=hash: expected content of the package, lets an identical package already in dlcache/ be used instead
 
 curl --clear_autodownload
 	clears the download success/failure counters
@@ -1430,6 +1938,7 @@ static void Curl_Curl_f(cmd_state_t *cmd)
 	qbool forthismap = false;
 	const char *url;
 	const char *name = 0;
+	const char *sha256 = NULL;
 
 	if(!curl_dll)
 	{
@@ -1541,6 +2050,11 @@ static void Curl_Curl_f(cmd_state_t *cmd)
 		{
 			maxspeed = atof(a + 11);
 		}
+		else if(!strncmp(a, "--sha256=", 9))
+		{
+			if(Curl_ValidSHA256(a + 9))
+				sha256 = a + 9;
+		}
 		else if(*a == '-')
 		{
 			Con_Printf("curl: invalid option %s\n", a);
@@ -1549,7 +2063,7 @@ static void Curl_Curl_f(cmd_state_t *cmd)
 	}
 
 needthefile:
-	Curl_Begin_ToFile(url, maxspeed, name, loadtype, forthismap);
+	Curl_Begin(url, NULL, maxspeed, name, loadtype, forthismap, sha256, NULL, NULL, 0, NULL, 0, NULL, NULL);
 }
 
 /*
@@ -1591,6 +2105,8 @@ void Curl_Init_Commands(void)
 	Cvar_RegisterVariable (&sv_curl_defaulturl);
 	Cvar_RegisterVariable (&sv_curl_serverpackages);
 	Cvar_RegisterVariable (&sv_curl_maxspeed);
+	Cvar_RegisterVariable (&sv_curl_sha256);
+	Cvar_RegisterVariable (&sv_curl_sha256_framebytes);
 
 	Cvar_RegisterVariable (&developer_curl);
 
@@ -1779,9 +2295,13 @@ Adds the given file to the list of requirements.
 void Curl_RequireFile(const char *filename)
 {
 	requirement *req = (requirement *) Z_Malloc(sizeof(*requirements));
+	const char *packfile;
 	req->next = requirements;
 	dp_strlcpy(req->filename, filename, sizeof(req->filename));
 	requirements = req;
+	// start hashing the package now, so it is ready when clients connect
+	if(sv_curl_sha256.integer && (packfile = FS_WhichPackFile(filename)))
+		Curl_ServerSHA256(packfile);
 }
 
 /*
@@ -1819,6 +2339,7 @@ static qbool Curl_SendRequirement(const char *filename, qbool foundone, char *se
 	const char *p;
 	const char *thispack = FS_WhichPack(filename);
 	const char *packurl;
+	const char *packfile, *hash;
 
 	if(!thispack || !*thispack)
 		return false;
@@ -1838,6 +2359,8 @@ static qbool Curl_SendRequirement(const char *filename, qbool foundone, char *se
 		dp_strlcat(sendbuffer, thispack, sendbuffer_len);
 		if(sv_curl_maxspeed.value > 0)
 			dpsnprintf(sendbuffer + strlen(sendbuffer), sendbuffer_len - strlen(sendbuffer), " --maxspeed=%.1f", sv_curl_maxspeed.value);
+		if(sv_curl_sha256.integer && (packfile = FS_WhichPackFile(filename)) && (hash = Curl_ServerSHA256(packfile)))
+			dpsnprintf(sendbuffer + strlen(sendbuffer), sendbuffer_len - strlen(sendbuffer), " --sha256=%s", hash);
 		dp_strlcat(sendbuffer, " --for ", sendbuffer_len);
 		dp_strlcat(sendbuffer, filename, sendbuffer_len);
 		dp_strlcat(sendbuffer, " ", sendbuffer_len);
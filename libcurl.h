@@ -1,6 +1,7 @@
 #include <stddef.h>
 #include "qtypes.h"
 #include "qdefs.h"
+#include "fs.h"
 
 enum
 {
@@ -31,6 +32,13 @@ void Curl_Clear_forthismap(void);
 qbool Curl_Have_forthismap(void);
 void Curl_Register_predownload(void);
 
+// content hash cache of downloaded files (dlcache/sha256.txt)
+#define CURL_SHA256_HEXSIZE 65
+qbool Curl_SHA256(const unsigned char *data, size_t size, char *hash);
+void Curl_HashCache_Add(const char *path, const unsigned char *data, size_t size);
+const char *Curl_HashCache_Find(const char *hash, fs_offset_t size, unsigned char **data);
+const char *Curl_ServerSHA256(const char *path);
+
 void Curl_ClearRequirements(void);
 void Curl_RequireFile(const char *filename);
 void Curl_SendRequirements(void);
@@ -0,0 +1,160 @@
+#include "mod_skeletal_animatevertices_avx2.h"
+
+#ifdef AVX2_POSSIBLE
+
+#include <immintrin.h>
+
+// only this file is built for AVX2, the caller checks Sys_HaveAVX2 first
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#else
+#define AVX2_TARGET
+#endif
+
+// transposes 8 xyz triplets into one register per component
+static AVX2_TARGET inline void Load3x8(const float * RESTRICT in, __m256 *x, __m256 *y, __m256 *z)
+{
+	__m256 m03, m14, m25, xy, yz;
+	m03 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(in + 0)), _mm_loadu_ps(in + 12), 1);
+	m14 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(in + 4)), _mm_loadu_ps(in + 16), 1);
+	m25 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(in + 8)), _mm_loadu_ps(in + 20), 1);
+	xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+	yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+	*x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+	*y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+	*z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+// inverse of Load3x8
+static AVX2_TARGET inline void Store3x8(float * RESTRICT out, __m256 x, __m256 y, __m256 z)
+{
+	__m256 rxy, ryz, rzx, r03, r14, r25;
+	rxy = _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+	ryz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+	rzx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+	r03 = _mm256_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0));
+	r14 = _mm256_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0));
+	r25 = _mm256_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1));
+	_mm_storeu_ps(out + 0, _mm256_castps256_ps128(r03));
+	_mm_storeu_ps(out + 4, _mm256_castps256_ps128(r14));
+	_mm_storeu_ps(out + 8, _mm256_castps256_ps128(r25));
+	_mm_storeu_ps(out + 12, _mm256_extractf128_ps(r03, 1));
+	_mm_storeu_ps(out + 16, _mm256_extractf128_ps(r14, 1));
+	_mm_storeu_ps(out + 20, _mm256_extractf128_ps(r25, 1));
+}
+
+// gathers element k of the blend matrix of 8 consecutive vertices into m[k]
+static AVX2_TARGET inline void LoadMatrices8(const float * RESTRICT boneposerelative, const unsigned short * RESTRICT b, __m256 m[12])
+{
+	int k;
+	__m256i index = _mm256_mullo_epi32(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)b)), _mm256_set1_epi32(12));
+	for (k = 0;k < 12;k++)
+		m[k] = _mm256_i32gather_ps(boneposerelative + k, index, 4);
+}
+
+static AVX2_TARGET inline void TransformPositions8(const float * RESTRICT in, float * RESTRICT out, const __m256 m[12])
+{
+	__m256 x, y, z;
+	Load3x8(in, &x, &y, &z);
+	Store3x8(out,
+		_mm256_fmadd_ps(x, m[0], _mm256_fmadd_ps(y, m[1], _mm256_fmadd_ps(z, m[ 2], m[ 3]))),
+		_mm256_fmadd_ps(x, m[4], _mm256_fmadd_ps(y, m[5], _mm256_fmadd_ps(z, m[ 6], m[ 7]))),
+		_mm256_fmadd_ps(x, m[8], _mm256_fmadd_ps(y, m[9], _mm256_fmadd_ps(z, m[10], m[11]))));
+}
+
+static AVX2_TARGET inline void TransformVectors8(const float * RESTRICT in, float * RESTRICT out, const __m256 m[12])
+{
+	__m256 x, y, z;
+	Load3x8(in, &x, &y, &z);
+	Store3x8(out,
+		_mm256_fmadd_ps(x, m[0], _mm256_fmadd_ps(y, m[1], _mm256_mul_ps(z, m[ 2]))),
+		_mm256_fmadd_ps(x, m[4], _mm256_fmadd_ps(y, m[5], _mm256_mul_ps(z, m[ 6]))),
+		_mm256_fmadd_ps(x, m[8], _mm256_fmadd_ps(y, m[9], _mm256_mul_ps(z, m[10]))));
+}
+
+AVX2_TARGET void Mod_Skeletal_AnimateVertices_AVX2(const model_t * RESTRICT model, const frameblend_t * RESTRICT frameblend, const skeleton_t *skeleton, float * RESTRICT vertex3f, float * RESTRICT normal3f, float * RESTRICT svector3f, float * RESTRICT tvector3f)
+{
+	// vertex weighted skeletal, 8 vertices at a time
+	int i, k;
+	int numvertices = model->surfmesh.num_vertices;
+	float *bonepose;
+	float *boneposerelative;
+	const blendweights_t * RESTRICT weights;
+	const unsigned short * RESTRICT b = model->surfmesh.blends;
+	const float * RESTRICT v = model->surfmesh.data_vertex3f;
+	const float * RESTRICT n = model->surfmesh.data_normal3f;
+	const float * RESTRICT svec = model->surfmesh.data_svector3f;
+	const float * RESTRICT tvec = model->surfmesh.data_tvector3f;
+	__m256 m[12];
+
+	bonepose = (float *) Mod_Skeletal_AnimateVertices_AllocBuffers(sizeof(float[12]) * (model->num_bones*2 + model->surfmesh.num_blends));
+	boneposerelative = bonepose + model->num_bones * 12;
+
+	Mod_Skeletal_BuildTransforms(model, frameblend, skeleton, bonepose, boneposerelative);
+
+	// generate matrices for all blend combinations
+	weights = model->surfmesh.data_blendweights;
+	for (i = 0;i < model->surfmesh.num_blends;i++, weights++)
+	{
+		float * RESTRICT out = boneposerelative + 12 * (model->num_bones + i);
+		const float * RESTRICT in = boneposerelative + 12 * (unsigned int)weights->index[0];
+		__m256 f = _mm256_set1_ps(weights->influence[0] * (1.0f / 255.0f));
+		__m256 r0 = _mm256_mul_ps(f, _mm256_loadu_ps(in));
+		__m128 r1 = _mm_mul_ps(_mm256_castps256_ps128(f), _mm_loadu_ps(in + 8));
+		for (k = 1;k < 4 && weights->influence[k];k++)
+		{
+			in = boneposerelative + 12 * (unsigned int)weights->index[k];
+			f = _mm256_set1_ps(weights->influence[k] * (1.0f / 255.0f));
+			r0 = _mm256_fmadd_ps(f, _mm256_loadu_ps(in), r0);
+			r1 = _mm_fmadd_ps(_mm256_castps256_ps128(f), _mm_loadu_ps(in + 8), r1);
+		}
+		_mm256_storeu_ps(out, r0);
+		_mm_storeu_ps(out + 8, r1);
+	}
+
+	// transform vertex attributes by blended matrices, loading each group of
+	// matrices only once for all requested attributes
+	for (i = 0;i + 8 <= numvertices;i += 8)
+	{
+		LoadMatrices8(boneposerelative, b + i, m);
+		if (vertex3f)
+			TransformPositions8(v + i * 3, vertex3f + i * 3, m);
+		if (normal3f)
+			TransformVectors8(n + i * 3, normal3f + i * 3, m);
+		if (svector3f)
+			TransformVectors8(svec + i * 3, svector3f + i * 3, m);
+		if (tvector3f)
+			TransformVectors8(tvec + i * 3, tvector3f + i * 3, m);
+	}
+
+	// leftover vertices
+	for (;i < numvertices;i++)
+	{
+		const float * RESTRICT mat = boneposerelative + 12 * (unsigned int)b[i];
+		const float * RESTRICT in;
+		float * RESTRICT out;
+		if (vertex3f)
+		{
+			in = v + i * 3;
+			out = vertex3f + i * 3;
+			out[0] = in[0] * mat[0] + in[1] * mat[1] + in[2] * mat[ 2] + mat[ 3];
+			out[1] = in[0] * mat[4] + in[1] * mat[5] + in[2] * mat[ 6] + mat[ 7];
+			out[2] = in[0] * mat[8] + in[1] * mat[9] + in[2] * mat[10] + mat[11];
+		}
+#define TRANSFORM_VECTOR(src, dst) \
+		if (dst) \
+		{ \
+			in = src + i * 3; \
+			out = dst + i * 3; \
+			out[0] = in[0] * mat[0] + in[1] * mat[1] + in[2] * mat[ 2]; \
+			out[1] = in[0] * mat[4] + in[1] * mat[5] + in[2] * mat[ 6]; \
+			out[2] = in[0] * mat[8] + in[1] * mat[9] + in[2] * mat[10]; \
+		}
+		TRANSFORM_VECTOR(n, normal3f)
+		TRANSFORM_VECTOR(svec, svector3f)
+		TRANSFORM_VECTOR(tvec, tvector3f)
+#undef TRANSFORM_VECTOR
+	}
+}
+
+#endif
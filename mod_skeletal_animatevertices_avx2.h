@@ -0,0 +1,10 @@
+#ifndef MOD_SKELETAL_ANIMATEVERTICES_AVX2_H
+#define MOD_SKELETAL_ANIMATEVERTICES_AVX2_H
+
+#include "quakedef.h"
+
+#ifdef AVX2_POSSIBLE
+void Mod_Skeletal_AnimateVertices_AVX2(const model_t * RESTRICT model, const frameblend_t * RESTRICT frameblend, const skeleton_t *skeleton, float * RESTRICT vertex3f, float * RESTRICT normal3f, float * RESTRICT svector3f, float * RESTRICT tvector3f);
+#endif
+
+#endif
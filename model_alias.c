@@ -22,6 +22,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "image.h"
 #include "r_shadow.h"
 #include "mod_skeletal_animatevertices_generic.h"
+#ifdef AVX2_POSSIBLE
+#include "mod_skeletal_animatevertices_avx2.h"
+#endif
 #ifdef SSE_POSSIBLE
 #include "mod_skeletal_animatevertices_sse.h"
 #endif
@@ -30,6 +33,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 static qbool r_skeletal_use_sse_defined = false;
 cvar_t r_skeletal_use_sse = {CF_CLIENT, "r_skeletal_use_sse", "1", "use SSE for skeletal model animation"};
 #endif
+#ifdef AVX2_POSSIBLE
+static qbool r_skeletal_use_avx2_defined = false;
+cvar_t r_skeletal_use_avx2 = {CF_CLIENT, "r_skeletal_use_avx2", "1", "use AVX2/FMA for skeletal model animation (8 vertices at a time, takes priority over r_skeletal_use_sse)"};
+#endif
 cvar_t r_skeletal_debugbone = {CF_CLIENT, "r_skeletal_debugbone", "-1", "development cvar for testing skeletal model code"};
 cvar_t r_skeletal_debugbonecomponent = {CF_CLIENT, "r_skeletal_debugbonecomponent", "3", "development cvar for testing skeletal model code"};
 cvar_t r_skeletal_debugbonevalue = {CF_CLIENT, "r_skeletal_debugbonevalue", "100", "development cvar for testing skeletal model code"};
@@ -38,28 +45,65 @@ cvar_t r_skeletal_debugtranslatey = {CF_CLIENT, "r_skeletal_debugtranslatey", "1
 cvar_t r_skeletal_debugtranslatez = {CF_CLIENT, "r_skeletal_debugtranslatez", "1", "development cvar for testing skeletal model code"};
 cvar_t mod_alias_supporttagscale = {CF_CLIENT | CF_SERVER, "mod_alias_supporttagscale", "1", "support scaling factors in bone/tag attachment matrices as supported by MD3"};
 cvar_t mod_alias_force_animated = {CF_CLIENT | CF_SERVER, "mod_alias_force_animated", "", "if set to an non-empty string, overrides the is-animated flag of any alias models (for benchmarking)"};
+cvar_t mod_alias_cache = {CF_CLIENT | CF_SERVER, "mod_alias_cache", "1", "keep post-processed IQM/MD3/PSK/DPM models in cache/models/ of the user directory so unchanged models load without reprocessing"};
 
 float mod_md3_sin[320];
 
-static size_t Mod_Skeletal_AnimateVertices_maxbonepose = 0;
-static void *Mod_Skeletal_AnimateVertices_bonepose = NULL;
+// per thread so R_AnimCache can skin entities on the task queue, and every
+// thread's buffer is also on a list so Mod_Skeletal_FreeBuffers frees those
+// of the task queue threads as well
+typedef struct mod_skeletal_bonepose_s
+{
+	struct mod_skeletal_bonepose_s *next;
+	size_t size;
+	void *data;
+}
+mod_skeletal_bonepose_t;
+static Thread_SpinLock Mod_Skeletal_AnimateVertices_lock;
+static mod_skeletal_bonepose_t *Mod_Skeletal_AnimateVertices_buffers = NULL;
+static int Mod_Skeletal_AnimateVertices_generation = 0; ///< bumped when the list is freed
+static THREADLOCAL mod_skeletal_bonepose_t *Mod_Skeletal_AnimateVertices_bonepose = NULL;
+static THREADLOCAL int Mod_Skeletal_AnimateVertices_bonepose_generation = 0;
+// only while nothing is being animated
 void Mod_Skeletal_FreeBuffers(void)
 {
-	if(Mod_Skeletal_AnimateVertices_bonepose)
-		Mem_Free(Mod_Skeletal_AnimateVertices_bonepose);
-	Mod_Skeletal_AnimateVertices_maxbonepose = 0;
-	Mod_Skeletal_AnimateVertices_bonepose = NULL;
+	mod_skeletal_bonepose_t *b;
+	Thread_AtomicLock(&Mod_Skeletal_AnimateVertices_lock);
+	while((b = Mod_Skeletal_AnimateVertices_buffers))
+	{
+		Mod_Skeletal_AnimateVertices_buffers = b->next;
+		Mem_Free(b->data);
+		Mem_Free(b);
+	}
+	// makes every thread's pointer stale
+	Mod_Skeletal_AnimateVertices_generation++;
+	Thread_AtomicUnlock(&Mod_Skeletal_AnimateVertices_lock);
 }
 void *Mod_Skeletal_AnimateVertices_AllocBuffers(size_t nbytes)
 {
-	if(Mod_Skeletal_AnimateVertices_maxbonepose < nbytes)
+	mod_skeletal_bonepose_t *b = Mod_Skeletal_AnimateVertices_bonepose;
+	void *data;
+	if(b && Mod_Skeletal_AnimateVertices_bonepose_generation == Mod_Skeletal_AnimateVertices_generation)
 	{
-		if(Mod_Skeletal_AnimateVertices_bonepose)
-			Mem_Free(Mod_Skeletal_AnimateVertices_bonepose);
-		Mod_Skeletal_AnimateVertices_bonepose = Z_Malloc(nbytes);
-		Mod_Skeletal_AnimateVertices_maxbonepose = nbytes;
+		if(b->size >= nbytes)
+			return b->data;
+		data = Z_Malloc(nbytes);
+		Mem_Free(b->data);
 	}
-	return Mod_Skeletal_AnimateVertices_bonepose;
+	else
+	{
+		data = Z_Malloc(nbytes);
+		b = (mod_skeletal_bonepose_t *)Z_Malloc(sizeof(*b));
+		Thread_AtomicLock(&Mod_Skeletal_AnimateVertices_lock);
+		b->next = Mod_Skeletal_AnimateVertices_buffers;
+		Mod_Skeletal_AnimateVertices_buffers = b;
+		Mod_Skeletal_AnimateVertices_bonepose_generation = Mod_Skeletal_AnimateVertices_generation;
+		Thread_AtomicUnlock(&Mod_Skeletal_AnimateVertices_lock);
+		Mod_Skeletal_AnimateVertices_bonepose = b;
+	}
+	b->data = data;
+	b->size = nbytes;
+	return data;
 }
 
 void Mod_Skeletal_BuildTransforms(const model_t * RESTRICT model, const frameblend_t * RESTRICT frameblend, const skeleton_t *skeleton, float * RESTRICT bonepose, float * RESTRICT boneposerelative)
@@ -175,6 +219,14 @@ static void Mod_Skeletal_AnimateVertices(const model_t * RESTRICT model, const f
 		return;
 	}
 
+#ifdef AVX2_POSSIBLE
+	if(r_skeletal_use_avx2_defined)
+		if(r_skeletal_use_avx2.integer)
+		{
+			Mod_Skeletal_AnimateVertices_AVX2(model, frameblend, skeleton, vertex3f, normal3f, svector3f, tvector3f);
+			return;
+		}
+#endif
 #ifdef SSE_POSSIBLE
 	if(r_skeletal_use_sse_defined)
 		if(r_skeletal_use_sse.integer)
@@ -186,6 +238,87 @@ static void Mod_Skeletal_AnimateVertices(const model_t * RESTRICT model, const f
 	Mod_Skeletal_AnimateVertices_Generic(model, frameblend, skeleton, vertex3f, normal3f, svector3f, tvector3f);
 }
 
+typedef void (*skeletalkernel_t)(const model_t * RESTRICT model, const frameblend_t * RESTRICT frameblend, const skeleton_t *skeleton, float * RESTRICT vertex3f, float * RESTRICT normal3f, float * RESTRICT svector3f, float * RESTRICT tvector3f);
+
+/*
+====================
+Mod_Skeletal_Benchmark_f
+
+times every skeletal animation kernel this CPU supports on one model and
+reports how far each result is from the generic kernel
+====================
+*/
+static void Mod_Skeletal_Benchmark_f(cmd_state_t *cmd)
+{
+	const char *kernelnames[3];
+	skeletalkernel_t kernels[3];
+	int numkernels = 0, kernelindex, iterations, i, numvertices, numfloats;
+	model_t *model;
+	frameblend_t frameblend[MAX_FRAMEBLENDS];
+	float *reference, *out;
+	qbool tangents;
+	double starttime, elapsed, maxerror;
+
+	if (Cmd_Argc(cmd) < 2)
+	{
+		Con_Print("usage: r_skeletal_benchmark <modelname> [iterations]\n");
+		return;
+	}
+	model = Mod_ForName(Cmd_Argv(cmd, 1), false, true, NULL);
+	if (!model || model->AnimateVertices != Mod_Skeletal_AnimateVertices || !model->num_bones || !model->surfmesh.num_vertices)
+	{
+		Con_Printf("%s is not a skeletal model\n", Cmd_Argv(cmd, 1));
+		return;
+	}
+	iterations = Cmd_Argc(cmd) >= 3 ? atoi(Cmd_Argv(cmd, 2)) : 1000;
+	iterations = max(iterations, 1);
+
+	kernelnames[numkernels] = "generic";
+	kernels[numkernels++] = Mod_Skeletal_AnimateVertices_Generic;
+#ifdef SSE_POSSIBLE
+	if (r_skeletal_use_sse_defined)
+	{
+		kernelnames[numkernels] = "sse";
+		kernels[numkernels++] = Mod_Skeletal_AnimateVertices_SSE;
+	}
+#endif
+#ifdef AVX2_POSSIBLE
+	if (r_skeletal_use_avx2_defined)
+	{
+		kernelnames[numkernels] = "avx2";
+		kernels[numkernels++] = Mod_Skeletal_AnimateVertices_AVX2;
+	}
+#endif
+
+	// blend two poses so the pose blending is timed as well
+	memset(frameblend, 0, sizeof(frameblend));
+	frameblend[0].subframe = 0;
+	frameblend[0].lerp = 0.5f;
+	frameblend[1].subframe = model->num_poses / 2;
+	frameblend[1].lerp = 0.5f;
+
+	// vertex, normal, svector, tvector
+	numvertices = model->surfmesh.num_vertices;
+	numfloats = numvertices * 12;
+	tangents = model->surfmesh.data_svector3f && model->surfmesh.data_tvector3f;
+	reference = (float *)Mem_Alloc(tempmempool, sizeof(float) * numfloats * 2);
+	out = reference + numfloats;
+	Mod_Skeletal_AnimateVertices_Generic(model, frameblend, NULL, reference, reference + numvertices * 3, tangents ? reference + numvertices * 6 : NULL, tangents ? reference + numvertices * 9 : NULL);
+	Con_Printf("%s: %i vertices, %i bones, %i blends, %i iterations\n", model->name, numvertices, model->num_bones, model->surfmesh.num_blends, iterations);
+	for (kernelindex = 0;kernelindex < numkernels;kernelindex++)
+	{
+		starttime = Sys_DirtyTime();
+		for (i = 0;i < iterations;i++)
+			kernels[kernelindex](model, frameblend, NULL, out, out + numvertices * 3, tangents ? out + numvertices * 6 : NULL, tangents ? out + numvertices * 9 : NULL);
+		elapsed = Sys_DirtyTime() - starttime;
+		maxerror = 0;
+		for (i = 0;i < numfloats;i++)
+			maxerror = max(maxerror, fabs(out[i] - reference[i]));
+		Con_Printf("%-8s %12.0f vertices/s, max difference %g\n", kernelnames[kernelindex], elapsed > 0 ? (double)numvertices * iterations / elapsed : 0.0, maxerror);
+	}
+	Mem_Free(reference);
+}
+
 void Mod_AliasInit (void)
 {
 	int i;
@@ -197,6 +330,8 @@ void Mod_AliasInit (void)
 	Cvar_RegisterVariable(&r_skeletal_debugtranslatez);
 	Cvar_RegisterVariable(&mod_alias_supporttagscale);
 	Cvar_RegisterVariable(&mod_alias_force_animated);
+	Cvar_RegisterVariable(&mod_alias_cache);
+	Cmd_AddCommand(CF_CLIENT, "r_skeletal_benchmark", Mod_Skeletal_Benchmark_f, "times the skeletal animation code paths on a model and compares their results (usage: r_skeletal_benchmark <modelname> [iterations])");
 	for (i = 0;i < 320;i++)
 		mod_md3_sin[i] = sin(i * M_PI * 2.0f / 256.0);
 #ifdef SSE_POSSIBLE
@@ -211,6 +346,14 @@ void Mod_AliasInit (void)
 #else
 	Con_Printf("Skeletal animation uses generic code path (SSE not compiled in)\n");
 #endif
+#ifdef AVX2_POSSIBLE
+	if(Sys_HaveAVX2())
+	{
+		Con_Printf("Skeletal animation uses AVX2 code path\n");
+		r_skeletal_use_avx2_defined = true;
+		Cvar_RegisterVariable(&r_skeletal_use_avx2);
+	}
+#endif
 }
 
 static int Mod_Skeletal_AddBlend(model_t *model, const blendweights_t *newweights)
@@ -922,11 +1065,577 @@ static void Mod_MDL_LoadFrames (unsigned char* datapointer, int inverts, int *ve
 	}
 }
 
+/*
+===============================================================================
+
+MODEL CACHE
+
+After a successful IQM/MD3/PSK/DPM load the post-processed model (welded and
+blend compressed vertices, normals and tangents, compiled morph frames, bone
+poses, bounds and the collision BIH) is written to cache/models/<name>.cache
+in the gamedir of the user directory, keyed on an MD4 digest of the source
+file(s).  Loading an unchanged model again reads that file back as a single
+allocation and points the model arrays straight into it, so none of the
+preprocessing is repeated.  Only the textures are rebuilt, as .skin files and
+shaders can change without the model file changing.
+
+The file is native endian and every lump is 16 byte aligned, so the blob is
+usable in place without any fixups.
+
+===============================================================================
+*/
+
+#define MODELCACHE_IDENT "DPMODELCACHE"
+#define MODELCACHE_VERSION 1
+#define MODELCACHE_ENDIAN 0x01020304
+#define MODELCACHE_ALIGN 16
+
+typedef enum modelcache_lump_e
+{
+	MODELCACHE_LUMP_ANIMSCENES,
+	MODELCACHE_LUMP_TAGS,
+	MODELCACHE_LUMP_BONES,
+	MODELCACHE_LUMP_BASEBONEPOSEINVERSE,
+	MODELCACHE_LUMP_POSES7S,
+	MODELCACHE_LUMP_SURFACES,
+	MODELCACHE_LUMP_ELEMENT3I,
+	MODELCACHE_LUMP_ELEMENT3S,
+	MODELCACHE_LUMP_VERTEX3F,
+	MODELCACHE_LUMP_SVECTOR3F,
+	MODELCACHE_LUMP_TVECTOR3F,
+	MODELCACHE_LUMP_NORMAL3F,
+	MODELCACHE_LUMP_TEXCOORDTEXTURE2F,
+	MODELCACHE_LUMP_LIGHTMAPCOLOR4F,
+	MODELCACHE_LUMP_SKELETALINDEX4UB,
+	MODELCACHE_LUMP_SKELETALWEIGHT4UB,
+	MODELCACHE_LUMP_BLENDS,
+	MODELCACHE_LUMP_BLENDWEIGHTS,
+	MODELCACHE_LUMP_MORPHMD3VERTEX,
+	MODELCACHE_LUMP_MORPHTEXVECVERTEX,
+	MODELCACHE_LUMP_BIHLEAFS,
+	MODELCACHE_LUMP_BIHNODES,
+	MODELCACHE_NUMLUMPS
+}
+modelcache_lump_t;
+
+// lumps that may be absent even when the model has data of that size
+#define MODELCACHE_OPTIONALLUMPS ((1 << MODELCACHE_LUMP_ELEMENT3S) | (1 << MODELCACHE_LUMP_LIGHTMAPCOLOR4F) | (1 << MODELCACHE_LUMP_SKELETALINDEX4UB) | (1 << MODELCACHE_LUMP_SKELETALWEIGHT4UB) | (1 << MODELCACHE_LUMP_BLENDS))
+
+typedef struct modelcache_header_s
+{
+	char ident[16];
+	int version;
+	int endian;
+	int headersize;
+	int smoothnormals_areaweighting;
+	unsigned char sourcedigest[16];
+	int sourcesize;
+	char datatype[8];
+	unsigned int effects;
+	int synctype;
+	int numframes;
+	int num_surfaces;
+	int num_tags;
+	int num_tagframes;
+	int num_bones;
+	int num_poses;
+	float num_posescale;
+	float num_poseinvscale;
+	int num_vertices;
+	int num_triangles;
+	int num_morphframes;
+	int num_blends;
+	int isanimated;
+	float normalmins[3], normalmaxs[3];
+	float yawmins[3], yawmaxs[3];
+	float rotatedmins[3], rotatedmaxs[3];
+	float radius, radius2;
+	int bih_numleafs;
+	int bih_numnodes;
+	int bih_rootnode;
+	float bih_mins[3], bih_maxs[3];
+	// offset and length in bytes of each lump
+	int lumps[MODELCACHE_NUMLUMPS][2];
+}
+modelcache_header_t;
+
+typedef struct modelcache_surface_s
+{
+	int num_firsttriangle;
+	int num_triangles;
+	int num_firstvertex;
+	int num_vertices;
+	char meshname[MAX_QPATH];
+	char shadername[MAX_QPATH];
+}
+modelcache_surface_t;
+
+// set by Mod_AliasCache_Load on a miss, Mod_AliasCache_Save then writes the result
+static qbool modelcache_pending;
+static unsigned char modelcache_digest[16];
+static int modelcache_sourcesize;
+// mesh and shader names passed to Mod_BuildAliasSkinsFromSkinFiles, [num_surfaces][2]
+static char (*modelcache_surfacenames)[2][MAX_QPATH];
+
+static void Mod_AliasCache_Reset(void)
+{
+	modelcache_pending = false;
+	if (modelcache_surfacenames)
+		Mem_Free(modelcache_surfacenames);
+	modelcache_surfacenames = NULL;
+}
+
+static void Mod_AliasCache_LumpSizes(const modelcache_header_t *h, size_t *sizes)
+{
+	sizes[MODELCACHE_LUMP_ANIMSCENES] = (size_t)h->numframes * sizeof(animscene_t);
+	sizes[MODELCACHE_LUMP_TAGS] = (size_t)h->num_tagframes * h->num_tags * sizeof(aliastag_t);
+	sizes[MODELCACHE_LUMP_BONES] = (size_t)h->num_bones * sizeof(aliasbone_t);
+	sizes[MODELCACHE_LUMP_BASEBONEPOSEINVERSE] = (size_t)h->num_bones * sizeof(float[12]);
+	sizes[MODELCACHE_LUMP_POSES7S] = (size_t)h->num_poses * h->num_bones * sizeof(short[7]);
+	sizes[MODELCACHE_LUMP_SURFACES] = (size_t)h->num_surfaces * sizeof(modelcache_surface_t);
+	sizes[MODELCACHE_LUMP_ELEMENT3I] = (size_t)h->num_triangles * sizeof(int[3]);
+	sizes[MODELCACHE_LUMP_ELEMENT3S] = (size_t)h->num_triangles * sizeof(unsigned short[3]);
+	sizes[MODELCACHE_LUMP_VERTEX3F] = (size_t)h->num_vertices * sizeof(float[3]);
+	sizes[MODELCACHE_LUMP_SVECTOR3F] = (size_t)h->num_vertices * sizeof(float[3]);
+	sizes[MODELCACHE_LUMP_TVECTOR3F] = (size_t)h->num_vertices * sizeof(float[3]);
+	sizes[MODELCACHE_LUMP_NORMAL3F] = (size_t)h->num_vertices * sizeof(float[3]);
+	sizes[MODELCACHE_LUMP_TEXCOORDTEXTURE2F] = (size_t)h->num_vertices * sizeof(float[2]);
+	sizes[MODELCACHE_LUMP_LIGHTMAPCOLOR4F] = (size_t)h->num_vertices * sizeof(float[4]);
+	sizes[MODELCACHE_LUMP_SKELETALINDEX4UB] = (size_t)h->num_vertices * sizeof(unsigned char[4]);
+	sizes[MODELCACHE_LUMP_SKELETALWEIGHT4UB] = (size_t)h->num_vertices * sizeof(unsigned char[4]);
+	sizes[MODELCACHE_LUMP_BLENDS] = (size_t)h->num_vertices * sizeof(unsigned short);
+	sizes[MODELCACHE_LUMP_BLENDWEIGHTS] = (size_t)h->num_blends * sizeof(blendweights_t);
+	sizes[MODELCACHE_LUMP_MORPHMD3VERTEX] = (size_t)h->num_morphframes * h->num_vertices * sizeof(md3vertex_t);
+	sizes[MODELCACHE_LUMP_MORPHTEXVECVERTEX] = (size_t)h->num_morphframes * h->num_vertices * sizeof(texvecvertex_t);
+	sizes[MODELCACHE_LUMP_BIHLEAFS] = (size_t)h->bih_numleafs * sizeof(bih_leaf_t);
+	sizes[MODELCACHE_LUMP_BIHNODES] = (size_t)h->bih_numnodes * sizeof(bih_node_t);
+}
+
+/*
+=================
+Mod_AliasCache_RecordSkin
+
+Called by Mod_BuildAliasSkinsFromSkinFiles so the cache can rebuild the
+textures of each surface exactly like the loader did
+=================
+*/
+static void Mod_AliasCache_RecordSkin(const texture_t *skin, const char *meshname, const char *shadername)
+{
+	int surfaceindex = skin - loadmodel->data_textures;
+	if (surfaceindex < 0 || surfaceindex >= loadmodel->num_surfaces || strlen(meshname) >= MAX_QPATH || strlen(shadername) >= MAX_QPATH)
+	{
+		// the names would not survive the round trip, don't cache this model
+		Mod_AliasCache_Reset();
+		return;
+	}
+	if (!modelcache_surfacenames)
+		modelcache_surfacenames = (char (*)[2][MAX_QPATH])Mem_Alloc(tempmempool, loadmodel->num_surfaces * sizeof(*modelcache_surfacenames));
+	dp_strlcpy(modelcache_surfacenames[surfaceindex][0], meshname, MAX_QPATH);
+	dp_strlcpy(modelcache_surfacenames[surfaceindex][1], shadername, MAX_QPATH);
+}
+
+/*
+=================
+Mod_AliasCache_Validate
+
+Checks every index in a cache file the way the loaders check the model
+files, so a damaged or forged cache can't make the renderer or the trace
+code read out of bounds.  lumpdata holds the lumps, NULL for absent ones.
+=================
+*/
+static qbool Mod_AliasCache_Validate(const modelcache_header_t *h, void **lumpdata)
+{
+	int i, j;
+	const animscene_t *animscenes = (const animscene_t *)lumpdata[MODELCACHE_LUMP_ANIMSCENES];
+	const aliastag_t *tags = (const aliastag_t *)lumpdata[MODELCACHE_LUMP_TAGS];
+	const aliasbone_t *bones = (const aliasbone_t *)lumpdata[MODELCACHE_LUMP_BONES];
+	const modelcache_surface_t *surfaces = (const modelcache_surface_t *)lumpdata[MODELCACHE_LUMP_SURFACES];
+	int *element3i = (int *)lumpdata[MODELCACHE_LUMP_ELEMENT3I];
+	unsigned short *element3s = (unsigned short *)lumpdata[MODELCACHE_LUMP_ELEMENT3S];
+	const unsigned char *skeletalindex4ub = (const unsigned char *)lumpdata[MODELCACHE_LUMP_SKELETALINDEX4UB];
+	const unsigned short *blends = (const unsigned short *)lumpdata[MODELCACHE_LUMP_BLENDS];
+	const blendweights_t *blendweights = (const blendweights_t *)lumpdata[MODELCACHE_LUMP_BLENDWEIGHTS];
+	bih_t bih;
+
+	// frames index the poses, and the tags and morph frames of each pose
+	for (i = 0;i < h->numframes;i++)
+		if (!memchr(animscenes[i].name, 0, sizeof(animscenes[i].name)) || animscenes[i].firstframe < 0 || animscenes[i].framecount < 1 || animscenes[i].firstframe > h->num_poses - animscenes[i].framecount)
+			return false;
+	if ((h->num_tags && h->num_tagframes < h->num_poses) || (h->num_morphframes && h->num_morphframes < h->num_poses))
+		return false;
+	for (i = 0;i < h->num_tags * h->num_tagframes;i++)
+		if (!memchr(tags[i].name, 0, sizeof(tags[i].name)))
+			return false;
+	// parents come before their children, the skeletal code relies on it
+	for (i = 0;i < h->num_bones;i++)
+		if (!memchr(bones[i].name, 0, sizeof(bones[i].name)) || bones[i].parent < -1 || bones[i].parent >= i)
+			return false;
+
+	for (i = 0;i < h->num_surfaces;i++)
+		if (!memchr(surfaces[i].meshname, 0, sizeof(surfaces[i].meshname)) || !memchr(surfaces[i].shadername, 0, sizeof(surfaces[i].shadername))
+		 || !Mod_ValidateElements(element3i + surfaces[i].num_firsttriangle * 3, element3s ? element3s + surfaces[i].num_firsttriangle * 3 : NULL, surfaces[i].num_triangles, surfaces[i].num_firstvertex, surfaces[i].num_vertices, __FILE__, __LINE__))
+			return false;
+	// the BIH may refer to any triangle, not only the ones of a surface
+	if (!Mod_ValidateElements(element3i, element3s, h->num_triangles, 0, h->num_vertices, __FILE__, __LINE__))
+		return false;
+
+	if (skeletalindex4ub)
+		for (i = 0;i < h->num_vertices * 4;i++)
+			if (skeletalindex4ub[i] >= h->num_bones)
+				return false;
+	if (blends)
+		for (i = 0;i < h->num_vertices;i++)
+			if (blends[i] >= h->num_bones + h->num_blends)
+				return false;
+	for (i = 0;i < h->num_blends;i++)
+		for (j = 0;j < 4;j++)
+			if (blendweights[i].index[j] >= h->num_bones)
+				return false;
+
+	if (h->bih_numleafs)
+	{
+		memset(&bih, 0, sizeof(bih));
+		bih.numleafs = h->bih_numleafs;
+		bih.leafs = (bih_leaf_t *)lumpdata[MODELCACHE_LUMP_BIHLEAFS];
+		bih.numnodes = h->bih_numnodes;
+		bih.nodes = (bih_node_t *)lumpdata[MODELCACHE_LUMP_BIHNODES];
+		bih.rootnode = h->bih_rootnode;
+		// the alias loaders build it from the surfaces, skin 0 textures line up with them
+		if (!Mod_ValidateCollisionBIH(&bih, h->num_surfaces, h->num_surfaces, h->num_triangles, 0, NULL, 0))
+			return false;
+	}
+	return true;
+}
+
+/*
+=================
+Mod_AliasCache_Load
+
+Called by the loaders once the type and function pointers of loadmodel are
+set up.  Returns true if loadmodel was completely loaded from the cache, in
+which case the loader must return without touching it.  Otherwise the loader
+continues as usual and calls Mod_AliasCache_Save at the end.  extra is a
+second source file the model depends on (the .psa of a .psk), or NULL.
+=================
+*/
+static qbool Mod_AliasCache_Load(const void *buffer, const void *bufferend, const void *extra, fs_offset_t extrasize)
+{
+	int i, j;
+	char path[MAX_QPATH + 32];
+	unsigned char digests[32];
+	unsigned char *blob;
+	fs_offset_t blobsize;
+	modelcache_header_t *h;
+	const modelcache_surface_t *cachesurfaces;
+	void *lumpdata[MODELCACHE_NUMLUMPS];
+	size_t lumpsizes[MODELCACHE_NUMLUMPS];
+	skinfile_t *skinfiles;
+	msurface_t *surface;
+
+	Mod_AliasCache_Reset();
+	// mod_alias_force_animated changes the stored isanimated flag, so bypass the cache entirely
+	if (!mod_alias_cache.integer || mod_alias_force_animated.string[0])
+		return false;
+
+	modelcache_sourcesize = (int)((const unsigned char *)bufferend - (const unsigned char *)buffer);
+	Com_BlockFullChecksum((void *)buffer, modelcache_sourcesize, digests);
+	if (extra)
+	{
+		Com_BlockFullChecksum((void *)extra, (int)extrasize, digests + 16);
+		Com_BlockFullChecksum(digests, sizeof(digests), modelcache_digest);
+	}
+	else
+		memcpy(modelcache_digest, digests, sizeof(modelcache_digest));
+	modelcache_pending = true;
+
+	// only ever the file Mod_AliasCache_Save wrote, never one from a package
+	dpsnprintf(path, sizeof(path), "cache/models/%s.cache", loadmodel->name);
+	blob = FS_LoadRealFile(path, loadmodel->mempool, true, &blobsize);
+	if (!blob)
+		return false;
+	h = (modelcache_header_t *)blob;
+	if (blobsize < (fs_offset_t)sizeof(*h)
+	 || memcmp(h->ident, MODELCACHE_IDENT, sizeof(MODELCACHE_IDENT))
+	 || h->version != MODELCACHE_VERSION
+	 || h->endian != MODELCACHE_ENDIAN
+	 || h->headersize != (int)sizeof(*h)
+	 || h->smoothnormals_areaweighting != r_smoothnormals_areaweighting.integer
+	 || h->sourcesize != modelcache_sourcesize
+	 || memcmp(h->sourcedigest, modelcache_digest, sizeof(modelcache_digest))
+	 || strncmp(h->datatype, loadmodel->modeldatatypestring, sizeof(h->datatype)))
+	{
+		// stale, Mod_AliasCache_Save will replace it
+		Mem_Free(blob);
+		return false;
+	}
+	if (h->numframes < 0 || h->num_surfaces < 1 || h->num_tags < 0 || h->num_tagframes < 0 || h->num_bones < 0 || h->num_poses < 0
+	 || h->num_vertices < 0 || h->num_triangles < 0 || h->num_morphframes < 0 || h->num_blends < 0 || h->bih_numleafs < 0 || h->bih_numnodes < 0)
+		goto invalid;
+	Mod_AliasCache_LumpSizes(h, lumpsizes);
+	for (i = 0;i < MODELCACHE_NUMLUMPS;i++)
+	{
+		int ofs = h->lumps[i][0], len = h->lumps[i][1];
+		lumpdata[i] = NULL;
+		if (!len)
+		{
+			if (lumpsizes[i] && !(MODELCACHE_OPTIONALLUMPS & (1 << i)))
+				goto invalid;
+			continue;
+		}
+		if ((size_t)len != lumpsizes[i] || ofs < (int)sizeof(*h) || (ofs & (MODELCACHE_ALIGN - 1)) || (fs_offset_t)ofs + len > blobsize)
+			goto invalid;
+		lumpdata[i] = blob + ofs;
+	}
+	cachesurfaces = (const modelcache_surface_t *)lumpdata[MODELCACHE_LUMP_SURFACES];
+	for (i = 0;i < h->num_surfaces;i++)
+		if (cachesurfaces[i].num_firsttriangle < 0 || cachesurfaces[i].num_triangles < 0 || cachesurfaces[i].num_firsttriangle + cachesurfaces[i].num_triangles > h->num_triangles
+		 || cachesurfaces[i].num_firstvertex < 0 || cachesurfaces[i].num_vertices < 0 || cachesurfaces[i].num_firstvertex + cachesurfaces[i].num_vertices > h->num_vertices)
+			goto invalid;
+	if (!Mod_AliasCache_Validate(h, lumpdata))
+		goto invalid;
+	modelcache_pending = false;
+
+	loadmodel->effects = h->effects;
+	loadmodel->synctype = (synctype_t)h->synctype;
+	loadmodel->numframes = h->numframes;
+	loadmodel->animscenes = (animscene_t *)lumpdata[MODELCACHE_LUMP_ANIMSCENES];
+	loadmodel->num_tags = h->num_tags;
+	loadmodel->num_tagframes = h->num_tagframes;
+	loadmodel->data_tags = (aliastag_t *)lumpdata[MODELCACHE_LUMP_TAGS];
+	loadmodel->num_bones = h->num_bones;
+	loadmodel->data_bones = (aliasbone_t *)lumpdata[MODELCACHE_LUMP_BONES];
+	loadmodel->data_baseboneposeinverse = (float *)lumpdata[MODELCACHE_LUMP_BASEBONEPOSEINVERSE];
+	loadmodel->num_poses = h->num_poses;
+	loadmodel->num_posescale = h->num_posescale;
+	loadmodel->num_poseinvscale = h->num_poseinvscale;
+	loadmodel->data_poses7s = (short *)lumpdata[MODELCACHE_LUMP_POSES7S];
+	VectorCopy(h->normalmins, loadmodel->normalmins);
+	VectorCopy(h->normalmaxs, loadmodel->normalmaxs);
+	VectorCopy(h->yawmins, loadmodel->yawmins);
+	VectorCopy(h->yawmaxs, loadmodel->yawmaxs);
+	VectorCopy(h->rotatedmins, loadmodel->rotatedmins);
+	VectorCopy(h->rotatedmaxs, loadmodel->rotatedmaxs);
+	loadmodel->radius = h->radius;
+	loadmodel->radius2 = h->radius2;
+
+	loadmodel->surfmesh.num_vertices = h->num_vertices;
+	loadmodel->surfmesh.num_triangles = h->num_triangles;
+	loadmodel->surfmesh.num_morphframes = h->num_morphframes;
+	loadmodel->surfmesh.num_blends = h->num_blends;
+	loadmodel->surfmesh.isanimated = h->isanimated != 0;
+	loadmodel->surfmesh.data_element3i = (int *)lumpdata[MODELCACHE_LUMP_ELEMENT3I];
+	loadmodel->surfmesh.data_element3s = (unsigned short *)lumpdata[MODELCACHE_LUMP_ELEMENT3S];
+	loadmodel->surfmesh.data_vertex3f = (float *)lumpdata[MODELCACHE_LUMP_VERTEX3F];
+	loadmodel->surfmesh.data_svector3f = (float *)lumpdata[MODELCACHE_LUMP_SVECTOR3F];
+	loadmodel->surfmesh.data_tvector3f = (float *)lumpdata[MODELCACHE_LUMP_TVECTOR3F];
+	loadmodel->surfmesh.data_normal3f = (float *)lumpdata[MODELCACHE_LUMP_NORMAL3F];
+	loadmodel->surfmesh.data_texcoordtexture2f = (float *)lumpdata[MODELCACHE_LUMP_TEXCOORDTEXTURE2F];
+	loadmodel->surfmesh.data_lightmapcolor4f = (float *)lumpdata[MODELCACHE_LUMP_LIGHTMAPCOLOR4F];
+	loadmodel->surfmesh.data_skeletalindex4ub = (unsigned char *)lumpdata[MODELCACHE_LUMP_SKELETALINDEX4UB];
+	loadmodel->surfmesh.data_skeletalweight4ub = (unsigned char *)lumpdata[MODELCACHE_LUMP_SKELETALWEIGHT4UB];
+	loadmodel->surfmesh.blends = (unsigned short *)lumpdata[MODELCACHE_LUMP_BLENDS];
+	loadmodel->surfmesh.data_blendweights = (blendweights_t *)lumpdata[MODELCACHE_LUMP_BLENDWEIGHTS];
+	loadmodel->surfmesh.data_morphmd3vertex = (md3vertex_t *)lumpdata[MODELCACHE_LUMP_MORPHMD3VERTEX];
+	loadmodel->surfmesh.data_morphtexvecvertex = (texvecvertex_t *)lumpdata[MODELCACHE_LUMP_MORPHTEXVECVERTEX];
+
+	memset(&loadmodel->collision_bih, 0, sizeof(loadmodel->collision_bih));
+	if (h->bih_numleafs)
+	{
+		loadmodel->collision_bih.numleafs = h->bih_numleafs;
+		loadmodel->collision_bih.leafs = (bih_leaf_t *)lumpdata[MODELCACHE_LUMP_BIHLEAFS];
+		loadmodel->collision_bih.numnodes = loadmodel->collision_bih.maxnodes = h->bih_numnodes;
+		loadmodel->collision_bih.nodes = (bih_node_t *)lumpdata[MODELCACHE_LUMP_BIHNODES];
+		loadmodel->collision_bih.rootnode = h->bih_rootnode;
+		VectorCopy(h->bih_mins, loadmodel->collision_bih.mins);
+		VectorCopy(h->bih_maxs, loadmodel->collision_bih.maxs);
+	}
+
+	// textures are not cached, they depend on .skin files and shaders
+	skinfiles = Mod_LoadSkinFiles();
+	if (loadmodel->numskins < 1)
+		loadmodel->numskins = 1;
+	loadmodel->skinscenes = Mem_AllocType(loadmodel->mempool, animscene_t, loadmodel->numskins * sizeof(animscene_t));
+	for (i = 0;i < loadmodel->numskins;i++)
+	{
+		loadmodel->skinscenes[i].firstframe = i;
+		loadmodel->skinscenes[i].framecount = 1;
+		loadmodel->skinscenes[i].loop = true;
+		loadmodel->skinscenes[i].framerate = 10;
+	}
+	loadmodel->submodelsurfaces_start = 0;
+	loadmodel->submodelsurfaces_end = loadmodel->num_surfaces = h->num_surfaces;
+	loadmodel->num_textures = loadmodel->num_surfaces * loadmodel->numskins;
+	loadmodel->num_texturesperskin = loadmodel->num_surfaces;
+	loadmodel->modelsurfaces_sorted = (int *)Mem_Alloc(loadmodel->mempool, loadmodel->num_surfaces * sizeof(int));
+	loadmodel->data_surfaces = Mem_AllocType(loadmodel->mempool, msurface_t, loadmodel->num_surfaces * sizeof(msurface_t));
+	loadmodel->data_textures = Mem_AllocType(loadmodel->mempool, texture_t, loadmodel->num_surfaces * loadmodel->numskins * sizeof(texture_t));
+	for (j = 0;j < loadmodel->num_surfaces;j++)
+	{
+		loadmodel->modelsurfaces_sorted[j] = j;
+		surface = loadmodel->data_surfaces + j;
+		surface->texture = loadmodel->data_textures + j;
+		surface->num_firsttriangle = cachesurfaces[j].num_firsttriangle;
+		surface->num_triangles = cachesurfaces[j].num_triangles;
+		surface->num_firstvertex = cachesurfaces[j].num_firstvertex;
+		surface->num_vertices = cachesurfaces[j].num_vertices;
+		Mod_BuildAliasSkinsFromSkinFiles(loadmodel->data_textures + j, skinfiles, cachesurfaces[j].meshname, cachesurfaces[j].shadername);
+	}
+	Mod_FreeSkinFiles(skinfiles);
+	Mod_MakeSortedSurfaces(loadmodel);
+
+	if (!loadmodel->surfmesh.isanimated)
+	{
+		loadmodel->TraceBox = Mod_CollisionBIH_TraceBox;
+		loadmodel->TraceBrush = Mod_CollisionBIH_TraceBrush;
+		loadmodel->TraceLine = Mod_CollisionBIH_TraceLine;
+		loadmodel->TracePoint = Mod_CollisionBIH_TracePoint_Mesh;
+		loadmodel->PointSuperContents = Mod_CollisionBIH_PointSuperContents_Mesh;
+	}
+
+	Con_DPrintf("%s: loaded from %s\n", loadmodel->name, path);
+	return true;
+
+invalid:
+	Con_DPrintf("%s: ignoring invalid cache file %s\n", loadmodel->name, path);
+	Mem_Free(blob);
+	return false;
+}
+
+/*
+=================
+Mod_AliasCache_Save
+
+Writes the cache file for loadmodel if Mod_AliasCache_Load missed on it
+=================
+*/
+static void Mod_AliasCache_Save(void)
+{
+	int i;
+	char path[MAX_QPATH + 32];
+	size_t size;
+	unsigned char *blob;
+	modelcache_header_t *h;
+	modelcache_surface_t *cachesurfaces;
+	const void *lumpdata[MODELCACHE_NUMLUMPS];
+	size_t lumpsizes[MODELCACHE_NUMLUMPS];
+
+	if (!modelcache_pending || !modelcache_surfacenames)
+	{
+		Mod_AliasCache_Reset();
+		return;
+	}
+
+	h = (modelcache_header_t *)Mem_Alloc(tempmempool, sizeof(*h));
+	memcpy(h->ident, MODELCACHE_IDENT, sizeof(MODELCACHE_IDENT));
+	h->version = MODELCACHE_VERSION;
+	h->endian = MODELCACHE_ENDIAN;
+	h->headersize = sizeof(*h);
+	h->smoothnormals_areaweighting = r_smoothnormals_areaweighting.integer;
+	memcpy(h->sourcedigest, modelcache_digest, sizeof(h->sourcedigest));
+	h->sourcesize = modelcache_sourcesize;
+	dp_strlcpy(h->datatype, loadmodel->modeldatatypestring, sizeof(h->datatype));
+	h->effects = loadmodel->effects;
+	h->synctype = loadmodel->synctype;
+	h->numframes = loadmodel->numframes;
+	h->num_surfaces = loadmodel->num_surfaces;
+	h->num_tags = loadmodel->num_tags;
+	h->num_tagframes = loadmodel->num_tagframes;
+	h->num_bones = loadmodel->num_bones;
+	h->num_poses = loadmodel->num_poses;
+	h->num_posescale = loadmodel->num_posescale;
+	h->num_poseinvscale = loadmodel->num_poseinvscale;
+	h->num_vertices = loadmodel->surfmesh.num_vertices;
+	h->num_triangles = loadmodel->surfmesh.num_triangles;
+	h->num_morphframes = loadmodel->surfmesh.data_morphmd3vertex ? loadmodel->surfmesh.num_morphframes : 0;
+	h->num_blends = loadmodel->surfmesh.num_blends;
+	h->isanimated = loadmodel->surfmesh.isanimated;
+	VectorCopy(loadmodel->normalmins, h->normalmins);
+	VectorCopy(loadmodel->normalmaxs, h->normalmaxs);
+	VectorCopy(loadmodel->yawmins, h->yawmins);
+	VectorCopy(loadmodel->yawmaxs, h->yawmaxs);
+	VectorCopy(loadmodel->rotatedmins, h->rotatedmins);
+	VectorCopy(loadmodel->rotatedmaxs, h->rotatedmaxs);
+	h->radius = loadmodel->radius;
+	h->radius2 = loadmodel->radius2;
+	if (loadmodel->collision_bih.leafs && loadmodel->collision_bih.nodes)
+	{
+		h->bih_numleafs = loadmodel->collision_bih.numleafs;
+		h->bih_numnodes = loadmodel->collision_bih.numnodes;
+		h->bih_rootnode = loadmodel->collision_bih.rootnode;
+		VectorCopy(loadmodel->collision_bih.mins, h->bih_mins);
+		VectorCopy(loadmodel->collision_bih.maxs, h->bih_maxs);
+	}
+
+	cachesurfaces = (modelcache_surface_t *)Mem_Alloc(tempmempool, loadmodel->num_surfaces * sizeof(*cachesurfaces));
+	for (i = 0;i < loadmodel->num_surfaces;i++)
+	{
+		cachesurfaces[i].num_firsttriangle = loadmodel->data_surfaces[i].num_firsttriangle;
+		cachesurfaces[i].num_triangles = loadmodel->data_surfaces[i].num_triangles;
+		cachesurfaces[i].num_firstvertex = loadmodel->data_surfaces[i].num_firstvertex;
+		cachesurfaces[i].num_vertices = loadmodel->data_surfaces[i].num_vertices;
+		memcpy(cachesurfaces[i].meshname, modelcache_surfacenames[i][0], MAX_QPATH);
+		memcpy(cachesurfaces[i].shadername, modelcache_surfacenames[i][1], MAX_QPATH);
+	}
+
+	lumpdata[MODELCACHE_LUMP_ANIMSCENES] = loadmodel->animscenes;
+	lumpdata[MODELCACHE_LUMP_TAGS] = loadmodel->data_tags;
+	lumpdata[MODELCACHE_LUMP_BONES] = loadmodel->data_bones;
+	lumpdata[MODELCACHE_LUMP_BASEBONEPOSEINVERSE] = loadmodel->data_baseboneposeinverse;
+	lumpdata[MODELCACHE_LUMP_POSES7S] = loadmodel->data_poses7s;
+	lumpdata[MODELCACHE_LUMP_SURFACES] = cachesurfaces;
+	lumpdata[MODELCACHE_LUMP_ELEMENT3I] = loadmodel->surfmesh.data_element3i;
+	lumpdata[MODELCACHE_LUMP_ELEMENT3S] = loadmodel->surfmesh.data_element3s;
+	lumpdata[MODELCACHE_LUMP_VERTEX3F] = loadmodel->surfmesh.data_vertex3f;
+	lumpdata[MODELCACHE_LUMP_SVECTOR3F] = loadmodel->surfmesh.data_svector3f;
+	lumpdata[MODELCACHE_LUMP_TVECTOR3F] = loadmodel->surfmesh.data_tvector3f;
+	lumpdata[MODELCACHE_LUMP_NORMAL3F] = loadmodel->surfmesh.data_normal3f;
+	lumpdata[MODELCACHE_LUMP_TEXCOORDTEXTURE2F] = loadmodel->surfmesh.data_texcoordtexture2f;
+	lumpdata[MODELCACHE_LUMP_LIGHTMAPCOLOR4F] = loadmodel->surfmesh.data_lightmapcolor4f;
+	lumpdata[MODELCACHE_LUMP_SKELETALINDEX4UB] = loadmodel->surfmesh.data_skeletalindex4ub;
+	lumpdata[MODELCACHE_LUMP_SKELETALWEIGHT4UB] = loadmodel->surfmesh.data_skeletalweight4ub;
+	lumpdata[MODELCACHE_LUMP_BLENDS] = loadmodel->surfmesh.blends;
+	lumpdata[MODELCACHE_LUMP_BLENDWEIGHTS] = loadmodel->surfmesh.data_blendweights;
+	lumpdata[MODELCACHE_LUMP_MORPHMD3VERTEX] = loadmodel->surfmesh.data_morphmd3vertex;
+	lumpdata[MODELCACHE_LUMP_MORPHTEXVECVERTEX] = loadmodel->surfmesh.data_morphtexvecvertex;
+	lumpdata[MODELCACHE_LUMP_BIHLEAFS] = loadmodel->collision_bih.leafs;
+	lumpdata[MODELCACHE_LUMP_BIHNODES] = loadmodel->collision_bih.nodes;
+
+	Mod_AliasCache_LumpSizes(h, lumpsizes);
+	size = (sizeof(*h) + MODELCACHE_ALIGN - 1) & ~(size_t)(MODELCACHE_ALIGN - 1);
+	for (i = 0;i < MODELCACHE_NUMLUMPS;i++)
+	{
+		if (!lumpdata[i] || !lumpsizes[i])
+			continue;
+		h->lumps[i][0] = (int)size;
+		h->lumps[i][1] = (int)lumpsizes[i];
+		size += (lumpsizes[i] + MODELCACHE_ALIGN - 1) & ~(size_t)(MODELCACHE_ALIGN - 1);
+	}
+
+	if (size < 0x7FFFFFFF)
+	{
+		blob = (unsigned char *)Mem_Alloc(tempmempool, size);
+		memcpy(blob, h, sizeof(*h));
+		for (i = 0;i < MODELCACHE_NUMLUMPS;i++)
+			if (h->lumps[i][1])
+				memcpy(blob + h->lumps[i][0], lumpdata[i], h->lumps[i][1]);
+		dpsnprintf(path, sizeof(path), "cache/models/%s.cache", loadmodel->name);
+		if (FS_WriteFile(path, blob, (fs_offset_t)size))
+			Con_DPrintf("%s: wrote %s (%i bytes)\n", loadmodel->name, path, (int)size);
+		Mem_Free(blob);
+	}
+
+	Mem_Free(cachesurfaces);
+	Mem_Free(h);
+	Mod_AliasCache_Reset();
+}
+
 void Mod_BuildAliasSkinsFromSkinFiles(texture_t *skin, skinfile_t *skinfile, const char *meshname, const char *shadername)
 {
 	int i;
 	char stripbuf[MAX_QPATH];
 	skinfileitem_t *skinfileitem;
+	if (modelcache_pending)
+		Mod_AliasCache_RecordSkin(skin, meshname, shadername);
 	if(developer_extra.integer)
 		Con_DPrintf("Looking up texture for %s (default: %s)\n", meshname, shadername);
 	if (skinfile)
@@ -944,7 +1653,7 @@ void Mod_BuildAliasSkinsFromSkinFiles(texture_t *skin, skinfile_t *skinfile, con
 					Image_StripImageExtension(skinfileitem->replacement, stripbuf, sizeof(stripbuf));
 					if(developer_extra.integer)
 						Con_DPrintf("--> got %s from skin file\n", stripbuf);
-					Mod_LoadTextureFromQ3Shader(loadmodel->mempool, loadmodel->name, skin, stripbuf, true, true, (r_mipskins.integer ? TEXF_MIPMAP : 0) | TEXF_ALPHA | TEXF_PICMIP | TEXF_COMPRESS, MATERIALFLAG_WALL);
+					Mod_LoadTextureFromQ3Shader(loadmodel->mempool, loadmodel->name, skin, stripbuf, true, true, (r_mipskins.integer ? TEXF_MIPMAP : 0) | TEXF_ALPHA | TEXF_PICMIP | TEXF_COMPRESS | TEXF_ASYNC, MATERIALFLAG_WALL);
 					break;
 				}
 			}
@@ -963,7 +1672,7 @@ void Mod_BuildAliasSkinsFromSkinFiles(texture_t *skin, skinfile_t *skinfile, con
 		if(developer_extra.integer)
 			Con_DPrintf("--> using default\n");
 		Image_StripImageExtension(shadername, stripbuf, sizeof(stripbuf));
-		Mod_LoadTextureFromQ3Shader(loadmodel->mempool, loadmodel->name, skin, stripbuf, true, true, (r_mipskins.integer ? TEXF_MIPMAP : 0) | TEXF_ALPHA | TEXF_PICMIP | TEXF_COMPRESS, MATERIALFLAG_WALL);
+		Mod_LoadTextureFromQ3Shader(loadmodel->mempool, loadmodel->name, skin, stripbuf, true, true, (r_mipskins.integer ? TEXF_MIPMAP : 0) | TEXF_ALPHA | TEXF_PICMIP | TEXF_COMPRESS | TEXF_ASYNC, MATERIALFLAG_WALL);
 	}
 }
 extern cvar_t r_nolerp_list;
@@ -1253,7 +1962,7 @@ void Mod_IDP0_Load(model_t *mod, void *buffer, void *bufferend)
 					dpsnprintf (name, sizeof(name), "%s_%i_%i", loadmodel->name, i, j);
 				else
 					dpsnprintf (name, sizeof(name), "%s_%i", loadmodel->name, i);
-				if (!Mod_LoadTextureFromQ3Shader(loadmodel->mempool, loadmodel->name, loadmodel->data_textures + totalskins * loadmodel->num_surfaces, name, false, false, (r_mipskins.integer ? TEXF_MIPMAP : 0) | TEXF_ALPHA | TEXF_PICMIP | TEXF_COMPRESS, MATERIALFLAG_WALL))
+				if (!Mod_LoadTextureFromQ3Shader(loadmodel->mempool, loadmodel->name, loadmodel->data_textures + totalskins * loadmodel->num_surfaces, name, false, false, (r_mipskins.integer ? TEXF_MIPMAP : 0) | TEXF_ALPHA | TEXF_PICMIP | TEXF_COMPRESS | TEXF_ASYNC, MATERIALFLAG_WALL))
 					Mod_LoadCustomMaterial(loadmodel->mempool, loadmodel->data_textures + totalskins * loadmodel->num_surfaces, name, SUPERCONTENTS_SOLID, MATERIALFLAG_WALL, R_SkinFrame_LoadInternalQuake(name, (r_mipskins.integer ? TEXF_MIPMAP : 0) | TEXF_PICMIP, true, r_fullbrights.integer, (unsigned char *)datapointer, skinwidth, skinheight));
 				datapointer += skinwidth * skinheight;
 				totalskins++;
@@ -1265,7 +1974,7 @@ void Mod_IDP0_Load(model_t *mod, void *buffer, void *bufferend)
 		for (;;)
 		{
 			dpsnprintf(name, sizeof(name), "%s_%i", loadmodel->name, loadmodel->numskins);
-			tempskinframe = R_SkinFrame_LoadExternal(name, (r_mipskins.integer ? TEXF_MIPMAP : 0) | TEXF_ALPHA | TEXF_PICMIP | TEXF_COMPRESS, false, false);
+			tempskinframe = R_SkinFrame_LoadExternal(name, (r_mipskins.integer ? TEXF_MIPMAP : 0) | TEXF_ALPHA | TEXF_PICMIP | TEXF_COMPRESS | TEXF_ASYNC, false, false);
 			if (!tempskinframe)
 				break;
 			// expand the arrays to make room
@@ -1429,7 +2138,7 @@ void Mod_IDP2_Load(model_t *mod, void *buffer, void *bufferend)
 		loadmodel->num_texturesperskin = loadmodel->num_surfaces;
 		loadmodel->data_textures = (texture_t *)Mem_Alloc(loadmodel->mempool, loadmodel->num_surfaces * loadmodel->numskins * sizeof(texture_t));
 		for (i = 0;i < loadmodel->numskins;i++, inskin += MD2_SKINNAME)
-			Mod_LoadTextureFromQ3Shader(loadmodel->mempool, loadmodel->name, loadmodel->data_textures + i * loadmodel->num_surfaces, inskin, true, true, (r_mipskins.integer ? TEXF_MIPMAP : 0) | TEXF_ALPHA | TEXF_PICMIP | TEXF_COMPRESS, MATERIALFLAG_WALL);
+			Mod_LoadTextureFromQ3Shader(loadmodel->mempool, loadmodel->name, loadmodel->data_textures + i * loadmodel->num_surfaces, inskin, true, true, (r_mipskins.integer ? TEXF_MIPMAP : 0) | TEXF_ALPHA | TEXF_PICMIP | TEXF_COMPRESS | TEXF_ASYNC, MATERIALFLAG_WALL);
 	}
 	else
 	{
@@ -1595,10 +2304,6 @@ void Mod_IDP3_Load(model_t *mod, void *buffer, void *bufferend)
 		Host_Error ("%s has wrong version number (%i should be %i)",
 			loadmodel->name, version, MD3VERSION);
 
-	skinfiles = Mod_LoadSkinFiles();
-	if (loadmodel->numskins < 1)
-		loadmodel->numskins = 1;
-
 	loadmodel->modeldatatypestring = "MD3";
 
 	loadmodel->type = mod_alias;
@@ -1618,6 +2323,13 @@ void Mod_IDP3_Load(model_t *mod, void *buffer, void *bufferend)
 	i = LittleLong (pinmodel->flags);
 	loadmodel->effects = (((unsigned)i & 255) << 24) | (i & 0x00FFFF00);
 
+	if (Mod_AliasCache_Load(buffer, bufferend, NULL, 0))
+		return;
+
+	skinfiles = Mod_LoadSkinFiles();
+	if (loadmodel->numskins < 1)
+		loadmodel->numskins = 1;
+
 	// set up some global info about the model
 	loadmodel->numframes = LittleLong(pinmodel->num_frames);
 	loadmodel->num_surfaces = LittleLong(pinmodel->num_meshes);
@@ -1763,6 +2475,7 @@ void Mod_IDP3_Load(model_t *mod, void *buffer, void *bufferend)
 		loadmodel->TracePoint = Mod_CollisionBIH_TracePoint_Mesh;
 		loadmodel->PointSuperContents = Mod_CollisionBIH_PointSuperContents_Mesh;
 	}
+	Mod_AliasCache_Save();
 }
 
 void Mod_ZYMOTICMODEL_Load(model_t *mod, void *buffer, void *bufferend)
@@ -2242,6 +2955,9 @@ void Mod_DARKPLACESMODEL_Load(model_t *mod, void *buffer, void *bufferend)
 	loadmodel->radius = pheader->allradius;
 	loadmodel->radius2 = pheader->allradius * pheader->allradius;
 
+	if (Mod_AliasCache_Load(buffer, bufferend, NULL, 0))
+		return;
+
 	// load external .skin files if present
 	skinfiles = Mod_LoadSkinFiles();
 	if (loadmodel->numskins < 1)
@@ -2533,6 +3249,7 @@ void Mod_DARKPLACESMODEL_Load(model_t *mod, void *buffer, void *bufferend)
 		loadmodel->TracePoint = Mod_CollisionBIH_TracePoint_Mesh;
 		loadmodel->PointSuperContents = Mod_CollisionBIH_PointSuperContents_Mesh;
 	}
+	Mod_AliasCache_Save();
 }
 
 // no idea why PSK/PSA files contain weird quaternions but they do...
@@ -2585,6 +3302,13 @@ void Mod_PSKMODEL_Load(model_t *mod, void *buffer, void *bufferend)
 	if (!animbuffer)
 		animbufferend = animbuffer;
 
+	if (Mod_AliasCache_Load(buffer, bufferend, animfilebuffer, animfilebuffer ? filesize : 0))
+	{
+		if (animfilebuffer)
+			Mem_Free(animfilebuffer);
+		return;
+	}
+
 	numpnts = 0;
 	pnts = NULL;
 	numvtxw = 0;
@@ -3214,6 +3938,7 @@ void Mod_PSKMODEL_Load(model_t *mod, void *buffer, void *bufferend)
 		loadmodel->TracePoint = Mod_CollisionBIH_TracePoint_Mesh;
 		loadmodel->PointSuperContents = Mod_CollisionBIH_PointSuperContents_Mesh;
 	}
+	Mod_AliasCache_Save();
 }
 
 void Mod_INTERQUAKEMODEL_Load(model_t *mod, void *buffer, void *bufferend)
@@ -3415,6 +4140,9 @@ void Mod_INTERQUAKEMODEL_Load(model_t *mod, void *buffer, void *bufferend)
 	loadmodel->PointSuperContents = NULL;
 	loadmodel->AnimateVertices = Mod_Skeletal_AnimateVertices;
 
+	if (Mod_AliasCache_Load(buffer, bufferend, NULL, 0))
+		return;
+
 	// load external .skin files if present
 	skinfiles = Mod_LoadSkinFiles();
 	if (loadmodel->numskins < 1)
@@ -3978,4 +4706,6 @@ void Mod_INTERQUAKEMODEL_Load(model_t *mod, void *buffer, void *bufferend)
 	if (joint1) { Mem_Free(joint1); joint1 = NULL; }
 	if (pose)   { Mem_Free(pose);   pose   = NULL; }
 	if (pose1)  { Mem_Free(pose1);  pose1  = NULL; }
+
+	Mod_AliasCache_Save();
 }
@@ -66,6 +66,7 @@ cvar_t mod_q1bsp_zero_hullsize_cutoff = {CF_CLIENT | CF_SERVER, "mod_q1bsp_zero_
 
 cvar_t mod_bsp_portalize = {CF_CLIENT, "mod_bsp_portalize", "0", "enables portal generation from BSP tree (takes a minute or more and GBs of memory when loading a complex map), used by r_drawportals, r_useportalculling, r_shadow_realtime_dlight_portalculling, r_shadow_realtime_world_compileportalculling"};
 cvar_t mod_recalculatenodeboxes = {CF_CLIENT | CF_SERVER, "mod_recalculatenodeboxes", "1", "enables use of generated node bounding boxes based on BSP tree portal reconstruction, rather than the node boxes supplied by the map compiler"};
+cvar_t mod_bsp_cache = {CF_CLIENT | CF_SERVER, "mod_bsp_cache", "1", "saves portals and collision trees generated for a map to cache/models/ in the user directory and reuses them while the map file stays the same"};
 
 cvar_t mod_obj_orientation = {CF_CLIENT | CF_SERVER, "mod_obj_orientation", "1", "fix orientation of OBJ models to the usual conventions (if zero, use coordinates as is)"};
 
@@ -81,6 +82,7 @@ void Mod_BrushInit(void)
 {
 //	Cvar_RegisterVariable(&r_subdivide_size);
 	Cvar_RegisterVariable(&mod_bsp_portalize);
+	Cvar_RegisterVariable(&mod_bsp_cache);
 	Cvar_RegisterVariable(&r_novis);
 	Cvar_RegisterVariable(&r_nosurftextures);
 	Cvar_RegisterVariable(&r_subdivisions_tolerance);
@@ -3871,6 +3873,579 @@ static void Mod_Q1BSP_RoundUpToHullSize(model_t *cmodel, const vec3_t inmins, co
 	VectorAdd(inmins, hull->clip_size, outmaxs);
 }
 
+/*
+=================
+Mod_BSP_StageTime
+
+developer_loading report of where the time of a bsp load goes, prints the time
+since the previous call (stage NULL just starts the clock)
+=================
+*/
+static double mod_bsp_stagetime;
+static void Mod_BSP_StageTime(const char *stage)
+{
+	double now = Sys_DirtyTime();
+	if (stage && developer_loading.integer)
+		Con_Printf("%s: %s took %.2f ms\n", loadmodel->name, stage, (now - mod_bsp_stagetime) * 1000.0);
+	mod_bsp_stagetime = now;
+}
+
+/*
+===============================================================================
+
+BSP DERIVED DATA CACHE
+
+Portals (with the leaf and node bounds recalculated from them) and the
+collision and render BIH of every submodel are saved to
+cache/models/<mapname>.cache in the gamedir of the user directory, keyed on an
+MD4 digest of the bsp file.  BIH sections are additionally keyed on a digest
+of the surface meshes and collision brushes they are built from, which covers
+cvars and shaders that change the generated geometry.  All references are
+stored as indices so the data is relocatable.
+
+===============================================================================
+*/
+
+#define BSPCACHE_IDENT "DPBSPCACHE"
+#define BSPCACHE_VERSION 1
+#define BSPCACHE_ENDIAN 0x01020304
+
+typedef enum bspcache_sectiontype_e
+{
+	BSPCACHE_SECTION_PORTALS,
+	BSPCACHE_SECTION_BIH
+}
+bspcache_sectiontype_t;
+
+typedef struct bspcache_header_s
+{
+	char ident[16];
+	int version;
+	int endian;
+	int headersize;
+	int recalculatenodeboxes;
+	unsigned char sourcedigest[16];
+	int sourcesize;
+	unsigned char geometrydigest[16];
+	int numsections;
+	int sectionsofs;
+}
+bspcache_header_t;
+
+typedef struct bspcache_section_s
+{
+	int type;
+	// BIH: which submodel and which of its trees
+	int submodel;
+	int userendersurfaces;
+	int surfacesstart, surfacesend;
+	int firstbrush, numbrushes;
+	// portals: num_portals, num_portalpoints, num_leafs, num_nodes
+	// BIH: numleafs (0 if it was empty), numnodes, rootnode
+	int counts[4];
+	float mins[3], maxs[3];
+	int ofs, len;
+}
+bspcache_section_t;
+
+typedef struct bspcache_portal_s
+{
+	int next; // -1 ends the chain of the leaf
+	int here, past; // leaf indices
+	int firstpoint, numpoints;
+	vec3_t mins, maxs;
+	mplane_t plane;
+}
+bspcache_portal_t;
+
+typedef struct bspcache_bih_s
+{
+	bih_t *bih; // NULL if Mod_MakeCollisionBIH found nothing to put in it
+	int submodel;
+	int userendersurfaces;
+	int surfacesstart, surfacesend;
+	int firstbrush, numbrushes;
+}
+bspcache_bih_t;
+
+typedef struct bspcache_state_s
+{
+	qbool active;
+	// something had to be rebuilt, so the file needs to be rewritten
+	qbool dirty;
+	qbool portals;
+	unsigned char sourcedigest[16];
+	int sourcesize;
+	qbool havegeometrydigest;
+	unsigned char geometrydigest[16];
+	// existing cache file, NULL if there was none or it did not match
+	unsigned char *blob;
+	fs_offset_t blobsize;
+	bspcache_header_t *header;
+	bspcache_section_t *sections;
+	// BIH trees of this load, in the order they were made
+	bspcache_bih_t *bihs;
+	int numbihs, maxbihs;
+}
+bspcache_state_t;
+
+static bspcache_state_t bspcache;
+
+static void Mod_BSPCache_Reset(void)
+{
+	if (bspcache.blob)
+		Mem_Free(bspcache.blob);
+	if (bspcache.bihs)
+		Mem_Free(bspcache.bihs);
+	memset(&bspcache, 0, sizeof(bspcache));
+}
+
+static void Mod_BSPCache_Path(char *path, size_t pathsize)
+{
+	dpsnprintf(path, pathsize, "cache/models/%s.cache", loadmodel->name);
+}
+
+static const void *Mod_BSPCache_SectionData(const bspcache_section_t *s, size_t expected)
+{
+	if (s->len < 0 || (size_t)s->len != expected || s->ofs < (int)sizeof(bspcache_header_t) || (s->ofs & 15) || (fs_offset_t)s->ofs + s->len > bspcache.blobsize)
+		return NULL;
+	return bspcache.blob + s->ofs;
+}
+
+/*
+=================
+Mod_BSPCache_Begin
+
+Called by the bsp loaders before anything that may come from the cache
+=================
+*/
+static void Mod_BSPCache_Begin(const void *buffer, const void *bufferend)
+{
+	char path[MAX_QPATH + 32];
+	bspcache_header_t *h;
+
+	Mod_BSPCache_Reset();
+	if (!mod_bsp_cache.integer)
+		return;
+	bspcache.active = true;
+	bspcache.sourcesize = (int)((const unsigned char *)bufferend - (const unsigned char *)buffer);
+	Com_BlockFullChecksum((void *)buffer, bspcache.sourcesize, bspcache.sourcedigest);
+
+	// only ever the file Mod_BSPCache_End wrote, never one from a package
+	Mod_BSPCache_Path(path, sizeof(path));
+	bspcache.blob = FS_LoadRealFile(path, tempmempool, true, &bspcache.blobsize);
+	if (!bspcache.blob)
+		return;
+	h = (bspcache_header_t *)bspcache.blob;
+	if (bspcache.blobsize < (fs_offset_t)sizeof(*h)
+	 || memcmp(h->ident, BSPCACHE_IDENT, sizeof(BSPCACHE_IDENT))
+	 || h->version != BSPCACHE_VERSION
+	 || h->endian != BSPCACHE_ENDIAN
+	 || h->headersize != (int)sizeof(*h)
+	 || h->recalculatenodeboxes != mod_recalculatenodeboxes.integer
+	 || h->sourcesize != bspcache.sourcesize
+	 || memcmp(h->sourcedigest, bspcache.sourcedigest, sizeof(h->sourcedigest))
+	 || h->numsections < 0 || h->sectionsofs < (int)sizeof(*h) || (h->sectionsofs & 3)
+	 || (fs_offset_t)h->sectionsofs + (fs_offset_t)h->numsections * (fs_offset_t)sizeof(bspcache_section_t) > bspcache.blobsize)
+	{
+		Mem_Free(bspcache.blob);
+		bspcache.blob = NULL;
+		return;
+	}
+	bspcache.header = h;
+	bspcache.sections = (bspcache_section_t *)(bspcache.blob + h->sectionsofs);
+}
+
+static qbool Mod_BSPCache_LoadPortals(void)
+{
+	int i;
+	const bspcache_section_t *s = NULL;
+	const bspcache_portal_t *in;
+	const mvertex_t *inpoints;
+	const int *leafportals;
+	const float *leafbounds, *nodebounds;
+	const unsigned char *data;
+	mportal_t *portal;
+	mleaf_t *leaf;
+	mnode_t *node;
+	int numportals, numpoints, numleafs, numnodes;
+
+	if (!bspcache.header)
+		return false;
+	for (i = 0;i < bspcache.header->numsections;i++)
+		if (bspcache.sections[i].type == BSPCACHE_SECTION_PORTALS)
+			s = bspcache.sections + i;
+	if (!s)
+		return false;
+	numportals = s->counts[0];
+	numpoints = s->counts[1];
+	numleafs = s->counts[2];
+	numnodes = s->counts[3];
+	if (numportals < 0 || numpoints < 0 || numleafs != loadmodel->brush.num_leafs || numnodes != loadmodel->brush.num_nodes)
+		return false;
+	data = (const unsigned char *)Mod_BSPCache_SectionData(s, numportals * sizeof(bspcache_portal_t) + numpoints * sizeof(mvertex_t) + numleafs * sizeof(int) + (numleafs + numnodes) * sizeof(float[6]));
+	if (!data)
+		return false;
+	in = (const bspcache_portal_t *)data;data += numportals * sizeof(bspcache_portal_t);
+	inpoints = (const mvertex_t *)data;data += numpoints * sizeof(mvertex_t);
+	leafportals = (const int *)data;data += numleafs * sizeof(int);
+	leafbounds = (const float *)data;data += numleafs * sizeof(float[6]);
+	nodebounds = (const float *)data;
+	for (i = 0;i < numportals;i++)
+		if (in[i].next < -1 || in[i].next >= numportals || in[i].here < 0 || in[i].here >= numleafs || in[i].past < 0 || in[i].past >= numleafs || in[i].firstpoint < 0 || in[i].numpoints < 0 || in[i].firstpoint + in[i].numpoints > numpoints)
+			return false;
+	for (i = 0;i < numleafs;i++)
+		if (leafportals[i] < -1 || leafportals[i] >= numportals)
+			return false;
+
+	// same layout Mod_BSP_FinalizePortals produces
+	loadmodel->brush.data_portals = (mportal_t *)Mem_Alloc(loadmodel->mempool, numportals * sizeof(mportal_t) + numpoints * sizeof(mvertex_t));
+	loadmodel->brush.num_portals = numportals;
+	loadmodel->brush.data_portalpoints = (mvertex_t *)((unsigned char *) loadmodel->brush.data_portals + numportals * sizeof(mportal_t));
+	loadmodel->brush.num_portalpoints = numpoints;
+	memcpy(loadmodel->brush.data_portalpoints, inpoints, numpoints * sizeof(mvertex_t));
+	for (i = 0, portal = loadmodel->brush.data_portals;i < numportals;i++, portal++, in++)
+	{
+		portal->next = in->next >= 0 ? loadmodel->brush.data_portals + in->next : NULL;
+		portal->here = loadmodel->brush.data_leafs + in->here;
+		portal->past = loadmodel->brush.data_leafs + in->past;
+		portal->points = loadmodel->brush.data_portalpoints + in->firstpoint;
+		portal->numpoints = in->numpoints;
+		VectorCopy(in->mins, portal->mins);
+		VectorCopy(in->maxs, portal->maxs);
+		portal->plane = in->plane;
+	}
+	for (i = 0, leaf = loadmodel->brush.data_leafs;i < numleafs;i++, leaf++, leafbounds += 6)
+	{
+		leaf->portals = leafportals[i] >= 0 ? loadmodel->brush.data_portals + leafportals[i] : NULL;
+		VectorCopy(leafbounds, leaf->mins);
+		VectorCopy(leafbounds + 3, leaf->maxs);
+	}
+	for (i = 0, node = loadmodel->brush.data_nodes;i < numnodes;i++, node++, nodebounds += 6)
+	{
+		VectorCopy(nodebounds, node->mins);
+		VectorCopy(nodebounds + 3, node->maxs);
+	}
+	return true;
+}
+
+/*
+=================
+Mod_BSPCache_MakePortals
+
+Mod_BSP_MakePortals, unless the cache has the result
+=================
+*/
+static void Mod_BSPCache_MakePortals(void)
+{
+	if (bspcache.active)
+		bspcache.portals = true;
+	if (Mod_BSPCache_LoadPortals())
+	{
+		Con_DPrintf("%s: loaded %i portals from cache\n", loadmodel->name, loadmodel->brush.num_portals);
+		return;
+	}
+	Mod_BSP_MakePortals();
+	bspcache.dirty = true;
+}
+
+static void Mod_BSPCache_GeometryDigest(void)
+{
+	int i, numcollisionvertices, numcollisiontriangles;
+	unsigned char digests[6][16];
+	int *surfaceinfo;
+	float *brushinfo;
+	const msurface_t *surface;
+	const q3mbrush_t *brush;
+
+	// the collision mesh has no counts of its own, find them from the surfaces
+	numcollisionvertices = 0;
+	numcollisiontriangles = 0;
+	for (i = 0, surface = loadmodel->data_surfaces;i < loadmodel->num_surfaces;i++, surface++)
+		numcollisiontriangles = max(numcollisiontriangles, surface->num_firstcollisiontriangle + surface->num_collisiontriangles);
+	if (loadmodel->brush.data_collisionelement3i)
+		for (i = 0;i < numcollisiontriangles * 3;i++)
+			numcollisionvertices = max(numcollisionvertices, loadmodel->brush.data_collisionelement3i[i] + 1);
+
+	memset(digests, 0, sizeof(digests));
+	if (loadmodel->surfmesh.data_vertex3f)
+		Com_BlockFullChecksum(loadmodel->surfmesh.data_vertex3f, loadmodel->surfmesh.num_vertices * sizeof(float[3]), digests[0]);
+	if (loadmodel->surfmesh.data_element3i)
+		Com_BlockFullChecksum(loadmodel->surfmesh.data_element3i, loadmodel->surfmesh.num_triangles * sizeof(int[3]), digests[1]);
+	if (loadmodel->brush.data_collisionvertex3f)
+		Com_BlockFullChecksum(loadmodel->brush.data_collisionvertex3f, numcollisionvertices * sizeof(float[3]), digests[2]);
+	if (loadmodel->brush.data_collisionelement3i)
+		Com_BlockFullChecksum(loadmodel->brush.data_collisionelement3i, numcollisiontriangles * sizeof(int[3]), digests[3]);
+	if (loadmodel->num_surfaces)
+	{
+		surfaceinfo = (int *)Mem_Alloc(tempmempool, loadmodel->num_surfaces * sizeof(int[6]));
+		for (i = 0, surface = loadmodel->data_surfaces;i < loadmodel->num_surfaces;i++, surface++)
+		{
+			surfaceinfo[i*6+0] = surface->num_firsttriangle;
+			surfaceinfo[i*6+1] = surface->num_triangles;
+			surfaceinfo[i*6+2] = surface->num_firstcollisiontriangle;
+			surfaceinfo[i*6+3] = surface->num_collisiontriangles;
+			surfaceinfo[i*6+4] = surface->texture ? (int)(surface->texture - loadmodel->data_textures) : -1;
+			surfaceinfo[i*6+5] = surface->texture && (surface->texture->basematerialflags & MATERIALFLAG_MESHCOLLISIONS);
+		}
+		Com_BlockFullChecksum(surfaceinfo, loadmodel->num_surfaces * sizeof(int[6]), digests[4]);
+		Mem_Free(surfaceinfo);
+	}
+	if (loadmodel->brush.num_brushes)
+	{
+		brushinfo = (float *)Mem_Alloc(tempmempool, loadmodel->brush.num_brushes * sizeof(float[8]));
+		for (i = 0, brush = loadmodel->brush.data_brushes;i < loadmodel->brush.num_brushes;i++, brush++)
+		{
+			brushinfo[i*8+0] = brush->colbrushf != NULL;
+			brushinfo[i*8+1] = brush->texture ? (float)(brush->texture - loadmodel->data_textures) : -1.0f;
+			if (brush->colbrushf)
+			{
+				VectorCopy(brush->colbrushf->mins, brushinfo + i*8+2);
+				VectorCopy(brush->colbrushf->maxs, brushinfo + i*8+5);
+			}
+		}
+		Com_BlockFullChecksum(brushinfo, loadmodel->brush.num_brushes * sizeof(float[8]), digests[5]);
+		Mem_Free(brushinfo);
+	}
+	Com_BlockFullChecksum(digests, sizeof(digests), bspcache.geometrydigest);
+	bspcache.havegeometrydigest = true;
+}
+
+static qbool Mod_BSPCache_LoadBIH(bspcache_bih_t *b, bih_t *out)
+{
+	int i;
+	const bspcache_section_t *s;
+	const unsigned char *data;
+	bih_t bih;
+
+	if (!bspcache.header || memcmp(bspcache.header->geometrydigest, bspcache.geometrydigest, sizeof(bspcache.geometrydigest)))
+		return false;
+	for (i = 0, s = bspcache.sections;i < bspcache.header->numsections;i++, s++)
+	{
+		if (s->type != BSPCACHE_SECTION_BIH || s->submodel != b->submodel || s->userendersurfaces != b->userendersurfaces)
+			continue;
+		if (s->surfacesstart != b->surfacesstart || s->surfacesend != b->surfacesend || s->firstbrush != b->firstbrush || s->numbrushes != b->numbrushes)
+			return false;
+		if (!s->counts[0])
+			return true; // nothing in it, leave out alone like Mod_MakeCollisionBIH does
+		if (s->counts[0] < 0 || s->counts[1] < 1 || s->counts[2] < 0 || s->counts[2] >= s->counts[1])
+			return false;
+		data = (const unsigned char *)Mod_BSPCache_SectionData(s, s->counts[0] * sizeof(bih_leaf_t) + s->counts[1] * sizeof(bih_node_t));
+		if (!data)
+			return false;
+		// every node and leaf is checked before the trace code may follow it
+		memset(&bih, 0, sizeof(bih));
+		bih.numleafs = s->counts[0];
+		bih.leafs = (bih_leaf_t *)data;
+		bih.numnodes = s->counts[1];
+		bih.nodes = (bih_node_t *)(data + bih.numleafs * sizeof(bih_leaf_t));
+		bih.rootnode = s->counts[2];
+		if (!Mod_ValidateCollisionBIH(&bih, loadmodel->num_textures, loadmodel->num_surfaces, loadmodel->surfmesh.num_triangles, loadmodel->brush.num_collisiontriangles, loadmodel->brush.data_brushes, loadmodel->brush.num_brushes))
+			return false;
+		memset(out, 0, sizeof(*out));
+		out->numleafs = s->counts[0];
+		out->leafs = (bih_leaf_t *)Mem_Alloc(loadmodel->mempool, out->numleafs * sizeof(bih_leaf_t));
+		memcpy(out->leafs, data, out->numleafs * sizeof(bih_leaf_t));
+		out->numnodes = out->maxnodes = s->counts[1];
+		out->nodes = (bih_node_t *)Mem_Alloc(loadmodel->mempool, out->numnodes * sizeof(bih_node_t));
+		memcpy(out->nodes, data + out->numleafs * sizeof(bih_leaf_t), out->numnodes * sizeof(bih_node_t));
+		out->rootnode = s->counts[2];
+		VectorCopy(s->mins, out->mins);
+		VectorCopy(s->maxs, out->maxs);
+		b->bih = out;
+		return true;
+	}
+	return false;
+}
+
+/*
+=================
+Mod_BSPCache_MakeCollisionBIH
+
+Mod_MakeCollisionBIH, unless the cache has the result
+=================
+*/
+static void Mod_BSPCache_MakeCollisionBIH(model_t *mod, qbool userendersurfaces, bih_t *out)
+{
+	bspcache_bih_t *b;
+
+	if (!bspcache.active)
+	{
+		Mod_MakeCollisionBIH(mod, userendersurfaces, out);
+		return;
+	}
+	if (!bspcache.havegeometrydigest)
+		Mod_BSPCache_GeometryDigest();
+	if (bspcache.numbihs >= bspcache.maxbihs)
+	{
+		bspcache.maxbihs = max(bspcache.maxbihs * 2, 64);
+		bspcache.bihs = (bspcache_bih_t *)Mem_Realloc(tempmempool, bspcache.bihs, bspcache.maxbihs * sizeof(bspcache_bih_t));
+	}
+	b = bspcache.bihs + bspcache.numbihs++;
+	b->submodel = mod->brush.submodel;
+	b->userendersurfaces = userendersurfaces;
+	b->surfacesstart = mod->submodelsurfaces_start;
+	b->surfacesend = mod->submodelsurfaces_end;
+	b->firstbrush = userendersurfaces ? 0 : mod->firstmodelbrush;
+	b->numbrushes = userendersurfaces ? 0 : mod->nummodelbrushes;
+	b->bih = NULL;
+	if (Mod_BSPCache_LoadBIH(b, out))
+		return;
+	b->bih = Mod_MakeCollisionBIH(mod, userendersurfaces, out);
+	bspcache.dirty = true;
+}
+
+/*
+=================
+Mod_BSPCache_End
+
+Called by the bsp loaders when everything that may come from the cache has
+been made, rewrites the cache file if any of it had to be rebuilt
+=================
+*/
+static void Mod_BSPCache_End(void)
+{
+	int i, j, numsections, ofs, size;
+	char path[MAX_QPATH + 32];
+	unsigned char *data, *out;
+	const bspcache_section_t *oldportals = NULL;
+	bspcache_header_t *h;
+	bspcache_section_t *sections, *s;
+	bspcache_portal_t *p;
+	const mportal_t *portal;
+	const mleaf_t *leaf;
+	const mnode_t *node;
+	int *leafportals;
+	float *bounds;
+
+	if (!bspcache.active || !bspcache.dirty)
+	{
+		Mod_BSPCache_Reset();
+		return;
+	}
+
+	// keep portals from the old file if they were not wanted this time
+	if (!bspcache.portals && bspcache.header)
+		for (i = 0;i < bspcache.header->numsections;i++)
+			if (bspcache.sections[i].type == BSPCACHE_SECTION_PORTALS && Mod_BSPCache_SectionData(bspcache.sections + i, bspcache.sections[i].len))
+				oldportals = bspcache.sections + i;
+
+	numsections = bspcache.numbihs + (bspcache.portals || oldportals);
+	sections = (bspcache_section_t *)Mem_Alloc(tempmempool, max(numsections, 1) * sizeof(bspcache_section_t));
+	ofs = (int)((sizeof(bspcache_header_t) + numsections * sizeof(bspcache_section_t) + 15) & ~15);
+	s = sections;
+	if (bspcache.portals)
+	{
+		s->type = BSPCACHE_SECTION_PORTALS;
+		s->counts[0] = loadmodel->brush.num_portals;
+		s->counts[1] = loadmodel->brush.num_portalpoints;
+		s->counts[2] = loadmodel->brush.num_leafs;
+		s->counts[3] = loadmodel->brush.num_nodes;
+		s->len = s->counts[0] * sizeof(bspcache_portal_t) + s->counts[1] * sizeof(mvertex_t) + s->counts[2] * sizeof(int) + (s->counts[2] + s->counts[3]) * sizeof(float[6]);
+		s->ofs = ofs;
+		ofs += (s->len + 15) & ~15;
+		s++;
+	}
+	else if (oldportals)
+	{
+		*s = *oldportals;
+		s->ofs = ofs;
+		ofs += (s->len + 15) & ~15;
+		s++;
+	}
+	for (i = 0;i < bspcache.numbihs;i++, s++)
+	{
+		s->type = BSPCACHE_SECTION_BIH;
+		s->submodel = bspcache.bihs[i].submodel;
+		s->userendersurfaces = bspcache.bihs[i].userendersurfaces;
+		s->surfacesstart = bspcache.bihs[i].surfacesstart;
+		s->surfacesend = bspcache.bihs[i].surfacesend;
+		s->firstbrush = bspcache.bihs[i].firstbrush;
+		s->numbrushes = bspcache.bihs[i].numbrushes;
+		if (bspcache.bihs[i].bih)
+		{
+			s->counts[0] = bspcache.bihs[i].bih->numleafs;
+			s->counts[1] = bspcache.bihs[i].bih->numnodes;
+			s->counts[2] = bspcache.bihs[i].bih->rootnode;
+			VectorCopy(bspcache.bihs[i].bih->mins, s->mins);
+			VectorCopy(bspcache.bihs[i].bih->maxs, s->maxs);
+			s->len = s->counts[0] * sizeof(bih_leaf_t) + s->counts[1] * sizeof(bih_node_t);
+		}
+		s->ofs = ofs;
+		ofs += (s->len + 15) & ~15;
+	}
+	size = ofs;
+
+	data = (unsigned char *)Mem_Alloc(tempmempool, size);
+	h = (bspcache_header_t *)data;
+	memcpy(h->ident, BSPCACHE_IDENT, sizeof(BSPCACHE_IDENT));
+	h->version = BSPCACHE_VERSION;
+	h->endian = BSPCACHE_ENDIAN;
+	h->headersize = sizeof(*h);
+	h->recalculatenodeboxes = mod_recalculatenodeboxes.integer;
+	memcpy(h->sourcedigest, bspcache.sourcedigest, sizeof(h->sourcedigest));
+	h->sourcesize = bspcache.sourcesize;
+	memcpy(h->geometrydigest, bspcache.geometrydigest, sizeof(h->geometrydigest));
+	h->numsections = numsections;
+	h->sectionsofs = sizeof(*h);
+	memcpy(data + h->sectionsofs, sections, numsections * sizeof(bspcache_section_t));
+
+	s = sections;
+	if (bspcache.portals)
+	{
+		out = data + s->ofs;
+		p = (bspcache_portal_t *)out;
+		for (i = 0, portal = loadmodel->brush.data_portals;i < loadmodel->brush.num_portals;i++, portal++, p++)
+		{
+			p->next = portal->next ? (int)(portal->next - loadmodel->brush.data_portals) : -1;
+			p->here = portal->here - loadmodel->brush.data_leafs;
+			p->past = portal->past - loadmodel->brush.data_leafs;
+			p->firstpoint = portal->points - loadmodel->brush.data_portalpoints;
+			p->numpoints = portal->numpoints;
+			VectorCopy(portal->mins, p->mins);
+			VectorCopy(portal->maxs, p->maxs);
+			p->plane = portal->plane;
+		}
+		out = (unsigned char *)p;
+		memcpy(out, loadmodel->brush.data_portalpoints, loadmodel->brush.num_portalpoints * sizeof(mvertex_t));
+		out += loadmodel->brush.num_portalpoints * sizeof(mvertex_t);
+		leafportals = (int *)out;
+		for (i = 0, leaf = loadmodel->brush.data_leafs;i < loadmodel->brush.num_leafs;i++, leaf++)
+			leafportals[i] = leaf->portals ? (int)(leaf->portals - loadmodel->brush.data_portals) : -1;
+		bounds = (float *)(leafportals + loadmodel->brush.num_leafs);
+		for (i = 0, leaf = loadmodel->brush.data_leafs;i < loadmodel->brush.num_leafs;i++, leaf++, bounds += 6)
+		{
+			VectorCopy(leaf->mins, bounds);
+			VectorCopy(leaf->maxs, bounds + 3);
+		}
+		for (i = 0, node = loadmodel->brush.data_nodes;i < loadmodel->brush.num_nodes;i++, node++, bounds += 6)
+		{
+			VectorCopy(node->mins, bounds);
+			VectorCopy(node->maxs, bounds + 3);
+		}
+		s++;
+	}
+	else if (oldportals)
+	{
+		memcpy(data + s->ofs, bspcache.blob + oldportals->ofs, s->len);
+		s++;
+	}
+	for (j = 0;j < bspcache.numbihs;j++, s++)
+	{
+		if (!bspcache.bihs[j].bih)
+			continue;
+		memcpy(data + s->ofs, bspcache.bihs[j].bih->leafs, s->counts[0] * sizeof(bih_leaf_t));
+		memcpy(data + s->ofs + s->counts[0] * sizeof(bih_leaf_t), bspcache.bihs[j].bih->nodes, s->counts[1] * sizeof(bih_node_t));
+	}
+
+	Mod_BSPCache_Path(path, sizeof(path));
+	if (FS_WriteFile(path, data, size))
+		Con_DPrintf("%s: wrote %i bytes of derived data to %s\n", loadmodel->name, size, path);
+	Mem_Free(data);
+	Mem_Free(sections);
+	Mod_BSPCache_Reset();
+}
+
 void Mod_CollisionBIH_TraceLineAgainstSurfaces(model_t *model, const frameblend_t *frameblend, const skeleton_t *skeleton, trace_t *trace, const vec3_t start, const vec3_t end, int hitsupercontentsmask, int skipsupercontentsmask, int skipmaterialflagsmask);
 
 void Mod_2PSB_Load(model_t *mod, void *buffer, void *bufferend)
@@ -3996,15 +4571,20 @@ void Mod_Q1BSP_Load(model_t *mod, void *buffer, void *bufferend)
 		mod->brush.qw_md4sum2 ^= LittleLong(temp);
 	}
 
+	Mod_BSP_StageTime(NULL);
 	Mod_Q1BSP_LoadEntities(&lumpsb[LUMP_ENTITIES]);
 	Mod_Q1BSP_LoadVertexes(&lumpsb[LUMP_VERTEXES]);
 	Mod_Q1BSP_LoadEdges(&lumpsb[LUMP_EDGES]);
 	Mod_Q1BSP_LoadSurfedges(&lumpsb[LUMP_SURFEDGES]);
+	Mod_BSP_StageTime("entities and vertices");
 	Mod_Q1BSP_LoadTextures(&lumpsb[LUMP_TEXTURES]);
+	Mod_BSP_StageTime("textures");
 	Mod_Q1BSP_LoadLighting(&lumpsb[LUMP_LIGHTING]);
 	Mod_Q1BSP_LoadPlanes(&lumpsb[LUMP_PLANES]);
 	Mod_Q1BSP_LoadTexinfo(&lumpsb[LUMP_TEXINFO]);
+	Mod_BSP_StageTime("lighting, planes and texinfo");
 	Mod_Q1BSP_LoadFaces(&lumpsb[LUMP_FACES]);
+	Mod_BSP_StageTime("faces and lightmaps");
 	Mod_Q1BSP_LoadLeaffaces(&lumpsb[LUMP_MARKSURFACES]);
 	Mod_Q1BSP_LoadVisibility(&lumpsb[LUMP_VISIBILITY]);
 	// load submodels before leafs because they contain the number of vis leafs
@@ -4012,6 +4592,7 @@ void Mod_Q1BSP_Load(model_t *mod, void *buffer, void *bufferend)
 	Mod_Q1BSP_LoadLeafs(&lumpsb[LUMP_LEAFS]);
 	Mod_Q1BSP_LoadNodes(&lumpsb[LUMP_NODES]);
 	Mod_Q1BSP_LoadClipnodes(&lumpsb[LUMP_CLIPNODES], &hullinfo);
+	Mod_BSP_StageTime("visibility and bsp tree");
 
 	for (i = 0; i < HEADER_LUMPS; i++)
 		if (lumpsb[i].readcount != lumpsb[i].cursize && i != LUMP_TEXTURES && i != LUMP_LIGHTING)
@@ -4027,8 +4608,10 @@ void Mod_Q1BSP_Load(model_t *mod, void *buffer, void *bufferend)
 	mod->brushq1.num_compressedpvs = 0;
 
 	Mod_Q1BSP_MakeHull0();
+	Mod_BSPCache_Begin(buffer, bufferend);
 	if (mod_bsp_portalize.integer && cls.state != ca_dedicated)
-		Mod_BSP_MakePortals();
+		Mod_BSPCache_MakePortals();
+	Mod_BSP_StageTime("portals");
 
 	mod->numframes = 2;		// regular and alternate animation
 	mod->numskins = 1;
@@ -4192,7 +4775,7 @@ void Mod_Q1BSP_Load(model_t *mod, void *buffer, void *bufferend)
 		//mod->brushq1.num_visleafs = bm->visleafs;
 
 		// build a Bounding Interval Hierarchy for culling triangles in light rendering
-		Mod_MakeCollisionBIH(mod, true, &mod->render_bih);
+		Mod_BSPCache_MakeCollisionBIH(mod, true, &mod->render_bih);
 
 		if (mod_q1bsp_polygoncollisions.integer)
 		{
@@ -4213,9 +4796,12 @@ void Mod_Q1BSP_Load(model_t *mod, void *buffer, void *bufferend)
 		}
 	}
 	mod = loadmodel;
+	Mod_BSPCache_End();
+	Mod_BSP_StageTime("submodels, collision and vertex buffers");
 
 	// make the model surface list (used by shadowing/lighting)
 	Mod_MakeSortedSurfaces(loadmodel);
+	Mod_BSP_StageTime("sorted surfaces");
 
 	Con_DPrintf("Stats for q1bsp model \"%s\": %i faces, %i nodes, %i leafs, %i visleafs, %i visleafportals, mesh: %i vertices, %i triangles, %i surfaces\n", loadmodel->name, loadmodel->num_surfaces, loadmodel->brush.num_nodes, loadmodel->brush.num_leafs, mod->brush.num_pvsclusters, loadmodel->brush.num_portals, loadmodel->surfmesh.num_vertices, loadmodel->surfmesh.num_triangles, loadmodel->num_surfaces);
 }
@@ -4962,8 +5548,9 @@ static void Mod_Q2BSP_Load(model_t *mod, void *buffer, void *bufferend)
 	mod->brushq1.num_compressedpvs = 0;
 
 	// the MakePortals code works fine on the q2bsp data as well
+	Mod_BSPCache_Begin(buffer, bufferend);
 	if (mod_bsp_portalize.integer && cls.state != ca_dedicated)
-		Mod_BSP_MakePortals();
+		Mod_BSPCache_MakePortals();
 
 	mod->numframes = 0;		// q2bsp animations are kind of special, frame is unbounded...
 	mod->numskins = 1;
@@ -5123,16 +5710,17 @@ static void Mod_Q2BSP_Load(model_t *mod, void *buffer, void *bufferend)
 		//mod->brushq1.num_visleafs = bm->visleafs;
 
 		// build a Bounding Interval Hierarchy for culling triangles in light rendering
-		Mod_MakeCollisionBIH(mod, false, &mod->collision_bih);
+		Mod_BSPCache_MakeCollisionBIH(mod, false, &mod->collision_bih);
 
 		// build a Bounding Interval Hierarchy for culling brushes in collision detection
-		Mod_MakeCollisionBIH(mod, true, &mod->render_bih);
+		Mod_BSPCache_MakeCollisionBIH(mod, true, &mod->render_bih);
 
 		// generate VBOs and other shared data before cloning submodels
 		if (i == 0)
 			Mod_BuildVBOs();
 	}
 	mod = loadmodel;
+	Mod_BSPCache_End();
 
 	// make the model surface list (used by shadowing/lighting)
 	Mod_MakeSortedSurfaces(loadmodel);
@@ -5798,16 +6386,50 @@ typedef struct patchtess_s
 		(a).lodgroup[5] == (b).lodgroup[5] \
 	)
 
-static void Mod_Q3BSP_LoadFaces(lump_t *l)
+typedef struct q3facebuild_s
 {
-	q3dface_t *in, *oldin;
-	msurface_t *out, *oldout;
-	int i, oldi, j, n, count, invalidelements, patchsize[2], finalwidth, finalheight, xtess, ytess, finalvertices, finaltriangles, firstvertex, firstelement, type, oldnumtriangles, oldnumtriangles2, meshvertices, meshtriangles, collisionvertices, collisiontriangles, numvertices, numtriangles, cxtess, cytess;
+	// index into patchtess, -1 if the face is not a patch
+	int patch;
+	// the face has geometry and got space reserved in the surface mesh
+	qbool build;
+	int firstcollisionvertex;
+	// space reserved before degenerate triangles were removed
+	int numtriangles;
+	int numcollisiontriangles;
+}
+q3facebuild_t;
+
+typedef struct q3facebuildcontext_s
+{
+	model_t *mod;
+	const q3dface_t *in;
+	const patchtess_t *patchtess;
+	q3facebuild_t *faces;
+}
+q3facebuildcontext_t;
+
+// number of faces given to each task by Mod_Q3BSP_LoadFaces
+#define Q3FACEBUILD_BATCH 256
+
+/*
+=================
+Mod_Q3BSP_BuildFaces_Task
+
+Fills in the mesh of the faces t->i[0] to t->i[1], each one only touches the
+ranges of the surface mesh and collision mesh reserved for it so any number of
+these can run at once
+=================
+*/
+static void Mod_Q3BSP_BuildFaces_Task(taskqueue_task_t *t)
+{
+	q3facebuildcontext_t *ctx = (q3facebuildcontext_t *)t->p[0];
+	model_t *mod = ctx->mod;
+	const q3dface_t *in;
+	const patchtess_t *patch;
+	msurface_t *out;
+	int i, j, type, firstvertex, firstelement, patchsize[2], finalwidth, finalheight, finalvertices, xtess, ytess, cxtess, cytess;
 	float lightmaptcbase[2], lightmaptcscale[2];
-	//int *originalelement3i;
 	float *originalvertex3f;
-	//float *originalsvector3f;
-	//float *originaltvector3f;
 	float *originalnormal3f;
 	float *originalcolor4f;
 	float *originaltexcoordtexture2f;
@@ -5815,9 +6437,147 @@ static void Mod_Q3BSP_LoadFaces(lump_t *l)
 	float *surfacecollisionvertex3f;
 	int *surfacecollisionelement3i;
 	float *v;
+
+	for (i = (int)t->i[0];i < (int)t->i[1];i++)
+	{
+		if (!ctx->faces[i].build)
+			continue;
+		in = ctx->in + i;
+		out = mod->data_surfaces + i;
+		type = LittleLong(in->type);
+		firstvertex = LittleLong(in->firstvertex);
+		firstelement = LittleLong(in->firstelement);
+		switch(type)
+		{
+		case Q3FACETYPE_FLAT:
+		case Q3FACETYPE_MESH:
+			// no processing necessary, except for lightmap merging
+			for (j = 0;j < out->num_vertices;j++)
+			{
+				(mod->surfmesh.data_vertex3f + 3 * out->num_firstvertex)[j * 3 + 0] = mod->brushq3.data_vertex3f[(firstvertex + j) * 3 + 0];
+				(mod->surfmesh.data_vertex3f + 3 * out->num_firstvertex)[j * 3 + 1] = mod->brushq3.data_vertex3f[(firstvertex + j) * 3 + 1];
+				(mod->surfmesh.data_vertex3f + 3 * out->num_firstvertex)[j * 3 + 2] = mod->brushq3.data_vertex3f[(firstvertex + j) * 3 + 2];
+				(mod->surfmesh.data_normal3f + 3 * out->num_firstvertex)[j * 3 + 0] = mod->brushq3.data_normal3f[(firstvertex + j) * 3 + 0];
+				(mod->surfmesh.data_normal3f + 3 * out->num_firstvertex)[j * 3 + 1] = mod->brushq3.data_normal3f[(firstvertex + j) * 3 + 1];
+				(mod->surfmesh.data_normal3f + 3 * out->num_firstvertex)[j * 3 + 2] = mod->brushq3.data_normal3f[(firstvertex + j) * 3 + 2];
+				(mod->surfmesh.data_texcoordtexture2f + 2 * out->num_firstvertex)[j * 2 + 0] = mod->brushq3.data_texcoordtexture2f[(firstvertex + j) * 2 + 0];
+				(mod->surfmesh.data_texcoordtexture2f + 2 * out->num_firstvertex)[j * 2 + 1] = mod->brushq3.data_texcoordtexture2f[(firstvertex + j) * 2 + 1];
+				(mod->surfmesh.data_texcoordlightmap2f + 2 * out->num_firstvertex)[j * 2 + 0] = mod->brushq3.data_texcoordlightmap2f[(firstvertex + j) * 2 + 0];
+				(mod->surfmesh.data_texcoordlightmap2f + 2 * out->num_firstvertex)[j * 2 + 1] = mod->brushq3.data_texcoordlightmap2f[(firstvertex + j) * 2 + 1];
+				(mod->surfmesh.data_lightmapcolor4f + 4 * out->num_firstvertex)[j * 4 + 0] = mod->brushq3.data_color4f[(firstvertex + j) * 4 + 0];
+				(mod->surfmesh.data_lightmapcolor4f + 4 * out->num_firstvertex)[j * 4 + 1] = mod->brushq3.data_color4f[(firstvertex + j) * 4 + 1];
+				(mod->surfmesh.data_lightmapcolor4f + 4 * out->num_firstvertex)[j * 4 + 2] = mod->brushq3.data_color4f[(firstvertex + j) * 4 + 2];
+				(mod->surfmesh.data_lightmapcolor4f + 4 * out->num_firstvertex)[j * 4 + 3] = mod->brushq3.data_color4f[(firstvertex + j) * 4 + 3];
+			}
+			for (j = 0;j < out->num_triangles*3;j++)
+				(mod->surfmesh.data_element3i + 3 * out->num_firsttriangle)[j] = mod->brushq3.data_element3i[firstelement + j] + out->num_firstvertex;
+			break;
+		case Q3FACETYPE_PATCH:
+			patch = ctx->patchtess + ctx->faces[i].patch;
+			patchsize[0] = LittleLong(in->specific.patch.patchsize[0]);
+			patchsize[1] = LittleLong(in->specific.patch.patchsize[1]);
+			originalvertex3f = mod->brushq3.data_vertex3f + firstvertex * 3;
+			originalnormal3f = mod->brushq3.data_normal3f + firstvertex * 3;
+			originaltexcoordtexture2f = mod->brushq3.data_texcoordtexture2f + firstvertex * 2;
+			originaltexcoordlightmap2f = mod->brushq3.data_texcoordlightmap2f + firstvertex * 2;
+			originalcolor4f = mod->brushq3.data_color4f + firstvertex * 4;
+			xtess = patch->info.lods[PATCH_LOD_VISUAL].xtess;
+			ytess = patch->info.lods[PATCH_LOD_VISUAL].ytess;
+			cxtess = patch->info.lods[PATCH_LOD_COLLISION].xtess;
+			cytess = patch->info.lods[PATCH_LOD_COLLISION].ytess;
+
+			finalwidth = Q3PatchDimForTess(patchsize[0],xtess); //((patchsize[0] - 1) * xtess) + 1;
+			finalheight = Q3PatchDimForTess(patchsize[1],ytess); //((patchsize[1] - 1) * ytess) + 1;
+			// generate geometry
+			// (note: normals are skipped because they get recalculated)
+			Q3PatchTesselateFloat(3, sizeof(float[3]), (mod->surfmesh.data_vertex3f + 3 * out->num_firstvertex), patchsize[0], patchsize[1], sizeof(float[3]), originalvertex3f, xtess, ytess);
+			Q3PatchTesselateFloat(3, sizeof(float[3]), (mod->surfmesh.data_normal3f + 3 * out->num_firstvertex), patchsize[0], patchsize[1], sizeof(float[3]), originalnormal3f, xtess, ytess);
+			Q3PatchTesselateFloat(2, sizeof(float[2]), (mod->surfmesh.data_texcoordtexture2f + 2 * out->num_firstvertex), patchsize[0], patchsize[1], sizeof(float[2]), originaltexcoordtexture2f, xtess, ytess);
+			Q3PatchTesselateFloat(2, sizeof(float[2]), (mod->surfmesh.data_texcoordlightmap2f + 2 * out->num_firstvertex), patchsize[0], patchsize[1], sizeof(float[2]), originaltexcoordlightmap2f, xtess, ytess);
+			Q3PatchTesselateFloat(4, sizeof(float[4]), (mod->surfmesh.data_lightmapcolor4f + 4 * out->num_firstvertex), patchsize[0], patchsize[1], sizeof(float[4]), originalcolor4f, xtess, ytess);
+			Q3PatchTriangleElements((mod->surfmesh.data_element3i + 3 * out->num_firsttriangle), finalwidth, finalheight, out->num_firstvertex);
+
+			out->num_triangles = Mod_RemoveDegenerateTriangles(out->num_triangles, (mod->surfmesh.data_element3i + 3 * out->num_firsttriangle), (mod->surfmesh.data_element3i + 3 * out->num_firsttriangle), mod->surfmesh.data_vertex3f);
+
+			// q3map does not put in collision brushes for curves... ugh
+			// build the lower quality collision geometry
+			finalwidth = Q3PatchDimForTess(patchsize[0],cxtess); //((patchsize[0] - 1) * cxtess) + 1;
+			finalheight = Q3PatchDimForTess(patchsize[1],cytess); //((patchsize[1] - 1) * cytess) + 1;
+			finalvertices = finalwidth * finalheight;
+
+			// store collision geometry for BIH collision tree
+			surfacecollisionvertex3f = mod->brush.data_collisionvertex3f + ctx->faces[i].firstcollisionvertex * 3;
+			surfacecollisionelement3i = mod->brush.data_collisionelement3i + out->num_firstcollisiontriangle * 3;
+			Q3PatchTesselateFloat(3, sizeof(float[3]), surfacecollisionvertex3f, patchsize[0], patchsize[1], sizeof(float[3]), originalvertex3f, cxtess, cytess);
+			Q3PatchTriangleElements(surfacecollisionelement3i, finalwidth, finalheight, ctx->faces[i].firstcollisionvertex);
+			Mod_SnapVertices(3, finalvertices, surfacecollisionvertex3f, 1);
+			out->num_collisiontriangles = Mod_RemoveDegenerateTriangles(out->num_collisiontriangles, surfacecollisionelement3i, surfacecollisionelement3i, mod->brush.data_collisionvertex3f);
+			break;
+		default:
+			break;
+		}
+		// calculate a bounding box
+		VectorClear(out->mins);
+		VectorClear(out->maxs);
+		if (out->num_vertices)
+		{
+			if (cls.state != ca_dedicated && out->lightmaptexture)
+			{
+				// figure out which part of the merged lightmap this fits into
+				int lightmapindex = LittleLong(in->lightmapindex) >> (mod->brushq3.deluxemapping ? 1 : 0);
+				int mergewidth = R_TextureWidth(out->lightmaptexture) / mod->brushq3.lightmapsize;
+				int mergeheight = R_TextureHeight(out->lightmaptexture) / mod->brushq3.lightmapsize;
+				lightmapindex &= mergewidth * mergeheight - 1;
+				lightmaptcscale[0] = 1.0f / mergewidth;
+				lightmaptcscale[1] = 1.0f / mergeheight;
+				lightmaptcbase[0] = (lightmapindex % mergewidth) * lightmaptcscale[0];
+				lightmaptcbase[1] = (lightmapindex / mergewidth) * lightmaptcscale[1];
+				// modify the lightmap texcoords to match this region of the merged lightmap
+				for (j = 0, v = mod->surfmesh.data_texcoordlightmap2f + 2 * out->num_firstvertex;j < out->num_vertices;j++, v += 2)
+				{
+					v[0] = v[0] * lightmaptcscale[0] + lightmaptcbase[0];
+					v[1] = v[1] * lightmaptcscale[1] + lightmaptcbase[1];
+				}
+			}
+			VectorCopy((mod->surfmesh.data_vertex3f + 3 * out->num_firstvertex), out->mins);
+			VectorCopy((mod->surfmesh.data_vertex3f + 3 * out->num_firstvertex), out->maxs);
+			for (j = 1, v = (mod->surfmesh.data_vertex3f + 3 * out->num_firstvertex) + 3;j < out->num_vertices;j++, v += 3)
+			{
+				out->mins[0] = min(out->mins[0], v[0]);
+				out->maxs[0] = max(out->maxs[0], v[0]);
+				out->mins[1] = min(out->mins[1], v[1]);
+				out->maxs[1] = max(out->maxs[1], v[1]);
+				out->mins[2] = min(out->mins[2], v[2]);
+				out->maxs[2] = max(out->maxs[2], v[2]);
+			}
+			out->mins[0] -= 1.0f;
+			out->mins[1] -= 1.0f;
+			out->mins[2] -= 1.0f;
+			out->maxs[0] += 1.0f;
+			out->maxs[1] += 1.0f;
+			out->maxs[2] += 1.0f;
+		}
+		// set lightmap styles for consistency with q1bsp
+		//out->lightmapinfo->styles[0] = 0;
+		//out->lightmapinfo->styles[1] = 255;
+		//out->lightmapinfo->styles[2] = 255;
+		//out->lightmapinfo->styles[3] = 255;
+	}
+	t->done = 1;
+}
+
+static void Mod_Q3BSP_LoadFaces(lump_t *l)
+{
+	q3dface_t *in, *oldin;
+	msurface_t *out, *oldout;
+	int i, oldi, j, n, count, invalidelements, patchsize[2], finalwidth, finalheight, xtess, ytess, finaltriangles, firstvertex, firstelement, type, meshvertices, meshtriangles, collisionvertices, collisiontriangles, allocatedcollisiontriangles, numvertices, numtriangles, cxtess, cytess, numtasks;
+	float *originalvertex3f;
 	patchtess_t *patchtess = NULL;
 	int patchtesscount = 0;
 	qbool again;
+	q3facebuild_t *faces;
+	q3facebuildcontext_t ctx;
+	taskqueue_task_t *tasks, done_task;
 
 	in = (q3dface_t *)(mod_base + l->fileofs);
 	if (l->filelen % sizeof(*in))
@@ -6025,11 +6785,21 @@ static void Mod_Q3BSP_LoadFaces(lump_t *l)
 	in = oldin;
 	out = oldout;
 	Mod_AllocSurfMesh(loadmodel->mempool, meshvertices, meshtriangles, false, true);
+	allocatedcollisiontriangles = collisiontriangles;
 	if (collisiontriangles)
 	{
 		loadmodel->brush.data_collisionvertex3f = (float *)Mem_Alloc(loadmodel->mempool, collisionvertices * sizeof(float[3]));
 		loadmodel->brush.data_collisionelement3i = (int *)Mem_Alloc(loadmodel->mempool, collisiontriangles * sizeof(int[3]));
 	}
+
+	// reserve each face its range of the meshes, the faces are then built on
+	// the task queue and packed together again once degenerate triangles are
+	// gone, which gives the same layout as building them one after another
+	faces = (q3facebuild_t *)Mem_Alloc(tempmempool, max(count, 1) * sizeof(*faces));
+	for (j = 0;j < count;j++)
+		faces[j].patch = -1;
+	for (j = 0;j < patchtesscount;j++)
+		faces[patchtess[j].surface_id].patch = j;
 	meshvertices = 0;
 	meshtriangles = 0;
 	collisionvertices = 0;
@@ -6038,114 +6808,86 @@ static void Mod_Q3BSP_LoadFaces(lump_t *l)
 	{
 		if (out->num_vertices < 3 || out->num_triangles < 1)
 			continue;
-
-		type = LittleLong(in->type);
-		firstvertex = LittleLong(in->firstvertex);
-		firstelement = LittleLong(in->firstelement);
+		if (LittleLong(in->type) == Q3FACETYPE_PATCH && faces[i].patch < 0)
+		{
+			Con_Printf(CON_ERROR "ERROR: patch %d isn't preprocessed?!?\n", i);
+			continue;
+		}
+		faces[i].build = true;
+		faces[i].numtriangles = out->num_triangles;
+		faces[i].numcollisiontriangles = out->num_collisiontriangles;
+		faces[i].firstcollisionvertex = collisionvertices;
 		out->num_firstvertex = meshvertices;
 		out->num_firsttriangle = meshtriangles;
 		out->num_firstcollisiontriangle = collisiontriangles;
-		switch(type)
+		meshvertices += out->num_vertices;
+		meshtriangles += out->num_triangles;
+		if (faces[i].patch >= 0)
 		{
-		case Q3FACETYPE_FLAT:
-		case Q3FACETYPE_MESH:
-			// no processing necessary, except for lightmap merging
-			for (j = 0;j < out->num_vertices;j++)
-			{
-				(loadmodel->surfmesh.data_vertex3f + 3 * out->num_firstvertex)[j * 3 + 0] = loadmodel->brushq3.data_vertex3f[(firstvertex + j) * 3 + 0];
-				(loadmodel->surfmesh.data_vertex3f + 3 * out->num_firstvertex)[j * 3 + 1] = loadmodel->brushq3.data_vertex3f[(firstvertex + j) * 3 + 1];
-				(loadmodel->surfmesh.data_vertex3f + 3 * out->num_firstvertex)[j * 3 + 2] = loadmodel->brushq3.data_vertex3f[(firstvertex + j) * 3 + 2];
-				(loadmodel->surfmesh.data_normal3f + 3 * out->num_firstvertex)[j * 3 + 0] = loadmodel->brushq3.data_normal3f[(firstvertex + j) * 3 + 0];
-				(loadmodel->surfmesh.data_normal3f + 3 * out->num_firstvertex)[j * 3 + 1] = loadmodel->brushq3.data_normal3f[(firstvertex + j) * 3 + 1];
-				(loadmodel->surfmesh.data_normal3f + 3 * out->num_firstvertex)[j * 3 + 2] = loadmodel->brushq3.data_normal3f[(firstvertex + j) * 3 + 2];
-				(loadmodel->surfmesh.data_texcoordtexture2f + 2 * out->num_firstvertex)[j * 2 + 0] = loadmodel->brushq3.data_texcoordtexture2f[(firstvertex + j) * 2 + 0];
-				(loadmodel->surfmesh.data_texcoordtexture2f + 2 * out->num_firstvertex)[j * 2 + 1] = loadmodel->brushq3.data_texcoordtexture2f[(firstvertex + j) * 2 + 1];
-				(loadmodel->surfmesh.data_texcoordlightmap2f + 2 * out->num_firstvertex)[j * 2 + 0] = loadmodel->brushq3.data_texcoordlightmap2f[(firstvertex + j) * 2 + 0];
-				(loadmodel->surfmesh.data_texcoordlightmap2f + 2 * out->num_firstvertex)[j * 2 + 1] = loadmodel->brushq3.data_texcoordlightmap2f[(firstvertex + j) * 2 + 1];
-				(loadmodel->surfmesh.data_lightmapcolor4f + 4 * out->num_firstvertex)[j * 4 + 0] = loadmodel->brushq3.data_color4f[(firstvertex + j) * 4 + 0];
-				(loadmodel->surfmesh.data_lightmapcolor4f + 4 * out->num_firstvertex)[j * 4 + 1] = loadmodel->brushq3.data_color4f[(firstvertex + j) * 4 + 1];
-				(loadmodel->surfmesh.data_lightmapcolor4f + 4 * out->num_firstvertex)[j * 4 + 2] = loadmodel->brushq3.data_color4f[(firstvertex + j) * 4 + 2];
-				(loadmodel->surfmesh.data_lightmapcolor4f + 4 * out->num_firstvertex)[j * 4 + 3] = loadmodel->brushq3.data_color4f[(firstvertex + j) * 4 + 3];
-			}
-			for (j = 0;j < out->num_triangles*3;j++)
-				(loadmodel->surfmesh.data_element3i + 3 * out->num_firsttriangle)[j] = loadmodel->brushq3.data_element3i[firstelement + j] + out->num_firstvertex;
-			break;
-		case Q3FACETYPE_PATCH:
-			patchsize[0] = LittleLong(in->specific.patch.patchsize[0]);
-			patchsize[1] = LittleLong(in->specific.patch.patchsize[1]);
-			originalvertex3f = loadmodel->brushq3.data_vertex3f + firstvertex * 3;
-			originalnormal3f = loadmodel->brushq3.data_normal3f + firstvertex * 3;
-			originaltexcoordtexture2f = loadmodel->brushq3.data_texcoordtexture2f + firstvertex * 2;
-			originaltexcoordlightmap2f = loadmodel->brushq3.data_texcoordlightmap2f + firstvertex * 2;
-			originalcolor4f = loadmodel->brushq3.data_color4f + firstvertex * 4;
-
-			xtess = ytess = cxtess = cytess = -1;
-			for(j = 0; j < patchtesscount; ++j)
-				if(patchtess[j].surface_id == i)
-				{
-					xtess = patchtess[j].info.lods[PATCH_LOD_VISUAL].xtess;
-					ytess = patchtess[j].info.lods[PATCH_LOD_VISUAL].ytess;
-					cxtess = patchtess[j].info.lods[PATCH_LOD_COLLISION].xtess;
-					cytess = patchtess[j].info.lods[PATCH_LOD_COLLISION].ytess;
-					break;
-				}
-			if(xtess == -1)
-			{
-				Con_Printf(CON_ERROR "ERROR: patch %d isn't preprocessed?!?\n", i);
-				xtess = ytess = cxtess = cytess = 0;
-			}
-
-			finalwidth = Q3PatchDimForTess(patchsize[0],xtess); //((patchsize[0] - 1) * xtess) + 1;
-			finalheight = Q3PatchDimForTess(patchsize[1],ytess); //((patchsize[1] - 1) * ytess) + 1;
-			finalvertices = finalwidth * finalheight;
-			oldnumtriangles = finaltriangles = (finalwidth - 1) * (finalheight - 1) * 2;
-			type = Q3FACETYPE_MESH;
-			// generate geometry
-			// (note: normals are skipped because they get recalculated)
-			Q3PatchTesselateFloat(3, sizeof(float[3]), (loadmodel->surfmesh.data_vertex3f + 3 * out->num_firstvertex), patchsize[0], patchsize[1], sizeof(float[3]), originalvertex3f, xtess, ytess);
-			Q3PatchTesselateFloat(3, sizeof(float[3]), (loadmodel->surfmesh.data_normal3f + 3 * out->num_firstvertex), patchsize[0], patchsize[1], sizeof(float[3]), originalnormal3f, xtess, ytess);
-			Q3PatchTesselateFloat(2, sizeof(float[2]), (loadmodel->surfmesh.data_texcoordtexture2f + 2 * out->num_firstvertex), patchsize[0], patchsize[1], sizeof(float[2]), originaltexcoordtexture2f, xtess, ytess);
-			Q3PatchTesselateFloat(2, sizeof(float[2]), (loadmodel->surfmesh.data_texcoordlightmap2f + 2 * out->num_firstvertex), patchsize[0], patchsize[1], sizeof(float[2]), originaltexcoordlightmap2f, xtess, ytess);
-			Q3PatchTesselateFloat(4, sizeof(float[4]), (loadmodel->surfmesh.data_lightmapcolor4f + 4 * out->num_firstvertex), patchsize[0], patchsize[1], sizeof(float[4]), originalcolor4f, xtess, ytess);
-			Q3PatchTriangleElements((loadmodel->surfmesh.data_element3i + 3 * out->num_firsttriangle), finalwidth, finalheight, out->num_firstvertex);
+			collisionvertices += out->num_collisionvertices;
+			collisiontriangles += out->num_collisiontriangles;
+		}
+	}
 
-			out->num_triangles = Mod_RemoveDegenerateTriangles(out->num_triangles, (loadmodel->surfmesh.data_element3i + 3 * out->num_firsttriangle), (loadmodel->surfmesh.data_element3i + 3 * out->num_firsttriangle), loadmodel->surfmesh.data_vertex3f);
+	ctx.mod = loadmodel;
+	ctx.in = oldin;
+	ctx.patchtess = patchtess;
+	ctx.faces = faces;
+	numtasks = (count + Q3FACEBUILD_BATCH - 1) / Q3FACEBUILD_BATCH;
+	if (numtasks > 1)
+	{
+		tasks = (taskqueue_task_t *)Mem_Alloc(tempmempool, numtasks * sizeof(*tasks));
+		for (j = 0;j < numtasks;j++)
+			TaskQueue_Setup(tasks + j, NULL, Mod_Q3BSP_BuildFaces_Task, j * Q3FACEBUILD_BATCH, min((j + 1) * Q3FACEBUILD_BATCH, count), &ctx, NULL);
+		TaskQueue_Setup(&done_task, NULL, TaskQueue_Task_CheckTasksDone, numtasks, 0, tasks, NULL);
+		TaskQueue_Enqueue(numtasks, tasks);
+		TaskQueue_Enqueue(1, &done_task);
+		TaskQueue_WaitForTaskDone(&done_task);
+		Mem_Free(tasks);
+	}
+	else if (numtasks)
+	{
+		TaskQueue_Setup(&done_task, NULL, Mod_Q3BSP_BuildFaces_Task, 0, count, &ctx, NULL);
+		Mod_Q3BSP_BuildFaces_Task(&done_task);
+	}
 
+	// pack the triangles left after removing degenerates, in face order
+	meshtriangles = 0;
+	collisiontriangles = 0;
+	for (i = oldi, in = oldin, out = oldout;i < count;i++, in++, out++)
+	{
+		if (!faces[i].build)
+			continue;
+		if (out->num_firsttriangle != meshtriangles)
+		{
+			memmove(loadmodel->surfmesh.data_element3i + 3 * meshtriangles, loadmodel->surfmesh.data_element3i + 3 * out->num_firsttriangle, out->num_triangles * sizeof(int[3]));
+			out->num_firsttriangle = meshtriangles;
+		}
+		if (out->num_firstcollisiontriangle != collisiontriangles)
+		{
+			memmove(loadmodel->brush.data_collisionelement3i + 3 * collisiontriangles, loadmodel->brush.data_collisionelement3i + 3 * out->num_firstcollisiontriangle, out->num_collisiontriangles * sizeof(int[3]));
+			out->num_firstcollisiontriangle = collisiontriangles;
+		}
+		meshtriangles += out->num_triangles;
+		collisiontriangles += out->num_collisiontriangles;
+		type = LittleLong(in->type);
+		firstvertex = LittleLong(in->firstvertex);
+		firstelement = LittleLong(in->firstelement);
+		if (type == Q3FACETYPE_PATCH)
+		{
+			type = Q3FACETYPE_MESH;
 			if (developer_extra.integer)
 			{
+				patchsize[0] = LittleLong(in->specific.patch.patchsize[0]);
+				patchsize[1] = LittleLong(in->specific.patch.patchsize[1]);
+				finaltriangles = faces[i].numtriangles;
 				if (out->num_triangles < finaltriangles)
 					Con_DPrintf("Mod_Q3BSP_LoadFaces: %ix%i curve subdivided to %i vertices / %i triangles, %i degenerate triangles removed (leaving %i)\n", patchsize[0], patchsize[1], out->num_vertices, finaltriangles, finaltriangles - out->num_triangles, out->num_triangles);
 				else
 					Con_DPrintf("Mod_Q3BSP_LoadFaces: %ix%i curve subdivided to %i vertices / %i triangles\n", patchsize[0], patchsize[1], out->num_vertices, out->num_triangles);
+				Con_DPrintf("Mod_Q3BSP_LoadFaces: %ix%i curve became %i:%i vertices / %i:%i triangles (%i:%i degenerate)\n", patchsize[0], patchsize[1], out->num_vertices, out->num_collisionvertices, faces[i].numtriangles, faces[i].numcollisiontriangles, faces[i].numtriangles - out->num_triangles, faces[i].numcollisiontriangles - out->num_collisiontriangles);
 			}
-			// q3map does not put in collision brushes for curves... ugh
-			// build the lower quality collision geometry
-			finalwidth = Q3PatchDimForTess(patchsize[0],cxtess); //((patchsize[0] - 1) * cxtess) + 1;
-			finalheight = Q3PatchDimForTess(patchsize[1],cytess); //((patchsize[1] - 1) * cytess) + 1;
-			finalvertices = finalwidth * finalheight;
-			oldnumtriangles2 = finaltriangles = (finalwidth - 1) * (finalheight - 1) * 2;
-
-			// store collision geometry for BIH collision tree
-			out->num_collisionvertices = finalvertices;
-			out->num_collisiontriangles = finaltriangles;
-			surfacecollisionvertex3f = loadmodel->brush.data_collisionvertex3f + collisionvertices * 3;
-			surfacecollisionelement3i = loadmodel->brush.data_collisionelement3i + collisiontriangles * 3;
-			Q3PatchTesselateFloat(3, sizeof(float[3]), surfacecollisionvertex3f, patchsize[0], patchsize[1], sizeof(float[3]), originalvertex3f, cxtess, cytess);
-			Q3PatchTriangleElements(surfacecollisionelement3i, finalwidth, finalheight, collisionvertices);
-			Mod_SnapVertices(3, finalvertices, surfacecollisionvertex3f, 1);
-			out->num_collisiontriangles = Mod_RemoveDegenerateTriangles(finaltriangles, surfacecollisionelement3i, surfacecollisionelement3i, loadmodel->brush.data_collisionvertex3f);
-
-			if (developer_extra.integer)
-				Con_DPrintf("Mod_Q3BSP_LoadFaces: %ix%i curve became %i:%i vertices / %i:%i triangles (%i:%i degenerate)\n", patchsize[0], patchsize[1], out->num_vertices, out->num_collisionvertices, oldnumtriangles, oldnumtriangles2, oldnumtriangles - out->num_triangles, oldnumtriangles2 - out->num_collisiontriangles);
-
-			collisionvertices += finalvertices;
-			collisiontriangles += out->num_collisiontriangles;
-			break;
-		default:
-			break;
 		}
-		meshvertices += out->num_vertices;
-		meshtriangles += out->num_triangles;
 		for (j = 0, invalidelements = 0;j < out->num_triangles * 3;j++)
 			if ((loadmodel->surfmesh.data_element3i + 3 * out->num_firsttriangle)[j] < out->num_firstvertex || (loadmodel->surfmesh.data_element3i + 3 * out->num_firsttriangle)[j] >= out->num_firstvertex + out->num_vertices)
 				invalidelements++;
@@ -6160,53 +6902,13 @@ static void Mod_Q3BSP_LoadFaces(lump_t *l)
 			}
 			Con_Print("\n");
 		}
-		// calculate a bounding box
-		VectorClear(out->mins);
-		VectorClear(out->maxs);
-		if (out->num_vertices)
-		{
-			if (cls.state != ca_dedicated && out->lightmaptexture)
-			{
-				// figure out which part of the merged lightmap this fits into
-				int lightmapindex = LittleLong(in->lightmapindex) >> (loadmodel->brushq3.deluxemapping ? 1 : 0);
-				int mergewidth = R_TextureWidth(out->lightmaptexture) / loadmodel->brushq3.lightmapsize;
-				int mergeheight = R_TextureHeight(out->lightmaptexture) / loadmodel->brushq3.lightmapsize;
-				lightmapindex &= mergewidth * mergeheight - 1;
-				lightmaptcscale[0] = 1.0f / mergewidth;
-				lightmaptcscale[1] = 1.0f / mergeheight;
-				lightmaptcbase[0] = (lightmapindex % mergewidth) * lightmaptcscale[0];
-				lightmaptcbase[1] = (lightmapindex / mergewidth) * lightmaptcscale[1];
-				// modify the lightmap texcoords to match this region of the merged lightmap
-				for (j = 0, v = loadmodel->surfmesh.data_texcoordlightmap2f + 2 * out->num_firstvertex;j < out->num_vertices;j++, v += 2)
-				{
-					v[0] = v[0] * lightmaptcscale[0] + lightmaptcbase[0];
-					v[1] = v[1] * lightmaptcscale[1] + lightmaptcbase[1];
-				}
-			}
-			VectorCopy((loadmodel->surfmesh.data_vertex3f + 3 * out->num_firstvertex), out->mins);
-			VectorCopy((loadmodel->surfmesh.data_vertex3f + 3 * out->num_firstvertex), out->maxs);
-			for (j = 1, v = (loadmodel->surfmesh.data_vertex3f + 3 * out->num_firstvertex) + 3;j < out->num_vertices;j++, v += 3)
-			{
-				out->mins[0] = min(out->mins[0], v[0]);
-				out->maxs[0] = max(out->maxs[0], v[0]);
-				out->mins[1] = min(out->mins[1], v[1]);
-				out->maxs[1] = max(out->maxs[1], v[1]);
-				out->mins[2] = min(out->mins[2], v[2]);
-				out->maxs[2] = max(out->maxs[2], v[2]);
-			}
-			out->mins[0] -= 1.0f;
-			out->mins[1] -= 1.0f;
-			out->mins[2] -= 1.0f;
-			out->maxs[0] += 1.0f;
-			out->maxs[1] += 1.0f;
-			out->maxs[2] += 1.0f;
-		}
-		// set lightmap styles for consistency with q1bsp
-		//out->lightmapinfo->styles[0] = 0;
-		//out->lightmapinfo->styles[1] = 255;
-		//out->lightmapinfo->styles[2] = 255;
-		//out->lightmapinfo->styles[3] = 255;
 	}
+	// the space freed by degenerate triangles stays at the end as before
+	if (meshtriangles < loadmodel->surfmesh.num_triangles)
+		memset(loadmodel->surfmesh.data_element3i + 3 * meshtriangles, 0, (loadmodel->surfmesh.num_triangles - meshtriangles) * sizeof(int[3]));
+	if (collisiontriangles < allocatedcollisiontriangles)
+		memset(loadmodel->brush.data_collisionelement3i + 3 * collisiontriangles, 0, (allocatedcollisiontriangles - collisiontriangles) * sizeof(int[3]));
+	Mem_Free(faces);
 
 	i = oldi;
 	out = oldout;
@@ -7540,6 +8242,70 @@ bih_t *Mod_MakeCollisionBIH(model_t *model, qbool userendersurfaces, bih_t *out)
 	return out;
 }
 
+/*
+=================
+Mod_ValidateCollisionBIH
+
+Checks a BIH that did not come from Mod_MakeCollisionBIH (such as one read
+from a cache file) before the trace code trusts it: every node index must
+point forward in the node array so the tree has no loops, and every leaf
+must refer to a triangle, brush, surface and texture that exists.  The
+counts are passed in rather than taken from a model so a loader can check
+the tree before it sets the model up.
+=================
+*/
+qbool Mod_ValidateCollisionBIH(const bih_t *bih, int numtextures, int numsurfaces, int numrendertriangles, int numcollisiontriangles, const q3mbrush_t *brushes, int numbrushes)
+{
+	int i, j;
+	const bih_node_t *node;
+	const bih_leaf_t *leaf;
+
+	if (bih->numleafs < 1 || bih->numnodes < 1 || bih->rootnode < 0 || bih->rootnode >= bih->numnodes)
+		return false;
+	for (i = 0, node = bih->nodes;i < bih->numnodes;i++, node++)
+	{
+		switch (node->type)
+		{
+		case BIH_SPLITX:
+		case BIH_SPLITY:
+		case BIH_SPLITZ:
+			if (node->front <= i || node->front >= bih->numnodes || node->back <= i || node->back >= bih->numnodes)
+				return false;
+			break;
+		case BIH_UNORDERED:
+			for (j = 0;j < BIH_MAXUNORDEREDCHILDREN;j++)
+				if (node->children[j] < -1 || node->children[j] >= bih->numleafs)
+					return false;
+			break;
+		default:
+			return false;
+		}
+	}
+	for (i = 0, leaf = bih->leafs;i < bih->numleafs;i++, leaf++)
+	{
+		if (leaf->textureindex < 0 || leaf->textureindex >= numtextures)
+			return false;
+		switch (leaf->type)
+		{
+		case BIH_BRUSH:
+			if (leaf->itemindex < 0 || leaf->itemindex >= numbrushes || !brushes[leaf->itemindex].colbrushf)
+				return false;
+			break;
+		case BIH_COLLISIONTRIANGLE:
+			if (leaf->itemindex < 0 || leaf->itemindex >= numcollisiontriangles || leaf->surfaceindex < 0 || leaf->surfaceindex >= numsurfaces)
+				return false;
+			break;
+		case BIH_RENDERTRIANGLE:
+			if (leaf->itemindex < 0 || leaf->itemindex >= numrendertriangles || leaf->surfaceindex < 0 || leaf->surfaceindex >= numsurfaces)
+				return false;
+			break;
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+
 static int Mod_Q3BSP_SuperContentsFromNativeContents(int nativecontents)
 {
 	int supercontents = 0;
@@ -7716,8 +8482,10 @@ static void Mod_Q3BSP_Load(model_t *mod, void *buffer, void *bufferend)
 	if (mod->texturepool == NULL)
 		mod->texturepool = R_AllocTexturePool();
 
+	Mod_BSP_StageTime(NULL);
 	Mod_Q3BSP_LoadEntities(&header->lumps[Q3LUMP_ENTITIES]);
 	Mod_Q3BSP_LoadTextures(&header->lumps[Q3LUMP_TEXTURES]);
+	Mod_BSP_StageTime("entities and shaders");
 	Mod_Q3BSP_LoadPlanes(&header->lumps[Q3LUMP_PLANES]);
 	if (header->version == Q3BSPVERSION_IG)
 		Mod_Q3BSP_LoadBrushSides_IG(&header->lumps[Q3LUMP_BRUSHSIDES]);
@@ -7727,20 +8495,27 @@ static void Mod_Q3BSP_Load(model_t *mod, void *buffer, void *bufferend)
 	Mod_Q3BSP_LoadEffects(&header->lumps[Q3LUMP_EFFECTS]);
 	Mod_Q3BSP_LoadVertices(&header->lumps[Q3LUMP_VERTICES]);
 	Mod_Q3BSP_LoadTriangles(&header->lumps[Q3LUMP_TRIANGLES]);
+	Mod_BSP_StageTime("brushes, vertices and triangles");
 	Mod_Q3BSP_LoadLightmaps(&header->lumps[Q3LUMP_LIGHTMAPS], &header->lumps[Q3LUMP_FACES]);
+	Mod_BSP_StageTime("lightmaps");
 	Mod_Q3BSP_LoadFaces(&header->lumps[Q3LUMP_FACES]);
+	Mod_BSP_StageTime("faces and curves");
 	Mod_Q3BSP_LoadModels(&header->lumps[Q3LUMP_MODELS]);
 	Mod_Q3BSP_LoadLeafBrushes(&header->lumps[Q3LUMP_LEAFBRUSHES]);
 	Mod_Q3BSP_LoadLeafFaces(&header->lumps[Q3LUMP_LEAFFACES]);
 	Mod_Q3BSP_LoadLeafs(&header->lumps[Q3LUMP_LEAFS]);
 	Mod_Q3BSP_LoadNodes(&header->lumps[Q3LUMP_NODES]);
+	Mod_BSP_StageTime("bsp tree");
 	Mod_Q3BSP_LoadLightGrid(&header->lumps[Q3LUMP_LIGHTGRID]);
 	Mod_Q3BSP_LoadPVS(&header->lumps[Q3LUMP_PVS]);
+	Mod_BSP_StageTime("light grid and pvs");
 	loadmodel->brush.numsubmodels = loadmodel->brushq3.num_models;
 
 	// the MakePortals code works fine on the q3bsp data as well
+	Mod_BSPCache_Begin(buffer, bufferend);
 	if (mod_bsp_portalize.integer && cls.state != ca_dedicated)
-		Mod_BSP_MakePortals();
+		Mod_BSPCache_MakePortals();
+	Mod_BSP_StageTime("portals");
 
 	// FIXME: shader alpha should replace r_wateralpha support in q3bsp
 	loadmodel->brush.supportwateralpha = true;
@@ -7829,17 +8604,20 @@ static void Mod_Q3BSP_Load(model_t *mod, void *buffer, void *bufferend)
 		mod->radius2 = modelradius * modelradius;
 
 		Mod_SetDrawSkyAndWater(mod);
-		Mod_MakeCollisionBIH(mod, false, &mod->collision_bih);
-		Mod_MakeCollisionBIH(mod, true, &mod->render_bih);
+		Mod_BSPCache_MakeCollisionBIH(mod, false, &mod->collision_bih);
+		Mod_BSPCache_MakeCollisionBIH(mod, true, &mod->render_bih);
 
 		// generate VBOs and other shared data before cloning submodels
 		if (i == 0)
 			Mod_BuildVBOs();
 	}
 	mod = loadmodel;
+	Mod_BSPCache_End();
+	Mod_BSP_StageTime("submodels, collision and vertex buffers");
 
 	// make the model surface list (used by shadowing/lighting)
 	Mod_MakeSortedSurfaces(loadmodel);
+	Mod_BSP_StageTime("sorted surfaces");
 
 	if (mod_q3bsp_sRGBlightmaps.integer)
 	{
@@ -409,6 +409,7 @@ model_t *Mod_LoadModel(model_t *mod, qbool crash, qbool checkdisk)
 	void *buf;
 	fs_offset_t filesize = 0;
 	char vabuf[1024];
+	double loadstarttime;
 
 	mod->used = true;
 
@@ -529,6 +530,7 @@ model_t *Mod_LoadModel(model_t *mod, qbool crash, qbool checkdisk)
 			   (loader[i].header && !memcmp(buf, loader[i].header, loader[i].headersize)))
 			{
 				// Matched. Load it.
+				loadstarttime = Sys_DirtyTime();
 				loader[i].Load(mod, buf, bufend);
 				Mem_Free(buf);
 
@@ -543,6 +545,7 @@ model_t *Mod_LoadModel(model_t *mod, qbool crash, qbool checkdisk)
 
 				Mod_SetDrawSkyAndWater(mod);
 				Mod_BuildVBOs();
+				Con_DPrintf("Mod_LoadModel: %s (%s) loaded in %.2f ms\n", mod->name, mod->modeldatatypestring ? mod->modeldatatypestring : "?", (Sys_DirtyTime() - loadstarttime) * 1000.0);
 				break;
 			}
 		}
@@ -2627,7 +2630,9 @@ nothing                GL_ZERO GL_ONE
 			if (skinframe)
 			{
 				texture->materialshaderpass = texture->shaderpasses[0] = Mod_CreateShaderPass(mempool, skinframe);
-				if (texture->materialshaderpass->skinframes[0]->hasalpha)
+				if (texture->materialshaderpass->skinframes[0]->async)
+					texture->skinframealphapending = true;
+				else if (texture->materialshaderpass->skinframes[0]->hasalpha)
 					texture->basematerialflags |= MATERIALFLAG_ALPHA | MATERIALFLAG_BLENDED | MATERIALFLAG_NOSHADOW;
 				if (texture->q2contents)
 					texture->supercontents = Mod_Q2BSP_SuperContentsFromNativeContents(texture->q2contents);
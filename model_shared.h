@@ -197,6 +197,9 @@ typedef struct texture_s
 
 	// base material flags
 	int basematerialflags;
+	// the skin was still decoding (TEXF_ASYNC) when the material was made, so
+	// R_GetCurrentTexture adds the alpha flags once it knows
+	qbool skinframealphapending;
 	// current material flags (updated each bmodel render)
 	int currentmaterialflags;
 	// base material alpha (used for Q2 materials)
@@ -727,6 +730,7 @@ qbool Mod_CollisionBIH_TraceLineOfSight(struct model_s *model, const vec3_t star
 int Mod_CollisionBIH_PointSuperContents(struct model_s *model, int frame, const vec3_t point);
 int Mod_CollisionBIH_PointSuperContents_Mesh(struct model_s *model, int frame, const vec3_t point);
 bih_t *Mod_MakeCollisionBIH(model_t *model, qbool userendersurfaces, bih_t *out);
+qbool Mod_ValidateCollisionBIH(const bih_t *bih, int numtextures, int numsurfaces, int numrendertriangles, int numcollisiontriangles, const q3mbrush_t *brushes, int numbrushes);
 
 // alias models
 struct frameblend_s;
@@ -4021,6 +4021,8 @@ static void PrintStats(netconn_t *conn)
 	Con_Printf("packetsReceived            = %i\n", conn->packetsReceived);
 	Con_Printf("receivedDuplicateCount     = %i\n", conn->receivedDuplicateCount);
 	Con_Printf("droppedDatagrams           = %i\n", conn->droppedDatagrams);
+	if (conn->rangecodedBytesIn)
+		Con_Printf("range coded bytes          = %u (from %u, %.1f%% saved)\n", conn->rangecodedBytesOut, conn->rangecodedBytesIn, 100.0 - 100.0 * conn->rangecodedBytesOut / conn->rangecodedBytesIn);
 }
 
 void Net_Stats_f(cmd_state_t *cmd)
@@ -241,6 +241,9 @@ typedef struct netconn_s
 	int unreliableMessagesReceived;
 	int reliableMessagesSent;
 	int reliableMessagesReceived;
+	// svc_rangecoded messages, size before and after coding
+	unsigned int rangecodedBytesIn;
+	unsigned int rangecodedBytesOut;
 } netconn_t;
 
 extern netconn_t *netconn_list;
@@ -10,6 +10,7 @@ entity_state_t defaultstate =
 	{0,0,0},//float angles[3];
 	0,//int effects;
 	0,//unsigned int customizeentityforclient; // !
+	0,//int originframenum; // ! client: frame the origin was last received in (PROTOCOL_DARKPLACES8 origin deltas)
 	0,//unsigned short number; // entity number this state is for
 	0,//unsigned short modelindex;
 	0,//unsigned short frame;
@@ -33,6 +34,7 @@ entity_state_t defaultstate =
 	0,//unsigned char flags;
 	0,//unsigned char internaleffects; // INTEF_FLAG1QW and so on
 	0,//unsigned char tagindex;
+	0,//unsigned char netpriority; // ! network update priority scale in 1/16ths (0 means 16, normal)
 	{32, 32, 32},//unsigned char colormod[3];
 	{32, 32, 32},//unsigned char glowmod[3];
 };
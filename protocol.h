@@ -185,6 +185,11 @@ void Protocol_Names(char *buffer, size_t buffersize);
 #define SU_EXTEND3       (1u<<31) ///< another byte to follow, future expansion
 // UBSan: unsigned literals because left shifting by 31 causes signed overflow, although it works as expected on x86.
 
+/// fields of svc_clientdata which PROTOCOL_DARKPLACES8 only sends when they
+/// changed (the client keeps the previous value when the bit is not set),
+/// lost updates are resent using the EntityFrame5 packet logs
+#define SU_DELTAFIELDS (SU_IDEALPITCH | SU_PUNCH1 | SU_PUNCH2 | SU_PUNCH3 | SU_VELOCITY1 | SU_VELOCITY2 | SU_VELOCITY3 | SU_PUNCHVEC1 | SU_PUNCHVEC2 | SU_PUNCHVEC3)
+
 // a sound with no channel is a local only sound
 #define	SND_VOLUME		(1<<0)		// a byte
 #define	SND_ATTENUATION	(1<<1)		// a byte
@@ -280,6 +285,7 @@ void Protocol_Names(char *buffer, size_t buffersize);
 #define svc_trailparticles	60		// [short] entnum [short] effectnum [vector] start [vector] end
 #define svc_pointparticles	61		// [short] effectnum [vector] start [vector] velocity [short] count
 #define svc_pointparticles1	62		// [short] effectnum [vector] start, same as svc_pointparticles except velocity is zero and count is 1
+#define svc_rangecoded		63		// [short] size [variable length] range coded message replacing the rest of the packet (DP8 and later)
 
 //
 // client to server
@@ -445,6 +451,7 @@ typedef struct entity_state_s
 	float angles[3];
 	int effects;
 	unsigned int customizeentityforclient; // !
+	int originframenum; // ! client: frame the origin was last received in (PROTOCOL_DARKPLACES8 origin deltas)
 	unsigned short number; // entity number this state is for
 	unsigned short modelindex;
 	unsigned short frame;
@@ -468,6 +475,7 @@ typedef struct entity_state_s
 	unsigned char flags;
 	unsigned char internaleffects; // INTEF_FLAG1QW and so on
 	unsigned char tagindex;
+	unsigned char netpriority; // ! network update priority scale in 1/16ths (0 means 16, normal)
 	unsigned char colormod[3];
 	unsigned char glowmod[3];
 	// LadyHavoc: very big data here :(
@@ -745,6 +753,15 @@ void EntityFrame4_CL_ReadFrame(void);
 #define E5_ORIGIN            (1u<<1)
 /// E5_ANGLES16=0: byte[3] = s->angle[0] * 256 / 360, s->angle[1] * 256 / 360, s->angle[2] * 256 / 360
 /// E5_ANGLES16=1: short[3] = s->angle[0] * 65536 / 360, s->angle[1] * 65536 / 360, s->angle[2] * 65536 / 360
+/// PROTOCOL_DARKPLACES8 sends E5_ORIGIN and E5_ANGLES as one run of bits
+/// (E5_ORIGIN32 and E5_ANGLES16 are never set), padded to a byte:
+///   E5_ORIGIN: 8 bits baseoffset
+///     baseoffset=0: 1 bit precise, then 3x32 bits float or 3x16 bits origin * 8
+///     baseoffset>0: 4 bits width, 3x width bits signed delta in 1/32 units
+///       from the origin received in frame (framenum - baseoffset)
+///   E5_ANGLES: 2 bits mode
+///     mode=0: 3x8 bits angles, mode=1: 3x16 bits angles
+///     mode=2: 32 bits quaternion (see EntityState5_PackAngles)
 #define E5_ANGLES            (1u<<2)
 /// E5_MODEL16=0: byte = s->modelindex
 /// E5_MODEL16=1: short = s->modelindex
@@ -826,6 +843,19 @@ void EntityFrame4_CL_ReadFrame(void);
 #define ENTITYFRAME5_MAXPACKETLOGS 64
 #define ENTITYFRAME5_MAXSTATES 1024
 #define ENTITYFRAME5_PRIORITYLEVELS 32
+/// priorities are accumulated in fixed point, this many bits of fraction
+#define ENTITYFRAME5_PRIORITYSHIFT 4
+/// highest accumulated priority (maps to the top priority level)
+#define ENTITYFRAME5_PRIORITYMAX ((ENTITYFRAME5_PRIORITYLEVELS << ENTITYFRAME5_PRIORITYSHIFT) - 1)
+/// update latency histogram buckets: 0, 1, 2, 3-4, 5-8, 9-16, 17-32, 33-64, 65+ frames
+#define ENTITYFRAME5_LATENCYBUCKETS 9
+/// PROTOCOL_DARKPLACES8 origin deltas are in 1/(1<<ENTITYFRAME5_ORIGINDELTASHIFT) units
+#define ENTITYFRAME5_ORIGINDELTASHIFT 5
+/// widest PROTOCOL_DARKPLACES8 origin delta component, in bits
+#define ENTITYFRAME5_ORIGINDELTAMAXBITS 15
+/// PROTOCOL_DARKPLACES8 only uses the packed quaternion angles if they
+/// decode within this many degrees of the real angles
+#define ENTITYFRAME5_PACKEDANGLEERROR 0.5f
 
 typedef struct entityframe5_changestate_s
 {
@@ -840,6 +870,8 @@ typedef struct entityframe5_packetlog_s
 	int numstates;
 	entityframe5_changestate_t states[ENTITYFRAME5_MAXSTATES];
 	unsigned char statsdeltabits[(MAX_CL_STATS+7)/8];
+	// SU_DELTAFIELDS bits of svc_clientdata sent in this packet
+	unsigned int clientdatadeltabits;
 }
 entityframe5_packetlog_t;
 
@@ -858,11 +890,20 @@ typedef struct entityframe5_database_s
 
 	// which properties of each entity have changed since last send
 	int *deltabits; // [maxedicts]
-	// priorities of entities (updated whenever deltabits change)
-	// (derived from deltabits)
-	unsigned char *priorities; // [maxedicts]
+	// accumulated priorities of entities, in 1<<ENTITYFRAME5_PRIORITYSHIFT
+	// units per priority level; every frame an entity waits with pending
+	// deltabits adds its weight, so starved entities rise to the top
+	// (0 means nothing is pending)
+	unsigned short *priorities; // [maxedicts]
 	// last frame this entity was sent on, for prioritzation
 	int *updateframenum; // [maxedicts]
+	// frame on which the currently pending changes of this entity began
+	// waiting, for latency statistics
+	int *pendingframenum; // [maxedicts]
+	// PROTOCOL_DARKPLACES8: frame the origin was last sent in (0 if the
+	// next one must be absolute), and the origin the client rebuilt from it
+	int *originframenum; // [maxedicts]
+	float *originsent; // [maxedicts*3]
 
 	// database of current status of all entities
 	entity_state_t *states; // [maxedicts]
@@ -887,16 +928,26 @@ typedef struct entityframe5_database_s
 	// buffers for building priority info
 	int prioritychaincounts[ENTITYFRAME5_PRIORITYLEVELS];
 	unsigned short prioritychains[ENTITYFRAME5_PRIORITYLEVELS][ENTITYFRAME5_MAXSTATES];
+
+	// how many frames entity updates waited before being sent (see
+	// ENTITYFRAME5_LATENCYBUCKETS), and how many updates did not fit
+	unsigned int latencyhistogram[ENTITYFRAME5_LATENCYBUCKETS];
+	unsigned int deferredupdates;
 }
 entityframe5_database_t;
 
 entityframe5_database_t *EntityFrame5_AllocDatabase(struct mempool_s *pool);
 void EntityFrame5_FreeDatabase(entityframe5_database_t *d);
-void EntityState5_WriteUpdate(int number, const entity_state_t *s, int changedbits, struct sizebuf_s *msg);
+void EntityState5_WriteUpdate(int number, const entity_state_t *s, int changedbits, struct sizebuf_s *msg, int originbaseoffset, const float *originbase, float *originsent);
+void EntityState5_WriteOriginAnglesBits(struct sizebuf_s *msg, const entity_state_t *s, unsigned int bits, qbool precise, int originbaseoffset, const float *originbase, float *originsent);
+unsigned int EntityState5_PackAngles(const float *angles);
+void EntityState5_UnpackAngles(unsigned int packed, float *angles);
 int EntityState5_DeltaBitsForState(entity_state_t *o, entity_state_t *n);
 void EntityFrame5_CL_ReadFrame(void);
+void EntityFrame5_SelfTest_f(struct cmd_state_s *cmd);
 void EntityFrame5_LostFrame(entityframe5_database_t *d, int framenum);
 void EntityFrame5_AckFrame(entityframe5_database_t *d, int framenum);
+void EntityFrame5_PrintLatency(entityframe5_database_t *d, qbool reset);
 qbool EntityFrame5_WriteFrame(struct sizebuf_s *msg, int maxsize, entityframe5_database_t *d, int numstates, const entity_state_t **states, int viewentnum, unsigned int movesequence, qbool need_empty);
 
 extern struct cvar_s developer_networkentities;
@@ -341,6 +341,7 @@ PRVM_DECLARE_field(movetype)
 PRVM_DECLARE_field(movetypesteplandevent)
 PRVM_DECLARE_field(netaddress)
 PRVM_DECLARE_field(netname)
+PRVM_DECLARE_field(netpriority)
 PRVM_DECLARE_field(nextthink)
 PRVM_DECLARE_field(nodrawtoclient)
 PRVM_DECLARE_field(noise)
@@ -705,6 +706,7 @@ PRVM_DECLARE_serverfieldfloat(max_health)
 PRVM_DECLARE_serverfieldfloat(modelflags)
 PRVM_DECLARE_serverfieldfloat(modelindex)
 PRVM_DECLARE_serverfieldfloat(movetype)
+PRVM_DECLARE_serverfieldfloat(netpriority)
 PRVM_DECLARE_serverfieldfloat(nextthink)
 PRVM_DECLARE_serverfieldfloat(pflags)
 PRVM_DECLARE_serverfieldfloat(ping)
@@ -47,6 +47,7 @@
 #define	MAX_LOCALINFO_STRING	1 // not actually used by DP servers
 #define	CL_MAX_USERCMDS			32
 #define	CVAR_HASHSIZE			1024
+#define	CMD_HASHSIZE			256
 #define	M_MAX_EDICTS			4096
 #define	MAX_DEMOS				8
 #define	MAX_DEMONAME			16
@@ -114,6 +115,7 @@
 #define	MAX_LOCALINFO_STRING	32768 ///< max length of server-local infostring for PROTOCOL_QUAKEWORLD (32768 in QuakeWorld)
 #define	CL_MAX_USERCMDS			128 ///< max number of predicted input packets in queue
 #define	CVAR_HASHSIZE			65536 ///< number of hash buckets for accelerating cvar name lookups
+#define	CMD_HASHSIZE			4096 ///< number of hash buckets for accelerating command and alias name lookups
 #define	M_MAX_EDICTS			32768 ///< max objects in menu vm
 #define	MAX_DEMOS				8 ///< max demos provided to demos command
 #define	MAX_DEMONAME			32 ///< max demo name length for demos command
@@ -86,6 +86,8 @@ const char *r_stat_name[r_stat_count] =
 	"animcache_shape_count",
 	"animcache_shape_vertices",
 	"animcache_shape_maxvertices",
+	"animcache_pose_lookups",
+	"animcache_pose_hits",
 	"batch_batches",
 	"batch_withgaps",
 	"batch_surfaces",
@@ -284,7 +286,7 @@ void R_TimeReport_EndFrame(void)
 "%6i draws%8i vertices%8i triangles bloompixels%8i copied%8i drawn\n"
 "%3i rendertargets%8i pixels\n"
 "updated%5i indexbuffers%8i bytes%5i vertexbuffers%8i bytes\n"
-"animcache%5ib gpuskeletal%7i vertices (%7i with normals)\n"
+"animcache%5ib gpuskeletal%7i vertices (%7i with normals)%5i/%5i poses shared\n"
 "fastbatch%5i count%5i surfaces%7i vertices %7i triangles\n"
 "copytris%5i count%5i surfaces%7i vertices %7i triangles\n"
 "dynamic%5i count%5i surfaces%7i vertices%7i triangles\n"
@@ -301,7 +303,7 @@ void R_TimeReport_EndFrame(void)
 , r_refdef.stats[r_stat_draws], r_refdef.stats[r_stat_draws_vertices], r_refdef.stats[r_stat_draws_elements] / 3, r_refdef.stats[r_stat_bloom_copypixels], r_refdef.stats[r_stat_bloom_drawpixels]
 , r_refdef.stats[r_stat_rendertargets_used], r_refdef.stats[r_stat_rendertargets_pixels]
 , r_refdef.stats[r_stat_indexbufferuploadcount], r_refdef.stats[r_stat_indexbufferuploadsize], r_refdef.stats[r_stat_vertexbufferuploadcount], r_refdef.stats[r_stat_vertexbufferuploadsize]
-, r_refdef.stats[r_stat_animcache_skeletal_bones], r_refdef.stats[r_stat_animcache_shape_vertices], r_refdef.stats[r_stat_animcache_shade_vertices]
+, r_refdef.stats[r_stat_animcache_skeletal_bones], r_refdef.stats[r_stat_animcache_shape_vertices], r_refdef.stats[r_stat_animcache_shade_vertices], r_refdef.stats[r_stat_animcache_pose_hits], r_refdef.stats[r_stat_animcache_pose_lookups]
 , r_refdef.stats[r_stat_batch_fast_batches], r_refdef.stats[r_stat_batch_fast_surfaces], r_refdef.stats[r_stat_batch_fast_vertices], r_refdef.stats[r_stat_batch_fast_triangles]
 , r_refdef.stats[r_stat_batch_copytriangles_batches], r_refdef.stats[r_stat_batch_copytriangles_surfaces], r_refdef.stats[r_stat_batch_copytriangles_vertices], r_refdef.stats[r_stat_batch_copytriangles_triangles]
 , r_refdef.stats[r_stat_batch_dynamic_batches], r_refdef.stats[r_stat_batch_dynamic_surfaces], r_refdef.stats[r_stat_batch_dynamic_vertices], r_refdef.stats[r_stat_batch_dynamic_triangles]
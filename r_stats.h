@@ -67,6 +67,8 @@ typedef enum r_stat_e
 	r_stat_animcache_shape_count,
 	r_stat_animcache_shape_vertices,
 	r_stat_animcache_shape_maxvertices,
+	r_stat_animcache_pose_lookups,
+	r_stat_animcache_pose_hits,
 	r_stat_batch_batches,
 	r_stat_batch_withgaps,
 	r_stat_batch_surfaces,
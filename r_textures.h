@@ -39,6 +39,8 @@
 #define TEXF_IMPORTANTBITS (TEXF_ALPHA | TEXF_MIPMAP | TEXF_RGBMULTIPLYBYALPHA | TEXF_CLAMP | TEXF_FORCENEAREST | TEXF_FORCELINEAR | TEXF_PICMIP | TEXF_COMPARE | TEXF_LOWPRECISION | TEXF_RENDERTARGET)
 // set as a flag to force the texture to be reloaded
 #define TEXF_FORCE_RELOAD 0x80000000
+// set as a flag to let R_SkinFrame_LoadExternal decode the images on the task queue and upload them later
+#define TEXF_ASYNC 0x40000000
 
 typedef enum textype_e
 {
@@ -162,6 +164,8 @@ typedef struct skinframe_s
 	qbool qgeneratemerged;
 	qbool qgeneratenmap;
 	qbool qgenerateglow;
+	// images still being decoded on the task queue, textures are NULL until R_SkinFrame_FinishAsync uploads them
+	struct r_skinframe_async_s *async;
 }
 skinframe_t;
 
@@ -277,6 +277,16 @@ typedef struct client_s
 	unsigned char statsdeltabits[(MAX_CL_STATS+7)/8];
 	int stats[MAX_CL_STATS];
 
+	// delta compression of clientdata (PROTOCOL_DARKPLACES8)
+	// SU_DELTAFIELDS bits that need to be sent, bits written to the current
+	// packet that are not in a packetlog yet, and the last sent values
+	unsigned int clientdatadeltabits;
+	unsigned int clientdatasentbits;
+	int clientdata_idealpitch;
+	vec3_t clientdata_punchangle;
+	vec3_t clientdata_punchvector;
+	vec3_t clientdata_velocity;
+
 	unsigned char unreliablemsg_data[NET_MAXMESSAGE];
 	sizebuf_t unreliablemsg;
 	int unreliablemsg_splitpoints;
@@ -288,6 +298,8 @@ typedef struct client_s
 	qbool download_started;
 	char download_name[MAX_QPATH];
 	qbool download_deflate;
+	qbool download_window; ///< client acks every block, so sv_download_window bytes may be in flight
+	double download_rewindtime; ///< lost blocks don't cause another rewind before this time
 
 	// fixangle data
 	qbool fixangle_angles_set;
@@ -431,6 +443,7 @@ extern cvar_t sv_cullentities_trace_prediction;
 extern cvar_t sv_cullentities_trace_samples;
 extern cvar_t sv_cullentities_trace_samples_extra;
 extern cvar_t sv_debugmove;
+extern cvar_t sv_download_window;
 extern cvar_t sv_echobprint;
 extern cvar_t sv_edgefriction;
 extern cvar_t sv_entpatch;
@@ -480,6 +493,7 @@ extern cvar_t sv_playerphysicsqc;
 extern cvar_t sv_progs;
 extern cvar_t sv_protocolname;
 extern cvar_t sv_random_seed;
+extern cvar_t sv_rangecoder;
 extern cvar_t host_limitlocal;
 extern cvar_t sv_sound_land;
 extern cvar_t sv_sound_watersplash;
@@ -42,22 +42,31 @@ static void EntityFrame5_ExpandEdicts(entityframe5_database_t *d, int newmax)
 		unsigned char *data;
 		int oldmaxedicts = d->maxedicts;
 		int *olddeltabits = d->deltabits;
-		unsigned char *oldpriorities = d->priorities;
+		unsigned short *oldpriorities = d->priorities;
 		int *oldupdateframenum = d->updateframenum;
+		int *oldpendingframenum = d->pendingframenum;
+		int *oldoriginframenum = d->originframenum;
+		float *oldoriginsent = d->originsent;
 		entity_state_t *oldstates = d->states;
 		unsigned char *oldvisiblebits = d->visiblebits;
 		d->maxedicts = newmax;
-		data = (unsigned char *)Mem_Alloc(sv_mempool, d->maxedicts * sizeof(int) + d->maxedicts * sizeof(unsigned char) + d->maxedicts * sizeof(int) + d->maxedicts * sizeof(entity_state_t) + (d->maxedicts+7)/8 * sizeof(unsigned char));
+		data = (unsigned char *)Mem_Alloc(sv_mempool, d->maxedicts * sizeof(int) + d->maxedicts * sizeof(unsigned short) + d->maxedicts * sizeof(int) + d->maxedicts * sizeof(int) + d->maxedicts * sizeof(int) + d->maxedicts * 3 * sizeof(float) + d->maxedicts * sizeof(entity_state_t) + (d->maxedicts+7)/8 * sizeof(unsigned char));
 		d->deltabits = (int *)data;data += d->maxedicts * sizeof(int);
-		d->priorities = (unsigned char *)data;data += d->maxedicts * sizeof(unsigned char);
 		d->updateframenum = (int *)data;data += d->maxedicts * sizeof(int);
+		d->pendingframenum = (int *)data;data += d->maxedicts * sizeof(int);
+		d->originframenum = (int *)data;data += d->maxedicts * sizeof(int);
+		d->originsent = (float *)data;data += d->maxedicts * 3 * sizeof(float);
 		d->states = (entity_state_t *)data;data += d->maxedicts * sizeof(entity_state_t);
+		d->priorities = (unsigned short *)data;data += d->maxedicts * sizeof(unsigned short);
 		d->visiblebits = (unsigned char *)data;data += (d->maxedicts+7)/8 * sizeof(unsigned char);
 		if (oldmaxedicts)
 		{
 			memcpy(d->deltabits, olddeltabits, oldmaxedicts * sizeof(int));
-			memcpy(d->priorities, oldpriorities, oldmaxedicts * sizeof(unsigned char));
+			memcpy(d->priorities, oldpriorities, oldmaxedicts * sizeof(unsigned short));
 			memcpy(d->updateframenum, oldupdateframenum, oldmaxedicts * sizeof(int));
+			memcpy(d->pendingframenum, oldpendingframenum, oldmaxedicts * sizeof(int));
+			memcpy(d->originframenum, oldoriginframenum, oldmaxedicts * sizeof(int));
+			memcpy(d->originsent, oldoriginsent, oldmaxedicts * 3 * sizeof(float));
 			memcpy(d->states, oldstates, oldmaxedicts * sizeof(entity_state_t));
 			memcpy(d->visiblebits, oldvisiblebits, (oldmaxedicts+7)/8 * sizeof(unsigned char));
 			// the previous buffers were a single allocation, so just one free
@@ -66,27 +75,39 @@ static void EntityFrame5_ExpandEdicts(entityframe5_database_t *d, int newmax)
 	}
 }
 
-static int EntityState5_Priority(entityframe5_database_t *d, int stateindex)
+// raises the accumulated priority of an entity to at least minpriority
+// (in whole priority levels), starting the latency clock if nothing was
+// pending before
+static void EntityFrame5_RaisePriority(entityframe5_database_t *d, int stateindex, int minpriority, int framenum)
 {
-	int limit, priority;
+	int priority = minpriority << ENTITYFRAME5_PRIORITYSHIFT;
+	if (!d->priorities[stateindex])
+		d->pendingframenum[stateindex] = framenum;
+	if (d->priorities[stateindex] < priority)
+		d->priorities[stateindex] = priority;
+}
+
+// returns how much priority this entity accumulates per frame while it has
+// pending changes, in 1<<ENTITYFRAME5_PRIORITYSHIFT units per level
+static int EntityState5_PriorityWeight(entityframe5_database_t *d, int stateindex)
+{
+	int limit, weight, scale;
 	entity_state_t *s = NULL; // hush compiler warning by initializing this
-	// if it is the player, update urgently
-	if (stateindex == d->viewentnum)
-		return ENTITYFRAME5_PRIORITYLEVELS - 1;
 	// priority increases each frame no matter what happens
-	priority = d->priorities[stateindex] + 1;
+	weight = 1;
 	// players get an extra priority boost
 	if (stateindex <= svs.maxclients)
-		priority++;
+		weight++;
 	// remove dead entities very quickly because they are just 2 bytes
 	if (d->states[stateindex].active != ACTIVE_NETWORK)
-	{
-		priority++;
-		return bound(1, priority, ENTITYFRAME5_PRIORITYLEVELS - 1);
-	}
+		return (weight + 1) << ENTITYFRAME5_PRIORITYSHIFT;
 	// certain changes are more noticable than others
 	if (d->deltabits[stateindex] & (E5_FULLUPDATE | E5_ATTACHMENT | E5_MODEL | E5_FLAGS | E5_COLORMAP))
-		priority++;
+		weight++;
+	// QC can scale the priority of an entity (.netpriority), 0 means normal
+	scale = d->states[stateindex].netpriority;
+	if (!scale)
+		scale = 1 << ENTITYFRAME5_PRIORITYSHIFT;
 	// find the root entity this one is attached to, and judge relevance by it
 	for (limit = 0;limit < 256;limit++)
 	{
@@ -105,8 +126,50 @@ static int EntityState5_Priority(entityframe5_database_t *d, int stateindex)
 	// now that we have the parent entity we can make some decisions based on
 	// distance from the player
 	if (VectorDistance(d->states[d->viewentnum].netcenter, s->netcenter) < 1024.0f)
-		priority++;
-	return bound(1, priority, ENTITYFRAME5_PRIORITYLEVELS - 1);
+		weight++;
+	// always make some progress so nothing starves forever
+	return max(1, weight * scale);
+}
+
+// accumulates priority on an entity with pending changes and returns the
+// priority level it should be sent at
+static int EntityState5_Priority(entityframe5_database_t *d, int stateindex)
+{
+	int priority;
+	// if it is the player, update urgently
+	if (stateindex == d->viewentnum)
+		priority = ENTITYFRAME5_PRIORITYMAX;
+	else
+		priority = d->priorities[stateindex] + EntityState5_PriorityWeight(d, stateindex);
+	d->priorities[stateindex] = bound(1 << ENTITYFRAME5_PRIORITYSHIFT, priority, ENTITYFRAME5_PRIORITYMAX);
+	return d->priorities[stateindex] >> ENTITYFRAME5_PRIORITYSHIFT;
+}
+
+static int EntityFrame5_LatencyBucket(int frames)
+{
+	int bucket;
+	// 0, 1, 2, 3-4, 5-8, 9-16, ...
+	for (bucket = 0;frames > 1 && bucket < ENTITYFRAME5_LATENCYBUCKETS - 2;bucket++)
+		frames = (frames + 1) >> 1;
+	return frames > 0 ? bucket + 1 : 0;
+}
+
+void EntityFrame5_PrintLatency(entityframe5_database_t *d, qbool reset)
+{
+	int i;
+	unsigned int total = 0;
+	static const char *bucketnames[ENTITYFRAME5_LATENCYBUCKETS] = {"0", "1", "2", "3-4", "5-8", "9-16", "17-32", "33-64", "65+"};
+	for (i = 0;i < ENTITYFRAME5_LATENCYBUCKETS;i++)
+		total += d->latencyhistogram[i];
+	Con_Printf("  %u updates sent, %u deferred for lack of space\n", total, d->deferredupdates);
+	for (i = 0;i < ENTITYFRAME5_LATENCYBUCKETS;i++)
+		if (d->latencyhistogram[i])
+			Con_Printf("  %6s frames: %8u (%5.1f%%)\n", bucketnames[i], d->latencyhistogram[i], 100.0 * d->latencyhistogram[i] / total);
+	if (reset)
+	{
+		memset(d->latencyhistogram, 0, sizeof(d->latencyhistogram));
+		d->deferredupdates = 0;
+	}
 }
 
 static int EntityState5_DeltaBits(const entity_state_t *o, const entity_state_t *n)
@@ -175,10 +238,102 @@ static int EntityState5_DeltaBits(const entity_state_t *o, const entity_state_t
 	return bits;
 }
 
-void EntityState5_WriteUpdate(int number, const entity_state_t *s, int changedbits, sizebuf_t *msg)
+// the client only gets the packed quaternion if it decodes to (nearly) the
+// same euler angles, otherwise interpolation would take the long way around
+static qbool EntityState5_PackedAnglesMatch(const float *angles, unsigned int packed)
+{
+	int i;
+	float unpacked[3];
+	EntityState5_UnpackAngles(packed, unpacked);
+	for (i = 0;i < 3;i++)
+		if (fabs(ANGLEMOD(angles[i] - unpacked[i] + 180.0f) - 180.0f) > ENTITYFRAME5_PACKEDANGLEERROR)
+			return false;
+	return true;
+}
+
+// PROTOCOL_DARKPLACES8 origin and angles, see E5_ANGLES in protocol.h
+// originbaseoffset is how many frames ago originbase was sent (0 to send an
+// absolute origin), originsent receives the origin the client will rebuild
+void EntityState5_WriteOriginAnglesBits(sizebuf_t *msg, const entity_state_t *s, unsigned int bits, qbool precise, int originbaseoffset, const float *originbase, float *originsent)
+{
+	int i, width, bitcount = 0;
+	int base[3], delta[3];
+	unsigned int packed;
+	if (bits & E5_ORIGIN)
+	{
+		width = 0;
+		if (originbaseoffset > 0 && originbaseoffset < 256)
+		{
+			for (i = 0;i < 3;i++)
+			{
+				base[i] = (int)floor(originbase[i] * (1 << ENTITYFRAME5_ORIGINDELTASHIFT) + 0.5f);
+				delta[i] = (int)floor(s->origin[i] * (1 << ENTITYFRAME5_ORIGINDELTASHIFT) + 0.5f) - base[i];
+			}
+			// find the smallest signed width that holds all three deltas
+			for (width = 1;width <= ENTITYFRAME5_ORIGINDELTAMAXBITS;width++)
+				if (delta[0] >= -(1 << (width - 1)) && delta[0] < (1 << (width - 1)) && delta[1] >= -(1 << (width - 1)) && delta[1] < (1 << (width - 1)) && delta[2] >= -(1 << (width - 1)) && delta[2] < (1 << (width - 1)))
+					break;
+			if (width > ENTITYFRAME5_ORIGINDELTAMAXBITS)
+				width = 0;
+		}
+		if (width)
+		{
+			MSG_WriteBits(msg, originbaseoffset, 8, &bitcount);
+			MSG_WriteBits(msg, width, 4, &bitcount);
+			for (i = 0;i < 3;i++)
+			{
+				MSG_WriteBits(msg, (unsigned int)delta[i], width, &bitcount);
+				originsent[i] = (base[i] + delta[i]) * (1.0f / (1 << ENTITYFRAME5_ORIGINDELTASHIFT));
+			}
+		}
+		else
+		{
+			MSG_WriteBits(msg, 0, 8, &bitcount);
+			MSG_WriteBits(msg, precise, 1, &bitcount);
+			for (i = 0;i < 3;i++)
+			{
+				if (precise)
+				{
+					union {float f;unsigned int i;} u;
+					u.f = s->origin[i];
+					MSG_WriteBits(msg, u.i, 32, &bitcount);
+					originsent[i] = s->origin[i];
+				}
+				else
+				{
+					MSG_WriteBits(msg, (unsigned int)Q_rint(s->origin[i] * 8), 16, &bitcount);
+					originsent[i] = (short)Q_rint(s->origin[i] * 8) * (1.0f / 8.0f);
+				}
+			}
+		}
+	}
+	if (bits & E5_ANGLES)
+	{
+		if (s->flags & RENDER_LOWPRECISION)
+		{
+			MSG_WriteBits(msg, 0, 2, &bitcount);
+			for (i = 0;i < 3;i++)
+				MSG_WriteBits(msg, (int)Q_rint(s->angles[i]*(256.0/360.0)) & 255, 8, &bitcount);
+		}
+		else if (EntityState5_PackedAnglesMatch(s->angles, (packed = EntityState5_PackAngles(s->angles))))
+		{
+			MSG_WriteBits(msg, 2, 2, &bitcount);
+			MSG_WriteBits(msg, packed, 32, &bitcount);
+		}
+		else
+		{
+			MSG_WriteBits(msg, 1, 2, &bitcount);
+			for (i = 0;i < 3;i++)
+				MSG_WriteBits(msg, (int)Q_rint(s->angles[i]*(65536.0/360.0)) & 65535, 16, &bitcount);
+		}
+	}
+}
+
+void EntityState5_WriteUpdate(int number, const entity_state_t *s, int changedbits, sizebuf_t *msg, int originbaseoffset, const float *originbase, float *originsent)
 {
 	prvm_prog_t *prog = SVVM_prog;
 	unsigned int bits = 0;
+	qbool precise;
 	//model_t *model;
 
 	if (s->active != ACTIVE_NETWORK)
@@ -207,6 +362,10 @@ void EntityState5_WriteUpdate(int number, const entity_state_t *s, int changedbi
 			//           f * 8 + 0.5) <   4095.9375
 		if ((bits & E5_ANGLES) && !(s->flags & RENDER_LOWPRECISION))
 			bits |= E5_ANGLES16;
+		// the bit packed origin and angles make these flags implicit
+		precise = (bits & E5_ORIGIN32) != 0;
+		if (sv.protocol == PROTOCOL_DARKPLACES8)
+			bits &= ~(E5_ORIGIN32 | E5_ANGLES16);
 		if ((bits & E5_MODEL) && s->modelindex >= 256)
 			bits |= E5_MODEL16;
 		if ((bits & E5_FRAME) && s->frame >= 256)
@@ -236,7 +395,12 @@ void EntityState5_WriteUpdate(int number, const entity_state_t *s, int changedbi
 				MSG_WriteByte(msg, (bits >> 24) & 0xFF);
 			if (bits & E5_FLAGS)
 				MSG_WriteByte(msg, s->flags);
-			if (bits & E5_ORIGIN)
+			if (sv.protocol == PROTOCOL_DARKPLACES8)
+			{
+				if (bits & (E5_ORIGIN | E5_ANGLES))
+					EntityState5_WriteOriginAnglesBits(msg, s, bits, precise, originbaseoffset, originbase, originsent);
+			}
+			else if (bits & E5_ORIGIN)
 			{
 				if (bits & E5_ORIGIN32)
 				{
@@ -251,7 +415,7 @@ void EntityState5_WriteUpdate(int number, const entity_state_t *s, int changedbi
 					MSG_WriteCoord13i(msg, s->origin[2]);
 				}
 			}
-			if (bits & E5_ANGLES)
+			if ((bits & E5_ANGLES) && sv.protocol != PROTOCOL_DARKPLACES8)
 			{
 				if (bits & E5_ANGLES16)
 				{
@@ -411,7 +575,9 @@ qbool EntityFrame5_WriteFrame(sizebuf_t *msg, int maxsize, entityframe5_database
 {
 	prvm_prog_t *prog = SVVM_prog;
 	const entity_state_t *n;
-	int i, num, l, framenum, packetlognumber, priority;
+	int i, num, l, framenum, packetlognumber, priority, bucket, originbaseoffset;
+	float originsent[3];
+	qbool full = false;
 	sizebuf_t buf;
 	unsigned char data[128];
 	entityframe5_packetlog_t *packetlog;
@@ -452,9 +618,10 @@ qbool EntityFrame5_WriteFrame(sizebuf_t *msg, int maxsize, entityframe5_database
 			{
 				CLEARPVSBIT(d->visiblebits, num);
 				d->deltabits[num] = E5_FULLUPDATE;
-				d->priorities[num] = max(d->priorities[num], 8); // removal is cheap
+				EntityFrame5_RaisePriority(d, num, 8, framenum); // removal is cheap
 				d->states[num] = defaultstate;
 				d->states[num].number = num;
+				d->originframenum[num] = 0;
 			}
 		}
 		// update the entity state data
@@ -465,11 +632,11 @@ qbool EntityFrame5_WriteFrame(sizebuf_t *msg, int maxsize, entityframe5_database
 			d->updateframenum[num] = framenum;
 			// initial priority is a bit high to make projectiles send on the
 			// first frame, among other things
-			d->priorities[num] = max(d->priorities[num], 4);
+			EntityFrame5_RaisePriority(d, num, 4, framenum);
 		}
 		SETPVSBIT(d->visiblebits, num);
 		d->deltabits[num] |= EntityState5_DeltaBits(d->states + num, n);
-		d->priorities[num] = max(d->priorities[num], 1);
+		EntityFrame5_RaisePriority(d, num, 1, framenum);
 		d->states[num] = *n;
 		d->states[num].number = num;
 		// advance to next entity so the next iteration doesn't immediately remove it
@@ -482,9 +649,10 @@ qbool EntityFrame5_WriteFrame(sizebuf_t *msg, int maxsize, entityframe5_database
 		{
 			CLEARPVSBIT(d->visiblebits, num);
 			d->deltabits[num] = E5_FULLUPDATE;
-			d->priorities[num] = max(d->priorities[num], 8); // removal is cheap
+			EntityFrame5_RaisePriority(d, num, 8, framenum); // removal is cheap
 			d->states[num] = defaultstate;
 			d->states[num].number = num;
+			d->originframenum[num] = 0;
 		}
 	}
 
@@ -493,7 +661,8 @@ qbool EntityFrame5_WriteFrame(sizebuf_t *msg, int maxsize, entityframe5_database
 	if (buf.cursize + 11 > buf.maxsize)
 		return false;
 
-	// build lists of entities by priority level
+	// build lists of entities by priority level, each level is a bucket so
+	// there is no need to sort them
 	memset(d->prioritychaincounts, 0, sizeof(d->prioritychaincounts));
 	l = 0;
 	for (num = 0;num < d->maxedicts;num++)
@@ -502,10 +671,8 @@ qbool EntityFrame5_WriteFrame(sizebuf_t *msg, int maxsize, entityframe5_database
 		{
 			if (d->deltabits[num])
 			{
-				if (d->priorities[num] < (ENTITYFRAME5_PRIORITYLEVELS - 1))
-					d->priorities[num] = EntityState5_Priority(d, num);
 				l = num;
-				priority = d->priorities[num];
+				priority = EntityState5_Priority(d, num);
 				if (d->prioritychaincounts[priority] < ENTITYFRAME5_MAXSTATES)
 					d->prioritychains[priority][d->prioritychaincounts[priority]++] = num;
 			}
@@ -550,6 +717,11 @@ qbool EntityFrame5_WriteFrame(sizebuf_t *msg, int maxsize, entityframe5_database
 		}
 	}
 
+	// log clientdata fields written to this packet (PROTOCOL_DARKPLACES8)
+	// so they are resent if it is lost, this needs a frame to be sent
+	if (host_client->clientdatasentbits)
+		l = 1;
+
 	// only send empty svc_entities frame if needed
 	if(!l && !need_empty)
 		return false;
@@ -562,6 +734,8 @@ qbool EntityFrame5_WriteFrame(sizebuf_t *msg, int maxsize, entityframe5_database
 		packetlog->numstates = 0;
 		memset(packetlog->statsdeltabits, 0, sizeof(packetlog->statsdeltabits));
 	}
+	packetlog->clientdatadeltabits = host_client->clientdatasentbits;
+	host_client->clientdatasentbits = 0;
 
 	// write state updates
 	if (developer_networkentities.integer >= 10)
@@ -571,7 +745,7 @@ qbool EntityFrame5_WriteFrame(sizebuf_t *msg, int maxsize, entityframe5_database
 	MSG_WriteLong(msg, framenum);
 	if (sv.protocol != PROTOCOL_QUAKE && sv.protocol != PROTOCOL_QUAKEDP && sv.protocol != PROTOCOL_DARKPLACES1 && sv.protocol != PROTOCOL_DARKPLACES2 && sv.protocol != PROTOCOL_DARKPLACES3 && sv.protocol != PROTOCOL_DARKPLACES4 && sv.protocol != PROTOCOL_DARKPLACES5 && sv.protocol != PROTOCOL_DARKPLACES6)
 		MSG_WriteLong(msg, movesequence);
-	for (priority = ENTITYFRAME5_PRIORITYLEVELS - 1;priority >= 0 && packetlog->numstates < ENTITYFRAME5_MAXSTATES;priority--)
+	for (priority = ENTITYFRAME5_PRIORITYLEVELS - 1;priority >= 0 && !full && packetlog->numstates < ENTITYFRAME5_MAXSTATES;priority--)
 	{
 		for (i = 0;i < d->prioritychaincounts[priority] && packetlog->numstates < ENTITYFRAME5_MAXSTATES;i++)
 		{
@@ -579,15 +753,41 @@ qbool EntityFrame5_WriteFrame(sizebuf_t *msg, int maxsize, entityframe5_database
 			n = d->states + num;
 			if (d->deltabits[num] & E5_FULLUPDATE)
 				d->deltabits[num] = E5_FULLUPDATE | EntityState5_DeltaBits(&defaultstate, n);
+			// PROTOCOL_DARKPLACES8 sends the origin as a delta from the
+			// last one sent, unless that frame was lost (see LostFrame),
+			// players always get an exact origin for prediction
+			originbaseoffset = 0;
+			if (sv.protocol == PROTOCOL_DARKPLACES8 && d->originframenum[num] && !(d->deltabits[num] & E5_FULLUPDATE) && num > svs.maxclients)
+				originbaseoffset = framenum - d->originframenum[num];
 			buf.cursize = 0;
-			EntityState5_WriteUpdate(num, n, d->deltabits[num], &buf);
-			// if the entity won't fit, try the next one
+			EntityState5_WriteUpdate(num, n, d->deltabits[num], &buf, originbaseoffset, d->originsent + num * 3, originsent);
+			// if the entity won't fit, try the next one, it keeps its
+			// accumulated priority so it will be early in line next frame
 			if (msg->cursize + buf.cursize + 2 > maxsize)
+			{
+				d->deferredupdates++;
+				// even a removal (2 bytes) won't fit, don't bother with the
+				// rest of this or any lower priority
+				if (msg->cursize + 2 + 2 > maxsize)
+				{
+					full = true;
+					break;
+				}
 				continue;
+			}
 			// write entity to the packet
 			SZ_Write(msg, buf.data, buf.cursize);
+			// remember what the client will have as the base for the next
+			// origin delta
+			if (sv.protocol == PROTOCOL_DARKPLACES8 && buf.cursize && n->active == ACTIVE_NETWORK && (d->deltabits[num] & E5_ORIGIN))
+			{
+				d->originframenum[num] = framenum;
+				VectorCopy(originsent, d->originsent + num * 3);
+			}
 			// mark age on entity for prioritization
 			d->updateframenum[num] = framenum;
+			bucket = EntityFrame5_LatencyBucket(framenum - d->pendingframenum[num]);
+			d->latencyhistogram[bucket]++;
 			// log entity so deltabits can be restored later if lost
 			packetlog->states[packetlog->numstates].number = num;
 			packetlog->states[packetlog->numstates].bits = d->deltabits[num];
@@ -623,10 +823,12 @@ static int packetlog5cmp(const void *a_, const void *b_)
 void EntityFrame5_LostFrame(entityframe5_database_t *d, int framenum)
 {
 	int i, j, l, bits;
+	unsigned int clientdatadeltabits = 0;
 	entityframe5_changestate_t *s;
 	entityframe5_packetlog_t *p;
 	static unsigned char statsdeltabits[(MAX_CL_STATS+7)/8];
 	static int deltabits[MAX_EDICTS];
+	static unsigned char originlostbits[(MAX_EDICTS+7)/8];
 	entityframe5_packetlog_t *packetlogs[ENTITYFRAME5_MAXPACKETLOGS];
 
 	for (i = 0, p = d->packetlog;i < ENTITYFRAME5_MAXPACKETLOGS;i++, p++)
@@ -635,6 +837,7 @@ void EntityFrame5_LostFrame(entityframe5_database_t *d, int framenum)
 
 	memset(deltabits, 0, sizeof(deltabits));
 	memset(statsdeltabits, 0, sizeof(statsdeltabits));
+	memset(originlostbits, 0, sizeof(originlostbits));
 	for (i = 0; i < ENTITYFRAME5_MAXPACKETLOGS; i++)
 	{
 		p = packetlogs[i];
@@ -645,10 +848,17 @@ void EntityFrame5_LostFrame(entityframe5_database_t *d, int framenum)
 		if (p->packetnumber <= framenum)
 		{
 			for (j = 0, s = p->states;j < p->numstates;j++, s++)
+			{
 				deltabits[s->number] |= s->bits;
+				// any PROTOCOL_DARKPLACES8 origin delta sent since then
+				// was based on this one, so the client ignored it
+				if (s->bits & E5_ORIGIN)
+					originlostbits[s->number >> 3] |= 1 << (s->number & 7);
+			}
 
 			for (l = 0;l < (MAX_CL_STATS+7)/8;l++)
 				statsdeltabits[l] |= p->statsdeltabits[l];
+			clientdatadeltabits |= p->clientdatadeltabits;
 
 			p->packetnumber = 0;
 		}
@@ -658,20 +868,29 @@ void EntityFrame5_LostFrame(entityframe5_database_t *d, int framenum)
 				deltabits[s->number] &= ~s->bits;
 			for (l = 0;l < (MAX_CL_STATS+7)/8;l++)
 				statsdeltabits[l] &= ~p->statsdeltabits[l];
+			clientdatadeltabits &= ~p->clientdatadeltabits;
 		}
 	}
 
 	for(i = 0; i < d->maxedicts; ++i)
 	{
-		bits = deltabits[i] & ~d->deltabits[i];
+		bits = deltabits[i];
+		if (CHECKPVSBIT(originlostbits, i) && d->originframenum[i])
+		{
+			// resend the origin without a delta
+			d->originframenum[i] = 0;
+			if (d->states[i].active == ACTIVE_NETWORK)
+				bits |= E5_ORIGIN;
+		}
+		bits &= ~d->deltabits[i];
 		if(bits)
 		{
 			d->deltabits[i] |= bits;
 			// if it was a very important update, set priority higher
 			if (bits & (E5_FULLUPDATE | E5_ATTACHMENT | E5_MODEL | E5_COLORMAP))
-				d->priorities[i] = max(d->priorities[i], 4);
+				EntityFrame5_RaisePriority(d, i, 4, d->latestframenum);
 			else
-				d->priorities[i] = max(d->priorities[i], 1);
+				EntityFrame5_RaisePriority(d, i, 1, d->latestframenum);
 		}
 	}
 
@@ -679,6 +898,7 @@ void EntityFrame5_LostFrame(entityframe5_database_t *d, int framenum)
 		host_client->statsdeltabits[l] |= statsdeltabits[l];
 		// no need to mask out the already-set bits here, as we do not
 		// do that priorities stuff
+	host_client->clientdatadeltabits |= clientdatadeltabits;
 }
 
 void EntityFrame5_AckFrame(entityframe5_database_t *d, int framenum)
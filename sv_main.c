@@ -30,6 +30,7 @@ client_t *host_client;
 
 static void SV_SaveEntFile_f(cmd_state_t *cmd);
 static void SV_StartDownload_f(cmd_state_t *cmd);
+static void SV_SkipDownload_f(cmd_state_t *cmd);
 static void SV_Download_f(cmd_state_t *cmd);
 static void SV_VM_Setup(void);
 extern cvar_t net_connecttimeout;
@@ -96,6 +97,7 @@ cvar_t sv_cullentities_trace_samples_players = {CF_SERVER, "sv_cullentities_trac
 cvar_t sv_cullentities_trace_spectators = {CF_SERVER, "sv_cullentities_trace_spectators", "0", "enables trace entity culling for clients that are spectating"};
 cvar_t sv_debugmove = {CF_SERVER | CF_NOTIFY, "sv_debugmove", "0", "disables collision detection optimizations for debugging purposes"};
 cvar_t sv_dedicated = {CF_SERVER | CF_READONLY, "sv_dedicated", "0", "for scripts and SVQC to detect when they're running on a dedicated server"};
+cvar_t sv_download_window = {CF_SERVER, "sv_download_window", "65536", "how many bytes of a download may be sent ahead of the client's acknowledgements, filling extra packets as far as the client's rate allows (only for clients that announce support for it, 0 sends one block per frame)"};
 cvar_t sv_echobprint = {CF_SERVER | CF_ARCHIVE, "sv_echobprint", "1", "prints gamecode bprint() calls to server console"};
 cvar_t sv_edgefriction = {CF_SERVER, "edgefriction", "1", "how much you slow down when nearing a ledge you might fall off, multiplier of sv_friction (Quake used 2, QuakeWorld used 1 due to a bug in physics code)"};
 cvar_t sv_entpatch = {CF_SERVER, "sv_entpatch", "1", "enables loading of .ent files to override entities in the bsp (for example Threewave CTF server pack contains .ent patch files enabling play of CTF on id1 maps)"};
@@ -146,6 +148,7 @@ cvar_t sv_playerphysicsqc = {CF_SERVER | CF_NOTIFY, "sv_playerphysicsqc", "1", "
 cvar_t sv_progs = {CF_SERVER, "sv_progs", "progs.dat", "selects which quakec progs.dat file to run" };
 cvar_t sv_protocolname = {CF_SERVER, "sv_protocolname", "DP7", "selects network protocol to host for (values include QUAKE, QUAKEDP, NEHAHRAMOVIE, DP1 and up)"};
 cvar_t sv_qcstats = {CF_SERVER, "sv_qcstats", "0", "Disables engine sending of stats 220 and above, for use by certain games such as Xonotic, NOTE: it's strongly recommended that SVQC send correct STAT_MOVEVARS_TICRATE and STAT_MOVEVARS_TIMESCALE"};
+cvar_t sv_rangecoder = {CF_SERVER, "sv_rangecoder", "1", "compress unreliable messages with an adaptive range coder when it saves bytes (protocol DP8 and later), net_stats shows the savings"};
 cvar_t sv_random_seed = {CF_SERVER, "sv_random_seed", "", "random seed; when set, on every map start this random seed is used to initialize the random number generator. Don't touch it unless for benchmarking or debugging"};
 cvar_t host_limitlocal = {CF_SERVER, "host_limitlocal", "0", "whether to apply rate limiting to the local player in a listen server (only useful for testing)"};
 cvar_t sv_sound_land = {CF_SERVER, "sv_sound_land", "demon/dland2.wav", "sound to play when MOVETYPE_STEP entity hits the ground at high speed (empty cvar disables the sound)"};
@@ -446,6 +449,25 @@ static void SV_AreaStats_f(cmd_state_t *cmd)
 	World_PrintAreaStats(&sv.world, "server");
 }
 
+static void SV_EntityLatency_f(cmd_state_t *cmd)
+{
+	int i;
+	client_t *client;
+	qbool reset = Cmd_Argc(cmd) >= 2 && !strcmp(Cmd_Argv(cmd, 1), "reset");
+	if (!sv.active)
+	{
+		Con_Print("Not running a server\n");
+		return;
+	}
+	for (i = 0, client = svs.clients;i < svs.maxclients;i++, client++)
+	{
+		if (!client->active || !client->entitydatabase5)
+			continue;
+		Con_Printf("#%i %s^7:\n", i + 1, client->name);
+		EntityFrame5_PrintLatency(client->entitydatabase5, reset);
+	}
+}
+
 static void SV_ServerOptions (void)
 {
 	int i;
@@ -521,7 +543,9 @@ void SV_Init (void)
 
 	Cmd_AddCommand(CF_SHARED, "sv_saveentfile", SV_SaveEntFile_f, "save map entities to .ent file (to allow external editing)");
 	Cmd_AddCommand(CF_SHARED, "sv_areastats", SV_AreaStats_f, "prints statistics on entity culling during collision traces");
+	Cmd_AddCommand(CF_SHARED, "sv_entitylatency", SV_EntityLatency_f, "prints per-client histograms of how many frames entity updates waited before being sent (DP5 and later protocols), sv_entitylatency reset clears them");
 	Cmd_AddCommand(CF_CLIENT | CF_SERVER_FROM_CLIENT, "sv_startdownload", SV_StartDownload_f, "begins sending a file to the client (network protocol use only)");
+	Cmd_AddCommand(CF_CLIENT | CF_SERVER_FROM_CLIENT, "sv_skipdownload", SV_SkipDownload_f, "cancels a file the client already has before it is sent (network protocol use only)");
 	Cmd_AddCommand(CF_CLIENT | CF_SERVER_FROM_CLIENT, "download", SV_Download_f, "downloads a specified file from the server");
 
 	Cvar_RegisterVariable (&sv_disablenotify);
@@ -583,6 +607,7 @@ void SV_Init (void)
 	Cvar_RegisterVariable (&sv_cullentities_trace_spectators);
 	Cvar_RegisterVariable (&sv_debugmove);
 	Cvar_RegisterVariable (&sv_dedicated);
+	Cvar_RegisterVariable (&sv_download_window);
 	Cvar_RegisterVariable (&sv_echobprint);
 	Cvar_RegisterVariable (&sv_edgefriction);
 	Cvar_RegisterVariable (&sv_entpatch);
@@ -634,6 +659,7 @@ void SV_Init (void)
 	Cvar_RegisterVariable (&sv_progs);
 	Cvar_RegisterVariable (&sv_protocolname);
 	Cvar_RegisterVariable (&sv_random_seed);
+	Cvar_RegisterVariable (&sv_rangecoder);
 	Cvar_RegisterVariable (&host_limitlocal);
 	Cvar_RegisterVirtual(&host_limitlocal, "sv_ratelimitlocalplayer");
 	Cvar_RegisterVariable (&sv_sound_land);
@@ -776,6 +802,9 @@ void SV_SendServerinfo (client_t *client)
 
 	memset(client->stats, 0, sizeof(client->stats));
 	memset(client->statsdeltabits, 0, sizeof(client->statsdeltabits));
+	// the first clientdata is a full update
+	client->clientdatadeltabits = SU_DELTAFIELDS;
+	client->clientdatasentbits = 0;
 
 	if (sv.protocol != PROTOCOL_QUAKE && sv.protocol != PROTOCOL_QUAKEDP)
 	{
@@ -1162,6 +1191,18 @@ static void SV_StartDownload_f(cmd_state_t *cmd)
 		host_client->download_started = true;
 }
 
+// the client found the announced file in its content hash cache
+static void SV_SkipDownload_f(cmd_state_t *cmd)
+{
+	if (!host_client->download_file || host_client->download_started)
+		return;
+	Con_DPrintf("Download of %s skipped by %s, already has it\n", host_client->download_name, host_client->name);
+	FS_Close(host_client->download_file);
+	host_client->download_file = NULL;
+	host_client->download_name[0] = 0;
+	host_client->download_expectedposition = 0;
+}
+
 /*
  * Compression extension negotiation:
  *
@@ -1181,6 +1222,10 @@ static void SV_StartDownload_f(cmd_state_t *cmd)
  * The server may choose not to compress the file by sending no compression name, like:
  *   cl_downloadbegin 345678 maps/map1.bsp
  *
+ * The client may also list "window" to say that it acknowledges every data
+ * block it receives, so the server may send several packets of data per
+ * frame (see sv_download_window).
+ *
  * NOTE: the "download" command may only specify compression algorithms if
  *       cl_serverextension_download is 2!
  *       If cl_serverextension_download has a different value, the client must
@@ -1194,20 +1239,21 @@ static void Download_CheckExtensions(cmd_state_t *cmd)
 
 	// first reset them all
 	host_client->download_deflate = false;
+	host_client->download_window = false;
 
 	for(i = 2; i < argc; ++i)
 	{
 		if(!strcmp(Cmd_Argv(cmd, i), "deflate"))
-		{
 			host_client->download_deflate = true;
-			break;
-		}
+		else if(!strcmp(Cmd_Argv(cmd, i), "window"))
+			host_client->download_window = true;
 	}
 }
 
 static void SV_Download_f(cmd_state_t *cmd)
 {
-	const char *whichpack, *whichpack2, *extension;
+	const char *whichpack, *whichpack2, *extension, *hash;
+	char packpath[MAX_OSPATH];
 	qbool is_csqc; // so we need to check only once
 
 	if (Cmd_Argc(cmd) < 2)
@@ -1274,6 +1320,7 @@ static void SV_Download_f(cmd_state_t *cmd)
 		SV_ClientCommands("\ncl_downloadbegin %i %s%s\n", (int)FS_FileSize(host_client->download_file), host_client->download_name, extensions);
 
 		host_client->download_expectedposition = 0;
+		host_client->download_rewindtime = 0;
 		host_client->download_started = false;
 		host_client->sendsignon = true; // make sure this message is sent
 		return;
@@ -1380,9 +1427,18 @@ static void SV_Download_f(cmd_state_t *cmd)
 		SV_ClientCommands("\ncl_downloadbegin %i %s%s\n", (int)FS_FileSize(host_client->download_file), host_client->download_name, extensions);
 	}
 	*/
-	SV_ClientCommands("\ncl_downloadbegin %i %s\n", (int)FS_FileSize(host_client->download_file), host_client->download_name);
+	// packages come with their content hash, so the client can skip the
+	// download if it already has them under another name
+	hash = NULL;
+	if ((!strcasecmp(extension, "pak") || !strcasecmp(extension, "pk3") || !strcasecmp(extension, "dpk")) && FS_RealFilePath(host_client->download_name, packpath, sizeof(packpath)))
+		hash = Curl_ServerSHA256(packpath);
+	if (hash)
+		SV_ClientCommands("\ncl_downloadbegin %i %s sha256=%s\n", (int)FS_FileSize(host_client->download_file), host_client->download_name, hash);
+	else
+		SV_ClientCommands("\ncl_downloadbegin %i %s\n", (int)FS_FileSize(host_client->download_file), host_client->download_name);
 
 	host_client->download_expectedposition = 0;
+	host_client->download_rewindtime = 0;
 	host_client->download_started = false;
 	host_client->sendsignon = true; // make sure this message is sent
 
@@ -2713,6 +2769,8 @@ static int SV_ThreadFunc(void *voiddata)
 //		if (setjmp(sv_abortframe))
 //			continue;			// something bad happened in the server game
 
+		Mem_FrameArena_NewFrame();
+
 		sv_oldrealtime = sv_realtime;
 		sv_realtime = Sys_DirtyTime();
 		sv_deltarealtime = sv_realtime - sv_oldrealtime;
@@ -2829,6 +2887,7 @@ static int SV_ThreadFunc(void *voiddata)
 			sv_timer = 0;
 		}
 	}
+	Mem_FrameArena_Free();
 	return 0;
 }
 
@@ -123,7 +123,8 @@ trace_t SV_TracePoint(const vec3_t start, int type, prvm_edict_t *passedict, int
 	model_t *model;
 	// list of entities to test for collisions
 	int numtouchedicts;
-	static prvm_edict_t *touchedicts[MAX_EDICTS];
+	prvm_edict_t **touchedicts;
+	size_t arenamark;
 	int clipgroup;
 
 	//return SV_TraceBox(start, vec3_origin, vec3_origin, end, type, passedict, hitsupercontentsmask, skipsupercontentsmask, skipmaterialflagsmask);
@@ -180,6 +181,8 @@ trace_t SV_TracePoint(const vec3_t start, int type, prvm_edict_t *passedict, int
 	// clip to entities
 	// because this uses World_EntitiestoBox, we know all entity boxes overlap
 	// the clip region, so we can skip culling checks in the loop below
+	arenamark = Mem_FrameArena_Mark();
+	touchedicts = (prvm_edict_t **)Mem_FrameArena_Alloc(MAX_EDICTS * sizeof(*touchedicts));
 	numtouchedicts = SV_EntitiesInBox(clipboxmins, clipboxmaxs, MAX_EDICTS, touchedicts);
 	if (numtouchedicts > MAX_EDICTS)
 	{
@@ -241,6 +244,7 @@ trace_t SV_TracePoint(const vec3_t start, int type, prvm_edict_t *passedict, int
 
 		Collision_CombineTraces(&cliptrace, &trace, (void *)touch, PRVM_serveredictfloat(touch, solid) == SOLID_BSP);
 	}
+	Mem_FrameArena_Pop(arenamark);
 
 finished:
 	return cliptrace;
@@ -275,7 +279,8 @@ trace_t SV_TraceLine(const vec3_t start, const vec3_t end, int type, prvm_edict_
 	model_t *model;
 	// list of entities to test for collisions
 	int numtouchedicts;
-	static prvm_edict_t *touchedicts[MAX_EDICTS];
+	prvm_edict_t **touchedicts;
+	size_t arenamark;
 	int clipgroup;
 	if (VectorCompare(start, end))
 		return SV_TracePoint(start, type, passedict, hitsupercontentsmask, skipsupercontentsmask, skipmaterialflagsmask);
@@ -335,6 +340,8 @@ trace_t SV_TraceLine(const vec3_t start, const vec3_t end, int type, prvm_edict_
 	// clip to entities
 	// because this uses World_EntitiestoBox, we know all entity boxes overlap
 	// the clip region, so we can skip culling checks in the loop below
+	arenamark = Mem_FrameArena_Mark();
+	touchedicts = (prvm_edict_t **)Mem_FrameArena_Alloc(MAX_EDICTS * sizeof(*touchedicts));
 	numtouchedicts = SV_EntitiesInBox(clipboxmins, clipboxmaxs, MAX_EDICTS, touchedicts);
 	if (numtouchedicts > MAX_EDICTS)
 	{
@@ -396,6 +403,7 @@ trace_t SV_TraceLine(const vec3_t start, const vec3_t end, int type, prvm_edict_
 
 		Collision_CombineTraces(&cliptrace, &trace, (void *)touch, PRVM_serveredictfloat(touch, solid) == SOLID_BSP);
 	}
+	Mem_FrameArena_Pop(arenamark);
 
 finished:
 	return cliptrace;
@@ -438,7 +446,8 @@ trace_t SV_TraceBox(const vec3_t start, const vec3_t mins, const vec3_t maxs, co
 	model_t *model;
 	// list of entities to test for collisions
 	int numtouchedicts;
-	static prvm_edict_t *touchedicts[MAX_EDICTS];
+	prvm_edict_t **touchedicts;
+	size_t arenamark;
 	int clipgroup;
 	if (VectorCompare(mins, maxs))
 	{
@@ -519,6 +528,8 @@ trace_t SV_TraceBox(const vec3_t start, const vec3_t mins, const vec3_t maxs, co
 	// clip to entities
 	// because this uses World_EntitiestoBox, we know all entity boxes overlap
 	// the clip region, so we can skip culling checks in the loop below
+	arenamark = Mem_FrameArena_Mark();
+	touchedicts = (prvm_edict_t **)Mem_FrameArena_Alloc(MAX_EDICTS * sizeof(*touchedicts));
 	numtouchedicts = SV_EntitiesInBox(clipboxmins, clipboxmaxs, MAX_EDICTS, touchedicts);
 	if (numtouchedicts > MAX_EDICTS)
 	{
@@ -580,6 +591,7 @@ trace_t SV_TraceBox(const vec3_t start, const vec3_t mins, const vec3_t maxs, co
 
 		Collision_CombineTraces(&cliptrace, &trace, (void *)touch, PRVM_serveredictfloat(touch, solid) == SOLID_BSP);
 	}
+	Mem_FrameArena_Pop(arenamark);
 
 finished:
 	return cliptrace;
@@ -620,7 +632,8 @@ int SV_PointSuperContents(const vec3_t point)
 	int frame;
 	// list of entities to test for collisions
 	int numtouchedicts;
-	static prvm_edict_t *touchedicts[MAX_EDICTS];
+	prvm_edict_t **touchedicts;
+	size_t arenamark;
 
 	// get world supercontents at this point
 	if (sv.worldmodel && sv.worldmodel->PointSuperContents)
@@ -631,6 +644,8 @@ int SV_PointSuperContents(const vec3_t point)
 		return supercontents;
 
 	// get list of entities at this point
+	arenamark = Mem_FrameArena_Mark();
+	touchedicts = (prvm_edict_t **)Mem_FrameArena_Alloc(MAX_EDICTS * sizeof(*touchedicts));
 	numtouchedicts = SV_EntitiesInBox(point, point, MAX_EDICTS, touchedicts);
 	if (numtouchedicts > MAX_EDICTS)
 	{
@@ -656,6 +671,7 @@ int SV_PointSuperContents(const vec3_t point)
 		frame = (int)PRVM_serveredictfloat(touch, frame);
 		supercontents |= model->PointSuperContents(model, bound(0, frame, (model->numframes - 1)), transformed);
 	}
+	Mem_FrameArena_Pop(arenamark);
 
 	return supercontents;
 }
@@ -727,7 +743,8 @@ void SV_LinkEdict_TouchAreaGrid(prvm_edict_t *ent)
 	prvm_prog_t *prog = SVVM_prog;
 	int i, numtouchedicts, old_self, old_other;
 	prvm_edict_t *touch;
-	static prvm_edict_t *touchedicts[MAX_EDICTS];
+	prvm_edict_t **touchedicts;
+	size_t arenamark;
 
 	if (ent == prog->edicts)
 		return;		// don't add the world
@@ -739,7 +756,10 @@ void SV_LinkEdict_TouchAreaGrid(prvm_edict_t *ent)
 		return;
 
 	// build a list of edicts to touch, because the link loop can be corrupted
-	// by IncreaseEdicts called during touch functions
+	// by IncreaseEdicts called during touch functions, the list comes from the
+	// frame arena because touch functions can relink entities and recurse here
+	arenamark = Mem_FrameArena_Mark();
+	touchedicts = (prvm_edict_t **)Mem_FrameArena_Alloc(MAX_EDICTS * sizeof(*touchedicts));
 	numtouchedicts = SV_EntitiesInBox(ent->priv.server->areamins, ent->priv.server->areamaxs, MAX_EDICTS, touchedicts);
 	if (numtouchedicts > MAX_EDICTS)
 	{
@@ -758,6 +778,7 @@ void SV_LinkEdict_TouchAreaGrid(prvm_edict_t *ent)
 			SV_LinkEdict_TouchAreaGrid_Call(touch, ent);
 		}
 	}
+	Mem_FrameArena_Pop(arenamark);
 	PRVM_serverglobaledict(self) = old_self;
 	PRVM_serverglobaledict(other) = old_other;
 }
@@ -499,6 +499,8 @@ static qbool SV_PrepareEntityForSending (prvm_edict_t *ent, entity_state_t *cs,
 	cs->tagindex = (unsigned char)PRVM_serveredictfloat(ent, tag_index);
 	cs->glowsize = glowsize;
 	cs->traileffectnum = PRVM_serveredictfloat(ent, traileffectnum);
+	f = PRVM_serveredictfloat(ent, netpriority) * 16.0f;
+	cs->netpriority = (unsigned char)bound(0, f, 255);
 
 	// don't need to init cs->colormod because the defaultstate did that for us
 	//cs->colormod[0] = cs->colormod[1] = cs->colormod[2] = 32;
@@ -716,7 +718,8 @@ qbool SV_CanSeeBox(int numtraces, vec_t eyejitter, vec_t enlarge, vec_t entboxex
 	matrix4x4_t matrix, imatrix;
 	model_t *model;
 	prvm_edict_t *touch;
-	static prvm_edict_t *touchedicts[MAX_EDICTS];
+	prvm_edict_t **touchedicts;
+	size_t arenamark;
 	vec3_t eyemins, eyemaxs, start;
 	vec3_t boxmins, boxmaxs;
 	vec3_t clipboxmins, clipboxmaxs;
@@ -757,6 +760,8 @@ qbool SV_CanSeeBox(int numtraces, vec_t eyejitter, vec_t enlarge, vec_t entboxex
 	}
 
 	// get the list of entities in the sweep box
+	arenamark = Mem_FrameArena_Mark();
+	touchedicts = (prvm_edict_t **)Mem_FrameArena_Alloc(MAX_EDICTS * sizeof(*touchedicts));
 	if (sv_cullentities_trace_entityocclusion.integer)
 		numtouchedicts = SV_EntitiesInBox(clipboxmins, clipboxmaxs, MAX_EDICTS, touchedicts);
 	if (numtouchedicts > MAX_EDICTS)
@@ -833,8 +838,10 @@ qbool SV_CanSeeBox(int numtraces, vec_t eyejitter, vec_t enlarge, vec_t entboxex
 		if (touchindex < numtouchedicts)
 			continue;
 		// return if the ray was not blocked
+		Mem_FrameArena_Pop(arenamark);
 		return true;
 	}
+	Mem_FrameArena_Pop(arenamark);
 
 	// no rays survived
 	return false;
@@ -1062,6 +1069,54 @@ static void SV_CleanupEnts (void)
 		PRVM_serveredictfloat(ent, effects) = (int)PRVM_serveredictfloat(ent, effects) & ~EF_MUZZLEFLASH;
 }
 
+/*
+==================
+SV_ClientdataDeltaBits
+
+Returns the SU_DELTAFIELDS bits of clientdata that PROTOCOL_DARKPLACES8 has
+to send this frame, the rest are unchanged since they were last sent
+==================
+*/
+static int SV_ClientdataDeltaBits(client_t *client, prvm_edict_t *ent)
+{
+	prvm_prog_t *prog = SVVM_prog;
+	int i;
+	int idealpitch = (int)PRVM_serveredictfloat(ent, idealpitch);
+
+	// fields from a packet that never made it into a packetlog can't be
+	// resent on loss, so send them again
+	client->clientdatadeltabits |= client->clientdatasentbits;
+
+	if (client->clientdata_idealpitch != idealpitch)
+	{
+		client->clientdata_idealpitch = idealpitch;
+		client->clientdatadeltabits |= SU_IDEALPITCH;
+	}
+	for (i = 0;i < 3;i++)
+	{
+		if (client->clientdata_punchangle[i] != PRVM_serveredictvector(ent, punchangle)[i])
+		{
+			client->clientdata_punchangle[i] = PRVM_serveredictvector(ent, punchangle)[i];
+			client->clientdatadeltabits |= SU_PUNCH1<<i;
+		}
+		if (client->clientdata_punchvector[i] != PRVM_serveredictvector(ent, punchvector)[i])
+		{
+			client->clientdata_punchvector[i] = PRVM_serveredictvector(ent, punchvector)[i];
+			client->clientdatadeltabits |= SU_PUNCHVEC1<<i;
+		}
+		if (client->clientdata_velocity[i] != PRVM_serveredictvector(ent, velocity)[i])
+		{
+			client->clientdata_velocity[i] = PRVM_serveredictvector(ent, velocity)[i];
+			client->clientdatadeltabits |= SU_VELOCITY1<<i;
+		}
+	}
+
+	// EntityFrame5_WriteFrame logs these in the packetlog
+	client->clientdatasentbits = client->clientdatadeltabits;
+	client->clientdatadeltabits = 0;
+	return client->clientdatasentbits;
+}
+
 /*
 ==================
 SV_WriteClientdataToMessage
@@ -1164,6 +1219,10 @@ void SV_WriteClientdataToMessage (client_t *client, prvm_edict_t *ent, sizebuf_t
 			bits |= (SU_VELOCITY1<<i);
 	}
 
+	// PROTOCOL_DARKPLACES8 sends these fields only when they changed
+	if (sv.protocol == PROTOCOL_DARKPLACES8)
+		bits = (bits & ~SU_DELTAFIELDS) | SV_ClientdataDeltaBits(client, ent);
+
 	gravity = PRVM_serveredictfloat(ent, gravity);if (!gravity) gravity = 1.0f;
 
 	memset(stats, 0, sizeof(int[MAX_CL_STATS]));
@@ -1394,6 +1453,109 @@ static void SV_WriteUnreliableMessages(client_t *client, sizebuf_t *msg, int max
 		client->unreliablemsg_splitpoint[j] = client->unreliablemsg_splitpoint[numsegments + j] - split;
 }
 
+/*
+=======================
+SV_RangeCodeDatagram
+
+Replaces the message with an svc_rangecoded one if that makes it smaller
+=======================
+*/
+static void SV_RangeCodeDatagram (client_t *client, sizebuf_t *msg)
+{
+	int size;
+	static unsigned char sv_rangecodedatagram_buf[NET_MAXMESSAGE];
+
+	// not worth it for tiny messages, and nothing to save over loopback
+	if (msg->cursize < 16 || msg->cursize > 65535 || LHNETADDRESS_GetAddressType(&client->netconnection->peeraddress) == LHNETADDRESSTYPE_LOOP)
+		return;
+	size = RangeCoder_Compress(msg->data, msg->cursize, sv_rangecodedatagram_buf + 3, msg->cursize - 4);
+	if (size < 0)
+		return;
+	client->netconnection->rangecodedBytesIn += msg->cursize;
+	client->netconnection->rangecodedBytesOut += size + 3;
+	sv_rangecodedatagram_buf[0] = svc_rangecoded;
+	sv_rangecodedatagram_buf[1] = msg->cursize & 0xFF;
+	sv_rangecodedatagram_buf[2] = (msg->cursize >> 8) & 0xFF;
+	memcpy(msg->data, sv_rangecodedatagram_buf, size + 3);
+	msg->cursize = size + 3;
+}
+
+// acks carry the block size as a signed short
+#define SV_DOWNLOAD_MAXBLOCK 32767
+// clients without the window extension have always been sent at most this
+#define SV_DOWNLOAD_OLDBLOCK 1400
+
+/*
+=======================
+SV_WriteDownloadData
+
+Writes the next block of the active download, using at most space bytes of
+msg including the svc_downloaddata header, returns the number of data bytes
+=======================
+*/
+static int SV_WriteDownloadData(client_t *client, sizebuf_t *msg, int space)
+{
+	fs_offset_t downloadstart;
+	int downloadsize;
+	static unsigned char data[SV_DOWNLOAD_MAXBLOCK];
+
+	downloadstart = FS_Tell(client->download_file);
+	downloadsize = min(space - 7, client->download_window ? SV_DOWNLOAD_MAXBLOCK : SV_DOWNLOAD_OLDBLOCK);
+	downloadsize = FS_Read(client->download_file, data, downloadsize);
+	// note this sends empty messages if at the end of the file, which is
+	// necessary to keep the packet loss logic working
+	// (the last blocks may be lost and need to be re-sent, and that will
+	//  only occur if the client acks the empty end messages, revealing
+	//  a gap in the download progress, causing the last blocks to be
+	//  sent again)
+	MSG_WriteChar (msg, svc_downloaddata);
+	MSG_WriteLong (msg, downloadstart);
+	MSG_WriteShort (msg, downloadsize);
+	if (downloadsize > 0)
+		SZ_Write (msg, data, downloadsize);
+	return downloadsize;
+}
+
+/*
+=======================
+SV_SendDownloadWindow
+
+The regular datagram only carries one download block per frame, which caps
+a download at one packet per server frame no matter how high the client's
+rate is. Clients that ack every block get extra packets of download data
+until sv_download_window bytes are unacknowledged or the rate limit is hit.
+Lost blocks are resent from download_expectedposition as before.
+=======================
+*/
+#define SV_DOWNLOAD_MAXPACKETS 64
+static void SV_SendDownloadWindow (client_t *client, int clientrate, int packetsize)
+{
+	int i;
+	sizebuf_t msg;
+	fs_offset_t position, filesize;
+	static unsigned char sv_senddownloadwindow_buf[NET_MAXMESSAGE];
+
+	filesize = FS_FileSize(client->download_file);
+	packetsize = min(packetsize, (int)sizeof(sv_senddownloadwindow_buf));
+	for (i = 0;i < SV_DOWNLOAD_MAXPACKETS;i++)
+	{
+		// the end of file blocks are left to the regular datagram
+		position = FS_Tell(client->download_file);
+		if (position >= filesize || position - client->download_expectedposition >= sv_download_window.integer)
+			break;
+		if (!NetConn_CanSend(client->netconnection))
+			break;
+
+		msg.data = sv_senddownloadwindow_buf;
+		msg.maxsize = sizeof(sv_senddownloadwindow_buf);
+		msg.cursize = 0;
+		msg.allowoverflow = false;
+		if (SV_WriteDownloadData(client, &msg, packetsize) <= 0)
+			break;
+		NetConn_SendUnreliableMessage (client->netconnection, &msg, sv.protocol, clientrate, client->rate_burstsize, client->sendsignon == 2);
+	}
+}
+
 /*
 =======================
 SV_SendClientDatagram
@@ -1530,24 +1692,7 @@ static void SV_SendClientDatagram (client_t *client)
 	// in this packet
 	downloadsize = min(maxsize*2,maxsize2) - msg.cursize - 7;
 	if (host_client->download_file && host_client->download_started && downloadsize > 0)
-	{
-		fs_offset_t downloadstart;
-		unsigned char data[1400];
-		downloadstart = FS_Tell(host_client->download_file);
-		downloadsize = min(downloadsize, (int)sizeof(data));
-		downloadsize = FS_Read(host_client->download_file, data, downloadsize);
-		// note this sends empty messages if at the end of the file, which is
-		// necessary to keep the packet loss logic working
-		// (the last blocks may be lost and need to be re-sent, and that will
-		//  only occur if the client acks the empty end messages, revealing
-		//  a gap in the download progress, causing the last blocks to be
-		//  sent again)
-		MSG_WriteChar (&msg, svc_downloaddata);
-		MSG_WriteLong (&msg, downloadstart);
-		MSG_WriteShort (&msg, downloadsize);
-		if (downloadsize > 0)
-			SZ_Write (&msg, data, downloadsize);
-	}
+		SV_WriteDownloadData(client, &msg, downloadsize);
 
 	// reliable only if none is in progress
 	if(client->sendsignon != 2 && !client->netconnection->sendMessageLength)
@@ -1555,10 +1700,17 @@ static void SV_SendClientDatagram (client_t *client)
 	// unreliable
 	SV_WriteDemoMessage(client, &msg, false);
 
+	// DP8 can range code the whole datagram (demos above stay uncoded)
+	if (sv.protocol == PROTOCOL_DARKPLACES8 && sv_rangecoder.integer)
+		SV_RangeCodeDatagram(client, &msg);
+
 // send the datagram
 	NetConn_SendUnreliableMessage (client->netconnection, &msg, sv.protocol, clientrate, client->rate_burstsize, client->sendsignon == 2);
 	if (client->sendsignon == 1 && !client->netconnection->message.cursize)
 		client->sendsignon = 2; // prevent reliable until client sends prespawn (this is the keepalive phase)
+
+	if (client->download_file && client->download_started && client->download_window && sv_download_window.integer > 0)
+		SV_SendDownloadWindow(client, clientrate, maxsize2);
 }
 
 /*
@@ -1130,11 +1130,15 @@ clc_stringcmd_invalid:
 						host_client->download_started = false;
 					}
 				}
-				else
+				else if (!host_client->download_window || host.realtime >= host_client->download_rewindtime)
 				{
 					// a data block was lost, reset to the expected position
 					// and resume sending from there
 					FS_Seek(host_client->download_file, host_client->download_expectedposition, SEEK_SET);
+					// with a window of blocks in flight the acks of the ones
+					// after the gap all show it, so only rewind again once
+					// the resent data had time to arrive
+					host_client->download_rewindtime = host.realtime + bound(0.1, host_client->ping * 2, 1);
 				}
 			}
 			break;
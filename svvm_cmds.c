@@ -57,6 +57,7 @@ const char *vm_sv_extensions[] = {
 "DP_ENT_GLOW",
 "DP_ENT_GLOWMOD",
 "DP_ENT_LOWPRECISION",
+"DP_ENT_NETPRIORITY",
 "DP_ENT_SCALE",
 "DP_ENT_TRAILEFFECTNUM",
 "DP_ENT_VIEWMODEL",
@@ -93,10 +93,16 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 # define SSE_POSSIBLE
 #endif
 
+// AVX2/FMA code is compiled per function and only used after runtime detection
+#if ((defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)) || (defined(_MSC_VER) && defined(_M_X64))
+# define AVX2_POSSIBLE
+#endif
+
 #ifdef NO_SSE
 # undef SSE_PRESENT
 # undef SSE_POSSIBLE
 # undef SSE2_PRESENT
+# undef AVX2_POSSIBLE
 #endif
 
 #ifdef SSE_POSSIBLE
@@ -108,6 +114,13 @@ qbool Sys_HaveSSE2(void);
 #define Sys_HaveSSE2() false
 #endif
 
+#ifdef AVX2_POSSIBLE
+// runtime detection of AVX2 and FMA (including OS support for ymm registers)
+qbool Sys_HaveAVX2(void);
+#else
+#define Sys_HaveAVX2() false
+#endif
+
 typedef struct sys_s
 {
 	int argc;
@@ -895,6 +895,49 @@ static int CPUID_Features(void)
 // }
 #endif
 
+#ifdef AVX2_POSSIBLE
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+qbool Sys_HaveAVX2(void)
+{
+	unsigned int regs[4]; // eax, ebx, ecx, edx
+	unsigned long long xcr0;
+	// COMMANDLINEOPTION: AVX2: -noavx2 disables AVX2/FMA support and detection
+	if(Sys_CheckParm("-nosse") || Sys_CheckParm("-noavx2"))
+		return false;
+#ifdef _MSC_VER
+	__cpuid((int *)regs, 1);
+#else
+	__cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	// FMA is 1<<12, OSXSAVE is 1<<27, AVX is 1<<28
+	if((regs[2] & ((1 << 12) | (1 << 27) | (1 << 28))) != ((1 << 12) | (1 << 27) | (1 << 28)))
+		return false;
+	// the OS has to preserve the xmm and ymm registers
+#ifdef _MSC_VER
+	xcr0 = _xgetbv(0);
+#else
+	{
+		unsigned int lo, hi;
+		__asm__ ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+		xcr0 = ((unsigned long long)hi << 32) | lo;
+	}
+#endif
+	if((xcr0 & 6) != 6)
+		return false;
+#ifdef _MSC_VER
+	__cpuidex((int *)regs, 7, 0);
+#else
+	__cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	// AVX2 is leaf 7 ebx 1<<5
+	return (regs[1] & (1 << 5)) != 0;
+}
+#endif
+
 /// called to set process priority for dedicated servers
 #if defined(__linux__)
 #include <sys/resource.h>
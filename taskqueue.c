@@ -45,6 +45,10 @@ typedef struct taskqueue_state_s
 	unsigned int tasks_recentframes[RECENTFRAMES];
 	unsigned int tasks_thisframe;
 	unsigned int tasks_averageperframe;
+
+	// TaskQueue_RequireThreads requests
+	int required_count;
+	int required_threads;
 }
 taskqueue_state_t;
 
@@ -96,8 +100,10 @@ static int TaskQueue_ThreadFunc(void *d)
 			break;
 		sleepcounter++;
 		if (sleepcounter >= THREADSLEEPCOUNT)
+		{
 			Sys_Sleep(0.001);
-		sleepcounter = 0;
+			sleepcounter = 0;
+		}
 	}
 	return 0;
 }
@@ -210,33 +216,16 @@ void TaskQueue_WaitForTaskDone(taskqueue_task_t *t)
 	}
 }
 
-void TaskQueue_Frame(qbool shutdown)
+// starts or stops worker threads, fewer start if Thread_CreateThread fails
+static void TaskQueue_SetThreads(int numthreads)
 {
 	int i;
-	unsigned long long int avg;
-	int maxthreads = bound(0, taskqueue_maxthreads.integer, MAXTHREADS);
-	int numthreads = maxthreads;
-	int tasksperthread = bound(10, taskqueue_tasksperthread.integer, 100000);
+
+	numthreads = bound(0, numthreads, MAXTHREADS);
 #ifdef THREADDISABLE
 	numthreads = 0;
 #endif
 
-	Thread_AtomicLock(&taskqueue_state.command_lock);
-	taskqueue_state.tasks_recentframesindex = (taskqueue_state.tasks_recentframesindex + 1) % RECENTFRAMES;
-	taskqueue_state.tasks_recentframes[taskqueue_state.tasks_recentframesindex] = taskqueue_state.tasks_thisframe;
-	taskqueue_state.tasks_thisframe = 0;
-	avg = 0;
-	for (i = 0; i < RECENTFRAMES; i++)
-		avg += taskqueue_state.tasks_recentframes[i];
-	taskqueue_state.tasks_averageperframe = avg / RECENTFRAMES;
-	Thread_AtomicUnlock(&taskqueue_state.command_lock);
-
-	numthreads = taskqueue_state.tasks_averageperframe / tasksperthread;
-	numthreads = bound(taskqueue_minthreads.integer, numthreads, taskqueue_maxthreads.integer);
-
-	if (shutdown)
-		numthreads = 0;
-
 	// check if we need to close some threads
 	if (taskqueue_state.numthreads > numthreads)
 	{
@@ -264,16 +253,66 @@ void TaskQueue_Frame(qbool shutdown)
 			taskqueue_state.threads[i].quit = 0;
 		Thread_AtomicUnlock(&taskqueue_state.command_lock);
 
-		// start new threads
+		// start new threads, a thread that failed to start must not get any
+		// tasks, so stop at the first one
 		for (i = taskqueue_state.numthreads; i < numthreads; i++)
 		{
 			taskqueue_state.threads[i].thread_index = i;
 			taskqueue_state.threads[i].handle = Thread_CreateThread(TaskQueue_ThreadFunc, &taskqueue_state.threads[i]);
+			if (!taskqueue_state.threads[i].handle)
+				break;
 		}
 
 		// okay we're at the new state now
-		taskqueue_state.numthreads = numthreads;
+		taskqueue_state.numthreads = i;
 	}
+}
+
+int TaskQueue_RequireThreads(int numthreads)
+{
+	if (numthreads <= 0)
+		numthreads = Thread_GetCPUCount();
+	numthreads = min(numthreads, taskqueue_maxthreads.integer);
+	if (taskqueue_state.required_count++ == 0 || taskqueue_state.required_threads < numthreads)
+		taskqueue_state.required_threads = numthreads;
+	if (Thread_HasThreads() && taskqueue_state.numthreads < taskqueue_state.required_threads)
+		TaskQueue_SetThreads(taskqueue_state.required_threads);
+	return taskqueue_state.numthreads;
+}
+
+void TaskQueue_ReleaseThreads(void)
+{
+	if (taskqueue_state.required_count > 0 && --taskqueue_state.required_count == 0)
+		taskqueue_state.required_threads = 0;
+}
+
+void TaskQueue_Frame(qbool shutdown)
+{
+	int i;
+	unsigned long long int avg;
+	int numthreads;
+	int tasksperthread = bound(10, taskqueue_tasksperthread.integer, 100000);
+
+	Thread_AtomicLock(&taskqueue_state.command_lock);
+	taskqueue_state.tasks_recentframesindex = (taskqueue_state.tasks_recentframesindex + 1) % RECENTFRAMES;
+	taskqueue_state.tasks_recentframes[taskqueue_state.tasks_recentframesindex] = taskqueue_state.tasks_thisframe;
+	taskqueue_state.tasks_thisframe = 0;
+	avg = 0;
+	for (i = 0; i < RECENTFRAMES; i++)
+		avg += taskqueue_state.tasks_recentframes[i];
+	taskqueue_state.tasks_averageperframe = avg / RECENTFRAMES;
+	Thread_AtomicUnlock(&taskqueue_state.command_lock);
+
+	numthreads = taskqueue_state.tasks_averageperframe / tasksperthread;
+	numthreads = max(numthreads, taskqueue_state.required_threads);
+	numthreads = bound(taskqueue_minthreads.integer, numthreads, taskqueue_maxthreads.integer);
+
+	if (shutdown)
+		numthreads = 0;
+
+	// a thread that failed to start is tried again next frame
+	if (taskqueue_state.numthreads != numthreads)
+		TaskQueue_SetThreads(numthreads);
 
 	// just for good measure, distribute any pending tasks that span across frames
 	TaskQueue_DistributeTasks();
@@ -43,6 +43,17 @@ void TaskQueue_Setup(taskqueue_task_t *t, taskqueue_task_t *preceding, void(*fun
 // t->p[0] = array of taskqueue_task_t to check
 void TaskQueue_Task_CheckTasksDone(taskqueue_task_t *t);
 
+// starts worker threads right away (up to taskqueue_maxthreads) and keeps at
+// least numthreads of them running until TaskQueue_ReleaseThreads, no matter
+// how little work recent frames had; for work that must not run on the
+// calling thread, or that runs before the first TaskQueue_Frame.
+// numthreads <= 0 means one per CPU. Only call from the main thread.
+// Returns the number of worker threads running, 0 if threads are unavailable
+// (every call still needs its TaskQueue_ReleaseThreads)
+int TaskQueue_RequireThreads(int numthreads);
+// ends a TaskQueue_RequireThreads, extra threads stop in a later TaskQueue_Frame
+void TaskQueue_ReleaseThreads(void);
+
 void TaskQueue_Init(void);
 void TaskQueue_Shutdown(void);
 void TaskQueue_Frame(qbool shutdown);
@@ -9,6 +9,13 @@
 // use recursive mutex (non-posix) extensions in thread_pthread
 #define THREADRECURSIVE
 
+// storage class for variables every thread gets its own copy of
+#if defined(_MSC_VER)
+#define THREADLOCAL __declspec(thread)
+#else
+#define THREADLOCAL _Thread_local
+#endif
+
 typedef int Thread_SpinLock;
 typedef struct {int value;} Thread_Atomic;
 
@@ -38,6 +45,8 @@ typedef struct {int value;} Thread_Atomic;
 int Thread_Init(void);
 void Thread_Shutdown(void);
 qbool Thread_HasThreads(void);
+/// number of logical processors, at least 1
+int Thread_GetCPUCount(void);
 void *_Thread_CreateMutex(const char *filename, int fileline);
 void _Thread_DestroyMutex(void *mutex, const char *filename, int fileline);
 int _Thread_LockMutex(void *mutex, const char *filename, int fileline);
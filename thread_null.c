@@ -15,6 +15,11 @@ qbool Thread_HasThreads(void)
 	return false;
 }
 
+int Thread_GetCPUCount(void)
+{
+	return 1;
+}
+
 void *_Thread_CreateMutex(const char *filename, int fileline)
 {
 	return NULL;
@@ -107,7 +112,7 @@ void _Thread_AtomicIncRef(Thread_Atomic *a, const char *filename, int fileline)
 
 qbool _Thread_AtomicDecRef(Thread_Atomic *a, const char *filename, int fileline)
 {
-	return a->value++ == 1;
+	return --a->value == 0;
 }
 
 qbool _Thread_AtomicTryLock(Thread_SpinLock *lock, const char *filename, int fileline)
@@ -5,6 +5,7 @@
 #include <pthread.h>
 #endif
 #include <stdint.h>
+#include <unistd.h>
 
 
 int Thread_Init(void)
@@ -21,6 +22,12 @@ qbool Thread_HasThreads(void)
 	return true;
 }
 
+int Thread_GetCPUCount(void)
+{
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int)n : 1;
+}
+
 void *_Thread_CreateMutex(const char *filename, int fileline)
 {
 #ifdef THREADRECURSIVE
@@ -24,6 +24,12 @@ qbool Thread_HasThreads(void)
 #endif
 }
 
+int Thread_GetCPUCount(void)
+{
+	int n = SDL_GetCPUCount();
+	return n > 0 ? n : 1;
+}
+
 void *_Thread_CreateMutex(const char *filename, int fileline)
 {
 	void *mutex = SDL_CreateMutex();
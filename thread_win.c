@@ -23,6 +23,13 @@ qbool Thread_HasThreads(void)
 #endif
 }
 
+int Thread_GetCPUCount(void)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
 void *_Thread_CreateMutex(const char *filename, int fileline)
 {
 	void *mutex = (void *)CreateMutex(NULL, FALSE, NULL);
@@ -366,6 +366,213 @@ static void Clump_FreeBlock(void *base, size_t size)
 #endif
 }
 
+/*
+==============================================================================
+
+SIZE CLASS SLABS
+
+Small blocks are carved out of MEMSLAB_SLABSIZE slabs and kept on one free
+list per size class.  Every thread also caches a few free blocks of each
+class, so most small Mem_Alloc/Mem_Free calls never touch the shared lists,
+and those are only locked to move a batch of blocks at a time.
+Slabs are never released, each class keeps its peak number of blocks around.
+
+==============================================================================
+*/
+
+#define MEMSLAB_SLABSIZE (64<<10)
+#define MEMSLAB_CLASSES 10
+// blocks a thread may keep per class before returning MEMSLAB_BATCH of them
+#define MEMSLAB_CACHE 32
+#define MEMSLAB_BATCH 16
+// thread counters are added to the shared ones at least this often (power of 2)
+#define MEMSLAB_FLUSHOPS 256
+
+// these include the memheader_t, alignment padding and tail sentinel
+static const size_t memslab_classsize[MEMSLAB_CLASSES] = {96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048};
+
+typedef struct memslabblock_s
+{
+	struct memslabblock_s *next;
+}
+memslabblock_t;
+
+typedef struct memslabclass_s
+{
+	memslabblock_t *free;
+	size_t numfree;
+	size_t numblocks;
+	// totals for memstats, and their values at the previous memstats
+	size_t allocs, frees;
+	size_t lastallocs, lastfrees;
+}
+memslabclass_t;
+
+typedef struct memslabcache_s
+{
+	memslabblock_t *free[MEMSLAB_CLASSES];
+	int numfree[MEMSLAB_CLASSES];
+	unsigned int allocs[MEMSLAB_CLASSES];
+	unsigned int frees[MEMSLAB_CLASSES];
+	unsigned int ops;
+}
+memslabcache_t;
+
+static memslabclass_t memslab_class[MEMSLAB_CLASSES];
+static Thread_SpinLock memslab_lock;
+static double memslab_lasttime;
+static THREADLOCAL memslabcache_t memslab_cache;
+
+static int Mem_SlabClass(size_t realsize)
+{
+	int c;
+	for (c = 0;c < MEMSLAB_CLASSES;c++)
+		if (realsize <= memslab_classsize[c])
+			return c;
+	return -1;
+}
+
+// only called with memslab_lock held
+static void Mem_SlabFlushCounts(memslabcache_t *cache)
+{
+	int c;
+	for (c = 0;c < MEMSLAB_CLASSES;c++)
+	{
+		memslab_class[c].allocs += cache->allocs[c];
+		memslab_class[c].frees += cache->frees[c];
+		cache->allocs[c] = 0;
+		cache->frees[c] = 0;
+	}
+}
+
+static void Mem_SlabRefill(memslabcache_t *cache, int c)
+{
+	int i;
+	size_t blocksize = memslab_classsize[c];
+	unsigned char *slab;
+	memslabclass_t *sc = &memslab_class[c];
+	memslabblock_t *b;
+
+	Thread_AtomicLock(&memslab_lock);
+	Mem_SlabFlushCounts(cache);
+	if (sc->numfree < MEMSLAB_BATCH)
+	{
+		// the clump allocator is only safe to call under mem_mutex
+		if (mem_mutex)
+			Thread_LockMutex(mem_mutex);
+		slab = (unsigned char *)Clump_AllocBlock(MEMSLAB_SLABSIZE);
+		if (mem_mutex)
+			Thread_UnlockMutex(mem_mutex);
+		if (slab)
+		{
+			for (i = MEMSLAB_SLABSIZE / blocksize - 1;i >= 0;i--)
+			{
+				b = (memslabblock_t *)(slab + i * blocksize);
+				b->next = sc->free;
+				sc->free = b;
+				sc->numfree++;
+				sc->numblocks++;
+			}
+		}
+	}
+	for (i = 0;i < MEMSLAB_BATCH && sc->free;i++)
+	{
+		b = sc->free;
+		sc->free = b->next;
+		sc->numfree--;
+		b->next = cache->free[c];
+		cache->free[c] = b;
+		cache->numfree[c]++;
+	}
+	Thread_AtomicUnlock(&memslab_lock);
+}
+
+static void Mem_SlabDrain(memslabcache_t *cache, int c)
+{
+	int i;
+	memslabclass_t *sc = &memslab_class[c];
+	memslabblock_t *b;
+
+	Thread_AtomicLock(&memslab_lock);
+	Mem_SlabFlushCounts(cache);
+	for (i = 0;i < MEMSLAB_BATCH && cache->free[c];i++)
+	{
+		b = cache->free[c];
+		cache->free[c] = b->next;
+		cache->numfree[c]--;
+		b->next = sc->free;
+		sc->free = b;
+		sc->numfree++;
+	}
+	Thread_AtomicUnlock(&memslab_lock);
+}
+
+static void Mem_SlabTick(memslabcache_t *cache)
+{
+	if (++cache->ops & (MEMSLAB_FLUSHOPS - 1))
+		return;
+	Thread_AtomicLock(&memslab_lock);
+	Mem_SlabFlushCounts(cache);
+	Thread_AtomicUnlock(&memslab_lock);
+}
+
+static void *Mem_SlabAlloc(int c)
+{
+	memslabcache_t *cache = &memslab_cache;
+	memslabblock_t *b;
+	if (!cache->free[c])
+		Mem_SlabRefill(cache, c);
+	b = cache->free[c];
+	if (!b)
+		return NULL;
+	cache->free[c] = b->next;
+	cache->numfree[c]--;
+	cache->allocs[c]++;
+	Mem_SlabTick(cache);
+	if (developer_memorydebug.integer)
+		memset(b, 0xAF, memslab_classsize[c]);
+	return b;
+}
+
+static void Mem_SlabFree(void *base, int c)
+{
+	memslabcache_t *cache = &memslab_cache;
+	memslabblock_t *b = (memslabblock_t *)base;
+	memset(base, 0xFF, developer_memorydebug.integer ? memslab_classsize[c] : sizeof(memheader_t));
+	b->next = cache->free[c];
+	cache->free[c] = b;
+	cache->numfree[c]++;
+	cache->frees[c]++;
+	if (cache->numfree[c] > MEMSLAB_CACHE)
+		Mem_SlabDrain(cache, c);
+	Mem_SlabTick(cache);
+}
+
+static void Mem_PrintSlabStats(void)
+{
+	int c;
+	double now = Sys_DirtyTime(), elapsed;
+	size_t inuse;
+	memslabclass_t *sc;
+
+	Thread_AtomicLock(&memslab_lock);
+	Mem_SlabFlushCounts(&memslab_cache);
+	elapsed = memslab_lasttime ? now - memslab_lasttime : 0;
+	Con_Printf("size class  slabbed  in use (approx)  allocs/s  frees/s%s\n", elapsed > 0 ? "" : "  (rates start at the next memstats)");
+	for (c = 0;c < MEMSLAB_CLASSES;c++)
+	{
+		sc = &memslab_class[c];
+		inuse = sc->allocs >= sc->frees ? sc->allocs - sc->frees : 0;
+		Con_Printf("%10lu %8lu %16lu %9.0f %8.0f\n", (unsigned long)memslab_classsize[c], (unsigned long)sc->numblocks, (unsigned long)inuse,
+			elapsed > 0 ? (sc->allocs - sc->lastallocs) / elapsed : 0.0,
+			elapsed > 0 ? (sc->frees - sc->lastfrees) / elapsed : 0.0);
+		sc->lastallocs = sc->allocs;
+		sc->lastfrees = sc->frees;
+	}
+	memslab_lasttime = now;
+	Thread_AtomicUnlock(&memslab_lock);
+}
+
 void *_Mem_Alloc(mempool_t *pool, void *olddata, size_t size, size_t alignment, const char *filename, int fileline)
 {
 	unsigned int sentinel1;
@@ -376,6 +583,7 @@ void *_Mem_Alloc(mempool_t *pool, void *olddata, size_t size, size_t alignment,
 	memheader_t *mem;
 	memheader_t *oldmem;
 	unsigned char *base;
+	int sizeclass;
 
 	if (size <= 0)
 	{
@@ -390,6 +598,10 @@ void *_Mem_Alloc(mempool_t *pool, void *olddata, size_t size, size_t alignment,
 		else
 			Sys_Error("Mem_Alloc: pool == NULL (alloc at %s:%i)", filename, fileline);
 	}
+	// small blocks come from the thread's slab cache, outside of mem_mutex
+	realsize = alignment + sizeof(memheader_t) + size + sizeof(sentinel2);
+	sizeclass = Mem_SlabClass(realsize);
+	base = sizeclass >= 0 ? (unsigned char *)Mem_SlabAlloc(sizeclass) : NULL;
 	if (mem_mutex)
 		Thread_LockMutex(mem_mutex);
 	if (developer_memory.integer || size >= developer_memoryreportlargerthanmb.value * 1048576)
@@ -397,9 +609,8 @@ void *_Mem_Alloc(mempool_t *pool, void *olddata, size_t size, size_t alignment,
 	//if (developer.integer > 0 && developer_memorydebug.integer)
 	//	_Mem_CheckSentinelsGlobal(filename, fileline);
 	pool->totalsize += size;
-	realsize = alignment + sizeof(memheader_t) + size + sizeof(sentinel2);
-	pool->realsize += realsize;
-	base = (unsigned char *)Clump_AllocBlock(realsize);
+	if (sizeclass < 0)
+		base = (unsigned char *)Clump_AllocBlock(realsize);
 	if (base == NULL)
 	{
 		Mem_PrintList(0);
@@ -415,6 +626,9 @@ void *_Mem_Alloc(mempool_t *pool, void *olddata, size_t size, size_t alignment,
 	mem->fileline = fileline;
 	mem->size = size;
 	mem->pool = pool;
+	mem->sizeclass = sizeclass + 1;
+	// count the padding actually used so Mem_Free subtracts the same amount
+	pool->realsize += ((unsigned char *)mem - base) + sizeof(memheader_t) + size + sizeof(sentinel2);
 
 	// calculate sentinels (detects buffer overruns, in a way that is hard to exploit)
 	sentinel1 = MEMHEADER_SENTINEL_FOR_ADDRESS(&mem->sentinel);
@@ -451,6 +665,8 @@ static void _Mem_FreeBlock(memheader_t *mem, const char *filename, int fileline)
 	size_t realsize;
 	unsigned int sentinel1;
 	unsigned int sentinel2;
+	int sizeclass;
+	void *base;
 
 	// check sentinels (detects buffer overruns, in a way that is hard to exploit)
 	sentinel1 = MEMHEADER_SENTINEL_FOR_ADDRESS(&mem->sentinel);
@@ -471,12 +687,18 @@ static void _Mem_FreeBlock(memheader_t *mem, const char *filename, int fileline)
 	List_Delete(&mem->list);
 	// memheader has been unlinked, do the actual free now
 	size = mem->size;
-	realsize = sizeof(memheader_t) + size + sizeof(sentinel2);
+	// same as in _Mem_Alloc, including the alignment padding
+	realsize = ((unsigned char *)mem - (unsigned char *)mem->baseaddress) + sizeof(memheader_t) + size + sizeof(sentinel2);
+	sizeclass = mem->sizeclass;
+	base = mem->baseaddress;
 	pool->totalsize -= size;
 	pool->realsize -= realsize;
-	Clump_FreeBlock(mem->baseaddress, realsize);
+	if (!sizeclass)
+		Clump_FreeBlock(base, realsize);
 	if (mem_mutex)
 		Thread_UnlockMutex(mem_mutex);
+	if (sizeclass)
+		Mem_SlabFree(base, sizeclass - 1);
 }
 
 void _Mem_Free(void *data, const char *filename, int fileline)
@@ -497,6 +719,34 @@ void _Mem_Free(void *data, const char *filename, int fileline)
 	_Mem_FreeBlock((memheader_t *)((unsigned char *) data - sizeof(memheader_t)), filename, fileline);
 }
 
+void _Mem_ChangePool(mempool_t *pool, void *data, const char *filename, int fileline)
+{
+	memheader_t *mem = (memheader_t *)((unsigned char *) data - sizeof(memheader_t));
+	size_t realsize;
+
+	if (pool == NULL)
+		Sys_Error("Mem_ChangePool: pool == NULL (move at %s:%i)", filename, fileline);
+	if (mem->sentinel != MEMHEADER_SENTINEL_FOR_ADDRESS(&mem->sentinel))
+		Sys_Error("Mem_ChangePool: trashed head sentinel (alloc at %s:%i, move at %s:%i)", mem->filename, mem->fileline, filename, fileline);
+	if (mem->list.prev->next != &mem->list || mem->list.next->prev != &mem->list)
+		Sys_Error("Mem_ChangePool: not allocated or already freed (move at %s:%i)", filename, fileline);
+	if (mem->pool == pool)
+		return;
+	// same accounting as in _Mem_Alloc and _Mem_FreeBlock
+	realsize = ((unsigned char *)mem - (unsigned char *)mem->baseaddress) + sizeof(memheader_t) + mem->size + sizeof(unsigned int);
+	if (mem_mutex)
+		Thread_LockMutex(mem_mutex);
+	List_Delete(&mem->list);
+	mem->pool->totalsize -= mem->size;
+	mem->pool->realsize -= realsize;
+	mem->pool = pool;
+	pool->totalsize += mem->size;
+	pool->realsize += realsize;
+	List_Add(&mem->list, &pool->chain);
+	if (mem_mutex)
+		Thread_UnlockMutex(mem_mutex);
+}
+
 mempool_t *_Mem_AllocPool(const char *name, unsigned flags, mempool_t *parent, const char *filename, int fileline)
 {
 	mempool_t *pool;
@@ -787,6 +1037,115 @@ void *Mem_ExpandableArray_RecordAtIndex(const memexpandablearray_t *l, size_t in
 	return (void *)(l->arrays[i].data + j * l->recordsize);
 }
 
+/*
+==============================================================================
+
+FRAME ARENA
+
+Per-thread linear scratch memory for transient buffers (server, client and
+VM code alike).  Memory is handed out by bumping a pointer and given back by
+returning to a mark, or all at once by the next Mem_FrameArena_NewFrame of
+the same thread, so a Host_Error longjmp past a Mem_FrameArena_Pop can't
+leak.  The memory is not cleared.
+
+==============================================================================
+*/
+
+#define MEM_FRAMEARENA_MINSIZE (1<<20)
+
+typedef struct memframearena_s
+{
+	struct memframearena_s *prev; // older block, only chained until the next frame
+	size_t base; // mark value of data[0]
+	size_t size;
+	size_t used;
+	unsigned char *data; // 16 byte aligned
+}
+memframearena_t;
+
+static THREADLOCAL memframearena_t *mem_framearena;
+// largest mark value seen, the next frame gets a single block this big
+static THREADLOCAL size_t mem_framearena_peak;
+
+static memframearena_t *Mem_FrameArena_NewBlock(memframearena_t *prev, size_t size)
+{
+	memframearena_t *a = (memframearena_t *)Mem_Alloc(zonemempool, sizeof(*a) + 15 + size);
+	a->data = (unsigned char *)(((size_t)(a + 1) + 15) & ~15);
+	a->size = size;
+	a->prev = prev;
+	a->base = prev ? prev->base + prev->size : 0;
+	return a;
+}
+
+void *Mem_FrameArena_Alloc(size_t size)
+{
+	memframearena_t *a = mem_framearena;
+	size_t blocksize;
+	void *data;
+
+	size = (size + 15) & ~15;
+	if (!a || a->used + size > a->size)
+	{
+		// ran out of space, chain a bigger block until the next frame
+		blocksize = max(MEM_FRAMEARENA_MINSIZE, a ? a->size * 2 : 0);
+		blocksize = max(blocksize, size);
+		mem_framearena = a = Mem_FrameArena_NewBlock(a, blocksize);
+	}
+	data = a->data + a->used;
+	a->used += size;
+	mem_framearena_peak = max(mem_framearena_peak, a->base + a->used);
+	return data;
+}
+
+size_t Mem_FrameArena_Mark(void)
+{
+	memframearena_t *a = mem_framearena;
+	return a ? a->base + a->used : 0;
+}
+
+void Mem_FrameArena_Pop(size_t mark)
+{
+	memframearena_t *a = mem_framearena, *prev;
+	while (a && a->prev && a->base > mark)
+	{
+		prev = a->prev;
+		Mem_Free(a);
+		a = prev;
+	}
+	mem_framearena = a;
+	if (!a || mark >= a->base + a->used)
+		return;
+	if (developer_memorydebug.integer)
+		memset(a->data + (mark - a->base), 0xFF, a->base + a->used - mark);
+	a->used = mark - a->base;
+}
+
+void Mem_FrameArena_NewFrame(void)
+{
+	memframearena_t *a = mem_framearena;
+	if (!a)
+		return;
+	if (a->prev || a->size < mem_framearena_peak)
+	{
+		// merge the blocks of a frame that overflowed
+		Mem_FrameArena_Free();
+		mem_framearena = Mem_FrameArena_NewBlock(NULL, (mem_framearena_peak + 65535) & ~(size_t)65535);
+		return;
+	}
+	a->used = 0;
+}
+
+void Mem_FrameArena_Free(void)
+{
+	memframearena_t *a, *prev;
+	for (a = mem_framearena;a;a = prev)
+	{
+		prev = a->prev;
+		Mem_Free(a);
+	}
+	mem_framearena = NULL;
+}
+
 
 // used for temporary memory allocations around the engine, not for longterm
 // storage, if anything in this pool stays allocated during gameplay, it is
@@ -859,6 +1218,7 @@ static void MemStats_f(cmd_state_t *cmd)
 {
 	Mem_CheckSentinelsGlobal();
 	Mem_PrintStats();
+	Mem_PrintSlabStats();
 }
 
 
@@ -55,6 +55,8 @@ typedef struct memheader_s
 	// file name and line where Mem_Alloc was called
 	const char *filename;
 	int fileline;
+	// size class + 1 if the block came from a slab, 0 if it was allocated directly
+	int sizeclass;
 	// should always be equal to MEMHEADER_SENTINEL_FOR_ADDRESS()
 	unsigned int sentinel;
 	// immediately followed by data, which is followed by another copy of mem_sentinel[]
@@ -104,9 +106,12 @@ mempool_t;
 #define Mem_AllocPool(name, flags, parent) _Mem_AllocPool(name, flags, parent, __FILE__, __LINE__)
 #define Mem_FreePool(pool) _Mem_FreePool(pool, __FILE__, __LINE__)
 #define Mem_EmptyPool(pool) _Mem_EmptyPool(pool, __FILE__, __LINE__)
+#define Mem_ChangePool(pool, data) _Mem_ChangePool(pool, data, __FILE__, __LINE__)
 
 void *_Mem_Alloc(mempool_t *pool, void *data, size_t size, size_t alignment, const char *filename, int fileline);
 void _Mem_Free(void *data, const char *filename, int fileline);
+/// moves an allocation to another pool without copying it
+void _Mem_ChangePool(mempool_t *pool, void *data, const char *filename, int fileline);
 mempool_t *_Mem_AllocPool(const char *name, unsigned flags, mempool_t *parent, const char *filename, int fileline);
 void _Mem_FreePool(mempool_t **pool, const char *filename, int fileline);
 void _Mem_EmptyPool(mempool_t *pool, const char *filename, int fileline);
@@ -150,6 +155,16 @@ void Mem_ExpandableArray_FreeRecord(memexpandablearray_t *l, void *record);
 size_t Mem_ExpandableArray_IndexRange(const memexpandablearray_t *l) DP_FUNC_PURE;
 void *Mem_ExpandableArray_RecordAtIndex(const memexpandablearray_t *l, size_t index) DP_FUNC_PURE;
 
+// per-thread scratch memory, valid until the thread's next
+// Mem_FrameArena_NewFrame or until a Mem_FrameArena_Pop below it (not cleared)
+void *Mem_FrameArena_Alloc(size_t size);
+size_t Mem_FrameArena_Mark(void);
+void Mem_FrameArena_Pop(size_t mark);
+// called by Host_Frame and the server thread at the start of every frame
+void Mem_FrameArena_NewFrame(void);
+// releases the calling thread's arena, threads call this before they exit
+void Mem_FrameArena_Free(void);
+
 // used for temporary allocations
 extern mempool_t *tempmempool;
 